@@ -26,15 +26,6 @@ UTangoARCamera::UTangoARCamera() : Super()
 	FrameOfReference = FTangoCoordinateFramePair(ETangoCoordinateFrameType::START_OF_SERVICE, ETangoCoordinateFrameType::CAMERA_COLOR);
 }
 
-FTangoPoseData UTangoARCamera::GetCurrentPoseRENDERTHREAD(float TimeStamp)
-{
-	if (UTangoDevice::Get().GetTangoDeviceMotionPointer() == nullptr)
-	{
-		return FTangoPoseData();
-	}
-	return UTangoDevice::Get().GetTangoDeviceMotionPointer()->GetPoseAtTime(FrameOfReference, TimeStamp);
-}
-
 AActor * UTangoARCamera::GetActor()
 {
 	return Super::GetOwner();
@@ -63,6 +54,43 @@ void UTangoARCamera::InitializeComponent()
 	FieldOfView = FMath::RadiansToDegrees<float>(2.0f * FMath::Atan(0.5f * Intrin.Width / Intrin.Fx));
 }
 
+//The view extension walks the components below this one again with the next frame.
+void UTangoARCamera::OnRegister()
+{
+	Super::OnRegister();
+	if (ViewExtension.IsValid())
+	{
+		ViewExtension->InvalidateHierarchyCache();
+	}
+}
+
+void UTangoARCamera::OnUnregister()
+{
+	if (ViewExtension.IsValid())
+	{
+		ViewExtension->InvalidateHierarchyCache();
+	}
+	Super::OnUnregister();
+}
+
+void UTangoARCamera::OnChildAttached(USceneComponent* ChildComponent)
+{
+	Super::OnChildAttached(ChildComponent);
+	if (ViewExtension.IsValid())
+	{
+		ViewExtension->InvalidateHierarchyCache();
+	}
+}
+
+void UTangoARCamera::OnChildDetached(USceneComponent* ChildComponent)
+{
+	Super::OnChildDetached(ChildComponent);
+	if (ViewExtension.IsValid())
+	{
+		ViewExtension->InvalidateHierarchyCache();
+	}
+}
+
 
 void UTangoARCamera::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
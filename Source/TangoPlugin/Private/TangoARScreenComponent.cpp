@@ -84,9 +84,8 @@ void UTangoARScreenComponent::SetupMaterial()
 	if (FoundMaterial)
 	{
 		auto Inst = UMaterialInstanceDynamic::Create(FoundMaterial, this);
-
-		Inst->SetTextureParameterValue(FName("PackedYMaskTexture"), UTangoDevice::Get().GetTangoDeviceImagePointer()->GetYTexture());
-		Inst->SetTextureParameterValue(FName("PackedUVMaskTexture"), UTangoDevice::Get().GetTangoDeviceImagePointer()->GetCrTexture());
+		ScreenMaterial = Inst;
+		BindCameraTextures();
 		auto Intrin = UTangoDevice::Get().GetCameraIntrinsics(ETangoCameraType::COLOR);
 		Inst->SetVectorParameterValue(FName("CameraMaterialVector"), FLinearColor(0, 0, Intrin.Width, Intrin.Height));
 		Inst->SetVectorParameterValue(FName("Intrinsics"), FLinearColor(Intrin.Cx, Intrin.Cy, Intrin.Fx, Intrin.Fy));
@@ -110,6 +109,23 @@ void UTangoARScreenComponent::SetupMaterial()
 	}
 }
 
+void UTangoARScreenComponent::BindCameraTextures()
+{
+	UTangoDeviceImage* DeviceImage = UTangoDevice::Get().GetTangoDeviceImagePointer();
+	if (ScreenMaterial == nullptr || DeviceImage == nullptr)
+	{
+		return;
+	}
+	//Each camera frame lands in another texture of the ring
+	UTexture* YTexture = DeviceImage->GetYTexture();
+	if (YTexture != nullptr && YTexture != BoundYTexture)
+	{
+		ScreenMaterial->SetTextureParameterValue(FName("PackedYMaskTexture"), YTexture);
+		ScreenMaterial->SetTextureParameterValue(FName("PackedUVMaskTexture"), DeviceImage->GetCrTexture());
+		BoundYTexture = YTexture;
+	}
+}
+
 void UTangoARScreenComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	if (!bInitializedMaterial)
@@ -122,4 +138,8 @@ void UTangoARScreenComponent::TickComponent(float DeltaTime, enum ELevelTick Tic
 			}
 		}
 	}
+	else
+	{
+		BindCameraTextures();
+	}
 }
\ No newline at end of file
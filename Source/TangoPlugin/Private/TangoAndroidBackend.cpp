@@ -0,0 +1,332 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoAndroidBackend.h"
+
+#if PLATFORM_ANDROID
+#include "TangoDevice.h"
+#include "TangoFromToCObject.h"
+#include "Android/AndroidJNI.h"
+#include "AndroidApplication.h"
+
+namespace
+{
+	FTangoBackendPose ToBackendPose(const TangoPoseData* Pose)
+	{
+		FTangoBackendPose Result;
+		Result.Timestamp = Pose->timestamp;
+		Result.BaseFrame = Pose->frame.base;
+		Result.TargetFrame = Pose->frame.target;
+		Result.StatusCode = Pose->status_code;
+		FMemory::Memcpy(Result.Translation, Pose->translation, sizeof(Result.Translation));
+		FMemory::Memcpy(Result.Orientation, Pose->orientation, sizeof(Result.Orientation));
+		return Result;
+	}
+}
+
+TangoAndroidBackend::TangoAndroidBackend()
+	: Config_(nullptr)
+	, AppContextReference(nullptr)
+	, bIsConnected(false)
+{
+}
+
+TangoAndroidBackend::~TangoAndroidBackend()
+{
+	Disconnect();
+}
+
+bool TangoAndroidBackend::SetBinder(JNIEnv* Env, jobject IBinder)
+{
+	if (TangoService_setBinder(Env, IBinder) != TANGO_SUCCESS)
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoAndroidBackend::SetBinder: could not bind to Tango Service."));
+		return false;
+	}
+	UE_LOG(TangoPlugin, Log, TEXT("TangoAndroidBackend::SetBinder: successfully bound to Tango Service."));
+	return true;
+}
+
+/*
+ *  Populates the AppContextReference object with the Application context using a call to Java code via the JNI.
+ *  @TODO: Investigate whether we need to call this on every connection or whether we can get away with only
+ * triggering it once on app startup (i.e. will the application context switch? Is the bad global reference we
+ * experienced when calling only at TangoDevice startup due to local references from the Unreal JNI pipeline being
+ * converted into globals incorrectly, or because the Application context which is being pointed to has changed?)
+ */
+void TangoAndroidBackend::PopulateAppContext()
+{
+	jobject AppContext = NULL;
+
+	if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
+	{
+		//We identify the method we need to call, by passing the name of the function.
+		static jmethodID Method = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_GetAppContext", "()Landroid/content/Context;", false);
+		//Once jmethodID has been identified, we supply it as an argument to CallObjectMethod.
+		AppContext = FJavaWrapper::CallObjectMethod(Env, FJavaWrapper::GameActivityThis, Method);
+
+		if (AppContext == NULL)
+		{
+			UE_LOG(TangoPlugin, Warning, TEXT("TangoAndroidBackend::PopulateAppContext: Error - app context is still NULL after retrieval call!"));
+			AppContextReference = nullptr;
+		}
+		else
+		{
+			//Now we cache the activity for later use to prevent garbage collection
+			AppContextReference = Env->NewGlobalRef(AppContext);
+		}
+	}
+}
+
+void TangoAndroidBackend::DePopulateAppContext()
+{
+	if (AppContextReference == nullptr)
+	{
+		return;
+	}
+	if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
+	{
+		Env->DeleteGlobalRef(AppContextReference);
+	}
+	else
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoAndroidBackend::DePopulateAppContext: Could not get Java environment!"));
+	}
+	AppContextReference = nullptr;
+}
+
+bool TangoAndroidBackend::ApplyConfig(const FTangoConfig& Config)
+{
+	if (Config_ == nullptr)
+	{
+		Config_ = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
+		if (Config_ == nullptr)
+		{
+			UE_LOG(TangoPlugin, Error, TEXT("TangoAndroidBackend::ApplyConfig: SetConfig FAILED because TangoService_getConfig did return nullptr!"));
+			return false;
+		}
+	}
+
+	bool bSuccess = true;
+	bSuccess = TangoConfig_setBool(Config_, "config_enable_auto_recovery", Config.bEnableAutoRecovery) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setBool(Config_, "config_enable_color_camera", Config.bEnableColorCameraCapabilities) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setBool(Config_, "config_color_mode_auto", Config.bColorModeAuto) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setBool(Config_, "config_enable_depth", Config.bEnableDepthCapabilities) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setBool(Config_, "config_high_rate_pose", Config.bHighRatePose) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setBool(Config_, "config_enable_learning_mode", Config.bEnableLearningMode) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setBool(Config_, "config_enable_low_latency_imu_integration", Config.bLowLatencyIMUIntegration) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setBool(Config_, "config_enable_motion_tracking", Config.bEnableMotionTracking) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setBool(Config_, "config_smooth_pose", Config.bSmoothPose) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setInt32(Config_, "config_color_exp", Config.ColorExposure) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setInt32(Config_, "config_color_iso", Config.ColorISO) == TANGO_SUCCESS	&& bSuccess;
+	bSuccess = TangoConfig_setString(Config_, "config_load_area_description_UUID", TCHAR_TO_ANSI(*Config.AreaDescription.UUID)) == TANGO_SUCCESS	&& bSuccess;
+
+	if (!bSuccess)
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoAndroidBackend::ApplyConfig: ApplyConfig FAILED because the Config parameters could not be set."));
+	}
+	return bSuccess;
+}
+
+bool TangoAndroidBackend::ApplyRuntimeConfig(const FTangoRuntimeConfig& RuntimeConfig)
+{
+	UE_LOG(TangoPlugin, Log, TEXT("TangoAndroidBackend::ApplyRuntimeConfig: Rate is: %d "), (RuntimeConfig.bEnableDepth ? RuntimeConfig.RuntimeDepthFramerate : 0));
+	return TangoConfig_setInt32(Config_, "config_runtime_depth_framerate", RuntimeConfig.bEnableDepth ? RuntimeConfig.RuntimeDepthFramerate : 0) == TANGO_SUCCESS;
+}
+
+bool TangoAndroidBackend::Connect(const FTangoConfig& Config, const FTangoRuntimeConfig& RuntimeConfig)
+{
+	bool bSuccess = ApplyConfig(Config);
+	if (Config_ == nullptr)
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoAndroidBackend::Connect: failed because Config is NULL."));
+		return false;
+	}
+	bSuccess = ApplyRuntimeConfig(RuntimeConfig) && bSuccess;
+
+	//Refresh Java global reference here
+	/*@TODO: This is a little hacky, see if we can get a reference to a state which won't be garbage collected so we don't need to do this.*/
+	PopulateAppContext();
+	bIsConnected = TangoService_connect(AppContextReference, Config_) == TANGO_SUCCESS;
+	return bIsConnected;
+}
+
+void TangoAndroidBackend::Disconnect()
+{
+	if (Config_ != nullptr)
+	{
+		TangoConfig_free(Config_);
+		Config_ = nullptr;
+	}
+	if (bIsConnected)
+	{
+		TangoService_disconnect();
+		bIsConnected = false;
+	}
+	DePopulateAppContext();
+}
+
+bool TangoAndroidBackend::SetRuntimeConfig(const FTangoRuntimeConfig& RuntimeConfig)
+{
+	if (Config_ == nullptr)
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoAndroidBackend::SetRuntimeConfig: Unable to set runtime Config Tango Config pointer is nullptr."));
+		return false;
+	}
+	bool bSuccess = ApplyRuntimeConfig(RuntimeConfig);
+	return TangoService_setRuntimeConfig(Config_) == TANGO_SUCCESS && bSuccess;
+}
+
+int32 TangoAndroidBackend::GetMaxPointCloudElements()
+{
+	int32 MaxPointCloudElements = 0;
+	if (Config_ == nullptr || TangoConfig_getInt32(Config_, "max_point_cloud_elements", &MaxPointCloudElements) != TANGO_SUCCESS)
+	{
+		return 0;
+	}
+	return MaxPointCloudElements;
+}
+
+bool TangoAndroidBackend::GetCameraTextureSizes(int32& YWidth, int32& YHeight, int32& UVWidth, int32& UVHeight)
+{
+	if (Config_ == nullptr)
+	{
+		return false;
+	}
+	bool bSuccess = true;
+	bSuccess = TangoConfig_getInt32(Config_, "experimental_color_y_tex_data_width", &YWidth) == TANGO_SUCCESS && bSuccess;
+	bSuccess = TangoConfig_getInt32(Config_, "experimental_color_y_tex_data_height", &YHeight) == TANGO_SUCCESS && bSuccess;
+	bSuccess = TangoConfig_getInt32(Config_, "experimental_color_uv_tex_data_width", &UVWidth) == TANGO_SUCCESS && bSuccess;
+	bSuccess = TangoConfig_getInt32(Config_, "experimental_color_uv_tex_data_height", &UVHeight) == TANGO_SUCCESS && bSuccess;
+	return bSuccess;
+}
+
+bool TangoAndroidBackend::GetPoseAtTime(double Timestamp, const FTangoCoordinateFramePair& FrameOfReference, FTangoBackendPose& Pose)
+{
+	TangoPoseData Result;
+	if (TangoService_getPoseAtTime(Timestamp, ToCObject(FrameOfReference), &Result) != TANGO_SUCCESS)
+	{
+		return false;
+	}
+	Pose = ToBackendPose(&Result);
+	return true;
+}
+
+bool TangoAndroidBackend::GetCameraIntrinsics(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics)
+{
+	TangoCameraIntrinsics DeviceIntrinsics;
+	if (TangoService_getCameraIntrinsics(ToCObject(Camera), &DeviceIntrinsics) != TANGO_SUCCESS)
+	{
+		return false;
+	}
+	Intrinsics = FromCObject(DeviceIntrinsics);
+	return true;
+}
+
+void TangoAndroidBackend::ResetMotionTracking()
+{
+	TangoService_resetMotionTracking();
+}
+
+bool TangoAndroidBackend::ConnectOnPoseAvailable(const TArray<FTangoCoordinateFramePair>& FramesOfReference)
+{
+	TArray<TangoCoordinateFramePair> Pairs;
+	Pairs.SetNumUninitialized(FramesOfReference.Num());
+	for (int32 i = 0; i < FramesOfReference.Num(); ++i)
+	{
+		Pairs[i] = ToCObject(FramesOfReference[i]);
+	}
+	return TangoService_connectOnPoseAvailable(Pairs.Num(), Pairs.GetData(), [](void*, const TangoPoseData* Pose)
+	{
+		UTangoDevice::Get().OnPoseAvailable(ToBackendPose(Pose));
+	}) == TANGO_SUCCESS;
+}
+
+bool TangoAndroidBackend::ConnectOnPointCloudAvailable()
+{
+	return TangoService_connectOnXYZijAvailable([](void*, const TangoXYZij* XYZ_ij)
+	{
+		FTangoBackendPointCloud PointCloud;
+		PointCloud.Timestamp = XYZ_ij->timestamp;
+		PointCloud.NumPoints = XYZ_ij->xyz_count;
+		PointCloud.XYZ = XYZ_ij->xyz;
+		PointCloud.IJRows = XYZ_ij->ij_rows;
+		PointCloud.IJCols = XYZ_ij->ij_cols;
+		PointCloud.IJ = XYZ_ij->ij;
+		UTangoDevice::Get().OnPointCloudAvailable(PointCloud);
+	}) == TANGO_SUCCESS;
+}
+
+bool TangoAndroidBackend::ConnectOnTangoEvent()
+{
+	return TangoService_connectOnTangoEvent([](void*, const TangoEvent* Event)
+	{
+		FTangoBackendEvent BackendEvent;
+		BackendEvent.Timestamp = Event->timestamp;
+		BackendEvent.Type = Event->type;
+		BackendEvent.Key = Event->event_key;
+		BackendEvent.Value = Event->event_value;
+		UTangoDevice::Get().OnTangoEvent(BackendEvent);
+	}) == TANGO_SUCCESS;
+}
+
+bool TangoAndroidBackend::ConnectOnFrameAvailable()
+{
+	return TangoService_connectOnFrameAvailable(TANGO_CAMERA_COLOR, nullptr, [](void*, TangoCameraId Id, const TangoImageBuffer* Buffer)
+	{
+		if (Id != TANGO_CAMERA_COLOR || Buffer == nullptr)
+		{
+			return;
+		}
+		const bool bIsNV21 = Buffer->format == TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP;
+		FTangoBackendImage Image;
+		Image.Timestamp = Buffer->timestamp;
+		Image.FrameNumber = Buffer->frame_number;
+		Image.Width = Buffer->width;
+		Image.Height = Buffer->height;
+		Image.Stride = Buffer->stride;
+		Image.Y = bIsNV21 ? Buffer->data : nullptr;
+		Image.VU = bIsNV21 ? Buffer->data + Buffer->stride * Buffer->height : nullptr;
+		UTangoDevice::Get().OnCameraFrameAvailable(Image);
+	}) == TANGO_SUCCESS;
+}
+
+bool TangoAndroidBackend::DisconnectOnFrameAvailable()
+{
+	//A null callback disconnects the earlier one
+	return TangoService_connectOnFrameAvailable(TANGO_CAMERA_COLOR, nullptr, nullptr) == TANGO_SUCCESS;
+}
+
+bool TangoAndroidBackend::ConnectCameraTextures(uint32 YTexture, uint32 CbTexture, uint32 CrTexture)
+{
+	return TangoService_Experimental_connectTextureIdUnity(TANGO_CAMERA_COLOR, YTexture, CbTexture, CrTexture, nullptr, [](void*, TangoCameraId Id)
+	{
+		if (Id == TANGO_CAMERA_COLOR)
+		{
+			UTangoDevice::Get().OnCameraTexturesAvailable();
+		}
+	}) == TANGO_SUCCESS;
+}
+
+bool TangoAndroidBackend::UpdateCameraTextures(double& Timestamp)
+{
+	return TangoService_updateTexture(TANGO_CAMERA_COLOR, &Timestamp) == TANGO_SUCCESS;
+}
+
+bool TangoAndroidBackend::DisconnectCamera()
+{
+	return TangoService_disconnectCamera(TANGO_CAMERA_COLOR) == TANGO_SUCCESS;
+}
+#endif
@@ -0,0 +1,63 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoBackend.h"
+
+#if PLATFORM_ANDROID
+#include "tango_client_api.h"
+
+//The Tango service through its C API
+class TangoAndroidBackend : public ITangoBackend
+{
+public:
+	TangoAndroidBackend();
+	virtual ~TangoAndroidBackend();
+
+	//Hands the service bound on the Java side to the C API, before Connect.
+	static bool SetBinder(JNIEnv* Env, jobject IBinder);
+
+	//ITangoBackend interface
+	virtual const TCHAR* GetName() const override { return TEXT("Android"); }
+	virtual bool Connect(const FTangoConfig& Config, const FTangoRuntimeConfig& RuntimeConfig) override;
+	virtual void Disconnect() override;
+	virtual bool IsConnected() const override { return bIsConnected; }
+	virtual bool SetRuntimeConfig(const FTangoRuntimeConfig& RuntimeConfig) override;
+	virtual int32 GetMaxPointCloudElements() override;
+	virtual bool GetCameraTextureSizes(int32& YWidth, int32& YHeight, int32& UVWidth, int32& UVHeight) override;
+	virtual bool GetPoseAtTime(double Timestamp, const FTangoCoordinateFramePair& FrameOfReference, FTangoBackendPose& Pose) override;
+	virtual bool GetCameraIntrinsics(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics) override;
+	virtual void ResetMotionTracking() override;
+	virtual bool ConnectOnPoseAvailable(const TArray<FTangoCoordinateFramePair>& FramesOfReference) override;
+	virtual bool ConnectOnPointCloudAvailable() override;
+	virtual bool ConnectOnTangoEvent() override;
+	virtual bool ConnectOnFrameAvailable() override;
+	virtual bool DisconnectOnFrameAvailable() override;
+	virtual bool ConnectCameraTextures(uint32 YTexture, uint32 CbTexture, uint32 CrTexture) override;
+	virtual bool UpdateCameraTextures(double& Timestamp) override;
+	virtual bool DisconnectCamera() override;
+
+private:
+	bool ApplyConfig(const FTangoConfig& Config);
+	bool ApplyRuntimeConfig(const FTangoRuntimeConfig& RuntimeConfig);
+	//The service wants the application context to connect, it is fetched from Java on every connection.
+	void PopulateAppContext();
+	void DePopulateAppContext();
+
+	TangoConfig Config_;
+	jobject AppContextReference;
+	volatile bool bIsConnected;
+};
+#endif
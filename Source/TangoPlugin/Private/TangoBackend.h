@@ -0,0 +1,103 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoDataTypes.h"
+
+//What the service delivers, without the Tango headers which only exist on Android. Enums have the values of the C API.
+struct FTangoBackendPose
+{
+	double Timestamp;
+	int32 BaseFrame;
+	int32 TargetFrame;
+	int32 StatusCode;
+	//Tango space
+	double Translation[3];
+	//x, y, z, w
+	double Orientation[4];
+};
+
+//Meters in the depth camera frame
+struct FTangoBackendPointCloud
+{
+	double Timestamp;
+	int32 NumPoints;
+	const float (*XYZ)[3];
+	int32 IJRows;
+	int32 IJCols;
+	const uint32* IJ;
+};
+
+struct FTangoBackendEvent
+{
+	double Timestamp;
+	int32 Type;
+	const ANSICHAR* Key;
+	const ANSICHAR* Value;
+};
+
+//NV21
+struct FTangoBackendImage
+{
+	double Timestamp;
+	int64 FrameNumber;
+	int32 Width;
+	int32 Height;
+	int32 Stride;
+	const uint8* Y;
+	const uint8* VU;
+};
+
+/*
+ * The calls into the Tango service. The Android backend talks to the service, other platforms get a headless backend that
+ * generates or replays data, so the plugin can run and be profiled without a device.
+ * Backends deliver their data through the callback paths of UTangoDevice, on threads of their own.
+ */
+class ITangoBackend
+{
+public:
+	virtual ~ITangoBackend() {}
+
+	virtual const TCHAR* GetName() const = 0;
+
+	//Applies the config and connects. On Android the Java service has to be bound first.
+	virtual bool Connect(const FTangoConfig& Config, const FTangoRuntimeConfig& RuntimeConfig) = 0;
+	virtual void Disconnect() = 0;
+	virtual bool IsConnected() const = 0;
+	virtual bool SetRuntimeConfig(const FTangoRuntimeConfig& RuntimeConfig) = 0;
+
+	//Only valid while connected
+	virtual int32 GetMaxPointCloudElements() = 0;
+	virtual bool GetCameraTextureSizes(int32& YWidth, int32& YHeight, int32& UVWidth, int32& UVHeight) = 0;
+
+	//Can be called from any thread. Timestamp 0 asks for the latest pose.
+	virtual bool GetPoseAtTime(double Timestamp, const FTangoCoordinateFramePair& FrameOfReference, FTangoBackendPose& Pose) = 0;
+	virtual bool GetCameraIntrinsics(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics) = 0;
+	virtual void ResetMotionTracking() = 0;
+
+	//Start the callbacks into UTangoDevice. Connecting again replaces the earlier connection.
+	virtual bool ConnectOnPoseAvailable(const TArray<FTangoCoordinateFramePair>& FramesOfReference) = 0;
+	virtual bool ConnectOnPointCloudAvailable() = 0;
+	virtual bool ConnectOnTangoEvent() = 0;
+	virtual bool ConnectOnFrameAvailable() = 0;
+	virtual bool DisconnectOnFrameAvailable() = 0;
+
+	//Render thread. Lets the service write color frames into OpenGL textures.
+	virtual bool ConnectCameraTextures(uint32 YTexture, uint32 CbTexture, uint32 CrTexture) = 0;
+	virtual bool UpdateCameraTextures(double& Timestamp) = 0;
+	virtual bool DisconnectCamera() = 0;
+};
+
+typedef TSharedPtr<ITangoBackend, ESPMode::ThreadSafe> FTangoBackendPtr;
@@ -0,0 +1,358 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoBenchmarkCommandlet.h"
+#include "TangoDevicePointCloud.h"
+#include "TangoCoordinateConversions.h"
+#include "TangoFromToCObject.h"
+#include "TangoPointCloudComponent.h"
+#include "TangoPointsComponent.h"
+#include "TangoDevice.h"
+#include "TangoReport.h"
+
+namespace
+{
+	struct FBenchmarkResult
+	{
+		FString Name;
+		int32 Elements;
+		int32 Iterations;
+		//Read and written once per element, for MB/s
+		int32 BytesPerElement;
+		double MedianSeconds;
+		double MinSeconds;
+
+		double GetNsPerElement() const
+		{
+			return Elements > 0 ? MedianSeconds * 1e9 / Elements : 0.0;
+		}
+
+		double GetMBPerSecond() const
+		{
+			return MedianSeconds > 0.0 ? (double)Elements * BytesPerElement / MedianSeconds / 1e6 : 0.0;
+		}
+	};
+
+	//Written by every kernel so the compiler cannot drop the work
+	volatile float Sink = 0.0f;
+
+	class FBenchmarkRunner
+	{
+	public:
+		FBenchmarkRunner(const TArray<FString>& InFilter, int32 InIterations)
+			: Filter(InFilter)
+			, Iterations(InIterations)
+		{
+		}
+
+		bool IsEnabled(const TCHAR* Name) const
+		{
+			if (Filter.Num() == 0)
+			{
+				return true;
+			}
+			for (const FString& Entry : Filter)
+			{
+				if (Entry.Equals(Name, ESearchCase::IgnoreCase))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//Runs the kernel once to warm the caches, then Iterations times. Every call processes Elements elements.
+		void Run(const TCHAR* Name, int32 Elements, int32 BytesPerElement, TFunctionRef<void()> Kernel)
+		{
+			if (!IsEnabled(Name))
+			{
+				return;
+			}
+			Kernel();
+			TArray<double> Seconds;
+			Seconds.Reserve(Iterations);
+			for (int32 i = 0; i < Iterations; ++i)
+			{
+				const double Start = FPlatformTime::Seconds();
+				Kernel();
+				Seconds.Add(FPlatformTime::Seconds() - Start);
+			}
+			Seconds.Sort();
+
+			FBenchmarkResult Result;
+			Result.Name = Name;
+			Result.Elements = Elements;
+			Result.Iterations = Iterations;
+			Result.BytesPerElement = BytesPerElement;
+			Result.MedianSeconds = Seconds[Seconds.Num() / 2];
+			Result.MinSeconds = Seconds[0];
+			UE_LOG(TangoPlugin, Display, TEXT("UTangoBenchmarkCommandlet: %-20s %8d elements %10.2f ns/element %10.1f MB/s, median %.1f us, min %.1f us"),
+				Name, Elements, Result.GetNsPerElement(), Result.GetMBPerSecond(), Result.MedianSeconds * 1e6, Result.MinSeconds * 1e6);
+			Results.Add(Result);
+		}
+
+		const TArray<FBenchmarkResult>& GetResults() const { return Results; }
+
+	private:
+		TArray<FString> Filter;
+		int32 Iterations;
+		TArray<FBenchmarkResult> Results;
+	};
+
+	//Depth camera points in meters as the service delivers them, X right, Y down, Z forward
+	void MakeDepthPoints(int32 Count, TArray<float>& XYZ)
+	{
+		FRandomStream Random(1234);
+		XYZ.SetNumUninitialized(Count * 3);
+		for (int32 i = 0; i < Count; ++i)
+		{
+			const float Z = Random.FRandRange(0.5f, 4.0f);
+			XYZ[i * 3 + 0] = Random.FRandRange(-0.7f, 0.7f) * Z;
+			XYZ[i * 3 + 1] = Random.FRandRange(-0.4f, 0.4f) * Z;
+			XYZ[i * 3 + 2] = Z;
+		}
+	}
+
+	//Projection of a 16:9 color camera, only the terms the scene proxy uses
+	FMatrix MakeProjectionMatrix()
+	{
+		FMatrix ProjMat = FMatrix::Identity;
+		ProjMat.M[0][0] = 1.6f;
+		ProjMat.M[1][1] = 2.9f;
+		ProjMat.M[2][0] = 0.01f;
+		ProjMat.M[2][1] = -0.02f;
+		return ProjMat;
+	}
+
+	//The label goes into every row, so reports of several runs can be concatenated and compared
+	bool WriteReport(const FString& Path, const FString& Label, const TArray<FBenchmarkResult>& Results)
+	{
+		TangoReport Report({ TEXT("Benchmark"), TEXT("Label"), TEXT("Elements"), TEXT("Iterations"), TEXT("BytesPerElement"), TEXT("MedianUs"), TEXT("MinUs"),
+			TEXT("NsPerElement"), TEXT("MBPerSecond") });
+		Report.AddField(TEXT("EngineVersion"), FEngineVersion::Current().ToString());
+		Report.AddField(TEXT("Platform"), ANSI_TO_TCHAR(FPlatformProperties::PlatformName()));
+		Report.AddField(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+		for (const FBenchmarkResult& Result : Results)
+		{
+			Report.AddRow();
+			Report.AddText(Result.Name);
+			Report.AddText(Label);
+			Report.AddInt(Result.Elements);
+			Report.AddInt(Result.Iterations);
+			Report.AddInt(Result.BytesPerElement);
+			Report.AddNumber(Result.MedianSeconds * 1e6, 3);
+			Report.AddNumber(Result.MinSeconds * 1e6, 3);
+			Report.AddNumber(Result.GetNsPerElement(), 3);
+			Report.AddNumber(Result.GetMBPerSecond(), 2);
+		}
+		return Report.Save(Path);
+	}
+}
+
+UTangoBenchmarkCommandlet::UTangoBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Times the Tango plugin kernels over synthetic data and reports ns per element and MB/s.");
+	HelpUsage = TEXT("-run=TangoBenchmark [-Benchmarks=<Name>[+...]] [-Elements=<N>] [-Iterations=<N>] [-Report=<Path.csv or Path.json>] [-Label=<Text>]");
+}
+
+int32 UTangoBenchmarkCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Filter;
+	FString Benchmarks;
+	if (FParse::Value(*Params, TEXT("Benchmarks="), Benchmarks, false))
+	{
+		Benchmarks.ParseIntoArray(Filter, TEXT("+"), true);
+	}
+	//The most points a depth frame of the service has
+	int32 Elements = 60000;
+	FParse::Value(*Params, TEXT("Elements="), Elements);
+	Elements = FMath::Max(Elements, 3);
+	int32 Iterations = 50;
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+	Iterations = FMath::Max(Iterations, 1);
+	FString Label;
+	FParse::Value(*Params, TEXT("Label="), Label, false);
+	FString ReportPath = TangoReport::GetDefaultPath(TEXT("Benchmark"));
+	FParse::Value(*Params, TEXT("Report="), ReportPath, false);
+
+	if (!TangoSpaceConversions::PrepareOfflineExtrinsics())
+	{
+		UE_LOG(TangoPlugin, Display, TEXT("UTangoBenchmarkCommandlet::Main: No cached extrinsics, using cameras in the device origin"));
+	}
+	const float WorldScale = UTangoDevice::Get().GetMetersToWorldScale();
+	FBenchmarkRunner Runner(Filter, Iterations);
+
+	TArray<float> RawPoints;
+	MakeDepthPoints(Elements, RawPoints);
+	const float(*XYZ)[3] = reinterpret_cast<const float(*)[3]>(RawPoints.GetData());
+	TArray<FVector> Points;
+	Points.SetNumUninitialized(Elements);
+	TangoDevicePointCloud::ConvertPoints(XYZ, Elements, WorldScale, Points.GetData());
+
+	//TangoDevicePointCloud::TickByDevice
+	Runner.Run(TEXT("DepthSwizzle"), Elements, sizeof(float) * 3 + sizeof(FVector), [&]()
+	{
+		TArray<FVector> Converted;
+		Converted.SetNumUninitialized(Elements);
+		TangoDevicePointCloud::ConvertPoints(XYZ, Elements, WorldScale, Converted.GetData());
+		Sink = Converted.Last().X;
+	});
+
+	//One pose per element, with the conversion motion components use by default
+	TangoSpaceConversions::TangoSpaceConversionPair Converter;
+	const FTangoCoordinateFramePair PosePair(ETangoCoordinateFrameType::START_OF_SERVICE, ETangoCoordinateFrameType::DEVICE);
+	if (TangoSpaceConversions::GetSpaceConversionPair(Converter, PosePair))
+	{
+		FRandomStream Random(1234);
+		TArray<FTangoBackendPose> BackendPoses;
+		BackendPoses.SetNumUninitialized(Elements);
+		for (int32 i = 0; i < Elements; ++i)
+		{
+			FTangoBackendPose& Pose = BackendPoses[i];
+			const FQuat Orientation = FQuat(Random.GetUnitVector(), Random.FRandRange(-PI, PI));
+			Pose.Timestamp = i / 100.0;
+			Pose.BaseFrame = PosePair.BaseFrame;
+			Pose.TargetFrame = PosePair.TargetFrame;
+			Pose.StatusCode = ETangoPoseStatus::VALID;
+			Pose.Translation[0] = Random.FRandRange(-5.0f, 5.0f);
+			Pose.Translation[1] = Random.FRandRange(-5.0f, 5.0f);
+			Pose.Translation[2] = Random.FRandRange(-1.0f, 1.0f);
+			Pose.Orientation[0] = Orientation.X;
+			Pose.Orientation[1] = Orientation.Y;
+			Pose.Orientation[2] = Orientation.Z;
+			Pose.Orientation[3] = Orientation.W;
+		}
+		TArray<FTangoPoseData> Poses;
+		Poses.SetNum(Elements);
+
+		Runner.Run(TEXT("PoseFromBackend"), Elements, sizeof(FTangoBackendPose) + sizeof(FTangoPoseData), [&]()
+		{
+			for (int32 i = 0; i < Elements; ++i)
+			{
+				Poses[i] = FromBackendObject(BackendPoses[i]);
+			}
+			Sink = Poses.Last().Position.X;
+		});
+
+		const TArray<FTangoPoseData> SourcePoses = Poses;
+		Runner.Run(TEXT("ModifyPose"), Elements, sizeof(FTangoPoseData) * 2, [&]()
+		{
+			for (int32 i = 0; i < Elements; ++i)
+			{
+				Poses[i] = SourcePoses[i];
+				TangoSpaceConversions::ModifyPose(Poses[i], Converter);
+			}
+			Sink = Poses.Last().Position.X;
+		});
+	}
+	else
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("UTangoBenchmarkCommandlet::Main: No conversion for START_OF_SERVICE to DEVICE, skipping the pose benchmarks"));
+	}
+
+	{
+		const ANSICHAR* Key = "ColorOverExposed";
+		const ANSICHAR* Value = "1.5";
+		FTangoBackendEvent BackendEvent;
+		BackendEvent.Type = (int32)ETangoEventType::COLOR_CAMERA;
+		BackendEvent.Key = Key;
+		BackendEvent.Value = Value;
+		TArray<FTangoEvent> Events;
+		Events.SetNum(Elements);
+		const int32 EventBytes = sizeof(FTangoBackendEvent) + FCStringAnsi::Strlen(Key) + FCStringAnsi::Strlen(Value) + sizeof(FTangoEvent);
+		Runner.Run(TEXT("EventFromBackend"), Elements, EventBytes, [&]()
+		{
+			for (int32 i = 0; i < Elements; ++i)
+			{
+				BackendEvent.Timestamp = i / 100.0;
+				Events[i] = FromBackendObject(BackendEvent);
+			}
+			Sink = Events.Last().TimeStamp;
+		});
+	}
+
+	//Points in front of a 90 degree camera on a 1920x1080 viewport, as GetAllDepthPointsInArea projects them
+	{
+		const FVector2D ScreenDimensions(1920.0f, 1080.0f);
+		TArray<FVector2D> ScreenPoints;
+		ScreenPoints.SetNumUninitialized(Elements);
+		Runner.Run(TEXT("ProjectToScreen"), Elements, sizeof(FVector) + sizeof(FVector2D), [&]()
+		{
+			for (int32 i = 0; i < Elements; ++i)
+			{
+				ScreenPoints[i] = UTangoPointCloudComponent::ProjectToScreen(90.0f, 16.0f / 9.0f, ScreenDimensions, Points[i]);
+			}
+			Sink = ScreenPoints.Last().X;
+		});
+	}
+
+	//A plane per element, each from three of the points
+	FMath::RandInit(1234);
+	Runner.Run(TEXT("MakeRandomPlane"), Elements, sizeof(FVector) * 3 + sizeof(FPlane), [&]()
+	{
+		float Sum = 0.0f;
+		for (int32 i = 0; i < Elements; ++i)
+		{
+			Sum += UTangoPointCloudComponent::MakeRandomPlane(FVector::ForwardVector, Points).W;
+		}
+		Sink = Sum;
+	});
+
+	//Scattered points never reach the inlier percentage, so every call runs all RANSAC iterations
+	Runner.Run(TEXT("FitPlane"), Elements, sizeof(FVector), [&]()
+	{
+		FPlane Plane;
+		UTangoPointCloudComponent::FitPlane(Points, 0.9f, 1.0f, Plane);
+		Sink = Plane.W;
+	});
+
+	//The CPU side of FTangoPointCloudSceneProxy, both in point and in triangle mode
+	{
+		const FMatrix ProjMat = MakeProjectionMatrix();
+		TArray<FDynamicMeshVertex> Vertices;
+		TArray<int32> Indices;
+		const int32 ProxyBytes = sizeof(FVector) + sizeof(FDynamicMeshVertex) + sizeof(int32);
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			const bool bTriangles = Pass == 1;
+			Runner.Run(bTriangles ? TEXT("BuildProxyTriangles") : TEXT("BuildProxyPoints"), Elements, ProxyBytes, [&]()
+			{
+				FVector MinBounds;
+				FVector MaxBounds;
+				FTangoPointCloudSceneProxy::BuildBuffers(Points, ProjMat, bTriangles, FColor::White, Vertices, Indices, MinBounds, MaxBounds);
+				Sink = MaxBounds.X + Indices.Num();
+			});
+		}
+	}
+
+	if (Runner.GetResults().Num() == 0)
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoBenchmarkCommandlet::Main: No benchmark matches %s"), *Benchmarks);
+		return 1;
+	}
+	if (!WriteReport(ReportPath, Label, Runner.GetResults()))
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoBenchmarkCommandlet::Main: Could not write %s"), *ReportPath);
+		return 1;
+	}
+	UE_LOG(TangoPlugin, Display, TEXT("UTangoBenchmarkCommandlet::Main: Wrote %s"), *ReportPath);
+	return 0;
+}
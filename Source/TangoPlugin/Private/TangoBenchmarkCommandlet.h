@@ -0,0 +1,37 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "TangoBenchmarkCommandlet.generated.h"
+
+/*
+ * Times the inner loops of the plugin over synthetic data, without a service or rendering, and writes ns per element and MB/s
+ * of every kernel to a CSV or JSON report so runs of different versions can be compared.
+ *
+ * UE4Editor-Cmd <Project> -run=TangoBenchmark [-Benchmarks=<Name>[+...]] [-Elements=<N>] [-Iterations=<N>] [-Report=<Path.csv or Path.json>] [-Label=<Text>]
+ */
+UCLASS()
+class UTangoBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UTangoBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
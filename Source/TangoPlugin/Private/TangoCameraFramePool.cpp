@@ -0,0 +1,234 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoCameraFramePool.h"
+#include "TangoImageConversion.h"
+#include "TangoImagePyramid.h"
+#include "TangoTracer.h"
+
+const TArray<uint8>& FTangoCameraFrame::GetRGBA8() const
+{
+	FScopeLock ScopeLock(&ConversionLock);
+	if (!bHasRGBA8)
+	{
+		//Keeps its allocation across reuse of the frame, like Data.
+		RGBA8.SetNumUninitialized(Width * Height * 4, false);
+		TangoImageConversion::NV21ToRGBA8(GetY(), GetVU(), Width, Height, RGBA8.GetData());
+		bHasRGBA8 = true;
+	}
+	return RGBA8;
+}
+
+const TArray<uint8>& FTangoCameraFrame::GetHalfResolutionRGB() const
+{
+	FScopeLock ScopeLock(&ConversionLock);
+	if (!bHasHalfResolutionRGB)
+	{
+		HalfResolutionRGB.SetNumUninitialized((Width / 2) * (Height / 2) * 3, false);
+		TangoImageConversion::NV21ToHalfResolutionRGB(GetY(), GetVU(), Width, Height, HalfResolutionRGB.GetData());
+		bHasHalfResolutionRGB = true;
+	}
+	return HalfResolutionRGB;
+}
+
+const TArray<uint8>& FTangoCameraFrame::GetHalfResolutionY() const
+{
+	FScopeLock ScopeLock(&ConversionLock);
+	if (!bHasHalfResolutionY)
+	{
+		HalfResolutionY.SetNumUninitialized((Width / 2) * (Height / 2), false);
+		TangoImageConversion::DownscaleY(GetY(), Width, Height, Width, HalfResolutionY.GetData());
+		bHasHalfResolutionY = true;
+	}
+	return HalfResolutionY;
+}
+
+TangoImagePyramid& FTangoCameraFrame::GetOrCreatePyramid() const
+{
+	FScopeLock ScopeLock(&ConversionLock);
+	if (!Pyramid.IsValid())
+	{
+		Pyramid = MakeShareable(new TangoImagePyramid(*this));
+	}
+	return *Pyramid;
+}
+
+void FTangoCameraFrame::InvalidateConversions()
+{
+	FScopeLock ScopeLock(&ConversionLock);
+	bHasRGBA8 = false;
+	bHasHalfResolutionRGB = false;
+	bHasHalfResolutionY = false;
+	//Hands the level buffers back for the next pyramid
+	Pyramid.Reset();
+}
+
+TangoCameraFramePool::TangoCameraFramePool(int32 InPoolSize)
+	: PoolSize(FMath::Max(InPoolSize, 2))
+	, NextSyntheticFrameNumber(0)
+{
+	FreeFrames.Reserve(PoolSize);
+	for (int32 i = 0; i < PoolSize; ++i)
+	{
+		FreeFrames.Add(new FTangoCameraFrame());
+	}
+}
+
+TangoCameraFramePool::~TangoCameraFramePool()
+{
+	//Frames still held by consumers delete themselves once their last handle is released.
+	LatestFrame.Reset();
+	for (FTangoCameraFrame* Frame : FreeFrames)
+	{
+		delete Frame;
+	}
+	FreeFrames.Empty();
+}
+
+FTangoCameraFrame* TangoCameraFramePool::AcquireFrame()
+{
+	FScopeLock ScopeLock(&PoolLock);
+	if (FreeFrames.Num() == 0)
+	{
+		return nullptr;
+	}
+	return FreeFrames.Pop(false);
+}
+
+void TangoCameraFramePool::ReleaseFrame(FTangoCameraFrame* Frame)
+{
+	FScopeLock ScopeLock(&PoolLock);
+	FreeFrames.Push(Frame);
+}
+
+FTangoCameraFrameHandle TangoCameraFramePool::Publish(FTangoCameraFrame* Frame)
+{
+	TWeakPtr<TangoCameraFramePool, ESPMode::ThreadSafe> WeakPool = AsShared();
+	FTangoCameraFrameHandle NewFrame(Frame, [WeakPool](FTangoCameraFrame* ReleasedFrame)
+	{
+		TSharedPtr<TangoCameraFramePool, ESPMode::ThreadSafe> Pool = WeakPool.Pin();
+		if (Pool.IsValid())
+		{
+			Pool->ReleaseFrame(ReleasedFrame);
+		}
+		else
+		{
+			delete ReleasedFrame;
+		}
+	});
+
+	FTangoCameraFrameHandle PreviousFrame;
+	{
+		FScopeLock ScopeLock(&PoolLock);
+		PreviousFrame = LatestFrame;
+		LatestFrame = NewFrame;
+	}
+	//PreviousFrame goes out of scope here, outside of the lock, and returns to the pool if nobody else holds it.
+	return NewFrame;
+}
+
+FTangoCameraFrameHandle TangoCameraFramePool::SubmitFrame(const uint8* Y, const uint8* VU, int32 Width, int32 Height, int32 Stride, double Timestamp, int64 FrameNumber)
+{
+	NumReceivedFrames.Increment();
+	if (Y == nullptr || VU == nullptr || Width <= 0 || Height <= 0 || Width % 2 != 0 || Height % 2 != 0 || Stride < Width)
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoCameraFramePool::SubmitFrame: Ignoring invalid frame %dx%d stride %d"), Width, Height, Stride);
+		NumDroppedFrames.Increment();
+		return FTangoCameraFrameHandle();
+	}
+	TANGO_TRACE_SCOPE("ColorFrame.Copy", Timestamp);
+	FTangoCameraFrame* Frame = AcquireFrame();
+	if (Frame == nullptr)
+	{
+		//All frames are held by consumers that are too slow.
+		NumDroppedFrames.Increment();
+		return FTangoCameraFrameHandle();
+	}
+
+	Frame->InvalidateConversions();
+	//Only (re)allocates if the camera resolution changed, after that the memory of the frame is reused.
+	Frame->Data.SetNumUninitialized(FTangoCameraFrame::GetNV21Size(Width, Height), false);
+	Frame->Width = Width;
+	Frame->Height = Height;
+	Frame->Timestamp = Timestamp;
+	Frame->FrameNumber = FrameNumber;
+
+	uint8* DestY = Frame->Data.GetData();
+	uint8* DestVU = DestY + Width * Height;
+	if (Stride == Width)
+	{
+		FMemory::Memcpy(DestY, Y, Width * Height);
+		FMemory::Memcpy(DestVU, VU, Width * (Height / 2));
+	}
+	else
+	{
+		for (int32 Row = 0; Row < Height; ++Row)
+		{
+			FMemory::Memcpy(DestY + Row * Width, Y + Row * Stride, Width);
+		}
+		for (int32 Row = 0; Row < Height / 2; ++Row)
+		{
+			FMemory::Memcpy(DestVU + Row * Width, VU + Row * Stride, Width);
+		}
+	}
+	return Publish(Frame);
+}
+
+FTangoCameraFrameHandle TangoCameraFramePool::SubmitFrame(const FTangoBackendImage& Image)
+{
+	if (Image.Y == nullptr || Image.VU == nullptr)
+	{
+		NumReceivedFrames.Increment();
+		NumDroppedFrames.Increment();
+		return FTangoCameraFrameHandle();
+	}
+	return SubmitFrame(Image.Y, Image.VU, Image.Width, Image.Height, Image.Stride, Image.Timestamp, Image.FrameNumber);
+}
+
+FTangoCameraFrameHandle TangoCameraFramePool::SubmitSyntheticFrame(int32 Width, int32 Height, double Timestamp)
+{
+	//Moving gradient on Y and a constant tint on VU, so consumers can check orientation and that frames advance.
+	TArray<uint8> Pattern;
+	Pattern.SetNumUninitialized(FTangoCameraFrame::GetNV21Size(Width, Height));
+	const int64 FrameNumber = NextSyntheticFrameNumber++;
+	const int32 Offset = (int32)(FrameNumber % 256);
+	for (int32 Row = 0; Row < Height; ++Row)
+	{
+		uint8* Line = Pattern.GetData() + Row * Width;
+		for (int32 Column = 0; Column < Width; ++Column)
+		{
+			Line[Column] = (uint8)((Column + Row + Offset) & 0xFF);
+		}
+	}
+	uint8* VU = Pattern.GetData() + Width * Height;
+	for (int32 i = 0; i < Width * (Height / 2); i += 2)
+	{
+		VU[i] = 160;
+		VU[i + 1] = 96;
+	}
+	return SubmitFrame(Pattern.GetData(), VU, Width, Height, Width, Timestamp, FrameNumber);
+}
+
+FTangoCameraFrameHandle TangoCameraFramePool::GetLatestFrame() const
+{
+	FScopeLock ScopeLock(&PoolLock);
+	return LatestFrame;
+}
+
+int32 TangoCameraFramePool::GetNumFramesInUse() const
+{
+	FScopeLock ScopeLock(&PoolLock);
+	return PoolSize - FreeFrames.Num();
+}
@@ -0,0 +1,113 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "Object.h"
+#include "TangoBackend.h"
+
+class TangoImagePyramid;
+
+/*
+ * A color camera frame in NV21 layout: a full resolution Y plane followed by an interleaved VU plane
+ * at half resolution. Rows are tightly packed, so the stride is always Width.
+ */
+struct FTangoCameraFrame
+{
+	int32 Width;
+	int32 Height;
+	double Timestamp;
+	int64 FrameNumber;
+	TArray<uint8> Data;
+
+	FTangoCameraFrame()
+		: Width(0)
+		, Height(0)
+		, Timestamp(0.0)
+		, FrameNumber(0)
+	{
+	}
+
+	const uint8* GetY() const { return Data.GetData(); }
+	const uint8* GetVU() const { return Data.GetData() + Width * Height; }
+
+	//Conversions are computed on first request and kept until the frame is reused by the pool. Safe to call from any thread.
+	//Width * Height RGBA8 pixels
+	const TArray<uint8>& GetRGBA8() const;
+	//(Width / 2) * (Height / 2) RGB8 pixels
+	const TArray<uint8>& GetHalfResolutionRGB() const;
+	//(Width / 2) * (Height / 2) luma values
+	const TArray<uint8>& GetHalfResolutionY() const;
+	//The grayscale pyramid of this frame, created empty on first use. Levels are built through TangoImagePyramid::Request and Get.
+	TangoImagePyramid& GetOrCreatePyramid() const;
+
+	//Called by the pool before the frame is overwritten
+	void InvalidateConversions();
+
+	static int32 GetNV21Size(int32 InWidth, int32 InHeight) { return InWidth * InHeight + InWidth * (InHeight / 2); }
+
+private:
+	mutable FCriticalSection ConversionLock;
+	mutable TArray<uint8> RGBA8;
+	mutable TArray<uint8> HalfResolutionRGB;
+	mutable TArray<uint8> HalfResolutionY;
+	mutable bool bHasRGBA8 = false;
+	mutable bool bHasHalfResolutionRGB = false;
+	mutable bool bHasHalfResolutionY = false;
+	mutable TSharedPtr<TangoImagePyramid, ESPMode::ThreadSafe> Pyramid;
+};
+
+//Read-only, reference counted access to a pooled frame. The frame goes back to the pool once the last handle is gone.
+typedef TSharedPtr<const FTangoCameraFrame, ESPMode::ThreadSafe> FTangoCameraFrameHandle;
+
+/*
+ * A fixed number of preallocated frames the camera callback copies into.
+ * If every frame is still held by a consumer the incoming frame is dropped and counted, instead of allocating more memory.
+ */
+class TangoCameraFramePool : public TSharedFromThis<TangoCameraFramePool, ESPMode::ThreadSafe>
+{
+public:
+	TangoCameraFramePool(int32 PoolSize);
+	~TangoCameraFramePool();
+
+	//Copies one frame into the pool. Can be called from any thread. Returns the published frame, or an invalid handle if it was dropped.
+	FTangoCameraFrameHandle SubmitFrame(const uint8* Y, const uint8* VU, int32 Width, int32 Height, int32 Stride, double Timestamp, int64 FrameNumber);
+	//Frames of another format than NV21 come without planes and are counted as dropped.
+	FTangoCameraFrameHandle SubmitFrame(const FTangoBackendImage& Image);
+	//Submits a generated test pattern, so the image stream can be driven without a device.
+	FTangoCameraFrameHandle SubmitSyntheticFrame(int32 Width, int32 Height, double Timestamp);
+
+	//The most recent frame, or an invalid handle if no frame arrived yet.
+	FTangoCameraFrameHandle GetLatestFrame() const;
+
+	int32 GetPoolSize() const { return PoolSize; }
+	int32 GetNumFramesInUse() const;
+	uint64 GetNumReceivedFrames() const { return (uint64)NumReceivedFrames.GetValue(); }
+	uint64 GetNumDroppedFrames() const { return (uint64)NumDroppedFrames.GetValue(); }
+
+private:
+	FTangoCameraFrame* AcquireFrame();
+	void ReleaseFrame(FTangoCameraFrame* Frame);
+	FTangoCameraFrameHandle Publish(FTangoCameraFrame* Frame);
+
+	const int32 PoolSize;
+	mutable FCriticalSection PoolLock;
+	//Frames that nobody holds a handle to. Frames in use are owned by their handles.
+	TArray<FTangoCameraFrame*> FreeFrames;
+	FTangoCameraFrameHandle LatestFrame;
+
+	FThreadSafeCounter64 NumReceivedFrames;
+	FThreadSafeCounter64 NumDroppedFrames;
+	int64 NextSyntheticFrameNumber;
+};
@@ -0,0 +1,113 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoCameraImageState.h"
+
+TangoCameraImageState::TangoCameraImageState()
+	: bFrameAvailable(0)
+	, Version(0)
+	, FrameSequence(0)
+	, Timestamp(0.0)
+	, Slot(INDEX_NONE)
+	, PublishFrame(0)
+	, LastDisplayedSequence(0)
+	, LastFrameLatency(0)
+{
+}
+
+bool TangoCameraImageState::NotifyFrameAvailable()
+{
+	return FPlatformAtomics::InterlockedExchange(&bFrameAvailable, 1) != 0;
+}
+
+bool TangoCameraImageState::ConsumeFrameAvailable()
+{
+	return FPlatformAtomics::InterlockedExchange(&bFrameAvailable, 0) != 0;
+}
+
+int32 TangoCameraImageState::GetNextSlot() const
+{
+	return (Slot + 1) % NumSlots;
+}
+
+void TangoCameraImageState::Publish(double InTimestamp, int32 InSlot, uint32 FrameNumber)
+{
+	FPlatformAtomics::InterlockedIncrement(&Version);
+	Timestamp = InTimestamp;
+	Slot = InSlot;
+	PublishFrame = FrameNumber;
+	++FrameSequence;
+	FPlatformAtomics::InterlockedIncrement(&Version);
+}
+
+void TangoCameraImageState::Reset()
+{
+	FPlatformAtomics::InterlockedExchange(&bFrameAvailable, 0);
+	FPlatformAtomics::InterlockedIncrement(&Version);
+	Timestamp = 0.0;
+	Slot = INDEX_NONE;
+	PublishFrame = 0;
+	FrameSequence = 0;
+	FPlatformAtomics::InterlockedIncrement(&Version);
+	LastDisplayedSequence = 0;
+	LastFrameLatency = 0;
+	TotalFrameLatency.Reset();
+	NumDisplayedFrames.Reset();
+}
+
+FTangoCameraImageSnapshot TangoCameraImageState::GetSnapshot() const
+{
+	FTangoCameraImageSnapshot Result;
+	for (;;)
+	{
+		const int32 Before = Version;
+		FPlatformMisc::MemoryBarrier();
+		if ((Before & 1) != 0)
+		{
+			FPlatformProcess::Yield();
+			continue;
+		}
+		Result.FrameSequence = FrameSequence;
+		Result.Timestamp = Timestamp;
+		Result.Slot = Slot;
+		Result.PublishFrame = PublishFrame;
+		FPlatformMisc::MemoryBarrier();
+		if (Version == Before)
+		{
+			return Result;
+		}
+	}
+}
+
+void TangoCameraImageState::RecordDisplayed(const FTangoCameraImageSnapshot& Image, uint32 FrameNumber)
+{
+	//Several views can show the same image, only the first one counts.
+	const int32 Sequence = (int32)Image.FrameSequence;
+	const int32 Previous = LastDisplayedSequence;
+	if (Image.FrameSequence == 0 || Previous == Sequence || FPlatformAtomics::InterlockedCompareExchange(&LastDisplayedSequence, Sequence, Previous) != Previous)
+	{
+		return;
+	}
+	const int32 Latency = (int32)(FrameNumber - Image.PublishFrame);
+	FPlatformAtomics::InterlockedExchange(&LastFrameLatency, Latency);
+	TotalFrameLatency.Add(Latency);
+	NumDisplayedFrames.Increment();
+}
+
+float TangoCameraImageState::GetAverageFrameLatency() const
+{
+	const int32 Count = NumDisplayedFrames.GetValue();
+	return Count > 0 ? (float)TotalFrameLatency.GetValue() / Count : 0.0f;
+}
@@ -0,0 +1,87 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+//What the camera textures currently show. FrameSequence is 0 until the first frame was copied into them.
+struct FTangoCameraImageSnapshot
+{
+	int64 FrameSequence;
+	double Timestamp;
+	//Texture set of the ring that holds the frame, INDEX_NONE for the set the service writes into.
+	int32 Slot;
+	//Render frame the frame was published in
+	uint32 PublishFrame;
+
+	FTangoCameraImageSnapshot()
+		: FrameSequence(0)
+		, Timestamp(0.0)
+		, Slot(INDEX_NONE)
+		, PublishFrame(0)
+	{
+	}
+};
+
+/*
+ * State of the color camera textures, shared by the Tango callback, the render thread and the game thread.
+ * The service signals new images from its own thread, the render thread consumes that signal, updates the textures and publishes
+ * the frame. Readers never lock: the published frame is guarded by a sequence lock with the render thread as the only writer.
+ *
+ * Published frames go into a ring of texture sets. The render thread runs at most one frame behind the game thread,
+ * so with three slots the slot being written is never one that a frame in flight still samples.
+ */
+class TangoCameraImageState
+{
+public:
+	static const int32 NumSlots = 3;
+
+	TangoCameraImageState();
+
+	//Tango callback thread: the service has an image the textures can be updated with.
+	//Returns true if the previous image was not consumed yet.
+	bool NotifyFrameAvailable();
+	//Render thread: true if an image was signaled since the last call. Clears the signal before the textures are updated, so no image is missed.
+	bool ConsumeFrameAvailable();
+	//Render thread: slot the next frame should be copied into
+	int32 GetNextSlot() const;
+	//Render thread: Slot now holds the image taken at Timestamp.
+	void Publish(double Timestamp, int32 Slot, uint32 FrameNumber);
+	//Back to no data. Only while the render thread does not publish, e.g. before the texture callback is connected.
+	void Reset();
+
+	//Any thread
+	FTangoCameraImageSnapshot GetSnapshot() const;
+	int64 GetFrameSequence() const { return GetSnapshot().FrameSequence; }
+	bool HasData() const { return GetFrameSequence() > 0; }
+
+	//Render thread: a frame showing Image is rendered. Counted once per image.
+	void RecordDisplayed(const FTangoCameraImageSnapshot& Image, uint32 FrameNumber);
+	//Render frames between publishing the last displayed image and showing it
+	int32 GetFrameLatency() const { return LastFrameLatency; }
+	float GetAverageFrameLatency() const;
+
+private:
+	volatile int32 bFrameAvailable;
+	//Odd while Publish is writing
+	volatile int32 Version;
+	int64 FrameSequence;
+	double Timestamp;
+	int32 Slot;
+	uint32 PublishFrame;
+
+	volatile int32 LastDisplayedSequence;
+	volatile int32 LastFrameLatency;
+	FThreadSafeCounter TotalFrameLatency;
+	FThreadSafeCounter NumDisplayedFrames;
+};
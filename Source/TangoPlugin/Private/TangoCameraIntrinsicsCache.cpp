@@ -0,0 +1,150 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoCameraIntrinsicsCache.h"
+#include "TangoDevice.h"
+#include "Async.h"
+
+TangoCameraIntrinsicsCache::TangoCameraIntrinsicsCache()
+	: Generation(1)
+{
+	//Generation 0 marks every slot as stale
+	FMemory::Memzero(Slots, sizeof(Slots));
+}
+
+TangoCameraIntrinsicsCache::~TangoCameraIntrinsicsCache()
+{
+	while (PendingPrefetches.GetValue() > 0)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+}
+
+bool TangoCameraIntrinsicsCache::Get(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics)
+{
+	const int32 Index = (int32)Camera;
+	if (Index < 0 || Index >= NumCameras)
+	{
+		Intrinsics = FTangoCameraIntrinsics();
+		return false;
+	}
+	if (Read(Index, Intrinsics))
+	{
+		return true;
+	}
+	const int32 FetchGeneration = Generation;
+	if (!Fetch(Camera, Intrinsics))
+	{
+		return false;
+	}
+	Write(Index, FetchGeneration, Intrinsics);
+	return true;
+}
+
+void TangoCameraIntrinsicsCache::PrefetchAsync()
+{
+	const int32 FetchGeneration = Generation;
+	PendingPrefetches.Increment();
+	Async<void>(EAsyncExecution::ThreadPool, [this, FetchGeneration]()
+	{
+		int32 NumFetched = 0;
+		for (int32 Camera = 0; Camera < NumCameras; ++Camera)
+		{
+			FTangoCameraIntrinsics Intrinsics;
+			if (Fetch((ETangoCameraType::Type)Camera, Intrinsics))
+			{
+				Write(Camera, FetchGeneration, Intrinsics);
+				NumFetched++;
+			}
+		}
+		UE_LOG(TangoPlugin, Log, TEXT("TangoCameraIntrinsicsCache::PrefetchAsync: Fetched the intrinsics of %d cameras"), NumFetched);
+		PendingPrefetches.Decrement();
+	});
+}
+
+void TangoCameraIntrinsicsCache::Invalidate()
+{
+	FPlatformAtomics::InterlockedIncrement(&Generation);
+}
+
+bool TangoCameraIntrinsicsCache::Read(int32 Camera, FTangoCameraIntrinsics& Intrinsics) const
+{
+	const FSlot& Slot = Slots[Camera];
+	FSlot Copy;
+	for (;;)
+	{
+		const int32 Before = Slot.Sequence;
+		if ((Before & 1) == 0)
+		{
+			FPlatformMisc::MemoryBarrier();
+			FMemory::Memcpy(&Copy, (const void*)&Slot, sizeof(FSlot));
+			FPlatformMisc::MemoryBarrier();
+			if (Slot.Sequence == Before)
+			{
+				break;
+			}
+		}
+	}
+	if (Copy.Generation != Generation)
+	{
+		return false;
+	}
+	Intrinsics.CameraID = (ETangoCameraType::Type)Camera;
+	Intrinsics.CalibrationType = (ETangoCalibrationType::Type)Copy.CalibrationType;
+	Intrinsics.Width = Copy.Width;
+	Intrinsics.Height = Copy.Height;
+	Intrinsics.Cx = Copy.Cx;
+	Intrinsics.Cy = Copy.Cy;
+	Intrinsics.Fx = Copy.Fx;
+	Intrinsics.Fy = Copy.Fy;
+	Intrinsics.Distortion.SetNumUninitialized(ARRAY_COUNT(Copy.Distortion));
+	FMemory::Memcpy(Intrinsics.Distortion.GetData(), Copy.Distortion, sizeof(Copy.Distortion));
+	return true;
+}
+
+void TangoCameraIntrinsicsCache::Write(int32 Camera, int32 FetchGeneration, const FTangoCameraIntrinsics& Intrinsics)
+{
+	FScopeLock ScopeLock(&WriteLock);
+	//Invalidated while the service was queried, the values may belong to the old connection.
+	if (FetchGeneration != Generation)
+	{
+		return;
+	}
+	FSlot& Slot = Slots[Camera];
+	FPlatformAtomics::InterlockedIncrement(&Slot.Sequence);
+	Slot.Generation = FetchGeneration;
+	Slot.CalibrationType = (int32)Intrinsics.CalibrationType;
+	Slot.Width = Intrinsics.Width;
+	Slot.Height = Intrinsics.Height;
+	Slot.Cx = Intrinsics.Cx;
+	Slot.Cy = Intrinsics.Cy;
+	Slot.Fx = Intrinsics.Fx;
+	Slot.Fy = Intrinsics.Fy;
+	for (int32 i = 0; i < ARRAY_COUNT(Slot.Distortion); ++i)
+	{
+		Slot.Distortion[i] = Intrinsics.Distortion.IsValidIndex(i) ? Intrinsics.Distortion[i] : 0.0f;
+	}
+	FPlatformAtomics::InterlockedIncrement(&Slot.Sequence);
+}
+
+bool TangoCameraIntrinsicsCache::Fetch(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics)
+{
+	if (UTangoDevice::Get().GetBackend().GetCameraIntrinsics(Camera, Intrinsics))
+	{
+		return true;
+	}
+	Intrinsics = FTangoCameraIntrinsics();
+	return false;
+}
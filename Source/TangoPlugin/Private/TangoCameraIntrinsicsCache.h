@@ -0,0 +1,64 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoDataTypes.h"
+
+/*
+ * The intrinsics of every camera, queried once per connection to the service.
+ * Reads never take a lock: every slot is a sequence lock, readers retry in the rare case a write overlaps.
+ */
+class TangoCameraIntrinsicsCache
+{
+public:
+	static const int32 NumCameras = 4;
+
+	TangoCameraIntrinsicsCache();
+	~TangoCameraIntrinsicsCache();
+
+	//Can be called from any thread. Queries the service on a miss. Returns false if the service has no intrinsics for the camera.
+	bool Get(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics);
+	//Fetches all cameras on a worker thread, so the first Get does not have to wait for the service.
+	void PrefetchAsync();
+	//Forgets all cached intrinsics, e.g. because the connection or config changed.
+	void Invalidate();
+
+private:
+	struct FSlot
+	{
+		//Odd while the slot is being written
+		volatile int32 Sequence;
+		//Connection the values were fetched for. The slot is stale if this differs from the cache generation.
+		int32 Generation;
+		int32 CalibrationType;
+		int32 Width;
+		int32 Height;
+		int32 Cx;
+		int32 Cy;
+		float Fx;
+		float Fy;
+		float Distortion[5];
+	};
+
+	bool Read(int32 Camera, FTangoCameraIntrinsics& Intrinsics) const;
+	void Write(int32 Camera, int32 FetchGeneration, const FTangoCameraIntrinsics& Intrinsics);
+	static bool Fetch(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics);
+
+	FSlot Slots[NumCameras];
+	volatile int32 Generation;
+	//Only serializes writers
+	FCriticalSection WriteLock;
+	FThreadSafeCounter PendingPrefetches;
+};
@@ -0,0 +1,162 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoClockSync.h"
+#include "TangoDevice.h"
+
+const double TangoClockSync::WindowSeconds = 2.0;
+const double TangoClockSync::MinDriftSpan = 10.0;
+const double TangoClockSync::MaxDrift = 500e-6;
+
+TangoClockSync::TangoClockSync()
+{
+	Reset();
+}
+
+void TangoClockSync::AddSample(double ServiceTimestamp, double ArrivalTime)
+{
+	if (ServiceTimestamp <= 0.0)
+	{
+		return;
+	}
+	const double Sample = ArrivalTime - ServiceTimestamp;
+	FScopeLock ScopeLock(&Lock);
+	if (NumUsedWindows == 0 || ArrivalTime - Windows[CurrentWindow].Start >= WindowSeconds)
+	{
+		CurrentWindow = (CurrentWindow + 1) % NumWindows;
+		Windows[CurrentWindow].Start = ArrivalTime;
+		Windows[CurrentWindow].MinOffset = Sample;
+		Windows[CurrentWindow].Timestamp = ServiceTimestamp;
+		NumUsedWindows = FMath::Min(NumUsedWindows + 1, NumWindows);
+	}
+	else if (Sample < Windows[CurrentWindow].MinOffset)
+	{
+		Windows[CurrentWindow].MinOffset = Sample;
+		Windows[CurrentWindow].Timestamp = ServiceTimestamp;
+	}
+	else
+	{
+		return;
+	}
+	UpdateEstimate();
+}
+
+void TangoClockSync::UpdateEstimate()
+{
+	const double Reference = Windows[CurrentWindow].Timestamp;
+	double MeanX = 0.0;
+	double MeanY = 0.0;
+	double MinX = 0.0;
+	for (int32 i = 0; i < NumUsedWindows; ++i)
+	{
+		const FWindow& Window = Windows[(CurrentWindow + NumWindows - i) % NumWindows];
+		MeanX += Window.Timestamp - Reference;
+		MeanY += Window.MinOffset;
+		MinX = FMath::Min(MinX, Window.Timestamp - Reference);
+	}
+	MeanX /= NumUsedWindows;
+	MeanY /= NumUsedWindows;
+
+	double Drift = 0.0;
+	if (-MinX >= MinDriftSpan)
+	{
+		double Covariance = 0.0;
+		double Variance = 0.0;
+		for (int32 i = 0; i < NumUsedWindows; ++i)
+		{
+			const FWindow& Window = Windows[(CurrentWindow + NumWindows - i) % NumWindows];
+			const double X = Window.Timestamp - Reference - MeanX;
+			Covariance += X * (Window.MinOffset - MeanY);
+			Variance += X * X;
+		}
+		Drift = Variance > 0.0 ? FMath::Clamp(Covariance / Variance, -MaxDrift, MaxDrift) : 0.0;
+	}
+	//Lowest line with that slope that is still at or below every minimum
+	double Offset = DBL_MAX;
+	for (int32 i = 0; i < NumUsedWindows; ++i)
+	{
+		const FWindow& Window = Windows[(CurrentWindow + NumWindows - i) % NumWindows];
+		Offset = FMath::Min(Offset, Window.MinOffset - Drift * (Window.Timestamp - Reference));
+	}
+	Estimate.bIsValid = true;
+	Estimate.Offset = Offset;
+	Estimate.Drift = Drift;
+	Estimate.ReferenceTimestamp = Reference;
+	Estimate.NumWindows = NumUsedWindows;
+}
+
+bool TangoClockSync::ServiceToEngineTime(double ServiceTimestamp, double& EngineTime) const
+{
+	FScopeLock ScopeLock(&Lock);
+	if (!Estimate.bIsValid)
+	{
+		return false;
+	}
+	EngineTime = ServiceTimestamp + Estimate.Offset + Estimate.Drift * (ServiceTimestamp - Estimate.ReferenceTimestamp);
+	return true;
+}
+
+bool TangoClockSync::EngineToServiceTime(double EngineTime, double& ServiceTimestamp) const
+{
+	FScopeLock ScopeLock(&Lock);
+	if (!Estimate.bIsValid)
+	{
+		return false;
+	}
+	ServiceTimestamp = (EngineTime - Estimate.Offset + Estimate.Drift * Estimate.ReferenceTimestamp) / (1.0 + Estimate.Drift);
+	return true;
+}
+
+FTangoClockEstimate TangoClockSync::GetEstimate() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Estimate;
+}
+
+void TangoClockSync::Reset()
+{
+	FScopeLock ScopeLock(&Lock);
+	CurrentWindow = 0;
+	NumUsedWindows = 0;
+	Estimate = FTangoClockEstimate();
+}
+
+/*
+ * Tango.ClockSync
+ * Prints the current estimate of the service clock relative to the engine clock.
+ */
+namespace
+{
+	void PrintClockSync()
+	{
+		const TangoClockSync& Clock = UTangoDevice::Get().ClockSync;
+		const FTangoClockEstimate Estimate = Clock.GetEstimate();
+		if (!Estimate.bIsValid)
+		{
+			UE_LOG(TangoPlugin, Log, TEXT("Tango.ClockSync: No samples yet"));
+			return;
+		}
+		double ServiceNow = 0.0;
+		Clock.EngineToServiceTime(FPlatformTime::Seconds(), ServiceNow);
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.ClockSync: offset %.6f s at service time %.6f, drift %.1f ppm over %d windows, service time now %.6f"),
+			Estimate.Offset, Estimate.ReferenceTimestamp, Estimate.Drift * 1e6, Estimate.NumWindows, ServiceNow);
+	}
+
+	static FAutoConsoleCommand ClockSyncCommand(
+		TEXT("Tango.ClockSync"),
+		TEXT("Prints the estimated offset and drift between the service clock and the engine clock"),
+		FConsoleCommandDelegate::CreateStatic(&PrintClockSync));
+}
@@ -0,0 +1,77 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#pragma once
+
+struct FTangoClockEstimate
+{
+	bool bIsValid = false;
+	//Engine time minus service time at ReferenceTimestamp, in seconds
+	double Offset = 0.0;
+	//Change of the offset per second of service time
+	double Drift = 0.0;
+	double ReferenceTimestamp = 0.0;
+	//Windows the estimate is based on
+	int32 NumWindows = 0;
+};
+
+/*
+ * Relates the timestamps of the service, seconds since the device booted, to FPlatformTime::Seconds.
+ * Every callback is a sample of arrival time minus timestamp, which is the clock offset plus the delivery delay.
+ * Only the smallest sample of each window of a few seconds is kept, as it has the least delay. A line fitted through
+ * these minimums gives the drift, and it is then moved down to the lowest of them, so it follows the fastest deliveries.
+ * Converted times are therefore when an update would have arrived on the fastest delivery seen, not when it was captured.
+ * All times are doubles, the service timestamps lose milliseconds as floats after a day of uptime.
+ */
+class TangoClockSync
+{
+public:
+	TangoClockSync();
+
+	//Any thread. ArrivalTime is FPlatformTime::Seconds when the callback for the update with ServiceTimestamp ran.
+	void AddSample(double ServiceTimestamp, double ArrivalTime);
+	//Both are false until the first sample arrived
+	bool ServiceToEngineTime(double ServiceTimestamp, double& EngineTime) const;
+	bool EngineToServiceTime(double EngineTime, double& ServiceTimestamp) const;
+	FTangoClockEstimate GetEstimate() const;
+	//Forgets all samples, e.g. because the service was (re)connected
+	void Reset();
+
+private:
+	static const int32 NumWindows = 32;
+	//Old minimums age out, so the estimate follows when the clocks are reset
+	static const double WindowSeconds;
+	//The drift is only estimated once the windows span this many seconds, before that it is 0
+	static const double MinDriftSpan;
+	//Larger drifts are no clock drift but a change in delivery, and are clamped
+	static const double MaxDrift;
+
+	struct FWindow
+	{
+		double Start;
+		double MinOffset;
+		//Service timestamp of the sample with MinOffset
+		double Timestamp;
+	};
+
+	//Called with the lock held
+	void UpdateEstimate();
+
+	mutable FCriticalSection Lock;
+	FWindow Windows[NumWindows];
+	int32 CurrentWindow;
+	int32 NumUsedWindows;
+	FTangoClockEstimate Estimate;
+};
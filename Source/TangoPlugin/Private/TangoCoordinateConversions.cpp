@@ -15,62 +15,42 @@ limitations under the License.*/
 #include "TangoPluginPrivatePCH.h"
 #include "TangoCoordinateConversions.h"
 #include "TangoDevice.h"
-#include "TangoFromToCObject.h"
+#include "TangoExtrinsicsCache.h"
 
-#if PLATFORM_ANDROID
-#include "tango_client_api.h"
-#endif
+#include "Async.h"
 
 namespace 
 {
 
 	static TMap<ETangoCoordinateFrameType::Type, TMap<ETangoCoordinateFrameType::Type, TangoSpaceConversions::TangoSpaceConversionPair>> TangoSpaceConversionPairMapper;
 
-	static bool bMatricesArePrepared = false;
+	//Guards the mapper, it is rebuilt from the extrinsics check running on a worker thread.
+	static FCriticalSection MapperLock;
 
-	static bool GetOffsetMatrix(FTangoCoordinateFramePair Pair,FMatrix& Matrix)
-	{
-#if PLATFORM_ANDROID
-		TangoPoseData Result;
-		TangoErrorType ResultOfServiceCall;
-		ResultOfServiceCall = TangoService_getPoseAtTime(0.0, ToCObject(Pair), &Result);
-		FTangoPoseData D = FromCPointer(&Result);
-		Matrix = FTransform(D.QuatRotation, D.Position).ToMatrixNoScale();
-		if (!(ResultOfServiceCall == TANGO_SUCCESS && D.StatusCode == ETangoPoseStatus::VALID))
-		{
-			UE_LOG(TangoPlugin, Warning, TEXT("TangoSpaceConversions::GetOffsetMatrix: failed for %d and %d"), (int32)(Pair.BaseFrame), (int32)(Pair.TargetFrame));
-		}
-		return (ResultOfServiceCall == TANGO_SUCCESS && D.StatusCode == ETangoPoseStatus::VALID);
-#else
-		Matrix.SetIdentity();
-		return true;
-#endif
-	}
+	//Read without MapperLock by PrepareMatrices, so only accessed through the interlocked functions below
+	static volatile int32 bMatricesArePrepared = 0;
+	static bool bCacheWasChecked = false;
+	static FTangoDeviceExtrinsics CurrentExtrinsics;
+	//Bumped whenever the conversions are built from valid extrinsics
+	static FThreadSafeCounter ExtrinsicsGeneration;
 
-	static bool PrepareMatrices()
+	//While the extrinsics are unavailable we don't want to hit the service on every single query.
+	static const double ServiceRetryInterval = 0.5;
+	static double LastServiceQueryTime = -1.0;
+
+	static void BuildConversionPairs(const FTangoDeviceExtrinsics& Extrinsics)
 	{
-		if (bMatricesArePrepared)
-		{
-			return true;
-		}
 		FMatrix ADFtoUE;
 		FMatrix DEVICEtoUE;
 		FMatrix IMUtoUE;
 		FMatrix COLORtoUE;
 		FMatrix DISPLAYtoUE;
 
-		FMatrix IMUtoDEVICE;
-		FMatrix IMUtoCOLOR;
-		FMatrix IMUtoDEPTH;
-		FMatrix IMUtoFISHEYE;
+		const FMatrix& IMUtoDEVICE = Extrinsics.IMUtoDEVICE;
+		const FMatrix& IMUtoCOLOR = Extrinsics.IMUtoCOLOR;
+		const FMatrix& IMUtoFISHEYE = Extrinsics.IMUtoFISHEYE;
 		//FMatrix IMUtoDISPLAY;
 
-		bool bSuccess = GetOffsetMatrix(FTangoCoordinateFramePair(ETangoCoordinateFrameType::IMU, ETangoCoordinateFrameType::DEVICE), IMUtoDEVICE);
-		bSuccess = bSuccess && GetOffsetMatrix(FTangoCoordinateFramePair(ETangoCoordinateFrameType::IMU, ETangoCoordinateFrameType::CAMERA_COLOR), IMUtoCOLOR);
-		bSuccess = bSuccess && GetOffsetMatrix(FTangoCoordinateFramePair(ETangoCoordinateFrameType::IMU, ETangoCoordinateFrameType::CAMERA_FISHEYE), IMUtoFISHEYE);
-		bSuccess = bSuccess && GetOffsetMatrix(FTangoCoordinateFramePair(ETangoCoordinateFrameType::IMU, ETangoCoordinateFrameType::CAMERA_DEPTH), IMUtoDEPTH);
-		//bSuccess = bSuccess && GetOffsetMatrix(FTangoCoordinateFramePair(ETangoCoordinateFrameType::IMU, ETangoCoordinateFrameType::DISPLAY), IMUtoDISPLAY);
-
 		FMatrix DEVICEtoIMU = IMUtoDEVICE.Inverse();
 
 		ADFtoUE = FMatrix::Identity;ADFtoUE.M[0][0] = 0;ADFtoUE.M[1][1] = 0;ADFtoUE.M[2][2] = 0;
@@ -165,15 +145,180 @@ namespace
 				TangoSpaceConversionPairMapper.FindOrAdd(P.Pair.BaseFrame).Emplace(P.Pair.TargetFrame, P);
 			}
 		}
+		//Callers hold MapperLock, so whoever sees the new generation also finds the new pairs
+		if (Extrinsics.bIsValid)
+		{
+			ExtrinsicsGeneration.Increment();
+		}
+	}
+
+	//Full barriers: a thread that sees the flag set also sees the pairs and extrinsics written before it
+	static bool AreMatricesPrepared()
+	{
+		return FPlatformAtomics::InterlockedCompareExchange(&bMatricesArePrepared, 0, 0) != 0;
+	}
+
+	static void SetMatricesPrepared(bool bPrepared)
+	{
+		FPlatformAtomics::InterlockedExchange(&bMatricesArePrepared, bPrepared ? 1 : 0);
+	}
+
+	//Set while a thread loads or queries the extrinsics in PrepareMatrices
+	static volatile int32 bIsPreparing = 0;
+
+	//Unless other extrinsics were published in the meantime. Invalid ones still provide the conversions that need no offsets.
+	static bool PublishExtrinsics(const FTangoDeviceExtrinsics& Extrinsics)
+	{
+		FScopeLock ScopeLock(&MapperLock);
+		if (AreMatricesPrepared())
+		{
+			return true;
+		}
+		BuildConversionPairs(Extrinsics);
+		if (Extrinsics.bIsValid)
+		{
+			CurrentExtrinsics = Extrinsics;
+			SetMatricesPrepared(true);
+		}
+		return Extrinsics.bIsValid;
+	}
+
+	static bool PrepareMatrices()
+	{
+		if (AreMatricesPrepared())
+		{
+			return true;
+		}
+		//Loading and querying can block on the disk or the service. The render and synchronizer threads take MapperLock
+		//for every conversion, so this happens outside of it, on one thread at a time. The others don't wait for it.
+		if (FPlatformAtomics::InterlockedCompareExchange(&bIsPreparing, 1, 0) != 0)
+		{
+			return false;
+		}
+		bool bCheckCache;
+		{
+			FScopeLock ScopeLock(&MapperLock);
+			bCheckCache = !bCacheWasChecked;
+			bCacheWasChecked = true;
+		}
+
+		FTangoDeviceExtrinsics Extrinsics;
+		bool bSuccess = false;
+		//Try the extrinsics persisted from a previous session first, they are verified asynchronously once connected.
+		if (bCheckCache)
+		{
+			const uint32 CalibrationHash = UTangoDevice::Get().GetBackend().IsConnected() ? TangoExtrinsicsCache::QueryCalibrationHash() : 0;
+			bSuccess = TangoExtrinsicsCache::Load(Extrinsics, CalibrationHash) && PublishExtrinsics(Extrinsics);
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		if (!bSuccess && (LastServiceQueryTime < 0.0 || Now - LastServiceQueryTime >= ServiceRetryInterval))
+		{
+			LastServiceQueryTime = Now;
+			Extrinsics = FTangoDeviceExtrinsics();
+			const bool bQueried = TangoExtrinsicsCache::QueryFromService(Extrinsics);
+			bSuccess = PublishExtrinsics(Extrinsics);
+			if (bQueried)
+			{
+				TangoExtrinsicsCache::Save(Extrinsics);
+			}
+		}
+
+		FPlatformAtomics::InterlockedExchange(&bIsPreparing, 0);
+		return bSuccess || AreMatricesPrepared();
+	}
+}
+
+void TangoSpaceConversions::LoadCachedExtrinsics()
+{
+	PrepareMatrices();
+}
+
+void TangoSpaceConversions::VerifyExtrinsicsAsync()
+{
+	Async<void>(EAsyncExecution::ThreadPool, []()
+	{
+		FTangoDeviceExtrinsics Extrinsics;
+		if (!TangoExtrinsicsCache::QueryFromService(Extrinsics))
+		{
+			UE_LOG(TangoPlugin, Warning, TEXT("TangoSpaceConversions::VerifyExtrinsicsAsync: Service did not provide extrinsics yet, keeping the cached ones."));
+			return;
+		}
+		{
+			FScopeLock ScopeLock(&MapperLock);
+			if (AreMatricesPrepared() && CurrentExtrinsics.Equals(Extrinsics))
+			{
+				return;
+			}
+			UE_LOG(TangoPlugin, Log, TEXT("TangoSpaceConversions::VerifyExtrinsicsAsync: Extrinsics changed, updating cache."));
+			CurrentExtrinsics = Extrinsics;
+			BuildConversionPairs(CurrentExtrinsics);
+			SetMatricesPrepared(true);
+		}
+		TangoExtrinsicsCache::Save(Extrinsics);
+	});
+}
+
+bool TangoSpaceConversions::AreExtrinsicsAvailable()
+{
+	return PrepareMatrices();
+}
 
-		bMatricesArePrepared = bSuccess;
-		return bSuccess;
+int32 TangoSpaceConversions::GetExtrinsicsGeneration()
+{
+	return ExtrinsicsGeneration.GetValue();
+}
+
+bool TangoSpaceConversions::GetExtrinsics(FTangoDeviceExtrinsics& Extrinsics)
+{
+	if (!PrepareMatrices())
+	{
+		return false;
+	}
+	FScopeLock ScopeLock(&MapperLock);
+	Extrinsics = CurrentExtrinsics;
+	return CurrentExtrinsics.bIsValid;
+}
+
+void TangoSpaceConversions::SetExtrinsics(const FTangoDeviceExtrinsics& Extrinsics)
+{
+	FScopeLock ScopeLock(&MapperLock);
+	CurrentExtrinsics = Extrinsics;
+	BuildConversionPairs(CurrentExtrinsics);
+	bCacheWasChecked = true;
+	SetMatricesPrepared(true);
+}
+
+bool TangoSpaceConversions::PrepareOfflineExtrinsics(uint32 CalibrationHash)
+{
+	FTangoDeviceExtrinsics Extrinsics;
+	if (CalibrationHash != 0)
+	{
+		if (TangoExtrinsicsCache::Load(Extrinsics, CalibrationHash))
+		{
+			SetExtrinsics(Extrinsics);
+			return true;
+		}
 	}
+	else if (GetExtrinsics(Extrinsics))
+	{
+		return true;
+	}
+	//The cameras look out of the back of the device
+	const FMatrix IMUtoCamera = FTransform(FQuat(1.0f, 0.0f, 0.0f, 0.0f)).ToMatrixNoScale();
+	Extrinsics.IMUtoDEVICE = FMatrix::Identity;
+	Extrinsics.IMUtoCOLOR = IMUtoCamera;
+	Extrinsics.IMUtoFISHEYE = IMUtoCamera;
+	Extrinsics.IMUtoDEPTH = IMUtoCamera;
+	Extrinsics.bIsValid = true;
+	SetExtrinsics(Extrinsics);
+	return false;
 }
 
 bool TangoSpaceConversions::GetSpaceConversionPair(TangoSpaceConversionPair& Pair, const FTangoCoordinateFramePair& RefPair)
 {
 	bool bResult = PrepareMatrices();
+	FScopeLock ScopeLock(&MapperLock);
 	bResult = bResult && TangoSpaceConversionPairMapper.Contains(RefPair.BaseFrame);
 	if (bResult)
 	{
@@ -205,4 +350,10 @@ void TangoSpaceConversions::ModifyPose(FTangoPoseData& Pose, const TangoSpaceCon
 		Pose.Rotation = Transform.GetRotation().Rotator();
 		Pose.FrameOfReference = Converter.Pair;
 	}
+}
+
+FMatrix TangoSpaceConversions::GetTangoSpaceMatrix(const FTangoPoseData& Pose, const TangoSpaceConversionPair& Converter)
+{
+	const FMatrix Modified = FTransform(Pose.QuatRotation, Pose.Position / UTangoDevice::Get().GetMetersToWorldScale()).ToMatrixNoScale();
+	return (Converter.TargetFrameToUE * Converter.OffsetFromDevice).Inverse() * Modified * Converter.UEtoBaseFrame.Inverse();
 }
\ No newline at end of file
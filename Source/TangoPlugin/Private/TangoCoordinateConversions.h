@@ -15,6 +15,8 @@ limitations under the License.*/
 #pragma once
 #include "TangoDataTypes.h"
 
+struct FTangoDeviceExtrinsics;
+
 class TangoSpaceConversions
 {
 public:
@@ -31,4 +33,22 @@ public:
 	static bool GetSpaceConversionPair(TangoSpaceConversionPair& Pair,const FTangoCoordinateFramePair& RefPair);
 	
 	static void ModifyPose(FTangoPoseData& Pose, const TangoSpaceConversionPair& Converter);
+	//Undoes ModifyPose for a pose that was queried from the device: returns the raw Tango space pose in meters as a matrix.
+	static FMatrix GetTangoSpaceMatrix(const FTangoPoseData& Pose, const TangoSpaceConversionPair& Converter);
+
+	//Prepares the conversions from the extrinsics cached on disk so they work before the service is connected.
+	static void LoadCachedExtrinsics();
+	//Re-queries the extrinsics from the connected service on a worker thread and updates the cache if they changed.
+	static void VerifyExtrinsicsAsync();
+	//Tries to prepare the conversions, at most every half second while the service has no extrinsics.
+	static bool AreExtrinsicsAvailable();
+	//Changes whenever the conversions are rebuilt from new extrinsics, so cached conversion pairs can be fetched again.
+	static int32 GetExtrinsicsGeneration();
+	//The IMU to sensor offsets the conversions are currently built from. Returns false if they are not known yet.
+	static bool GetExtrinsics(FTangoDeviceExtrinsics& Extrinsics);
+	//Builds the conversions from known offsets, e.g. for offline processing without a service. Not written to the cache.
+	static void SetExtrinsics(const FTangoDeviceExtrinsics& Extrinsics);
+	//For tools without a service: falls back to cameras in the device origin if no extrinsics are known. Returns false if it had to.
+	//CalibrationHash selects the cached extrinsics of that calibration, see TangoExtrinsicsCache::HashCalibration. 0 takes the latest ones.
+	static bool PrepareOfflineExtrinsics(uint32 CalibrationHash = 0);
 };
\ No newline at end of file
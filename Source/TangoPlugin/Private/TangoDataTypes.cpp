@@ -53,6 +53,7 @@ FTangoPoseData::FTangoPoseData(FVector NewPosition, FRotator NewRotation, FQuat
 	FrameOfReference = NewFrameOfReference;
 	StatusCode = NewStatusCode;
 	Timestamp = NewTimestamp;
+	PreciseTimestamp = NewTimestamp;
 }
 
 FTangoAreaDescriptionMetaData::FTangoAreaDescriptionMetaData(const FString InFileName, const int32 InMillisecondsSinceUnixEpoch, const FTransform InTransformation)
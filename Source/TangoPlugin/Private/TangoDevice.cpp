@@ -14,6 +14,10 @@ limitations under the License.*/
 #include "TangoPluginPrivatePCH.h"
 #include "TangoDevice.h"
 #include "TangoFromToCObject.h"
+#include "TangoAndroidBackend.h"
+#include "TangoHeadlessBackend.h"
+#include "TangoStats.h"
+#include "TangoTracer.h"
 
 #include <UnrealTemplate.h>
 
@@ -33,9 +37,6 @@ UTangoDevice::UTangoDevice() : UObject(), FTickableGameObject()
 	MotionHelper = nullptr;
 	ImageHelper = nullptr;
 	AreaHelper = nullptr;
-#if PLATFORM_ANDROID
-    AppContextReference = nullptr;
-#endif
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::UTangoDevice: Instantiating TangoDevice FINISHED"));
 }
 
@@ -51,74 +52,20 @@ void UTangoDevice::ProperInitialize()
 #if PLATFORM_ANDROID
 	FCoreDelegates::ApplicationHasEnteredForegroundDelegate.AddUObject(this, &UTangoDevice::AppServiceResume);
 	FCoreDelegates::ApplicationWillEnterBackgroundDelegate.AddUObject(this, &UTangoDevice::AppServicePause);
-	Config_ = nullptr;
+	Backend = MakeShareable(new TangoAndroidBackend());
+#else
+	Backend = MakeShareable(new TangoHeadlessBackend());
 #endif
+	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::ProperInitialize: Using the %s backend"), Backend->GetName());
+	TangoSpaceConversions::LoadCachedExtrinsics();
 
 	bHasBeenPropelyInitialized = true;
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::ProperInitialize: FINISHED"));
 }
 
-#if PLATFORM_ANDROID
-/*
- *  This function will populate the AppContextReference object with the Application context using a call to Java code via the JNI.
- *  @TODO: Investigate whether we need to call this on every connection or whether we can get away with only
- * triggering it once on app startup (i.e. will the application context switch? Is the bad global reference we
- * experienced when calling only at TangoDevice startup due to local references from the Unreal JNI pipeline being
- * converted into globals incorrectly, or because the Application context which is being pointed to has changed?)
- */
-void UTangoDevice::PopulateAppContext()
-{
-    jobject AppContext = NULL;
-
-    if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
-    {
-        //We identify the method we need to call, by passing the name of the function.
-        static jmethodID Method = FJavaWrapper::FindMethod(Env, FJavaWrapper::GameActivityClassID, "AndroidThunkJava_GetAppContext", "()Landroid/content/Context;", false);
-        //Once jmethodID has been identified, we supply it as an argument to CallObjectMethod.
-        //Use CallObjectMethod for functions which return a jobject, CallIntMethod for functions which return an int, etc.
-        AppContext = FJavaWrapper::CallObjectMethod(Env, FJavaWrapper::GameActivityThis, Method);
-        
-        if (AppContext == NULL)
-        {
-            UE_LOG(LogTemp, Warning, TEXT("UTangoDevice::PopulateAppContext: Error - app context is still NULL after retrieval call!"));
-            AppContextReference = nullptr;
-        }
-        else
-        {
-            UE_LOG(LogTemp, Warning, TEXT("UTangoDevice::PopulateAppContext: Success - appcontext jobject is not null!!"));
-            //Now we cache the activity for later use to prevent garbage collection
-            AppContextReference = Env->NewGlobalRef(AppContext);
-        }
-    }
-    
-    return;
-}
-
-void UTangoDevice::DePopulateAppContext()
-{
-    if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
-    {
-        Env->DeleteGlobalRef(AppContextReference);
-    }
-    else
-    {
-        UE_LOG(LogTemp, Warning, TEXT("UTangoDevice::PopulateAppContext: Success - appcontext jobject is not null!!"));
-    }
-    
-}
-#endif
-
 void UTangoDevice::DeallocateResources()
 {
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::DeallocateResources: Called"));
-#if PLATFORM_ANDROID
-	if (Config_ != nullptr)
-	{
-		TangoConfig_free(Config_);
-		Config_ = nullptr;
-        DePopulateAppContext();
-	}
-#endif
 	if (GetTangoDevicePointCloudPointer() != nullptr)
 	{
 		delete GetTangoDevicePointCloudPointer();
@@ -157,6 +104,8 @@ bool UTangoDevice::IsTickable() const
 
 void UTangoDevice::Tick(float DeltaTime)
 {
+	SCOPE_CYCLE_COUNTER(STAT_TangoDeviceTick);
+	TANGO_TRACE_SCOPE("Device.Tick", 0.0);
 	if (GetTangoDeviceImagePointer())
 	{
 		GetTangoDeviceImagePointer()->TickByDevice();
@@ -166,11 +115,12 @@ void UTangoDevice::Tick(float DeltaTime)
 		GetTangoDevicePointCloudPointer()->TickByDevice();
 	}
 	BroadCastEvents();
+	BroadCastStreamStalls();
 }
 
 TStatId UTangoDevice::GetStatId() const
 {
-	return TStatId();
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTangoDevice, STATGROUP_Tango);
 }
 
 UTangoDevice& UTangoDevice::Get()
@@ -236,43 +186,29 @@ void UTangoDevice::StartTangoService(FTangoConfig & Config, FTangoRuntimeConfig&
 {
 	CurrentConfig = Config;
 	CurrentRuntimeConfig = RuntimeConfig;
-#if PLATFORM_ANDROID
 	ConnectTangoService();
-#endif
 }
 
 
 bool UTangoDevice::SetTangoRuntimeConfig(FTangoRuntimeConfig Configuration, bool bPreRuntime)
 {
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::SetTangoRuntimeConfig: Called."));
-#if PLATFORM_ANDROID
-	if (Config_ == nullptr)
-	{
-		UE_LOG(TangoPlugin, Error, TEXT("UTangoDevice::SetTangoRuntimeConfig: Unable to set runtime Config Tango Config pointer is nullptr."));
-		return false;
-	}
 	if(!bPreRuntime && !IsTangoServiceRunning() )
 	{
 		UE_LOG(TangoPlugin, Error, TEXT("UTangoDevice::SetTangoRuntimeConfig: Unable to set runtime Config since Tango Service is not running."));
 		return false;
 	}
-
-#endif
 	bool bSuccess = true;
 	if (Configuration.bEnableDepth && !CurrentConfig.bEnableDepthCapabilities)
 	{
 		Configuration.bEnableDepth = false;
 		UE_LOG(TangoPlugin, Warning, TEXT("UTangoDevice::SetTangoRuntimeConfig: Unable to set EnableDepth to RuntimeConfig since Config has no DepthCapabilites enabled"));
 	}
-#if PLATFORM_ANDROID
-	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::SetTangoRuntimeConfig: Rate is: %d "),(Configuration.bEnableDepth ? Configuration.RuntimeDepthFramerate : 0));
-	bSuccess = TangoConfig_setInt32(Config_, "config_runtime_depth_framerate", Configuration.bEnableDepth ? Configuration.RuntimeDepthFramerate : 0) == TANGO_SUCCESS && bSuccess;
+	//Before the connection the backend gets the runtime config with Connect
 	if (!bPreRuntime)
 	{
-		UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::SetTangoRuntimeConfig: TangoService_setRuntimeConfig"));
-		bSuccess = TangoService_setRuntimeConfig(Config_) && bSuccess;
+		bSuccess = Backend->SetRuntimeConfig(Configuration) && bSuccess;
 	}
-#endif
 
 
 	if (Configuration.bEnableColorCamera  && !CurrentConfig.bEnableColorCameraCapabilities)
@@ -285,7 +221,7 @@ bool UTangoDevice::SetTangoRuntimeConfig(FTangoRuntimeConfig Configuration, bool
 		GetTangoDeviceImagePointer()->setRuntimeConfig(Configuration);
 	}
 	CurrentRuntimeConfig = Configuration;
-
+	StreamMonitor.SetRuntimeConfig(CurrentRuntimeConfig);
 
 	return bSuccess;
 }
@@ -294,9 +230,7 @@ bool UTangoDevice::SetTangoRuntimeConfig(FTangoRuntimeConfig Configuration, bool
 void UTangoDevice::StopTangoService()
 {
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::StopTangoService: Called"));
-#if PLATFORM_ANDROID
 	DisconnectTangoService();
-#endif
 }
 
 FTangoConfig& UTangoDevice::GetCurrentConfig()
@@ -316,18 +250,10 @@ float UTangoDevice::GetMetersToWorldScale()
 
 FTangoCameraIntrinsics UTangoDevice::GetCameraIntrinsics(TEnumAsByte<ETangoCameraType::Type> CameraID)
 {
-#if PLATFORM_ANDROID
-
-	TangoCameraIntrinsics DeviceIntrinsics;
-	TangoErrorType RequestResult = TangoService_getCameraIntrinsics((TangoCameraId)(int)CameraID, &DeviceIntrinsics);
-	if (RequestResult == TANGO_SUCCESS)
-	{
-		return FromCObject(DeviceIntrinsics);
-	}
-#endif
-
-	//If we're not on Android, or the request result was not successful, just return an empty struct
-	return FTangoCameraIntrinsics();
+	//If we're not on Android, or the service has no intrinsics for this camera, this stays an empty struct
+	FTangoCameraIntrinsics Result;
+	CameraIntrinsicsCache.Get(CameraID, Result);
+	return Result;
 }
 
 bool UTangoDevice::IsLearningModeEnabled()
@@ -337,52 +263,10 @@ bool UTangoDevice::IsLearningModeEnabled()
 //END - Core Tango functions
 
 //BEGIN - Platform Only Functions
-#if PLATFORM_ANDROID
-
-bool UTangoDevice::ApplyConfig()
-{
-	if (IsTangoServiceRunning())
-	{
-		UE_LOG(TangoPlugin, Error, TEXT(" UTangoDevice::ApplyConfig: Cannot ApplyConfig while TangoService is running!"));
-		return false;
-	}
-	//Setting Up the Config:
-	if (Config_ == nullptr)
-	{
-		Config_ = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
-		if (Config_ == nullptr)
-		{
-			UE_LOG(TangoPlugin, Error, TEXT(" UTangoDevice::ApplyConfig: SetConfig FAILED because TangoService_getConfig did return nullptr!"));
-			return false;
-		}
-	}
-
-	bool bSuccess = true;
-	bSuccess = TangoConfig_setBool(Config_, "config_enable_auto_recovery", CurrentConfig.bEnableAutoRecovery) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setBool(Config_, "config_enable_color_camera", CurrentConfig.bEnableColorCameraCapabilities) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setBool(Config_, "config_color_mode_auto", CurrentConfig.bColorModeAuto) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setBool(Config_, "config_enable_depth", CurrentConfig.bEnableDepthCapabilities) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setBool(Config_, "config_high_rate_pose", CurrentConfig.bHighRatePose) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setBool(Config_, "config_enable_learning_mode", CurrentConfig.bEnableLearningMode) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setBool(Config_, "config_enable_low_latency_imu_integration", CurrentConfig.bLowLatencyIMUIntegration) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setBool(Config_, "config_enable_motion_tracking", CurrentConfig.bEnableMotionTracking) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setBool(Config_, "config_smooth_pose", CurrentConfig.bSmoothPose) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setInt32(Config_, "config_color_exp", CurrentConfig.ColorExposure) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setInt32(Config_, "config_color_iso", CurrentConfig.ColorISO) == TANGO_SUCCESS	&& bSuccess;
-	bSuccess = TangoConfig_setString(Config_, "config_load_area_description_UUID", TCHAR_TO_ANSI(*CurrentConfig.AreaDescription.UUID)) == TANGO_SUCCESS	&& bSuccess;
-	
-	if (!bSuccess)
-	{
-		UE_LOG(TangoPlugin, Warning, TEXT(" UTangoDevice::ApplyConfig: ApplyConfig FAILED because the Config parameters could not be set."));
-	}
-
-	bSuccess = SetTangoRuntimeConfig(CurrentRuntimeConfig,true) && bSuccess;
-
-	return bSuccess;
-}
 
 /*
- * This function sends a request to the Java layer to start the Tango service
+ * This function sends a request to the Java layer to start the Tango service.
+ * Other platforms have no service to bind, the headless backend is connected right away.
  */
 void UTangoDevice::ConnectTangoService()
 {
@@ -405,11 +289,21 @@ void UTangoDevice::ConnectTangoService()
     {
         UE_LOG(TangoPlugin, Error, TEXT("UTangoDevice::ConnectTangoService: Could not get Java environment!"));
     }
+#else
+	if (TangoHeadlessBackend::IsEnabled())
+	{
+		CompleteConnectionToService();
+	}
+	else
+	{
+		UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::ConnectTangoService: No Tango service on this platform, set Tango.Headless.Enable to use the headless backend."));
+	}
 #endif
     UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::ConnectTangoService: Finished sevice binding request call."));
 
 }
 
+#if PLATFORM_ANDROID
 /*
  * This function sends a request to the Java layer to start the Tango service
  */
@@ -420,7 +314,6 @@ void UTangoDevice::UnbindTangoService()
     UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::UnbindTangoService: starting service unbinding request call."));
     //Make the call to Java
     
-#if PLATFORM_ANDROID
     jobject AppContext = NULL;
     
     if (JNIEnv* Env = FAndroidApplication::GetJavaEnv())
@@ -434,13 +327,10 @@ void UTangoDevice::UnbindTangoService()
     {
         UE_LOG(TangoPlugin, Error, TEXT("UTangoDevice::UnbindTangoService: Could not get Java environment!"));
     }
-#endif
     UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::UnbindTangoService: Finished sevice unbinding request call."));
     
 }
 
-
-#if PLATFORM_ANDROID
 extern "C"
 {
     //JavaThunkCpp: Native function which is called by Java code. Completes connection to the Tango service.
@@ -452,47 +342,35 @@ extern "C"
         UTangoDevice::Get().BindAndCompleteConnectionToService(Env, IBinder);
     }
 }
-#endif
 
-#if PLATFORM_ANDROID
 /*
  *  This function should be called after the Tango service has been bound at the Java level.
  */
 void UTangoDevice::BindAndCompleteConnectionToService(JNIEnv* Env, jobject IBinder)
 {
-    
     //Bind to the Tango service
-    if (TangoService_setBinder(Env, IBinder) != TANGO_SUCCESS)
-    {
-        UE_LOG(TangoPlugin, Error, TEXT(" UTangoDevice::BindAndCompleteConnectionToService: could not bind to Tango Service."));
-    }
-    else
-    {
-        UE_LOG(TangoPlugin, Log, TEXT(" UTangoDevice::BindAndCompleteConnectionToService: successfully bound to Tango Service."));
-    }
-    
-    //Apply the service Configuration
-    ApplyConfig();
-    
-	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::BindAndCompleteConnectionToService: Called"));
-	if (Config_ == nullptr)
+    TangoAndroidBackend::SetBinder(Env, IBinder);
+	CompleteConnectionToService();
+}
+#endif
+
+void UTangoDevice::CompleteConnectionToService()
+{
+	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::CompleteConnectionToService: Called"));
+	if (IsTangoServiceRunning())
 	{
-		UE_LOG(TangoPlugin, Error, TEXT(" UTangoDevice::BindAndCompleteConnectionToService: failed because Config is NULL."));
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoDevice::CompleteConnectionToService: Cannot connect while TangoService is running!"));
 		return;
 	}
 
-    //Refresh Java global reference here
-    /*@TODO: This is a little hacky, see if we can get a reference to a state which won't be garbage collected so we don't need to do this.*/
-    PopulateAppContext();
-    
     //Attempt to connect to the now bound service
-	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::BindAndCompleteConnectionToService: Connecting!"));
-	ConnectionState = TangoService_connect(AppContextReference, Config_) == TANGO_SUCCESS ? CONNECTED : FAILED_TO_CONNECT;
+	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::CompleteConnectionToService: Connecting!"));
+	ConnectionState = Backend->Connect(CurrentConfig, CurrentRuntimeConfig) ? CONNECTED : FAILED_TO_CONNECT;
 
 	//Creating and deleting of additional class components that register callbacks and do their own thing
 	if (CurrentConfig.bEnableDepthCapabilities && GetTangoDevicePointCloudPointer() == nullptr)
 	{
-		PointCloudHelper = new TangoDevicePointCloud(Config_);
+		PointCloudHelper = new TangoDevicePointCloud(Backend->GetMaxPointCloudElements());
 	}
 	else if (!CurrentConfig.bEnableDepthCapabilities && GetTangoDevicePointCloudPointer() != nullptr)
 	{
@@ -514,7 +392,7 @@ void UTangoDevice::BindAndCompleteConnectionToService(JNIEnv* Env, jobject IBind
 	if (CurrentConfig.bEnableColorCameraCapabilities && GetTangoDeviceImagePointer() == nullptr)
 	{
 		ImageHelper = NewObject<UTangoDeviceImage>(UTangoDeviceImage::StaticClass());
-		ImageHelper->Init(Config_);
+		ImageHelper->Init();
 	}
 	else if (!CurrentConfig.bEnableColorCameraCapabilities && GetTangoDeviceImagePointer() != nullptr)
 	{
@@ -535,13 +413,24 @@ void UTangoDevice::BindAndCompleteConnectionToService(JNIEnv* Env, jobject IBind
 
 	if (GetTangoServiceStatus() == FAILED_TO_CONNECT)
 	{
-		UE_LOG(TangoPlugin, Error, TEXT("UTangoDevice::BindAndCompleteConnectionToService: Unable to connect!"));
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoDevice::CompleteConnectionToService: Unable to connect!"));
 	}
 	else
 	{
-		UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::BindAndCompleteConnectionToService: Connection succesfull! Now connecting callbacks!"));
+		UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::CompleteConnectionToService: Connection succesfull! Now connecting callbacks!"));
+		TangoSpaceConversions::VerifyExtrinsicsAsync();
+		StreamMonitor.Reset();
+		StreamMonitor.SetRuntimeConfig(CurrentRuntimeConfig);
+		ClockSync.Reset();
+		LatencyMonitor.Reset();
+		CameraIntrinsicsCache.Invalidate();
+		CameraIntrinsicsCache.PrefetchAsync();
 		if (GetTangoDeviceMotionPointer() != nullptr)
 		{
+			//Requests that could not be resolved before the connection may resolve now
+			MotionSubscriptions.MarkDirty();
+			MotionSubscriptions.RebuildIfDirty();
+			MotionSubscriptions.ConsumeQueriedPairsChanged();
 			GetTangoDeviceMotionPointer()->ConnectCallback();
 		}
 		if (GetTangoDevicePointCloudPointer() != nullptr)
@@ -552,9 +441,13 @@ void UTangoDevice::BindAndCompleteConnectionToService(JNIEnv* Env, jobject IBind
 		{
 			GetTangoDeviceImagePointer()->ConnectCallback();
 		}
+		if (GetTangoDeviceImagePointer() != nullptr && CurrentConfig.bEnableColorCameraFrames)
+		{
+			GetTangoDeviceImagePointer()->ConnectFrameCallback();
+		}
 	}
 	ConnectEventCallback();//Activate Events
-	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::BindAndCompleteConnectionToService: FINISHED"));
+	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::CompleteConnectionToService: FINISHED"));
 	BroadCastConnect();
 	//Call a second time to make depth disabling at startup work.
 	if (!CurrentRuntimeConfig.bEnableDepth && CurrentConfig.bEnableDepthCapabilities)
@@ -562,7 +455,6 @@ void UTangoDevice::BindAndCompleteConnectionToService(JNIEnv* Env, jobject IBind
 		SetTangoRuntimeConfig(CurrentRuntimeConfig);
 	}
 }
-#endif
 
 void UTangoDevice::DisconnectTangoService(bool bByAppServicePause)
 {
@@ -572,15 +464,17 @@ void UTangoDevice::DisconnectTangoService(bool bByAppServicePause)
 	{
 		UE_LOG(TangoPlugin, Log, TEXT(" UTangoDevice::DisconnectTangoService: will now disconnect!"));
 
-        //Free the Tango Config object
-        TangoConfig_free(Config_);
-        Config_ = NULL;
-        
-        //Disconnect from the C service
-		TangoService_disconnect();
+        //Disconnect from the service, this also frees its config
+		Backend->Disconnect();
+		//The next connection may come with a different config
+		CameraIntrinsicsCache.Invalidate();
+		//Streams end with the connection, that is no stall
+		StreamMonitor.Reset();
         
+#if PLATFORM_ANDROID
         //Unbind from the Java-level service after the TangoService_disconnect call
         UnbindTangoService();
+#endif
         
         //Mark the current connection state and broadcast the disconnection
 		ConnectionState = bByAppServicePause ? DISCONNECTED_BY_APPSERVICEPAUSE : DISCONNECTED;
@@ -595,13 +489,13 @@ void UTangoDevice::DisconnectTangoService(bool bByAppServicePause)
 
 //END - Platform Only Functions
 
+#if PLATFORM_ANDROID
 void UTangoDevice::AppServiceResume()
 {
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::AppServiceResume: Called"));
 	if (GetTangoServiceStatus() == DISCONNECTED_BY_APPSERVICEPAUSE)//We only reconnect when we disconnected the Tango by AppServicePause first!
 	{
 		UE_LOG(TangoPlugin, Log, TEXT(" UTangoDevice::AppServiceResume: Connect service called"));
-		ApplyConfig();
 		ConnectTangoService();
 	}
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::AppServiceResume: FINISHED"));
@@ -620,43 +514,64 @@ void UTangoDevice::AppServicePause()
 
 #endif
 
-//TangoDeviceMotion Helper
+//Backend callbacks
 
-void UTangoDevice::AddTangoMotionComponent(UTangoMotionComponent* Component, TArray<FTangoCoordinateFramePair>& Requests)
+void UTangoDevice::OnPoseAvailable(const FTangoBackendPose& Pose)
 {
-	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::AddTangoMotionComponent: Started"));
-	//Check if component is already added and remove components that have been garbage collected
-	bool bComponentFound = false;
-	for (int i = 0; i < MotionComponents.Num(); ++i)
+	TANGO_TRACE_SCOPE("Callback.Pose", Pose.Timestamp);
+	ClockSync.AddSample(Pose.Timestamp, FPlatformTime::Seconds());
+	StreamMonitor.RecordArrival(ETangoStreamType::POSE, Pose.Timestamp);
+	if (GetTangoDeviceMotionPointer() != nullptr)
 	{
-		while (MotionComponents[i] == nullptr)
-		{
-			MotionComponents.RemoveAt(i);
-			RequestedPairs.RemoveAt(i);
-			if (i >= MotionComponents.Num())
-			{
-				break;
-			}
-		}
-		if (MotionComponents[i] == Component)
-		{
-			bComponentFound = true;
-			RequestedPairs[i] = Requests;
-		}
+		GetTangoDeviceMotionPointer()->OnPoseAvailable(Pose);
 	}
-	if (!bComponentFound)
+}
+
+void UTangoDevice::OnPointCloudAvailable(const FTangoBackendPointCloud& PointCloud)
+{
+	TANGO_TRACE_SCOPE("Callback.Depth", PointCloud.Timestamp);
+	ClockSync.AddSample(PointCloud.Timestamp, FPlatformTime::Seconds());
+	StreamMonitor.RecordArrival(ETangoStreamType::DEPTH, PointCloud.Timestamp);
+	if (GetTangoDevicePointCloudPointer() != nullptr)
 	{
-		UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::AddTangoMotionComponent: Not Found"));
-		MotionComponents.Add(Component);
-		RequestedPairs.Add(Requests);
+		GetTangoDevicePointCloudPointer()->OnPointCloudAvailable(PointCloud);
 	}
-	else
+}
+
+void UTangoDevice::OnCameraFrameAvailable(const FTangoBackendImage& Image)
+{
+	TANGO_TRACE_SCOPE("Callback.ColorFrame", Image.Timestamp);
+	ClockSync.AddSample(Image.Timestamp, FPlatformTime::Seconds());
+	StreamMonitor.RecordArrival(ETangoStreamType::COLOR_FRAME, Image.Timestamp);
+	if (GetTangoDeviceImagePointer() != nullptr)
 	{
-		UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::AddTangoMotionComponent: Found"));
+		GetTangoDeviceImagePointer()->OnCameraFrameAvailable(Image);
 	}
-	if (GetTangoDeviceMotionPointer() != nullptr)
+}
+
+void UTangoDevice::OnCameraTexturesAvailable()
+{
+	TANGO_TRACE_SCOPE("Callback.CameraTexture", 0.0);
+	StreamMonitor.RecordArrival(ETangoStreamType::CAMERA_TEXTURE);
+	if (GetTangoDeviceImagePointer() != nullptr)
 	{
-		UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::AddTangoMotionComponent: Initiating Rebuild"));
-		GetTangoDeviceMotionPointer()->CheckForChangeInRequests();
+		GetTangoDeviceImagePointer()->OnNewDataAvailable();
 	}
-}
\ No newline at end of file
+}
+
+//TangoDeviceMotion Helper
+
+void UTangoDevice::AddTangoMotionComponent(UTangoMotionComponent* Component, const TArray<FTangoCoordinateFramePair>& Requests, float MaxDeliveryRate, FTangoSubscriptionHandle& Handle)
+{
+	UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::AddTangoMotionComponent: Started"));
+	if (!MotionSubscriptions.Update(Handle, Requests, MaxDeliveryRate))
+	{
+		Handle = MotionSubscriptions.Subscribe(Component, Requests, MaxDeliveryRate);
+	}
+	//The broadcast list and the callback are rebuilt by UTangoDeviceMotion::Tick, so many changes in one frame only cost one rebuild.
+}
+
+void UTangoDevice::RemoveTangoMotionComponent(FTangoSubscriptionHandle& Handle)
+{
+	MotionSubscriptions.Unsubscribe(Handle);
+}
@@ -19,6 +19,14 @@ limitations under the License.*/
 #include "TangoDeviceAreaLearning.h"
 #include "TangoEventComponent.h"
 #include "TangoViewExtension.h"
+#include "TangoMotionSubscriptions.h"
+#include "TangoFrameSynchronizer.h"
+#include "TangoCameraIntrinsicsCache.h"
+#include "TangoSessionRecorder.h"
+#include "TangoStreamMonitor.h"
+#include "TangoClockSync.h"
+#include "TangoLatencyMonitor.h"
+#include "TangoBackend.h"
 
 #include <sstream>
 #include <stdlib.h>
@@ -101,13 +109,13 @@ private:
 	//Service Configuration
 	FTangoConfig CurrentConfig;
 	FTangoRuntimeConfig CurrentRuntimeConfig;
+	//Talks to the service, or stands in for it where there is none
+	FTangoBackendPtr Backend;
 
-#if PLATFORM_ANDROID
-	TangoConfig Config_; //Internal Tango Pointer
 	//Core service functions
-	bool ApplyConfig();
 	void ConnectTangoService();
 	void DisconnectTangoService(bool bByAppServicePause = false);
+#if PLATFORM_ANDROID
     //To be called during the final phase of DisconnectTangoService
     void UnbindTangoService();
 	//Delegate binding functions
@@ -117,8 +125,20 @@ private:
 public:
     //Note: last part of the new async connection method
     void BindAndCompleteConnectionToService(JNIEnv* Env, jobject IBinder);
-
 #endif
+
+public:
+	//Connects the backend once the service is available and creates the submodules
+	void CompleteConnectionToService();
+	//Valid from the first call of Get() on, can be used from any thread
+	ITangoBackend& GetBackend() { return *Backend; }
+
+	//Called by the backend on its own threads
+	void OnPoseAvailable(const FTangoBackendPose& Pose);
+	void OnPointCloudAvailable(const FTangoBackendPointCloud& PointCloud);
+	void OnTangoEvent(const FTangoBackendEvent& Event);
+	void OnCameraFrameAvailable(const FTangoBackendImage& Image);
+	void OnCameraTexturesAvailable();
     
 	///////////////////////////
 	// General functionality //
@@ -126,7 +146,11 @@ public:
 public:
 	float GetMetersToWorldScale();
 	//Tango Camera Intrinsics defined here because we need the intrinsics to start the ImageDevice!
+	//Served from a cache that is filled once per connection, safe to call from any thread.
 	FTangoCameraIntrinsics GetCameraIntrinsics(TEnumAsByte<ETangoCameraType::Type> CameraID);
+private:
+	TangoCameraIntrinsicsCache CameraIntrinsicsCache;
+public:
 
 	//Area accessibility functions. Found in TangoDeviceADF.cpp
 	FString GetLoadedAreaDescriptionUUID();
@@ -141,29 +165,20 @@ public:
 	/////////////////
 public:
 	void AttachTangoEventComponent(UTangoEventComponent* Component);
-#if PLATFORM_ANDROID
     void PushTangoEvent(const FTangoEvent);
-#endif
+	//Hands the queued events to the event components, part of Tick
+	void BroadCastEvents();
     
 private:
 	void ConnectEventCallback();
 	void BroadCastConnect();
 	void BroadCastDisconnect();
-	void BroadCastEvents();
-#if PLATFORM_ANDROID
-    void OnTangoEvent(const TangoEvent * Event);
-    void PopulateAppContext();
-    void DePopulateAppContext();
-#endif
+	void BroadCastStreamStalls();
+	void RemoveInvalidEventComponents();
 	UPROPERTY(transient)
 	TArray<UTangoEventComponent*> TangoEventComponents;
-	TArray<FTangoEvent> CurrentEvents;
-	//For less blocking :(
-	TArray<FTangoEvent> CurrentEventsCopy;
-	FCriticalSection EventLock;
-#if PLATFORM_ANDROID
-    jobject AppContextReference;
-#endif
+	//Filled by the Tango event thread and other producers, drained on the game thread
+	TQueue<FTangoEvent, EQueueMode::Mpsc> PendingEvents;
 
 	/////////////////////
 	// Persistent Data //
@@ -181,11 +196,28 @@ public:
 		UTexture2D * CrTexture;
 	UPROPERTY(transient)
 		UTexture2D * CbTexture;
-	//TangoDeviceMotion
+	//Complete frames are copied from the textures above into this ring, NumSlots textures per plane.
+	UPROPERTY(transient)
+		TArray<UTexture2D*> YTextureRing;
 	UPROPERTY(transient)
-		TArray<UTangoMotionComponent*> MotionComponents;
+		TArray<UTexture2D*> CrTextureRing;
+	UPROPERTY(transient)
+		TArray<UTexture2D*> CbTextureRing;
+	//TangoDeviceMotion
 	UPROPERTY(transient)
 		TArray<UTangoPointCloudComponent*> PointCloudComponents;
-	TArray<TArray<FTangoCoordinateFramePair>> RequestedPairs;
-	void AddTangoMotionComponent(UTangoMotionComponent* Component, TArray<FTangoCoordinateFramePair>& Requests);
+	TangoMotionSubscriptionRegistry MotionSubscriptions;
+	//Subscribes the component to the pose events of Requests, or updates the subscription if Handle is still valid.
+	void AddTangoMotionComponent(UTangoMotionComponent* Component, const TArray<FTangoCoordinateFramePair>& Requests, float MaxDeliveryRate, FTangoSubscriptionHandle& Handle);
+	void RemoveTangoMotionComponent(FTangoSubscriptionHandle& Handle);
+	//Pairs depth with color frames and poses for C++ consumers
+	TangoFrameSynchronizer FrameSynchronizer;
+	//Streams everything the service delivers into a file, see the Tango.Session console commands
+	TangoSessionRecorder SessionRecorder;
+	//Arrival jitter and stalls of the service streams, see the Tango.StreamStats console command
+	TangoStreamMonitor StreamMonitor;
+	//Service timestamps to engine time, fed by the callbacks
+	TangoClockSync ClockSync;
+	//Pose and image age at render thread submission, see the Tango.LatencyStats console command
+	TangoLatencyMonitor LatencyMonitor;
 };
\ No newline at end of file
@@ -15,6 +15,7 @@ limitations under the License.*/
 #include "TangoDevice.h"
 #include "TangoDataTypes.h"
 #include "TangoFromToCObject.h"
+#include "TangoTracer.h"
 
 #include <UnrealTemplate.h>
 
@@ -26,120 +27,125 @@ limitations under the License.*/
 
 void UTangoDevice::ConnectEventCallback()
 {
-#if PLATFORM_ANDROID
-	if (TangoService_connectOnTangoEvent([](void* context, const TangoEvent* Event) {UTangoDevice::Get().OnTangoEvent(Event); }) != TANGO_SUCCESS)
+	if (!Backend->ConnectOnTangoEvent())
 	{
-		UE_LOG(TangoPlugin, Error, TEXT("UTangoDevice::ConnectEventCallback: TangoService_connectOnTangoEvent failed."));
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoDevice::ConnectEventCallback: Connecting the event callback failed."));
 	}
-#endif
+}
+
+//The broadcasts below loop by index: handlers may spawn actors whose event components attach themselves and grow the array.
+void UTangoDevice::RemoveInvalidEventComponents()
+{
+	TangoEventComponents.RemoveAll([](const UTangoEventComponent* Component) { return Component == nullptr; });
 }
 
 void UTangoDevice::BroadCastConnect()
 {
-	for (int i = 0; i < TangoEventComponents.Num(); ++i)
+	RemoveInvalidEventComponents();
+	for (int32 i = 0; i < TangoEventComponents.Num(); ++i)
 	{
-		while (TangoEventComponents[i] == nullptr)
-		{
-			TangoEventComponents.RemoveAt(i);
-			if (i >= TangoEventComponents.Num())
-			{
-				return;
-			}
-		}
-		TangoEventComponents[i]->OnTangoConnect.Broadcast();
+		UTangoEventComponent* Component = TangoEventComponents[i];
+		Component->OnTangoConnect.Broadcast();
 	}
 }
 
 void UTangoDevice::BroadCastDisconnect()
 {
-	for (int i = 0; i < TangoEventComponents.Num(); ++i)
+	RemoveInvalidEventComponents();
+	for (int32 i = 0; i < TangoEventComponents.Num(); ++i)
 	{
-		while (TangoEventComponents[i] == nullptr)
-		{
-			TangoEventComponents.RemoveAt(i);
-			if (i >= TangoEventComponents.Num())
-			{
-				return;
-			}
-		}
-		TangoEventComponents[i]->OnTangoDisconnect.Broadcast();
+		UTangoEventComponent* Component = TangoEventComponents[i];
+		Component->OnTangoDisconnect.Broadcast();
 	}
 }
 
 void UTangoDevice::BroadCastEvents()
 {
+	if (PendingEvents.IsEmpty())
 	{
-		FScopeLock ScopeLock(&EventLock);
-		CurrentEventsCopy = TArray<FTangoEvent>(CurrentEvents);
-		CurrentEvents.Empty();
+		return;
 	}
-	for (int e = 0; e < CurrentEventsCopy.Num(); ++e)
+	TANGO_TRACE_SCOPE("Events.Broadcast", 0.0);
+	RemoveInvalidEventComponents();
+	FTangoEvent Event;
+	while (PendingEvents.Dequeue(Event))
 	{
-		for (int i = 0; i < TangoEventComponents.Num(); ++i)
+		for (int32 i = 0; i < TangoEventComponents.Num(); ++i)
 		{
-			while (TangoEventComponents[i] == nullptr)
-			{
-				TangoEventComponents.RemoveAt(i);
-				if (i >= TangoEventComponents.Num())
-				{
-					return;
-				}
-			}
-
-			switch (CurrentEventsCopy[e].Key)
+			UTangoEventComponent* Component = TangoEventComponents[i];
+			switch (Event.Key)
 			{
 			case ETangoEventKeyType::KEY_SERVICE_EXCEPTION:
-				TangoEventComponents[i]->OnTangoServiceException.Broadcast(CurrentEventsCopy[e]);
+				Component->OnTangoServiceException.Broadcast(Event);
 				break;
 			case ETangoEventKeyType::DESCRIPTION_FISHEYE_OVER_EXPOSED:
-				TangoEventComponents[i]->OnFisheyeOverExposed.Broadcast(CurrentEventsCopy[e]);
+				Component->OnFisheyeOverExposed.Broadcast(Event);
 				break;
 			case ETangoEventKeyType::DESCRIPTION_FISHEYE_UNDER_EXPOSED:
-				TangoEventComponents[i]->OnFisheyeUnderExposed.Broadcast(CurrentEventsCopy[e]);
+				Component->OnFisheyeUnderExposed.Broadcast(Event);
 				break;
 			case ETangoEventKeyType::DESCRIPTION_COLOR_OVER_EXPOSED:
-				TangoEventComponents[i]->OnColorOverExposed.Broadcast(CurrentEventsCopy[e]);
+				Component->OnColorOverExposed.Broadcast(Event);
 				break;
 			case ETangoEventKeyType::DESCRIPTION_COLOR_UNDER_EXPOSED:
-				TangoEventComponents[i]->OnColorUnderExposed.Broadcast(CurrentEventsCopy[e]);
+				Component->OnColorUnderExposed.Broadcast(Event);
 				break;
 			case ETangoEventKeyType::DESCRIPTION_TOO_FEW_FEATURES:
-				TangoEventComponents[i]->OnTooFewFeaturesTracked.Broadcast(CurrentEventsCopy[e]);
+				Component->OnTooFewFeaturesTracked.Broadcast(Event);
 				break;
 			case ETangoEventKeyType::KEY_AREA_DESCRIPTION_SAVE_PROGRESS:
-				TangoEventComponents[i]->OnAreaDescriptionSaveProgress.Broadcast(CurrentEventsCopy[e]);
+				Component->OnAreaDescriptionSaveProgress.Broadcast(Event);
 				break;
 			case ETangoEventKeyType::UNKOWN:
-				TangoEventComponents[i]->OnUnknownEvent.Broadcast(CurrentEventsCopy[e]);
+				Component->OnUnknownEvent.Broadcast(Event);
 				break;
             //Events for import and export results (success, cancelled, declined)
             case ETangoEventKeyType::IMPORT_RESULT:
-                    TangoEventComponents[i]->OnFileImportEvent.Broadcast((ETangoRequestResult::Type) FCString::Atoi(*(CurrentEventsCopy[e].Message)));
+                    Component->OnFileImportEvent.Broadcast((ETangoRequestResult::Type) FCString::Atoi(*(Event.Message)));
                 break;
             case ETangoEventKeyType::EXPORT_RESULT:
-                    TangoEventComponents[i]->OnFileExportEvent.Broadcast((ETangoRequestResult::Type) FCString::Atoi(*(CurrentEventsCopy[e].Message)));
+                    Component->OnFileExportEvent.Broadcast((ETangoRequestResult::Type) FCString::Atoi(*(Event.Message)));
                 break;
 			default:
 				break;
 			}
 		}
 	}
-	CurrentEventsCopy.Empty();
 }
 
-#if PLATFORM_ANDROID
-void UTangoDevice::OnTangoEvent(const TangoEvent *Event)
+void UTangoDevice::BroadCastStreamStalls()
+{
+	if (!IsTangoServiceRunning())
+	{
+		return;
+	}
+	TArray<FTangoStreamStatistics> NewStalls;
+	StreamMonitor.CheckForStalls(NewStalls);
+	if (NewStalls.Num() == 0)
+	{
+		return;
+	}
+	RemoveInvalidEventComponents();
+	for (const FTangoStreamStatistics& Stall : NewStalls)
+	{
+		for (int32 i = 0; i < TangoEventComponents.Num(); ++i)
+		{
+			UTangoEventComponent* Component = TangoEventComponents[i];
+			Component->OnTangoStreamStalled.Broadcast(Stall);
+		}
+	}
+}
+
+void UTangoDevice::OnTangoEvent(const FTangoBackendEvent& Event)
 {
-	FScopeLock ScopeLock(&EventLock);
-	CurrentEvents.Emplace(FromCObject(Event));
+	SessionRecorder.RecordEvent(Event.Timestamp, Event.Type, Event.Key, Event.Value);
+	PendingEvents.Enqueue(FromBackendObject(Event));
 }
 
 void UTangoDevice::PushTangoEvent(const FTangoEvent Event)
 {
-    FScopeLock ScopeLock(&EventLock);
-    CurrentEvents.Emplace(Event);
+    PendingEvents.Enqueue(Event);
 }
-#endif
 
 void UTangoDevice::AttachTangoEventComponent(UTangoEventComponent* Component)
 {
@@ -15,45 +15,97 @@ limitations under the License.*/
 #include "TangoPluginPrivatePCH.h"
 #include "TangoDeviceImage.h"
 #include "TangoDevice.h"
+#include "TangoStats.h"
 
-void UTangoDeviceImage::Init(
 #if PLATFORM_ANDROID
-	TangoConfig Config_
+#include <GLES2/gl2.h>
 #endif
-	)
+
+namespace
+{
+	UTexture2D* CreateCameraTexture()
+	{
+		//The service resizes the texture when it writes into it.
+		UTexture2D* Texture = UTexture2D::CreateTransient(1, 1, PF_R8G8B8A8);
+		Texture->Filter = TF_Nearest;
+		Texture->CompressionSettings = TC_Masks;
+		Texture->SRGB = 0;
+		Texture->UpdateResource();
+		return Texture;
+	}
+
+#if PLATFORM_ANDROID
+	uint32 GetOpenGLName(UTexture2D* Texture)
+	{
+		if (Texture == nullptr || Texture->Resource == nullptr || !Texture->Resource->TextureRHI)
+		{
+			return 0;
+		}
+		void* Resource = Texture->Resource->TextureRHI->GetNativeResource();
+		return Resource != nullptr ? static_cast<uint32>(*reinterpret_cast<int32*>(Resource)) : 0;
+	}
+
+	//Copies through a framebuffer the source is attached to, which also resizes the destination.
+	//Restores the bindings afterwards, the RHI caches them.
+	bool CopyOpenGLTexture(uint32 Source, uint32 Destination, int32 Width, int32 Height, uint32& Framebuffer)
+	{
+		//Errors left over from other code would fail the check below
+		while (glGetError() != GL_NO_ERROR)
+		{
+		}
+		GLint PreviousFramebuffer = 0;
+		GLint PreviousTexture = 0;
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &PreviousTexture);
+		if (Framebuffer == 0)
+		{
+			glGenFramebuffers(1, &Framebuffer);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Source, 0);
+		const bool bComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		if (bComplete)
+		{
+			glBindTexture(GL_TEXTURE_2D, Destination);
+			glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, Width, Height, 0);
+		}
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindTexture(GL_TEXTURE_2D, PreviousTexture);
+		glBindFramebuffer(GL_FRAMEBUFFER, PreviousFramebuffer);
+		return bComplete && glGetError() == GL_NO_ERROR;
+	}
+#endif
+}
+
+void UTangoDeviceImage::Init()
 {
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceImage: Constructor called"));
 
 	State = DISCONNECTED;
 
-	ImageBufferTimestamp = 0;
-	bTexturesHaveDataInThem = false;
-	bNewDataAvailable = false;
-#if PLATFORM_ANDROID
-	CreateYUVTextures(Config_);
-#endif
+	ImageState.Reset();
+	LatchedImageFrame = 0;
+	bUseTextureRing = true;
+	CopyFramebuffer = 0;
+	FMemory::Memzero(TextureWidths);
+	FMemory::Memzero(TextureHeights);
+	FMemory::Memzero(RingTextureNames);
+	bFrameCallbackConnected = false;
+	CameraFramePool = MakeShareable(new TangoCameraFramePool(CameraFramePoolSize));
+	CreateYUVTextures();
 
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceImage: Constructor finished"));
 }
 
-bool UTangoDeviceImage::CreateYUVTextures(
-#if PLATFORM_ANDROID
-	TangoConfig Config_
-#endif
-	)
+bool UTangoDeviceImage::CreateYUVTextures()
 {
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceImage: CreateYUVTextures called"));
-#if PLATFORM_ANDROID
 	int32 YTextureWidth = 0;
 	int32 YTextureHeight = 0;
 	int32 uvTextureWidth = 0;
 	int32 uvTextureHeight = 0;
 
-	bool bSuccess = true;
-	bSuccess = TangoConfig_getInt32(Config_,"experimental_color_y_tex_data_width", &YTextureWidth) == TANGO_SUCCESS && bSuccess;
-	bSuccess = TangoConfig_getInt32(Config_, "experimental_color_y_tex_data_height", &YTextureHeight) == TANGO_SUCCESS && bSuccess;
-	bSuccess = TangoConfig_getInt32(Config_, "experimental_color_uv_tex_data_width", &uvTextureWidth) == TANGO_SUCCESS && bSuccess;
-	bSuccess = TangoConfig_getInt32(Config_, "experimental_color_uv_tex_data_height", &uvTextureHeight) == TANGO_SUCCESS && bSuccess;
+	const bool bSuccess = UTangoDevice::Get().GetBackend().GetCameraTextureSizes(YTextureWidth, YTextureHeight, uvTextureWidth, uvTextureHeight);
 
 	if (!bSuccess || YTextureWidth == 0 || YTextureHeight == 0 || uvTextureWidth == 0 || uvTextureHeight == 0)
 	{
@@ -65,27 +117,31 @@ bool UTangoDeviceImage::CreateYUVTextures(
 		UE_LOG(TangoPlugin, Log, TEXT("UTangoDevice::Get().YTextureWidth %d UTangoDevice::Get().YTextureHeight %d uvTextureWidth %d uvTextureHeight %d"), YTextureWidth, YTextureHeight, uvTextureWidth, uvTextureHeight);
     }
     
-	if (UTangoDevice::Get().YTexture == nullptr)
-	{
-		UTangoDevice::Get().YTexture = UTexture2D::CreateTransient(1, 1, PF_R8G8B8A8);
-		UTangoDevice::Get().CrTexture = UTexture2D::CreateTransient(1, 1, PF_R8G8B8A8);
-		UTangoDevice::Get().CbTexture = UTexture2D::CreateTransient(1, 1, PF_R8G8B8A8);
-
-		UTangoDevice::Get().YTexture->Filter = TF_Nearest;
-		UTangoDevice::Get().CrTexture->Filter = TF_Nearest;
-		UTangoDevice::Get().CbTexture->Filter = TF_Nearest;
-
-		UTangoDevice::Get().YTexture->CompressionSettings = TC_Masks;
-		UTangoDevice::Get().CrTexture->CompressionSettings = TC_Masks;
-		UTangoDevice::Get().CbTexture->CompressionSettings = TC_Masks;
-
-		UTangoDevice::Get().YTexture->SRGB = 0;
-		UTangoDevice::Get().CrTexture->SRGB = 0;
-		UTangoDevice::Get().CbTexture->SRGB = 0;
+	TextureWidths[0] = YTextureWidth;
+	TextureHeights[0] = YTextureHeight;
+	TextureWidths[1] = TextureWidths[2] = uvTextureWidth;
+	TextureHeights[1] = TextureHeights[2] = uvTextureHeight;
 
-		UTangoDevice::Get().YTexture->UpdateResource();
-		UTangoDevice::Get().CrTexture->UpdateResource();
-		UTangoDevice::Get().CbTexture->UpdateResource();
+	//The service writes the camera into OpenGL textures, which only exist on the device
+#if PLATFORM_ANDROID
+	UTangoDevice& Device = UTangoDevice::Get();
+	if (Device.YTexture == nullptr)
+	{
+		Device.YTexture = CreateCameraTexture();
+		Device.CrTexture = CreateCameraTexture();
+		Device.CbTexture = CreateCameraTexture();
+	}
+	if (Device.YTextureRing.Num() != TangoCameraImageState::NumSlots)
+	{
+		Device.YTextureRing.Reset();
+		Device.CrTextureRing.Reset();
+		Device.CbTextureRing.Reset();
+		for (int32 i = 0; i < TangoCameraImageState::NumSlots; ++i)
+		{
+			Device.YTextureRing.Add(CreateCameraTexture());
+			Device.CrTextureRing.Add(CreateCameraTexture());
+			Device.CbTextureRing.Add(CreateCameraTexture());
+		}
 	}
 
 
@@ -123,10 +179,7 @@ bool UTangoDeviceImage::DisconnectCallback()
 	}
 	else
 	{
-		bool bSuccess = true;
-#if PLATFORM_ANDROID
-		bSuccess = TangoService_disconnectCamera(TANGO_CAMERA_COLOR) == TANGO_SUCCESS;
-#endif
+		const bool bSuccess = UTangoDevice::Get().GetBackend().DisconnectCamera();
 		if (bSuccess == true)
 		{
 			State = DISCONNECTED;
@@ -137,7 +190,11 @@ bool UTangoDeviceImage::DisconnectCallback()
 
 void UTangoDeviceImage::OnNewDataAvailable()
 {
-	bNewDataAvailable = true;
+	INC_DWORD_STAT(STAT_TangoTexturesReceived);
+	if (ImageState.NotifyFrameAvailable())
+	{
+		INC_DWORD_STAT(STAT_TangoTexturesDropped);
+	}
 }
 
 void UTangoDeviceImage::ConnectCallback()
@@ -145,6 +202,130 @@ void UTangoDeviceImage::ConnectCallback()
 	State = WANTTOCONNECT;
 }
 
+void UTangoDeviceImage::ConnectFrameCallback()
+{
+	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceImage::ConnectFrameCallback: called"));
+	if (!UTangoDevice::Get().GetBackend().ConnectOnFrameAvailable())
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoDeviceImage::ConnectFrameCallback: Was unsuccessfull"));
+		return;
+	}
+	bFrameCallbackConnected = true;
+}
+
+void UTangoDeviceImage::DisconnectFrameCallback()
+{
+	if (!bFrameCallbackConnected)
+	{
+		return;
+	}
+	//Disconnecting the service already dropped the callback
+	ITangoBackend& Backend = UTangoDevice::Get().GetBackend();
+	if (Backend.IsConnected() && !Backend.DisconnectOnFrameAvailable())
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoDeviceImage::DisconnectFrameCallback: Was unsuccessfull"));
+	}
+	bFrameCallbackConnected = false;
+}
+
+void UTangoDeviceImage::OnCameraFrameAvailable(const FTangoBackendImage& Image)
+{
+	INC_DWORD_STAT(STAT_TangoColorReceived);
+	//The frame we copied, GetLatestFrame could already be a newer one from another callback
+	const FTangoCameraFrameHandle Frame = CameraFramePool.IsValid() ? CameraFramePool->SubmitFrame(Image) : FTangoCameraFrameHandle();
+	if (!Frame.IsValid())
+	{
+		INC_DWORD_STAT(STAT_TangoColorDropped);
+		return;
+	}
+	INC_DWORD_STAT(STAT_TangoColorProcessed);
+	UTangoDevice::Get().FrameSynchronizer.PushColor(Image.Timestamp, Frame);
+	UTangoDevice::Get().SessionRecorder.RecordColorFrame(*Frame);
+}
+
+void UTangoDeviceImage::DataSet(double Stamp, uint32 FrameNumber)
+{
+	int32 Slot = INDEX_NONE;
+	if (bUseTextureRing)
+	{
+		Slot = ImageState.GetNextSlot();
+		if (!CopyToSlot(Slot))
+		{
+			UE_LOG(TangoPlugin, Warning, TEXT("UTangoDeviceImage::DataSet: Could not copy the camera image, consumers sample the textures the service writes into"));
+			bUseTextureRing = false;
+			Slot = INDEX_NONE;
+		}
+	}
+	ImageState.Publish(Stamp, Slot, FrameNumber);
+	INC_DWORD_STAT(STAT_TangoTexturesProcessed);
+	//With CPU frames the synchronizer already gets every frame from the frame callback.
+	if (!bFrameCallbackConnected)
+	{
+		UTangoDevice::Get().FrameSynchronizer.PushColor(Stamp, FTangoCameraFrameHandle());
+	}
+}
+
+bool UTangoDeviceImage::CopyToSlot(int32 Slot)
+{
+#if PLATFORM_ANDROID
+	UTangoDevice& Device = UTangoDevice::Get();
+	if (Device.YTextureRing.Num() <= Slot || Device.CrTextureRing.Num() <= Slot || Device.CbTextureRing.Num() <= Slot)
+	{
+		return false;
+	}
+	UTexture2D* const Sources[3] = { Device.YTexture, Device.CrTexture, Device.CbTexture };
+	UTexture2D* const Destinations[3] = { Device.YTextureRing[Slot], Device.CrTextureRing[Slot], Device.CbTextureRing[Slot] };
+	for (int32 Plane = 0; Plane < 3; ++Plane)
+	{
+		if (RingTextureNames[Slot][Plane] == 0)
+		{
+			RingTextureNames[Slot][Plane] = GetOpenGLName(Destinations[Plane]);
+		}
+		const uint32 Source = GetOpenGLName(Sources[Plane]);
+		if (Source == 0 || RingTextureNames[Slot][Plane] == 0
+			|| !CopyOpenGLTexture(Source, RingTextureNames[Slot][Plane], TextureWidths[Plane], TextureHeights[Plane], CopyFramebuffer))
+		{
+			return false;
+		}
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+FTangoCameraImageSnapshot UTangoDeviceImage::GetFrameImage()
+{
+	check(IsInGameThread());
+	if (LatchedImageFrame != GFrameCounter)
+	{
+		LatchedImage = ImageState.GetSnapshot();
+		LatchedImageFrame = GFrameCounter;
+	}
+	return LatchedImage;
+}
+
+UTexture2D* UTangoDeviceImage::GetPlaneTexture(int32 Plane)
+{
+	const FTangoCameraImageSnapshot Image = GetFrameImage();
+	if (Image.FrameSequence == 0)
+	{
+		return nullptr;
+	}
+	UTangoDevice& Device = UTangoDevice::Get();
+	const TArray<UTexture2D*>& Ring = Plane == 0 ? Device.YTextureRing : (Plane == 1 ? Device.CrTextureRing : Device.CbTextureRing);
+	if (Ring.IsValidIndex(Image.Slot))
+	{
+		return Ring[Image.Slot];
+	}
+	return Plane == 0 ? Device.YTexture : (Plane == 1 ? Device.CrTexture : Device.CbTexture);
+}
+
+FTangoCameraFrameHandle UTangoDeviceImage::GetLatestCameraFrame() const
+{
+	return CameraFramePool.IsValid() ? CameraFramePool->GetLatestFrame() : FTangoCameraFrameHandle();
+}
+
 bool UTangoDeviceImage::TexturesReady()
 {
 	if (!(UTangoDevice::Get().YTexture || UTangoDevice::Get().CrTexture || UTangoDevice::Get().CbTexture))
@@ -229,9 +410,7 @@ void UTangoDeviceImage::CheckConnectCallback()
 			if (*StateRef == CONNECTSHEDULED)
 			{
 				*StateRef = CONNECTED;
-				TangoService_Experimental_connectTextureIdUnity(TANGO_CAMERA_COLOR, YOpenGLPointer, CbOpenGLPointer, CrOpenGLPointer, this,
-					[](void*, TangoCameraId id) {if (id == TANGO_CAMERA_COLOR && UTangoDevice::Get().GetTangoDeviceImagePointer() != nullptr) UTangoDevice::Get().GetTangoDeviceImagePointer()->OnNewDataAvailable(); }
-				);
+				UTangoDevice::Get().GetBackend().ConnectCameraTextures(YOpenGLPointer, CbOpenGLPointer, CrOpenGLPointer);
 			}
 		});
 #endif
@@ -240,6 +419,7 @@ void UTangoDeviceImage::CheckConnectCallback()
 
 void UTangoDeviceImage::TickByDevice()
 {
+	SCOPE_CYCLE_COUNTER(STAT_TangoImageTick);
 	CheckConnectCallback();
 	if (!ViewExtension.IsValid() && GEngine)
 	{
@@ -251,38 +431,17 @@ void UTangoDeviceImage::TickByDevice()
 
 UTexture* UTangoDeviceImage::GetYTexture()
 {
-	if (!bTexturesHaveDataInThem)
-	{
-		return nullptr;
-	}
-	else
-	{
-		return UTangoDevice::Get().YTexture;
-	}
+	return GetPlaneTexture(0);
 }
 
 UTexture* UTangoDeviceImage::GetCrTexture()
 {
-	if (!bTexturesHaveDataInThem)
-	{
-		return nullptr;
-	}
-	else
-	{
-		return UTangoDevice::Get().CrTexture;
-	}
+	return GetPlaneTexture(1);
 }
 
 UTexture* UTangoDeviceImage::GetCbTexture()
 {
-	if (!bTexturesHaveDataInThem)
-	{
-		return nullptr;
-	}
-	else
-	{
-		return UTangoDevice::Get().CbTexture;
-	}
+	return GetPlaneTexture(2);
 }
 
 void UTangoDeviceImage::BeginDestroy()
@@ -292,16 +451,31 @@ void UTangoDeviceImage::BeginDestroy()
 		GEngine->ViewExtensions.Remove(ViewExtension);
 	}
 	ViewExtension.Reset();
+#if PLATFORM_ANDROID
+	if (CopyFramebuffer != 0)
+	{
+		ENQUEUE_UNIQUE_RENDER_COMMAND_ONEPARAMETER(DeleteTangoCopyFramebuffer,
+			uint32, Framebuffer, CopyFramebuffer,
+			{
+				glDeleteFramebuffers(1, &Framebuffer);
+			});
+		CopyFramebuffer = 0;
+	}
+#endif
 	Super::BeginDestroy();
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceImage::BeginDestroy: destructor called"));
 	DisconnectCallback();
+	//The frame callback submits into the pool, so it has to be gone first.
+	DisconnectFrameCallback();
+	//Handles that are still held keep their frames alive after this.
+	CameraFramePool.Reset();
 }
 
-float UTangoDeviceImage::GetImageBufferTimestamp()
+double UTangoDeviceImage::GetImageBufferTimestamp()
 {
-	float ReturnValue = 0;
+	double ReturnValue = 0.0;
 #if PLATFORM_ANDROID
-	ReturnValue = ImageBufferTimestamp;
+	ReturnValue = GetFrameImage().Timestamp;
 #endif
 	return ReturnValue;
 }
\ No newline at end of file
@@ -15,17 +15,12 @@ limitations under the License.*/
 #pragma once
 
 #include "TangoViewExtension.h"
-
-#if PLATFORM_ANDROID
-#include "tango_client_api.h"
-#endif
+#include "TangoCameraFramePool.h"
+#include "TangoCameraImageState.h"
+#include "TangoBackend.h"
 
 #include "TangoDeviceImage.generated.h"
 
-
-static bool bTexturesHaveDataInThem;
-static double ImageBufferTimestamp;
-
 UCLASS(NotBlueprintable, NotPlaceable, Transient)
 class UTangoDeviceImage : public UObject
 {
@@ -33,19 +28,15 @@ class UTangoDeviceImage : public UObject
 public:
 	virtual void BeginDestroy() override;
 
-	void Init(
-#if PLATFORM_ANDROID
-		TangoConfig Config_
-#endif
-		);
-
-	bool CreateYUVTextures(
-#if PLATFORM_ANDROID
-		TangoConfig Config_
-#endif
-	);
+	//Needs a connected backend
+	void Init();
+
+	bool CreateYUVTextures();
 	void ConnectCallback();
 	bool DisconnectCallback();
+	//Connects the CPU frame callback. Only needed if color camera frames are requested in the config.
+	void ConnectFrameCallback();
+	void DisconnectFrameCallback();
 
 	void TickByDevice();
 
@@ -57,10 +48,26 @@ public:
 
 	//Tango Image functions
 	bool bIsImageBufferSet;
-	float GetImageBufferTimestamp();
+	double GetImageBufferTimestamp();
+	//Lock-free, any thread. The frame sequence only changes when the textures got a new image.
+	FTangoCameraImageSnapshot GetImageSnapshot() const { return ImageState.GetSnapshot(); }
+	//Game thread: the image the textures returned above show. Latched once per frame, so every consumer binds the same slot.
+	FTangoCameraImageSnapshot GetFrameImage();
+	//Render thread: a view showing Image is rendered in FrameNumber
+	void RecordImageDisplayed(const FTangoCameraImageSnapshot& Image, uint32 FrameNumber) { ImageState.RecordDisplayed(Image, FrameNumber); }
+	//Render frames between an image being copied into the ring and being shown
+	int32 GetFrameLatency() const { return ImageState.GetFrameLatency(); }
+	float GetAverageFrameLatency() const { return ImageState.GetAverageFrameLatency(); }
 
 	bool setRuntimeConfig(FTangoRuntimeConfig& RuntimeConfig);
 
+	//CPU side camera frames
+	FTangoCameraFrameHandle GetLatestCameraFrame() const;
+	TSharedPtr<TangoCameraFramePool, ESPMode::ThreadSafe> GetCameraFramePool() const { return CameraFramePool; }
+
+	//Called by the backend on its own thread
+	void OnCameraFrameAvailable(const FTangoBackendImage& Image);
+	void OnNewDataAvailable();
 
 private:
 
@@ -75,13 +82,33 @@ private:
 	ConnectionState State;
 
 	bool TexturesReady();
-	void OnNewDataAvailable();
 	void CheckConnectCallback();
 
-	bool bNewDataAvailable;
+	TangoCameraImageState ImageState;
+	FTangoCameraImageSnapshot LatchedImage;
+	uint64 LatchedImageFrame;
+
+	//Y, Cr and Cb as the service writes them
+	int32 TextureWidths[3];
+	int32 TextureHeights[3];
+	UTexture2D* GetPlaneTexture(int32 Plane);
+
+	//Render thread only. Copies the textures the service wrote into a slot of the ring.
+	bool CopyToSlot(int32 Slot);
+	//Turned off if copying fails, consumers then sample the textures of the service directly.
+	bool bUseTextureRing;
+	uint32 CopyFramebuffer;
+	uint32 RingTextureNames[TangoCameraImageState::NumSlots][3];
+
+	//The frame synchronizer holds up to two frames, this leaves room for a consumer and the frame being written.
+	static const int32 CameraFramePoolSize = 4;
+	bool bFrameCallbackConnected;
+	TSharedPtr<TangoCameraFramePool, ESPMode::ThreadSafe> CameraFramePool;
 public:
-	bool IsNewDataAvail() { return bNewDataAvailable; }
-	void DataSet(double Stamp) { bNewDataAvailable = false; bTexturesHaveDataInThem = true; ImageBufferTimestamp = Stamp; }
+	//Render thread: true once for every batch of images signaled by the service.
+	bool ConsumeNewData() { return ImageState.ConsumeFrameAvailable(); }
+	//Render thread: the textures were updated with the image taken at Stamp. Copies them into the next slot of the ring and publishes it.
+	void DataSet(double Stamp, uint32 FrameNumber);
 
 	TSharedPtr< FTangoViewExtension, ESPMode::ThreadSafe > ViewExtension;
 };
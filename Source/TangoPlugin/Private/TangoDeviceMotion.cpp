@@ -17,6 +17,8 @@ limitations under the License.*/
 #include "TangoDeviceMotion.h"
 #include "TangoFromToCObject.h"
 #include "TangoCoordinateConversions.h"
+#include "TangoStats.h"
+#include "TangoTracer.h"
 
 #include "TangoDevice.h"
 
@@ -36,27 +38,24 @@ void UTangoDeviceMotion::ProperInitialize()
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceMotion::Initialize: called"));
 #if PLATFORM_ANDROID
 #endif
-	CheckForChangeInRequests();
+	//A new helper always has to connect its callback, whatever was requested before.
+	//Requests made before the extrinsics were known are resolved again.
+	TangoMotionSubscriptionRegistry& Subscriptions = UTangoDevice::Get().MotionSubscriptions;
+	Subscriptions.MarkDirty();
+	Subscriptions.RebuildIfDirty();
+	Subscriptions.ConsumeQueriedPairsChanged();
+	ConnectCallback();
 	bIsProperlyInitialized = true;
 }
 
 void UTangoDeviceMotion::ConnectCallback()
 {
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceMotion::ConnectCallback: called"));
-#if PLATFORM_ANDROID
-	TangoCoordinateFramePair Pairs[RequestedPairs.Num()];
-	int i = 0;
-	for (auto& Elem : RequestedPairs)
-	{
-		Pairs[i].base = static_cast<TangoCoordinateFrameType>(static_cast<int32>(Elem.Key.BaseFrame));
-		Pairs[i].target = static_cast<TangoCoordinateFrameType>(static_cast<int32>(Elem.Key.TargetFrame));
-		i++;
-	}
-	if (TangoService_connectOnPoseAvailable(RequestedPairs.Num(), Pairs, [](void*, const TangoPoseData* Pose) {if (UTangoDevice::Get().GetTangoDeviceMotionPointer() != nullptr)UTangoDevice::Get().GetTangoDeviceMotionPointer()->OnPoseAvailable(Pose); }) != TANGO_SUCCESS)
+	UTangoDevice::Get().MotionSubscriptions.GetQueriedPairs(ConnectedPairs);
+	if (!UTangoDevice::Get().GetBackend().ConnectOnPoseAvailable(ConnectedPairs))
 	{
 		UE_LOG(TangoPlugin, Error, TEXT("UTangoDeviceMotion::ConnectCallback: Was unsuccessfull"));
 	}
-#endif
 	bCallbackIsConnected = true;
 }
 
@@ -67,12 +66,13 @@ void UTangoDeviceMotion::BeginDestroy()
 }
 
 
-/** Function called by the Tango Library with head pose data.
+/** Function called by the backend with head pose data.
 */
-#if PLATFORM_ANDROID
-void UTangoDeviceMotion::OnPoseAvailable(const TangoPoseData* Pose)
+void UTangoDeviceMotion::OnPoseAvailable(const FTangoBackendPose& Pose)
 {
-	FTangoPoseData Data = FromCPointer(Pose);
+	INC_DWORD_STAT(STAT_TangoPosesReceived);
+	UTangoDevice::Get().SessionRecorder.RecordPose(Pose.Timestamp, Pose.BaseFrame, Pose.TargetFrame, Pose.StatusCode, Pose.Translation, Pose.Orientation);
+	FTangoPoseData Data = FromBackendObject(Pose);
 	if (Data.FrameOfReference.BaseFrame == ETangoCoordinateFrameType::PREVIOUS_DEVICE_POSE && Data.FrameOfReference.TargetFrame == ETangoCoordinateFrameType::DEVICE)
 	{
 		PoseMutex.Lock();
@@ -93,15 +93,19 @@ void UTangoDeviceMotion::OnPoseAvailable(const TangoPoseData* Pose)
 	else
 	{
 		PoseMutex.Lock();
+		//A pose the game thread has not broadcast yet is replaced
+		if (BroadcastTangoPoseData.Contains(Data.FrameOfReference))
+		{
+			INC_DWORD_STAT(STAT_TangoPosesDropped);
+		}
 		BroadcastTangoPoseData.FindOrAdd(Data.FrameOfReference) = Data;
 		PoseMutex.Unlock();
 	}
 }
-#endif
 
 //START - Tango Motion functions
 
-FTangoPoseData UTangoDeviceMotion::GetPoseAtTime(FTangoCoordinateFramePair FrameOfReference, float Timestamp)
+FTangoPoseData UTangoDeviceMotion::GetPoseAtTime(FTangoCoordinateFramePair FrameOfReference, double Timestamp)
 {
     //Prevent Tango calls before the system is ready, return null data instead
     if(!(UTangoDevice::Get().IsTangoServiceRunning()))
@@ -123,8 +127,10 @@ FTangoPoseData UTangoDeviceMotion::GetPoseAtTime(FTangoCoordinateFramePair Frame
 
 	if (SpaceConverter.bIsStatic)//Just querying extrinsics
 	{
+		SCOPE_CYCLE_COUNTER(STAT_TangoGetPoseAtTimeCached);
 		TangoSpaceConversions::ModifyPose(BlueprintFriendlyPoseData, SpaceConverter);
 		BlueprintFriendlyPoseData.Timestamp = Timestamp;
+		BlueprintFriendlyPoseData.PreciseTimestamp = Timestamp;
 		return BlueprintFriendlyPoseData;
 	}
 	else if (SpaceConverter.bNeedToBeQueriedFromDevice)
@@ -132,19 +138,15 @@ FTangoPoseData UTangoDeviceMotion::GetPoseAtTime(FTangoCoordinateFramePair Frame
 		FrameOfReference.TargetFrame = ETangoCoordinateFrameType::DEVICE;
 	}
 
-#if PLATFORM_ANDROID
-	TangoPoseData Result;
-
-	////Remember to observe the Tango status in case the system isn't ready yet
-	TangoErrorType ResultOfServiceCall;
-	if (TangoService_getPoseAtTime(static_cast<double> (Timestamp), ToCObject(FrameOfReference), &Result) != TANGO_SUCCESS)
+	SCOPE_CYCLE_COUNTER(STAT_TangoGetPoseAtTimeService);
+	FTangoBackendPose Result;
+	if (!UTangoDevice::Get().GetBackend().GetPoseAtTime(Timestamp, FrameOfReference, Result))
 	{
-		UE_LOG(TangoPlugin, Warning, TEXT("UTangoDeviceMotion::GetPoseAtTime: TangoService_getPoseAtTime not successful"));
+		UE_LOG(TangoPlugin, Warning, TEXT("UTangoDeviceMotion::GetPoseAtTime: GetPoseAtTime of the backend not successful"));
 		//return a generic object
 		return FTangoPoseData();
 	}
-	BlueprintFriendlyPoseData = FromCPointer(&Result);
-#endif
+	BlueprintFriendlyPoseData = FromBackendObject(Result);
 	TangoSpaceConversions::ModifyPose(BlueprintFriendlyPoseData, SpaceConverter);
 	return BlueprintFriendlyPoseData;
 }
@@ -156,124 +158,56 @@ bool UTangoDeviceMotion::IsTickable() const
 
 TStatId UTangoDeviceMotion::GetStatId() const
 {
-	return TStatId();
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTangoDeviceMotion, STATGROUP_Tango);
 }
 
 
 void UTangoDeviceMotion::Tick(float DeltaTime)
 {
+	CheckForChangeInRequests();
+
+	SCOPE_CYCLE_COUNTER(STAT_TangoPoseBroadcast);
+	TANGO_TRACE_SCOPE("Pose.Broadcast", 0.0);
 	PoseMutex.Lock();
 	TMap<FTangoCoordinateFramePair, FTangoPoseData> BroadcastTangoPoseDataCopy = BroadcastTangoPoseData;
-	BroadcastTangoPoseData.Empty(RequestedPairs.Num());
+	BroadcastTangoPoseData.Empty(ConnectedPairs.Num());
 	PoseMutex.Unlock();
+	INC_DWORD_STAT_BY(STAT_TangoPosesProcessed, BroadcastTangoPoseDataCopy.Num());
 	
+	TangoMotionSubscriptionRegistry& Subscriptions = UTangoDevice::Get().MotionSubscriptions;
 	for (auto& Elem : BroadcastTangoPoseDataCopy)
 	{
-		auto& BroadCastPairs = RequestedPairs[Elem.Key];
-		for (auto& BroadCastPair : BroadCastPairs)
-		{
-			FTangoPoseData Pose = Elem.Value;
-			TangoSpaceConversions::ModifyPose(Pose, BroadCastPair.Value.RequestedSpace);
-			for (int32 ComponentID : BroadCastPair.Value.ComponentIDs)
-			{
-				if (UTangoDevice::Get().MotionComponents[ComponentID] != nullptr)
-				{
-					UTangoDevice::Get().MotionComponents[ComponentID]->OnTangoPoseAvailable.Broadcast(Pose, BroadCastPair.Key);
-				}
-			}
-		}
+		Subscriptions.Broadcast(Elem.Key, Elem.Value);
 	}
 }
 
 void UTangoDeviceMotion::ResetMotionTracking()
 {
 	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceMotion::ResetMotionTracking: Called"));
-#if PLATFORM_ANDROID
-	TangoService_resetMotionTracking();
-#endif
+	UTangoDevice::Get().GetBackend().ResetMotionTracking();
 }
 
 bool UTangoDeviceMotion::IsLocalized()
 {
 	//@TODO: See if there's a cleaner way to poll the service than getting entire pose value and checking the validity.
-#if PLATFORM_ANDROID
-	TangoPoseData Result;
-
-	////Remember to observe the Tango status in case the system isn't ready yet
-	TangoErrorType ResultOfServiceCall;
-	TangoCoordinateFramePair ADFFramePair = { TANGO_COORDINATE_FRAME_AREA_DESCRIPTION, TANGO_COORDINATE_FRAME_DEVICE };
-
-	ResultOfServiceCall = TangoService_getPoseAtTime(0.0, ADFFramePair, &Result);
-
-	if (ResultOfServiceCall == TANGO_SUCCESS)
-	{
-		if (Result.status_code == TANGO_POSE_VALID)
-		{
-			return true;
-		}
-		else
-		{
-			return false;
-		}
-	}
-	else
+	FTangoBackendPose Result;
+	const FTangoCoordinateFramePair ADFFramePair(ETangoCoordinateFrameType::AREA_DESCRIPTION, ETangoCoordinateFrameType::DEVICE);
+	if (!UTangoDevice::Get().GetBackend().GetPoseAtTime(0.0, ADFFramePair, Result))
 	{
 		UE_LOG(TangoPlugin, Log, TEXT("TangoDeviceAreaLearning::IsLocalized: Could not successfully call GetPoseAtTime!"));
 		return false;
 	}
-
-#endif
-	//We're not localized if we're not on Android
-	return false;
+	return Result.StatusCode == ETangoPoseStatus::VALID;
 }
 
 void UTangoDeviceMotion::CheckForChangeInRequests()
 {
-	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceMotion::CheckForChangeInRequests: Called"));
-	TMap<FTangoCoordinateFramePair, TMap<FTangoCoordinateFramePair,MotionEventRequestedFramePair>> NewRequestedPairs;
-	for (int32 mc = 0; mc < UTangoDevice::Get().RequestedPairs.Num(); mc++)
-	{
-		for (int32 i = 0; i < UTangoDevice::Get().RequestedPairs[mc].Num(); ++i)
-		{
-			TangoSpaceConversions::TangoSpaceConversionPair RequestPairSpace; //We cannot request any pair so we have to look stuff up
-			if (TangoSpaceConversions::GetSpaceConversionPair(RequestPairSpace, UTangoDevice::Get().RequestedPairs[mc][i]))
-			{
-				FTangoCoordinateFramePair TrueRequestPair;
-				if (RequestPairSpace.bNeedToBeQueriedFromDevice)
-				{
-					TrueRequestPair = FTangoCoordinateFramePair(UTangoDevice::Get().RequestedPairs[mc][i].BaseFrame,ETangoCoordinateFrameType::DEVICE);
-				}
-				else if(RequestPairSpace.bIsStatic)//Ignore static ones
-				{
-					continue;
-				}
-				else
-				{
-					TrueRequestPair = UTangoDevice::Get().RequestedPairs[mc][i];
-				}
-				//Now add this to NewRequestedPairs in order to rebuild it.
-				auto& RequestMap = NewRequestedPairs.FindOrAdd(TrueRequestPair);
-				auto& Entry = RequestMap.FindOrAdd(RequestPairSpace.Pair);
-				Entry.RequestedSpace = RequestPairSpace;
-				Entry.ComponentIDs.AddUnique(mc);
-			}
-		}
-	}
-	if (NewRequestedPairs.Num() == RequestedPairs.Num())
-	{
-		for (auto& Elem : NewRequestedPairs)
-		{
-			if (!RequestedPairs.Contains(Elem.Key))
-			{
-				ConnectCallback();
-				break;
-			}
-		}
-	}
-	else
+	TangoMotionSubscriptionRegistry& Subscriptions = UTangoDevice::Get().MotionSubscriptions;
+	Subscriptions.RebuildIfDirty();
+	//Only reconnect when a pair has to be requested that the callback is not connected for yet.
+	if (Subscriptions.ConsumeQueriedPairsChanged())
 	{
+		UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceMotion::CheckForChangeInRequests: Requested pairs changed, reconnecting"));
 		ConnectCallback();
 	}
-	RequestedPairs = NewRequestedPairs;
-	UE_LOG(TangoPlugin, Log, TEXT("UTangoDeviceMotion::CheckForChangeInRequests: Finished"));
-}
\ No newline at end of file
+}
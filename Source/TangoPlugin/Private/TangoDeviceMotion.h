@@ -16,10 +16,7 @@ limitations under the License.*/
 
 #include "TangoMotionComponent.h"
 #include "TangoCoordinateConversions.h"
-
-#if PLATFORM_ANDROID
-#include "tango_client_api.h"
-#endif
+#include "TangoBackend.h"
 
 #include "TangoDeviceMotion.generated.h"
 
@@ -42,7 +39,7 @@ public:
 	virtual TStatId GetStatId() const override;
 
 	//Tango Motion functions
-	FTangoPoseData GetPoseAtTime(FTangoCoordinateFramePair FrameOfReference, float Timestamp);
+	FTangoPoseData GetPoseAtTime(FTangoCoordinateFramePair FrameOfReference, double Timestamp);
 	
 	void ResetMotionTracking();
 
@@ -50,25 +47,19 @@ public:
 
 	void CheckForChangeInRequests();
 
+	//Called by the backend on its own thread
+	void OnPoseAvailable(const FTangoBackendPose& Pose);
+
 private:
 	bool bIsProperlyInitialized = false;
 
-#if PLATFORM_ANDROID
-	void OnPoseAvailable(const TangoPoseData * Pose);
-#endif
-
 	FCriticalSection PoseMutex;
 
 
 	bool bCallbackIsConnected = false;
 
-	struct MotionEventRequestedFramePair
-	{
-		TangoSpaceConversions::TangoSpaceConversionPair RequestedSpace;
-		TArray<int32> ComponentIDs;
-	};
-
-	TMap<FTangoCoordinateFramePair, TMap<FTangoCoordinateFramePair,MotionEventRequestedFramePair>> RequestedPairs;
+	//The pairs the callback is currently connected for
+	TArray<FTangoCoordinateFramePair> ConnectedPairs;
 	//Stuff used in the Tangothread:
 	TMap<FTangoCoordinateFramePair, FTangoPoseData> BroadcastTangoPoseData;
 };
@@ -15,35 +15,47 @@ limitations under the License.*/
 #include "TangoPluginPrivatePCH.h"
 #include "TangoDevicePointCloud.h"
 #include "TangoPointCloudComponent.h"
+#include "TangoStats.h"
+#include "TangoTracer.h"
 
 #include "TangoDevice.h"
 
 #include <UnrealTemplate.h>
 
-#if PLATFORM_ANDROID
-#include "Android/AndroidJNI.h"
-#include "AndroidApplication.h"
-
-
-/** Static function called by the Tango Library with depth cloud point data.
+/** Function called by the backend with depth cloud point data.
 */
-void TangoDevicePointCloud::OnXYZijAvailable(const TangoXYZij* XYZ_ij)
+void TangoDevicePointCloud::OnPointCloudAvailable(const FTangoBackendPointCloud& PointCloud)
 {
-	if (XYZ_ij->xyz_count <= VertCapacity)
+	INC_DWORD_STAT(STAT_TangoDepthReceived);
+	if (PointCloud.NumPoints <= (int32)VertCapacity)
 	{
 		FScopeLock ScopeLock(&XYZIJLock);
-		if (RawDataB != nullptr && XYZ_ij->xyz != nullptr)
+		if (RawDataB != nullptr && PointCloud.XYZ != nullptr)
 		{
-			memcpy(IJDataB, XYZ_ij->ij, sizeof(uint32_t) * XYZ_ij->ij_cols * XYZ_ij->ij_rows);
-			memcpy(RawDataB, XYZ_ij->xyz, sizeof(float) * 3 * VertCount);
-			NewDataTimeStamp = XYZ_ij->timestamp;
-			VertCount = XYZ_ij->xyz_count;
-			ColumnCount = XYZ_ij->ij_cols;
-			RowCount = XYZ_ij->ij_rows;
+			//The game thread has not swapped in the previous cloud yet
+			if (NewDataTimeStamp != TimeStamp)
+			{
+				INC_DWORD_STAT(STAT_TangoDepthDropped);
+			}
+			const bool bHasIJ = PointCloud.IJ != nullptr && PointCloud.IJRows * PointCloud.IJCols <= (int32)VertCapacity;
+			if (bHasIJ)
+			{
+				memcpy(IJDataB, PointCloud.IJ, sizeof(uint32) * PointCloud.IJCols * PointCloud.IJRows);
+			}
+			memcpy(RawDataB, PointCloud.XYZ, sizeof(float) * 3 * PointCloud.NumPoints);
+			NewDataTimeStamp = PointCloud.Timestamp;
+			VertCount = PointCloud.NumPoints;
+			ColumnCount = bHasIJ ? PointCloud.IJCols : 0;
+			RowCount = bHasIJ ? PointCloud.IJRows : 0;
 		}
 	}
+	else
+	{
+		INC_DWORD_STAT(STAT_TangoDepthDropped);
+	}
+	UTangoDevice::Get().FrameSynchronizer.PushDepth(PointCloud.Timestamp, PointCloud.XYZ, PointCloud.NumPoints);
+	UTangoDevice::Get().SessionRecorder.RecordDepth(PointCloud.Timestamp, PointCloud.XYZ, PointCloud.NumPoints, PointCloud.IJ, PointCloud.IJRows, PointCloud.IJCols);
 }
-#endif
 
 int32 TangoDevicePointCloud::GetMaxVertexCapacity()
 {
@@ -55,21 +67,22 @@ TArray<FVector>& TangoDevicePointCloud::GetPointCloud()
 	return PointCloudValues;
 }
 
-float TangoDevicePointCloud::GetPointCloudTimestamp()
+double TangoDevicePointCloud::GetPointCloudTimestamp()
 {
 	return TimeStamp;
 }
 void TangoDevicePointCloud::TickByDevice()
 {
-#if PLATFORM_ANDROID
-
+	SCOPE_CYCLE_COUNTER(STAT_TangoPointCloudTick);
 	bool bIsNewDataAvailable = false;
 	int Count = 0;
 
 	if (TimeStamp != NewDataTimeStamp)
 	{
+		FTangoTraceScope Trace(TEXT("PointCloud.Swap"));
 		FScopeLock ScopeLock(&XYZIJLock);
 		TimeStamp = NewDataTimeStamp;
+		Trace.SetTangoTimestamp(TimeStamp);
 		bIsNewDataAvailable = true;
 		Count = VertCount;
 		//Swap buffers
@@ -85,14 +98,13 @@ void TangoDevicePointCloud::TickByDevice()
 
 	if (bIsNewDataAvailable)
 	{
-		float WorldScale = UTangoDevice::Get().GetMetersToWorldScale();
-		PointCloudValues.SetNum(Count, false);
-		for (int i = 0; i < Count; ++i)
+		INC_DWORD_STAT(STAT_TangoDepthProcessed);
 		{
-			PointCloudValues[i].X = RawData[i][2] * WorldScale;
-			PointCloudValues[i].Y = RawData[i][0] * WorldScale;
-			PointCloudValues[i].Z = -RawData[i][1] * WorldScale;
+			TANGO_TRACE_SCOPE("PointCloud.Convert", TimeStamp);
+			PointCloudValues.SetNum(Count, false);
+			ConvertPoints(RawData, Count, UTangoDevice::Get().GetMetersToWorldScale(), PointCloudValues.GetData());
 		}
+		TANGO_TRACE_SCOPE("PointCloud.Broadcast", TimeStamp);
 		for (int i = 0; i < UTangoDevice::Get().PointCloudComponents.Num(); ++i)
 		{
 			if (UTangoDevice::Get().PointCloudComponents[i] != nullptr)
@@ -106,63 +118,69 @@ void TangoDevicePointCloud::TickByDevice()
 			}
 		}
 	}
-#endif
 }
 
-TangoDevicePointCloud::TangoDevicePointCloud(
-#if PLATFORM_ANDROID
-	TangoConfig Config_
-#endif
-	)
+void TangoDevicePointCloud::ConvertPoints(const float(*XYZ)[3], int32 Count, float WorldScale, FVector* OutPoints)
+{
+	for (int32 i = 0; i < Count; ++i)
+	{
+		OutPoints[i].X = XYZ[i][2] * WorldScale;
+		OutPoints[i].Y = XYZ[i][0] * WorldScale;
+		OutPoints[i].Z = -XYZ[i][1] * WorldScale;
+	}
+}
+
+TangoDevicePointCloud::TangoDevicePointCloud(int32 MaxPointCloudElements)
 {
 	UE_LOG(TangoPlugin, Log, TEXT("TangoDevicePointCloud::TangoDevicePointCloud: Creating TangoDevicePointCloud!"));
 	//Setting up Point Cloud Buffers
 	TimeStamp = 0;
-#if PLATFORM_ANDROID
-
 	NewDataTimeStamp = 0;
-	int MaxPointCloudElements = 0;
-	bool bSuccess = TangoConfig_getInt32(Config_, "max_point_cloud_elements", &MaxPointCloudElements) == TANGO_SUCCESS;
-	uint32_t MaxPointCloudVertexCount = static_cast<uint32_t>(MaxPointCloudElements);
+	VertCount = 0;
+	VertCapacity = 0;
+	ColumnCount = 0;
+	RowCount = 0;
+	RawData = nullptr;
+	RawDataB = nullptr;
+	IJDataA = nullptr;
+	IJDataB = nullptr;
 
-	if (bSuccess)
+	if (MaxPointCloudElements > 0)
 	{
+		const uint32_t MaxPointCloudVertexCount = static_cast<uint32_t>(MaxPointCloudElements);
 		UE_LOG(TangoPlugin, Log, TEXT("TangoDevicePointCloud::TangoDevicePointCloud: allocations. Max point count: %d"),MaxPointCloudVertexCount);
 		FScopeLock ScopeLock(&XYZIJLock);
-		VertCount = 0;
 		VertCapacity = MaxPointCloudVertexCount;
-		PointCloudValues.Reserve(static_cast<int32_t>(MaxPointCloudElements));
+		PointCloudValues.Reserve(MaxPointCloudElements);
 
 		RawData = new float[MaxPointCloudVertexCount][3];
 		RawDataB = new float[MaxPointCloudVertexCount][3];
 
 		IJDataA = new int32[MaxPointCloudVertexCount];
 		IJDataB = new int32[MaxPointCloudVertexCount];
-
-		ColumnCount = 0;
-		RowCount = 0;
+		INC_MEMORY_STAT_BY(STAT_TangoPointCloudMemory, GetBufferSize());
 	}
 	else
 	{
-		UE_LOG(TangoPlugin, Warning, TEXT("TangoDevicePointCloud::TangoDevicePointCloud: construction failed because read of max_point_cloud_elements was not successful."));
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoDevicePointCloud::TangoDevicePointCloud: construction failed because the backend reported no max_point_cloud_elements."));
 	}
 
-#endif
 	UE_LOG(TangoPlugin, Log, TEXT("TangoDevicePointCloud::TangoDevicePointCloud: Creating TangoDevicePointCloud FINISHED"));
 }
 
 void TangoDevicePointCloud::ConnectCallback()
 {
 	UE_LOG(TangoPlugin, Log, TEXT("TangoDevicePointCloud::ConnectCallback: RegisterCallBack!"));
-#if PLATFORM_ANDROID
-	TangoService_connectOnXYZijAvailable([](void*, const TangoXYZij* XYZ_ij) {UTangoDevice::Get().GetTangoDevicePointCloudPointer()->OnXYZijAvailable(XYZ_ij); });
-#endif
+	if (!UTangoDevice::Get().GetBackend().ConnectOnPointCloudAvailable())
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoDevicePointCloud::ConnectCallback: Was unsuccessfull"));
+	}
 }
 
 TangoDevicePointCloud::~TangoDevicePointCloud()
 {
-#if PLATFORM_ANDROID
 	FScopeLock ScopeLock(&XYZIJLock);
+	DEC_MEMORY_STAT_BY(STAT_TangoPointCloudMemory, GetBufferSize());
 	delete[] RawData;
 	delete[] RawDataB;
 	delete[] IJDataA;
@@ -171,18 +189,17 @@ TangoDevicePointCloud::~TangoDevicePointCloud()
 	RawDataB = nullptr;
 	IJDataA = nullptr;
 	IJDataB = nullptr;
-#endif
+}
+
+SIZE_T TangoDevicePointCloud::GetBufferSize() const
+{
+	//Both sides of the raw and IJ buffers plus the converted points
+	return VertCapacity * (2 * sizeof(float) * 3 + 2 * sizeof(int32) + sizeof(FVector));
 }
 
 int32 * TangoDevicePointCloud::GetIJData(uint32 & _RowCount, uint32 & ColCount)
 {
-#if PLATFORM_ANDROID
 	_RowCount = RowCount;
 	ColCount = ColumnCount;
 	return IJDataA;
-#else
-	_RowCount = 0;
-	ColCount = 0;
-	return nullptr;
-#endif
 }
@@ -15,10 +15,7 @@ limitations under the License.*/
 #pragma once
 
 #include "Object.h"
-
-#if PLATFORM_ANDROID
-#include "tango_client_api.h"
-#endif
+#include "TangoBackend.h"
 
 class TangoDevicePointCloud
 {
@@ -26,29 +23,28 @@ class TangoDevicePointCloud
 public:
 	int32 GetMaxVertexCapacity();
 	TArray<FVector>& GetPointCloud();
-	float GetPointCloudTimestamp();
+	double GetPointCloudTimestamp();
 	void TickByDevice();
 
-	TangoDevicePointCloud(
-#if PLATFORM_ANDROID
-		TangoConfig Config_
-#endif
-		);
+	TangoDevicePointCloud(int32 MaxPointCloudElements);
 	void ConnectCallback();
 	~TangoDevicePointCloud();
 	
 	int32* GetIJData(uint32& _RowCount, uint32& ColCount);
 
+	//Called by the backend on its own thread
+	void OnPointCloudAvailable(const FTangoBackendPointCloud& PointCloud);
+
+	//Depth camera meters to Unreal space, the swizzle TickByDevice does for every new cloud
+	static void ConvertPoints(const float(*XYZ)[3], int32 Count, float WorldScale, FVector* OutPoints);
+
 private:
-#if PLATFORM_ANDROID
-	void OnXYZijAvailable(const TangoXYZij* XYZ_ij);
-#endif
+	//Bytes allocated for VertCapacity points, for the memory stat
+	SIZE_T GetBufferSize() const;
 
 	//Mutex to lock the buffer when being swapped or when b side is written from Tango Thread
 	FCriticalSection XYZIJLock;
 
-#if PLATFORM_ANDROID
-
 	//Of course only Reading is threadsafe from side A - side B should only be touched from the Tango Thread and by the swap.
 	//Raw Data
 	float(*RawData)[3];
@@ -60,7 +56,7 @@ private:
 	uint32 ColumnCount;
 	int32* IJDataA;
 	int32* IJDataB;
-#endif
+
 	uint32_t VertCapacity;
 	//safe Data Timestamp
 	double TimeStamp;
@@ -0,0 +1,82 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoEventKeys.h"
+
+namespace
+{
+	struct FEventKeyEntry
+	{
+		const ANSICHAR* Name;
+		int32 Length;
+		ETangoEventKeyType::Type Key;
+	};
+
+	//Keys as the service sends them
+	const FEventKeyEntry KnownKeys[] =
+	{
+		{ "TangoServiceException", 21, ETangoEventKeyType::KEY_SERVICE_EXCEPTION },
+		{ "FisheyeOverExposed", 18, ETangoEventKeyType::DESCRIPTION_FISHEYE_OVER_EXPOSED },
+		{ "FisheyeUnderExposed", 19, ETangoEventKeyType::DESCRIPTION_FISHEYE_UNDER_EXPOSED },
+		{ "ColorOverExposed", 16, ETangoEventKeyType::DESCRIPTION_COLOR_OVER_EXPOSED },
+		{ "ColorUnderExposed", 17, ETangoEventKeyType::DESCRIPTION_COLOR_UNDER_EXPOSED },
+		{ "TooFewFeaturesTracked", 21, ETangoEventKeyType::DESCRIPTION_TOO_FEW_FEATURES },
+		{ "AreaDescriptionSaveProgress", 27, ETangoEventKeyType::KEY_AREA_DESCRIPTION_SAVE_PROGRESS },
+		{ "Unknown", 7, ETangoEventKeyType::UNKOWN },
+	};
+}
+
+uint32 TangoEventKeys::Hash(const ANSICHAR* EventKey, int32 Length)
+{
+	//Length and three characters are enough to tell the known keys apart, case-insensitively
+	const uint32 First = FCharAnsi::ToLower(EventKey[0]);
+	const uint32 Middle = FCharAnsi::ToLower(EventKey[Length / 2]);
+	const uint32 Last = FCharAnsi::ToLower(EventKey[Length - 1]);
+	return (Length * 2 + (First << 2) + Middle + Last) % TableSize;
+}
+
+bool TangoEventKeys::Classify(const ANSICHAR* EventKey, ETangoEventKeyType::Type& Key)
+{
+	//Index into KnownKeys per hash value, built on first use
+	static struct FTable
+	{
+		int8 Slots[TableSize];
+		FTable()
+		{
+			FMemory::Memset(Slots, -1, sizeof(Slots));
+			for (int32 i = 0; i < ARRAY_COUNT(KnownKeys); ++i)
+			{
+				check(FCStringAnsi::Strlen(KnownKeys[i].Name) == KnownKeys[i].Length);
+				const uint32 Slot = Hash(KnownKeys[i].Name, KnownKeys[i].Length);
+				//A new key has to keep the hash perfect
+				check(Slots[Slot] == -1);
+				Slots[Slot] = (int8)i;
+			}
+		}
+	} Table;
+
+	if (EventKey == nullptr || EventKey[0] == '\0')
+	{
+		return false;
+	}
+	const int32 Length = FCStringAnsi::Strlen(EventKey);
+	const int32 Index = Table.Slots[Hash(EventKey, Length)];
+	if (Index < 0 || KnownKeys[Index].Length != Length || FCStringAnsi::Stricmp(EventKey, KnownKeys[Index].Name) != 0)
+	{
+		return false;
+	}
+	Key = KnownKeys[Index].Key;
+	return true;
+}
@@ -0,0 +1,32 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoDataTypes.h"
+
+/*
+ * Classifies the raw event keys of the service. Runs on the Tango event thread, so it works on the char string as it comes:
+ * a perfect hash over the known keys picks the only candidate, which is then compared once.
+ */
+class TangoEventKeys
+{
+public:
+	//Returns false for keys the plugin does not know, Key is left untouched then.
+	static bool Classify(const ANSICHAR* EventKey, ETangoEventKeyType::Type& Key);
+
+private:
+	static const int32 TableSize = 16;
+	static uint32 Hash(const ANSICHAR* EventKey, int32 Length);
+};
@@ -0,0 +1,203 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoExtrinsicsCache.h"
+#include "TangoFromToCObject.h"
+#include "TangoDevice.h"
+
+namespace
+{
+	//Bump this whenever the layout of the cache file changes.
+	static const uint32 ExtrinsicsCacheMagic = 0x54455843; //'TEXC'
+	static const uint32 ExtrinsicsCacheVersion = 2;
+
+	static bool GetOffsetMatrix(FTangoCoordinateFramePair Pair, FMatrix& Matrix)
+	{
+		FTangoBackendPose Result;
+		const bool bQueried = UTangoDevice::Get().GetBackend().GetPoseAtTime(0.0, Pair, Result);
+		FTangoPoseData D = bQueried ? FromBackendObject(Result) : FTangoPoseData();
+		Matrix = FTransform(D.QuatRotation, D.Position).ToMatrixNoScale();
+		if (!(bQueried && D.StatusCode == ETangoPoseStatus::VALID))
+		{
+			UE_LOG(TangoPlugin, Warning, TEXT("TangoExtrinsicsCache::GetOffsetMatrix: failed for %d and %d"), (int32)(Pair.BaseFrame), (int32)(Pair.TargetFrame));
+		}
+		return (bQueried && D.StatusCode == ETangoPoseStatus::VALID);
+	}
+}
+
+FString TangoExtrinsicsCache::GetModelName()
+{
+	FString Model;
+#if PLATFORM_ANDROID
+	Model = FPlatformMisc::GetDeviceModel();
+#endif
+	if (Model.IsEmpty())
+	{
+		Model = FPlatformProperties::PlatformName();
+	}
+	//Make sure the model name is usable as a file name
+	for (TCHAR& Character : Model.GetCharArray())
+	{
+		if (Character != 0 && !FChar::IsAlnum(Character))
+		{
+			Character = TEXT('_');
+		}
+	}
+	return Model;
+}
+
+FString TangoExtrinsicsCache::GetCacheFilePath(uint32 CalibrationHash)
+{
+	//A recalibrated unit of the same model gets a cache of its own
+	return FPaths::Combine(*FPaths::GameSavedDir(), TEXT("Tango"), *FString::Printf(TEXT("Extrinsics_%s_%08X.bin"), *GetModelName(), CalibrationHash));
+}
+
+FString TangoExtrinsicsCache::FindLatestCacheFile()
+{
+	const FString Directory = FPaths::Combine(*FPaths::GameSavedDir(), TEXT("Tango"));
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *FPaths::Combine(*Directory, *FString::Printf(TEXT("Extrinsics_%s_*.bin"), *GetModelName())), true, false);
+	FString Latest;
+	FDateTime LatestTime = FDateTime::MinValue();
+	for (const FString& File : Files)
+	{
+		const FString Path = FPaths::Combine(*Directory, *File);
+		const FDateTime Time = IFileManager::Get().GetTimeStamp(*Path);
+		if (Latest.IsEmpty() || Time > LatestTime)
+		{
+			Latest = Path;
+			LatestTime = Time;
+		}
+	}
+	return Latest;
+}
+
+uint32 TangoExtrinsicsCache::QueryCalibrationHash()
+{
+	TArray<FTangoCameraIntrinsics> Intrinsics;
+	const ETangoCameraType::Type Cameras[] = { ETangoCameraType::COLOR, ETangoCameraType::DEPTH, ETangoCameraType::FISHEYE };
+	for (ETangoCameraType::Type Camera : Cameras)
+	{
+		FTangoCameraIntrinsics CameraIntrinsics;
+		if (UTangoDevice::Get().GetBackend().GetCameraIntrinsics(Camera, CameraIntrinsics))
+		{
+			CameraIntrinsics.CameraID = Camera;
+			Intrinsics.Add(CameraIntrinsics);
+		}
+	}
+	return HashCalibration(Intrinsics);
+}
+
+uint32 TangoExtrinsicsCache::HashCalibration(const TArray<FTangoCameraIntrinsics>& Intrinsics)
+{
+	uint32 Hash = 0;
+	//Always in the same order, however the intrinsics were collected
+	const ETangoCameraType::Type Cameras[] = { ETangoCameraType::COLOR, ETangoCameraType::DEPTH, ETangoCameraType::FISHEYE };
+	for (ETangoCameraType::Type Camera : Cameras)
+	{
+		const FTangoCameraIntrinsics* Found = Intrinsics.FindByPredicate([Camera](const FTangoCameraIntrinsics& Candidate) { return Candidate.CameraID == Camera; });
+		if (Found != nullptr && Found->Distortion.Num() >= 5)
+		{
+			float Values[9] = { Found->Fx, Found->Fy, (float)Found->Cx, (float)Found->Cy,
+				Found->Distortion[0], Found->Distortion[1], Found->Distortion[2], Found->Distortion[3], Found->Distortion[4] };
+			Hash = FCrc::MemCrc32(Values, sizeof(Values), Hash);
+		}
+	}
+	return Hash;
+}
+
+bool TangoExtrinsicsCache::QueryFromService(FTangoDeviceExtrinsics& Extrinsics)
+{
+	bool bSuccess = GetOffsetMatrix(FTangoCoordinateFramePair(ETangoCoordinateFrameType::IMU, ETangoCoordinateFrameType::DEVICE), Extrinsics.IMUtoDEVICE);
+	bSuccess = bSuccess && GetOffsetMatrix(FTangoCoordinateFramePair(ETangoCoordinateFrameType::IMU, ETangoCoordinateFrameType::CAMERA_COLOR), Extrinsics.IMUtoCOLOR);
+	bSuccess = bSuccess && GetOffsetMatrix(FTangoCoordinateFramePair(ETangoCoordinateFrameType::IMU, ETangoCoordinateFrameType::CAMERA_FISHEYE), Extrinsics.IMUtoFISHEYE);
+	bSuccess = bSuccess && GetOffsetMatrix(FTangoCoordinateFramePair(ETangoCoordinateFrameType::IMU, ETangoCoordinateFrameType::CAMERA_DEPTH), Extrinsics.IMUtoDEPTH);
+	Extrinsics.CalibrationHash = bSuccess ? QueryCalibrationHash() : 0;
+	Extrinsics.bIsValid = bSuccess;
+	return bSuccess;
+}
+
+bool TangoExtrinsicsCache::Load(FTangoDeviceExtrinsics& Extrinsics, uint32 CalibrationHash)
+{
+	//Before the connection the calibration is unknown, VerifyExtrinsicsAsync replaces the offsets of the last one if it changed
+	const FString Path = CalibrationHash != 0 ? GetCacheFilePath(CalibrationHash) : FindLatestCacheFile();
+	TUniquePtr<FArchive> Reader(Path.IsEmpty() ? nullptr : IFileManager::Get().CreateFileReader(*Path));
+	if (!Reader.IsValid())
+	{
+		UE_LOG(TangoPlugin, Log, TEXT("TangoExtrinsicsCache::Load: No cached extrinsics for calibration %08X of %s"), CalibrationHash, *GetModelName());
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*Reader << Magic;
+	*Reader << Version;
+	if (Magic != ExtrinsicsCacheMagic || Version != ExtrinsicsCacheVersion)
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoExtrinsicsCache::Load: Ignoring outdated cache file %s"), *Path);
+		return false;
+	}
+
+	FTangoDeviceExtrinsics Loaded;
+	*Reader << Loaded.CalibrationHash;
+	*Reader << Loaded.IMUtoDEVICE;
+	*Reader << Loaded.IMUtoCOLOR;
+	*Reader << Loaded.IMUtoFISHEYE;
+	*Reader << Loaded.IMUtoDEPTH;
+	if (Reader->IsError())
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoExtrinsicsCache::Load: Cache file %s is corrupt"), *Path);
+		return false;
+	}
+	Loaded.bIsValid = true;
+	Extrinsics = Loaded;
+	UE_LOG(TangoPlugin, Log, TEXT("TangoExtrinsicsCache::Load: Loaded extrinsics from %s"), *Path);
+	return true;
+}
+
+bool TangoExtrinsicsCache::Save(const FTangoDeviceExtrinsics& Extrinsics)
+{
+	if (!Extrinsics.bIsValid)
+	{
+		return false;
+	}
+	const FString Path = GetCacheFilePath(Extrinsics.CalibrationHash);
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Path));
+	if (!Writer.IsValid())
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoExtrinsicsCache::Save: Unable to open %s for writing"), *Path);
+		return false;
+	}
+
+	FTangoDeviceExtrinsics Copy = Extrinsics;
+	uint32 Magic = ExtrinsicsCacheMagic;
+	uint32 Version = ExtrinsicsCacheVersion;
+	*Writer << Magic;
+	*Writer << Version;
+	*Writer << Copy.CalibrationHash;
+	*Writer << Copy.IMUtoDEVICE;
+	*Writer << Copy.IMUtoCOLOR;
+	*Writer << Copy.IMUtoFISHEYE;
+	*Writer << Copy.IMUtoDEPTH;
+	//Close flushes, which can fail as well
+	Writer->Close();
+	if (Writer->IsError())
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoExtrinsicsCache::Save: Unable to write %s"), *Path);
+		return false;
+	}
+	UE_LOG(TangoPlugin, Log, TEXT("TangoExtrinsicsCache::Save: Wrote extrinsics to %s"), *Path);
+	return true;
+}
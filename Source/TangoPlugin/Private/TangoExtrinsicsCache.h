@@ -0,0 +1,72 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+#include "TangoDataTypes.h"
+
+/*
+ * The IMU to sensor offsets of the device. These never change for a given device and calibration,
+ * so they are persisted to disk and reused on the next startup before the service is even connected.
+ */
+struct FTangoDeviceExtrinsics
+{
+	FMatrix IMUtoDEVICE;
+	FMatrix IMUtoCOLOR;
+	FMatrix IMUtoFISHEYE;
+	FMatrix IMUtoDEPTH;
+	//CRC of the camera intrinsics the offsets were captured with. A recalibrated device will produce a different value.
+	uint32 CalibrationHash;
+	bool bIsValid;
+
+	FTangoDeviceExtrinsics()
+		: IMUtoDEVICE(FMatrix::Identity)
+		, IMUtoCOLOR(FMatrix::Identity)
+		, IMUtoFISHEYE(FMatrix::Identity)
+		, IMUtoDEPTH(FMatrix::Identity)
+		, CalibrationHash(0)
+		, bIsValid(false)
+	{
+	}
+
+	bool Equals(const FTangoDeviceExtrinsics& Other, float Tolerance = KINDA_SMALL_NUMBER) const
+	{
+		return CalibrationHash == Other.CalibrationHash
+			&& IMUtoDEVICE.Equals(Other.IMUtoDEVICE, Tolerance)
+			&& IMUtoCOLOR.Equals(Other.IMUtoCOLOR, Tolerance)
+			&& IMUtoFISHEYE.Equals(Other.IMUtoFISHEYE, Tolerance)
+			&& IMUtoDEPTH.Equals(Other.IMUtoDEPTH, Tolerance);
+	}
+};
+
+class TangoExtrinsicsCache
+{
+public:
+	//Loads the extrinsics stored for this device model and calibration. Returns false if there is no (valid) cache file.
+	//A CalibrationHash of 0 stands for an unknown calibration and loads the most recently written cache of the model.
+	static bool Load(FTangoDeviceExtrinsics& Extrinsics, uint32 CalibrationHash);
+	//Writes the extrinsics for this device model and their calibration to disk.
+	static bool Save(const FTangoDeviceExtrinsics& Extrinsics);
+
+	//Queries all offsets from the running Tango service. Can be called from any thread.
+	static bool QueryFromService(FTangoDeviceExtrinsics& Extrinsics);
+	//Of the intrinsics of the connected service, 0 if it has none
+	static uint32 QueryCalibrationHash();
+	//Of the given intrinsics, e.g. the ones stored in a session recording
+	static uint32 HashCalibration(const TArray<FTangoCameraIntrinsics>& Intrinsics);
+
+private:
+	static FString GetModelName();
+	static FString GetCacheFilePath(uint32 CalibrationHash);
+	static FString FindLatestCacheFile();
+};
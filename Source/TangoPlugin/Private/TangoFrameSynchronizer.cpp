@@ -0,0 +1,328 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoFrameSynchronizer.h"
+#include "TangoCoordinateConversions.h"
+#include "TangoFromToCObject.h"
+#include "TangoDevice.h"
+#include "TangoTracer.h"
+
+namespace
+{
+	//Depth is usually a bit older than the newest color frame, but give color this long (wall clock) to catch up before giving up.
+	static const double MaxWaitForColor = 0.1;
+	//Color frames kept for matching. Only the newest ones keep their pooled frame alive, the rest only serve as timestamps.
+	static const int32 MaxColorHistory = 8;
+	static const int32 MaxHeldColorFrames = 2;
+	static const uint32 PollIntervalMs = 5;
+}
+
+TangoFrameSynchronizer::TangoFrameSynchronizer()
+	: Thread(nullptr)
+	, WakeUpEvent(nullptr)
+	, bIsActive(false)
+	, Tolerance(0.02)
+	, TotalMatchLatency(0.0)
+	, TotalTimestampDelta(0.0)
+{
+}
+
+TangoFrameSynchronizer::~TangoFrameSynchronizer()
+{
+	if (Thread != nullptr)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	if (WakeUpEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+		WakeUpEvent = nullptr;
+	}
+}
+
+void TangoFrameSynchronizer::StartThread()
+{
+	if (Thread != nullptr || !FPlatformProcess::SupportsMultithreading())
+	{
+		return;
+	}
+	WakeUpEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("TangoFrameSynchronizer"), 0, TPri_Normal);
+}
+
+FDelegateHandle TangoFrameSynchronizer::AddConsumer(const FTangoOnFrameBundle::FDelegate& Consumer)
+{
+	FScopeLock ScopeLock(&ConsumerLock);
+	FDelegateHandle Handle = Consumers.Add(Consumer);
+	StartThread();
+	bIsActive = Thread != nullptr;
+	if (WakeUpEvent != nullptr)
+	{
+		WakeUpEvent->Trigger();
+	}
+	return Handle;
+}
+
+void TangoFrameSynchronizer::RemoveConsumer(FDelegateHandle Handle)
+{
+	FScopeLock ScopeLock(&ConsumerLock);
+	Consumers.Remove(Handle);
+	//The thread stays around parked on its event, no more frames are queued for it.
+	bIsActive = Thread != nullptr && Consumers.IsBound();
+}
+
+void TangoFrameSynchronizer::SetPoseProvider(TFunction<bool(double, FTangoPoseData&)> Provider)
+{
+	FScopeLock ScopeLock(&ConsumerLock);
+	PoseProvider = Provider;
+}
+
+void TangoFrameSynchronizer::PushDepth(double Timestamp, const float (*XYZ)[3], int32 Count)
+{
+	if (!bIsActive)
+	{
+		return;
+	}
+	TANGO_TRACE_SCOPE("FrameSync.CopyDepth", Timestamp);
+	FTangoDepthFrame* Depth = new FTangoDepthFrame();
+	Depth->Timestamp = Timestamp;
+	Depth->Points.SetNumUninitialized(Count);
+	for (int32 i = 0; i < Count; ++i)
+	{
+		Depth->Points[i] = FVector(XYZ[i][0], XYZ[i][1], XYZ[i][2]);
+	}
+	FInput Input;
+	Input.ArrivalTime = FPlatformTime::Seconds();
+	Input.Timestamp = Timestamp;
+	Input.Depth = MakeShareable(Depth);
+	Inputs.Enqueue(Input);
+	WakeUpEvent->Trigger();
+}
+
+void TangoFrameSynchronizer::PushColor(double Timestamp, const FTangoCameraFrameHandle& Frame)
+{
+	if (!bIsActive)
+	{
+		return;
+	}
+	FInput Input;
+	Input.ArrivalTime = FPlatformTime::Seconds();
+	Input.Timestamp = Timestamp;
+	Input.Color = Frame;
+	Inputs.Enqueue(Input);
+	WakeUpEvent->Trigger();
+}
+
+uint32 TangoFrameSynchronizer::Run()
+{
+	while (!bStopping)
+	{
+		if (!bIsActive)
+		{
+			//Nobody takes bundles anymore, give the frames still held back to the pool and sleep until AddConsumer or Stop
+			ProcessInputs();
+			PendingDepth.Reset();
+			ColorHistory.Reset();
+			WakeUpEvent->Wait();
+			continue;
+		}
+		WakeUpEvent->Wait(PollIntervalMs);
+		ProcessInputs();
+		MatchPendingDepth(FPlatformTime::Seconds());
+	}
+	return 0;
+}
+
+void TangoFrameSynchronizer::Stop()
+{
+	bStopping = true;
+	if (WakeUpEvent != nullptr)
+	{
+		WakeUpEvent->Trigger();
+	}
+}
+
+void TangoFrameSynchronizer::ProcessInputs()
+{
+	FInput Input;
+	while (Inputs.Dequeue(Input))
+	{
+		if (Input.Depth.IsValid())
+		{
+			FScopeLock ScopeLock(&StatsLock);
+			Stats.NumDepthFrames++;
+			PendingDepth.Add(Input);
+			continue;
+		}
+		{
+			FScopeLock ScopeLock(&StatsLock);
+			Stats.NumColorFrames++;
+		}
+		//Frames arrive in order, anything older than the newest entry is a duplicate.
+		if (ColorHistory.Num() > 0 && Input.Timestamp <= ColorHistory.Last().Timestamp)
+		{
+			continue;
+		}
+		FColorEntry Entry;
+		Entry.Timestamp = Input.Timestamp;
+		Entry.Frame = Input.Color;
+		Entry.bFrameReleased = false;
+		ColorHistory.Add(Entry);
+		if (ColorHistory.Num() > MaxColorHistory)
+		{
+			ColorHistory.RemoveAt(0, 1, false);
+		}
+		//Give older frames back to the camera pool
+		for (int32 i = 0; i < ColorHistory.Num() - MaxHeldColorFrames; ++i)
+		{
+			if (ColorHistory[i].Frame.IsValid())
+			{
+				ColorHistory[i].Frame.Reset();
+				ColorHistory[i].bFrameReleased = true;
+			}
+		}
+	}
+}
+
+void TangoFrameSynchronizer::MatchPendingDepth(double Now)
+{
+	for (int32 i = 0; i < PendingDepth.Num();)
+	{
+		const FInput& Depth = PendingDepth[i];
+		//Once a color frame newer than the depth frame exists, the nearest one cannot change anymore.
+		const bool bHasNewerColor = ColorHistory.Num() > 0 && ColorHistory.Last().Timestamp >= Depth.Timestamp;
+		const bool bTimedOut = Now - Depth.ArrivalTime > Tolerance + MaxWaitForColor;
+		if (!bHasNewerColor && !bTimedOut)
+		{
+			++i;
+			continue;
+		}
+
+		int32 Nearest = INDEX_NONE;
+		double NearestDelta = Tolerance;
+		for (int32 c = 0; c < ColorHistory.Num(); ++c)
+		{
+			//With CPU frames a bundle without the image is useless to the consumers, so it counts as unmatched
+			if (ColorHistory[c].bFrameReleased)
+			{
+				continue;
+			}
+			const double Delta = FMath::Abs(ColorHistory[c].Timestamp - Depth.Timestamp);
+			if (Delta <= NearestDelta)
+			{
+				Nearest = c;
+				NearestDelta = Delta;
+			}
+		}
+		if (Nearest != INDEX_NONE)
+		{
+			Deliver(Depth, ColorHistory[Nearest]);
+		}
+		else
+		{
+			FScopeLock ScopeLock(&StatsLock);
+			Stats.NumUnmatchedDepthFrames++;
+		}
+		PendingDepth.RemoveAt(i, 1, false);
+	}
+}
+
+bool TangoFrameSynchronizer::QueryPose(double Timestamp, FTangoPoseData& Pose)
+{
+	{
+		FScopeLock ScopeLock(&ConsumerLock);
+		if (PoseProvider)
+		{
+			return PoseProvider(Timestamp, Pose);
+		}
+	}
+	const FTangoCoordinateFramePair Pair(ETangoCoordinateFrameType::START_OF_SERVICE, ETangoCoordinateFrameType::DEVICE);
+	TangoSpaceConversions::TangoSpaceConversionPair SpaceConverter;
+	FTangoBackendPose Result;
+	if (!TangoSpaceConversions::GetSpaceConversionPair(SpaceConverter, Pair) || !UTangoDevice::Get().GetBackend().GetPoseAtTime(Timestamp, Pair, Result))
+	{
+		return false;
+	}
+	Pose = FromBackendObject(Result);
+	TangoSpaceConversions::ModifyPose(Pose, SpaceConverter);
+	return Pose.StatusCode == ETangoPoseStatus::VALID;
+}
+
+void TangoFrameSynchronizer::Deliver(const FInput& Depth, const FColorEntry& Color)
+{
+	FTangoFrameBundle Bundle;
+	Bundle.Depth = Depth.Depth;
+	Bundle.ColorTimestamp = Color.Timestamp;
+	Bundle.ColorFrame = Color.Frame;
+	{
+		TANGO_TRACE_SCOPE("FrameSync.QueryPoses", Depth.Timestamp);
+		if (!QueryPose(Depth.Timestamp, Bundle.DepthPose))
+		{
+			Bundle.DepthPose.StatusCode = ETangoPoseStatus::INVALID;
+		}
+		if (!QueryPose(Color.Timestamp, Bundle.ColorPose))
+		{
+			Bundle.ColorPose.StatusCode = ETangoPoseStatus::INVALID;
+		}
+	}
+
+	{
+		TANGO_TRACE_SCOPE("FrameSync.Consumers", Depth.Timestamp);
+		FScopeLock ScopeLock(&ConsumerLock);
+		Consumers.Broadcast(Bundle);
+	}
+
+	const double Latency = FPlatformTime::Seconds() - Depth.ArrivalTime;
+	FScopeLock ScopeLock(&StatsLock);
+	Stats.NumBundles++;
+	TotalMatchLatency += Latency;
+	TotalTimestampDelta += FMath::Abs(Color.Timestamp - Depth.Timestamp);
+	Stats.MaxMatchLatency = FMath::Max(Stats.MaxMatchLatency, Latency);
+	Stats.AverageMatchLatency = TotalMatchLatency / Stats.NumBundles;
+	Stats.AverageTimestampDelta = TotalTimestampDelta / Stats.NumBundles;
+}
+
+FTangoFrameSyncStats TangoFrameSynchronizer::GetStats() const
+{
+	FScopeLock ScopeLock(&StatsLock);
+	return Stats;
+}
+
+void TangoFrameSynchronizer::ResetStats()
+{
+	FScopeLock ScopeLock(&StatsLock);
+	Stats = FTangoFrameSyncStats();
+	TotalMatchLatency = 0.0;
+	TotalTimestampDelta = 0.0;
+}
+
+namespace
+{
+	void PrintFrameSyncStats()
+	{
+		const FTangoFrameSyncStats Stats = UTangoDevice::Get().FrameSynchronizer.GetStats();
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.FrameSyncStats: depth %llu, color %llu, bundles %llu, unmatched depth %llu, match latency avg %.2f ms max %.2f ms, depth to color %.2f ms"),
+			Stats.NumDepthFrames, Stats.NumColorFrames, Stats.NumBundles, Stats.NumUnmatchedDepthFrames,
+			Stats.AverageMatchLatency * 1000.0, Stats.MaxMatchLatency * 1000.0, Stats.AverageTimestampDelta * 1000.0);
+	}
+
+	static FAutoConsoleCommand FrameSyncStatsCommand(
+		TEXT("Tango.FrameSyncStats"),
+		TEXT("Prints how many depth frames were paired with a color frame and how long pairing took"),
+		FConsoleCommandDelegate::CreateStatic(&PrintFrameSyncStats));
+}
@@ -0,0 +1,127 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoDataTypes.h"
+#include "TangoCameraFramePool.h"
+
+//One depth frame as delivered by the service: meters, in the coordinate frame of the depth camera.
+struct FTangoDepthFrame
+{
+	double Timestamp;
+	TArray<FVector> Points;
+};
+
+//A depth frame together with the color frame closest to it in time and the device poses at both timestamps.
+struct FTangoFrameBundle
+{
+	TSharedPtr<const FTangoDepthFrame, ESPMode::ThreadSafe> Depth;
+	double ColorTimestamp;
+	//Only valid if CPU color frames are enabled, otherwise just the camera texture has the image.
+	FTangoCameraFrameHandle ColorFrame;
+	//START_OF_SERVICE to DEVICE in Unreal space, interpolated by the service at the depth and the color timestamp.
+	FTangoPoseData DepthPose;
+	FTangoPoseData ColorPose;
+};
+
+struct FTangoFrameSyncStats
+{
+	uint64 NumDepthFrames = 0;
+	uint64 NumColorFrames = 0;
+	uint64 NumBundles = 0;
+	//Depth frames without a color frame within the tolerance
+	uint64 NumUnmatchedDepthFrames = 0;
+	//Seconds from the arrival of a depth frame until its bundle was delivered
+	double AverageMatchLatency = 0.0;
+	double MaxMatchLatency = 0.0;
+	//Mean absolute difference between the depth and the color timestamp of delivered bundles
+	double AverageTimestampDelta = 0.0;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FTangoOnFrameBundle, const FTangoFrameBundle&);
+
+/*
+ * Pairs every depth frame with the nearest color frame and the poses at both timestamps.
+ * Matching runs on its own thread, which is started with the first consumer. Consumers are called on that thread.
+ */
+class TangoFrameSynchronizer : public FRunnable
+{
+public:
+	TangoFrameSynchronizer();
+	virtual ~TangoFrameSynchronizer();
+
+	FDelegateHandle AddConsumer(const FTangoOnFrameBundle::FDelegate& Consumer);
+	void RemoveConsumer(FDelegateHandle Handle);
+	bool IsActive() const { return bIsActive; }
+
+	//Can be called from any thread. Frames are ignored while nobody consumes bundles.
+	void PushDepth(double Timestamp, const float (*XYZ)[3], int32 Count);
+	void PushColor(double Timestamp, const FTangoCameraFrameHandle& Frame);
+
+	//How far apart the depth and color timestamps of a bundle may be, in seconds
+	void SetTolerance(double Seconds) { Tolerance = Seconds; }
+	//Replaces the service as the source of poses, e.g. for recorded or synthetic data
+	void SetPoseProvider(TFunction<bool(double, FTangoPoseData&)> Provider);
+
+	FTangoFrameSyncStats GetStats() const;
+	void ResetStats();
+
+	//FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	struct FInput
+	{
+		double ArrivalTime;
+		double Timestamp;
+		TSharedPtr<const FTangoDepthFrame, ESPMode::ThreadSafe> Depth;
+		FTangoCameraFrameHandle Color;
+	};
+	struct FColorEntry
+	{
+		double Timestamp;
+		FTangoCameraFrameHandle Frame;
+		//The frame went back to the pool, a depth frame matched with this entry would come without its image
+		bool bFrameReleased;
+	};
+
+	void StartThread();
+	void ProcessInputs();
+	void MatchPendingDepth(double Now);
+	void Deliver(const FInput& Depth, const FColorEntry& Color);
+	bool QueryPose(double Timestamp, FTangoPoseData& Pose);
+
+	FRunnableThread* Thread;
+	FEvent* WakeUpEvent;
+	FThreadSafeBool bStopping;
+	volatile bool bIsActive;
+	double Tolerance;
+
+	TQueue<FInput, EQueueMode::Mpsc> Inputs;
+
+	//Only touched by the synchronizer thread
+	TArray<FInput> PendingDepth;
+	TArray<FColorEntry> ColorHistory;
+
+	FCriticalSection ConsumerLock;
+	FTangoOnFrameBundle Consumers;
+	TFunction<bool(double, FTangoPoseData&)> PoseProvider;
+
+	mutable FCriticalSection StatsLock;
+	FTangoFrameSyncStats Stats;
+	double TotalMatchLatency;
+	double TotalTimestampDelta;
+};
@@ -14,6 +14,8 @@ limitations under the License.*/
 
 #pragma once
 #include "TangoDataTypes.h"
+#include "TangoEventKeys.h"
+#include "TangoBackend.h"
 
 #if PLATFORM_ANDROID
 #include "tango_client_api.h"
@@ -34,16 +36,27 @@ static TangoCoordinateFramePair ToCObject(FTangoCoordinateFramePair ToConvert)
 	return Result;
 }
 
-static FTangoPoseData FromCPointer(const TangoPoseData* ToConvert)
+//The C enum orders the cameras differently
+static TangoCameraId ToCObject(ETangoCameraType::Type Camera)
 {
-	FTangoPoseData Result;
-	Result.Position = FVector(ToConvert->translation[0], ToConvert->translation[1], ToConvert->translation[2]);
-	Result.Rotation = FRotator(FQuat(ToConvert->orientation[0], ToConvert->orientation[1], ToConvert->orientation[2], ToConvert->orientation[3]));
-	Result.QuatRotation = FQuat(ToConvert->orientation[0], ToConvert->orientation[1], ToConvert->orientation[2], ToConvert->orientation[3]);
-	Result.FrameOfReference = FromCObject(ToConvert->frame);
-	Result.Timestamp = ToConvert->timestamp;
-	Result.StatusCode = (ETangoPoseStatus::Type)ToConvert->status_code;
-	return Result;
+	switch (Camera)
+	{
+	case ETangoCameraType::DEPTH:	return TANGO_CAMERA_DEPTH;
+	case ETangoCameraType::FISHEYE:	return TANGO_CAMERA_FISHEYE;
+	case ETangoCameraType::RGBR:	return TANGO_CAMERA_RGBIR;
+	default:						return TANGO_CAMERA_COLOR;
+	}
+}
+
+static ETangoCameraType::Type FromCObject(TangoCameraId Camera)
+{
+	switch (Camera)
+	{
+	case TANGO_CAMERA_DEPTH:	return ETangoCameraType::DEPTH;
+	case TANGO_CAMERA_FISHEYE:	return ETangoCameraType::FISHEYE;
+	case TANGO_CAMERA_RGBIR:	return ETangoCameraType::RGBR;
+	default:					return ETangoCameraType::COLOR;
+	}
 }
 
 static FTangoCameraIntrinsics FromCObject(TangoCameraIntrinsics ToConvert)
@@ -51,7 +64,17 @@ static FTangoCameraIntrinsics FromCObject(TangoCameraIntrinsics ToConvert)
 
 	FTangoCameraIntrinsics Result;
 
-	Result.CameraID = static_cast<TEnumAsByte<ETangoCameraType::Type>>((int)ToConvert.camera_id);
+	Result.CameraID = FromCObject(ToConvert.camera_id);
+
+	//The order of the C enum differs, UNKNOWN comes first there.
+	switch (ToConvert.calibration_type)
+	{
+	case TANGO_CALIBRATION_EQUIDISTANT:				Result.CalibrationType = ETangoCalibrationType::EQUIDISTANT; break;
+	case TANGO_CALIBRATION_POLYNOMIAL_2_PARAMETERS:	Result.CalibrationType = ETangoCalibrationType::POLYNOMIAL_2_PARAMETERS; break;
+	case TANGO_CALIBRATION_POLYNOMIAL_3_PARAMETERS:	Result.CalibrationType = ETangoCalibrationType::POLYNOMIAL_3_PARAMETERS; break;
+	case TANGO_CALIBRATION_POLYNOMIAL_5_PARAMETERS:	Result.CalibrationType = ETangoCalibrationType::POLYNOMIAL_5_PARAMETERS; break;
+	default:										Result.CalibrationType = ETangoCalibrationType::UNKNOWN; break;
+	}
 
 	Result.Width = static_cast<int32>(ToConvert.width);
 	Result.Height = static_cast<int32> (ToConvert.height);
@@ -80,52 +103,36 @@ static FTangoCameraIntrinsics FromCObject(TangoCameraIntrinsics ToConvert)
 
 }
 
-static FTangoEvent FromCObject(const TangoEvent* Event)
+#endif
+
+static FTangoPoseData FromBackendObject(const FTangoBackendPose& ToConvert)
+{
+	FTangoPoseData Result;
+	Result.Position = FVector(ToConvert.Translation[0], ToConvert.Translation[1], ToConvert.Translation[2]);
+	Result.QuatRotation = FQuat(ToConvert.Orientation[0], ToConvert.Orientation[1], ToConvert.Orientation[2], ToConvert.Orientation[3]);
+	Result.Rotation = FRotator(Result.QuatRotation);
+	Result.FrameOfReference = FTangoCoordinateFramePair((ETangoCoordinateFrameType::Type)ToConvert.BaseFrame, (ETangoCoordinateFrameType::Type)ToConvert.TargetFrame);
+	Result.Timestamp = ToConvert.Timestamp;
+	Result.PreciseTimestamp = ToConvert.Timestamp;
+	Result.StatusCode = (ETangoPoseStatus::Type)ToConvert.StatusCode;
+	return Result;
+}
+
+static FTangoEvent FromBackendObject(const FTangoBackendEvent& Event)
 {
 	FTangoEvent UEvent;
 
-	UEvent.Type = static_cast<ETangoEventType::Type>(Event->type);
+	UEvent.Type = static_cast<ETangoEventType::Type>(Event.Type);
 
-	if (FString(Event->event_key).Equals(TEXT("TangoServiceException"), ESearchCase::IgnoreCase))
-	{
-		UEvent.Key = ETangoEventKeyType::KEY_SERVICE_EXCEPTION;
-	}
-	else if (FString(Event->event_key).Equals(TEXT("FisheyeOverExposed"), ESearchCase::IgnoreCase))
-	{
-		UEvent.Key = ETangoEventKeyType::DESCRIPTION_FISHEYE_OVER_EXPOSED;
-	}
-	else if (FString(Event->event_key).Equals(TEXT("FisheyeUnderExposed"), ESearchCase::IgnoreCase))
-	{
-		UEvent.Key = ETangoEventKeyType::DESCRIPTION_FISHEYE_UNDER_EXPOSED;
-	}
-	else if (FString(Event->event_key).Equals(TEXT("ColorOverExposed"), ESearchCase::IgnoreCase))
-	{
-		UEvent.Key = ETangoEventKeyType::DESCRIPTION_COLOR_OVER_EXPOSED;
-	}
-	else if (FString(Event->event_key).Equals(TEXT("ColorUnderExposed"), ESearchCase::IgnoreCase))
-	{
-		UEvent.Key = ETangoEventKeyType::DESCRIPTION_COLOR_UNDER_EXPOSED;
-	}
-	else if (FString(Event->event_key).Equals(TEXT("TooFewFeaturesTracked"), ESearchCase::IgnoreCase))
-	{
-		UEvent.Key = ETangoEventKeyType::DESCRIPTION_TOO_FEW_FEATURES;
-	}
-	else if (FString(Event->event_key).Equals(TEXT("AreaDescriptionSaveProgress"), ESearchCase::IgnoreCase))
-	{
-		UEvent.Key = ETangoEventKeyType::KEY_AREA_DESCRIPTION_SAVE_PROGRESS;
-	}
-	else if (FString(Event->event_key).Equals(TEXT("Unknown"), ESearchCase::IgnoreCase))
-	{
-		UEvent.Key = ETangoEventKeyType::UNKOWN;
-	}
-	else
+	ETangoEventKeyType::Type Key = UEvent.Key;
+	if (!TangoEventKeys::Classify(Event.Key, Key))
 	{
-		UE_LOG(TangoPlugin, Warning, TEXT("UTangoDevice::OnTangoEvent: Unknown TangoEvent: %s %s"), *FString(Event->event_key), *FString(Event->event_value));
+		UE_LOG(TangoPlugin, Warning, TEXT("UTangoDevice::OnTangoEvent: Unknown TangoEvent: %s %s"), ANSI_TO_TCHAR(Event.Key), ANSI_TO_TCHAR(Event.Value));
 	}
+	UEvent.Key = Key;
 
-	UEvent.Message = FString(Event->event_value);
-	UEvent.TimeStamp = static_cast<float>(Event->timestamp);
+	UEvent.Message = FString(Event.Value);
+	UEvent.TimeStamp = static_cast<float>(Event.Timestamp);
 
 	return UEvent;
 }
-#endif
\ No newline at end of file
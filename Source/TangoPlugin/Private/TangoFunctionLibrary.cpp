@@ -42,6 +42,16 @@ FTangoCameraIntrinsics UTangoFunctionLibrary::GetCameraIntrinsics(TEnumAsByte<ET
 	return UTangoDevice::Get().GetCameraIntrinsics(CameraID);
 }
 
+FTangoStreamStatistics UTangoFunctionLibrary::GetStreamStatistics(TEnumAsByte<ETangoStreamType::Type> Stream)
+{
+	return UTangoDevice::Get().StreamMonitor.GetStatistics(Stream);
+}
+
+void UTangoFunctionLibrary::ResetStreamStatistics()
+{
+	UTangoDevice::Get().StreamMonitor.Reset();
+}
+
 TArray<FTangoAreaDescription> UTangoFunctionLibrary::GetAllAreaDescriptionData()
 {
 	return UTangoDevice::Get().GetAreaDescriptions();
@@ -0,0 +1,742 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoHeadlessBackend.h"
+#include "TangoDevice.h"
+
+namespace
+{
+	static TAutoConsoleVariable<int32> CVarEnable(
+		TEXT("Tango.Headless.Enable"),
+		PLATFORM_LINUX ? 1 : 0,
+		TEXT("Whether connecting the Tango service connects the headless backend on platforms without a service. On by default on Linux only."));
+
+	static TAutoConsoleVariable<int32> CVarDeliver(
+		TEXT("Tango.Headless.Deliver"),
+		1,
+		TEXT("Whether the headless backend delivers data through the callbacks. 0 connects it without its thread, for tools that push their own data."));
+
+	static TAutoConsoleVariable<FString> CVarReplayFile(
+		TEXT("Tango.Headless.ReplayFile"),
+		TEXT(""),
+		TEXT("Session file the headless backend replays on the next connection. Empty generates a synthetic scene."));
+
+	static TAutoConsoleVariable<float> CVarSpeed(
+		TEXT("Tango.Headless.Speed"),
+		1.0f,
+		TEXT("How fast the headless backend runs. 1 is real time, 0 delivers data as fast as possible."));
+
+	static const double PosePeriod = 0.01;
+	static const double FramePeriod = 1.0 / 30.0;
+	//Poses are INITIALIZING this long after connecting or resetting, like the service before it tracks features
+	static const double InitializingDuration = 0.5;
+	static const int32 MaxReplayPoses = 512;
+	//Never waits longer than this, so stopping is not held up
+	static const uint32 MaxWaitMs = 100;
+
+	//The device circles the center of the room at its height, looking outwards
+	static const double CircleRadius = 1.0;
+	static const double CirclePeriod = 10.0;
+	static const FVector RoomMin(-3.0f, -3.0f, -1.3f);
+	static const FVector RoomMax(3.0f, 3.0f, 1.7f);
+
+	static const int32 DepthColumns = 160;
+	static const int32 DepthRows = 90;
+	static const int32 MaxPointCloudElements = 60000;
+
+	//TANGO_EVENT_FEATURE_TRACKING, backend events carry the values of the C API
+	static const int32 FeatureTrackingEventType = 5;
+
+	static const int32 FrameWidth = 640;
+	static const int32 FrameHeight = 360;
+
+	//Distance along Direction to the first wall of the room. Origin is inside the room.
+	float RaycastRoom(const FVector& Origin, const FVector& Direction)
+	{
+		float T = MAX_flt;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (Direction[Axis] > KINDA_SMALL_NUMBER)
+			{
+				T = FMath::Min(T, (RoomMax[Axis] - Origin[Axis]) / Direction[Axis]);
+			}
+			else if (Direction[Axis] < -KINDA_SMALL_NUMBER)
+			{
+				T = FMath::Min(T, (RoomMin[Axis] - Origin[Axis]) / Direction[Axis]);
+			}
+		}
+		return T;
+	}
+
+	void SetPose(FTangoBackendPose& Pose, double Timestamp, int32 BaseFrame, int32 TargetFrame, int32 StatusCode, const FVector& Translation, const FQuat& Orientation)
+	{
+		Pose.Timestamp = Timestamp;
+		Pose.BaseFrame = BaseFrame;
+		Pose.TargetFrame = TargetFrame;
+		Pose.StatusCode = StatusCode;
+		Pose.Translation[0] = Translation.X;
+		Pose.Translation[1] = Translation.Y;
+		Pose.Translation[2] = Translation.Z;
+		Pose.Orientation[0] = Orientation.X;
+		Pose.Orientation[1] = Orientation.Y;
+		Pose.Orientation[2] = Orientation.Z;
+		Pose.Orientation[3] = Orientation.W;
+	}
+
+	bool IsCameraFrame(int32 Frame)
+	{
+		return Frame == ETangoCoordinateFrameType::CAMERA_COLOR || Frame == ETangoCoordinateFrameType::CAMERA_DEPTH || Frame == ETangoCoordinateFrameType::CAMERA_FISHEYE;
+	}
+
+	//The cameras look out of the back of the device: DEVICE turned half around its X axis
+	const FQuat DeviceToCamera(1.0f, 0.0f, 0.0f, 0.0f);
+}
+
+bool TangoHeadlessBackend::IsEnabled()
+{
+	return CVarEnable.GetValueOnGameThread() != 0;
+}
+
+void TangoHeadlessBackend::Enable(bool bDeliverData)
+{
+	CVarEnable->Set(1, ECVF_SetByCode);
+	CVarDeliver->Set(bDeliverData ? 1 : 0, ECVF_SetByCode);
+}
+
+TangoHeadlessBackend::TangoHeadlessBackend()
+	: Thread(nullptr)
+	, WakeUpEvent(nullptr)
+	, bIsConnected(false)
+	, bEnableColorFrames(false)
+	, bPoseCallback(false)
+	, bPointCloudCallback(false)
+	, bEventCallback(false)
+	, bFrameCallback(false)
+	, bDepthEnabled(false)
+	, DepthFramerate(0)
+	, Speed(1.0)
+	, WallStart(0.0)
+	, ServiceStart(1.0)
+	, ServiceNow(1.0)
+	, TrajectoryStart(1.0)
+{
+}
+
+TangoHeadlessBackend::~TangoHeadlessBackend()
+{
+	Disconnect();
+	if (WakeUpEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+		WakeUpEvent = nullptr;
+	}
+}
+
+bool TangoHeadlessBackend::Connect(const FTangoConfig& Config, const FTangoRuntimeConfig& RuntimeConfig)
+{
+	if (bIsConnected)
+	{
+		return true;
+	}
+	if (!FPlatformProcess::SupportsMultithreading())
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoHeadlessBackend::Connect: Needs a thread to deliver data"));
+		return false;
+	}
+
+	const FString ReplayFile = CVarReplayFile.GetValueOnGameThread();
+	ReplayIntrinsics.Reset();
+	if (!ReplayFile.IsEmpty())
+	{
+		if (!Reader.Open(ReplayFile))
+		{
+			UE_LOG(TangoPlugin, Error, TEXT("TangoHeadlessBackend::Connect: Could not open %s"), *ReplayFile);
+			return false;
+		}
+		ReplayIntrinsics = Reader.GetIntrinsics();
+		ServiceStart = Reader.GetStartTimestamp();
+		UE_LOG(TangoPlugin, Log, TEXT("TangoHeadlessBackend::Connect: Replaying %s, %.1f seconds"), *ReplayFile, Reader.GetEndTimestamp() - ServiceStart);
+	}
+	else
+	{
+		ServiceStart = 1.0;
+		UE_LOG(TangoPlugin, Log, TEXT("TangoHeadlessBackend::Connect: Generating a synthetic scene"));
+	}
+
+	Speed = FMath::Max(CVarSpeed.GetValueOnGameThread(), 0.0f);
+	bEnableColorFrames = Config.bEnableColorCameraFrames;
+	SetRuntimeConfig(RuntimeConfig);
+	{
+		FScopeLock ScopeLock(&Lock);
+		ServiceNow = ServiceStart;
+		TrajectoryStart = ServiceStart;
+		PoseHistory.Reset();
+	}
+	WallStart = FPlatformTime::Seconds();
+
+	if (CVarDeliver.GetValueOnGameThread() == 0)
+	{
+		//Queries are answered, but the clock stands still and no callback is ever called
+		UE_LOG(TangoPlugin, Log, TEXT("TangoHeadlessBackend::Connect: Not delivering any data"));
+		bIsConnected = true;
+		return true;
+	}
+	if (WakeUpEvent == nullptr)
+	{
+		WakeUpEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	}
+	bStopping = false;
+	//Before the thread starts, its first poses are queried through GetPoseAtTime
+	bIsConnected = true;
+	Thread = FRunnableThread::Create(this, TEXT("TangoHeadlessBackend"), 0, TPri_Normal);
+	bIsConnected = Thread != nullptr;
+	return bIsConnected;
+}
+
+void TangoHeadlessBackend::Disconnect()
+{
+	bIsConnected = false;
+	if (Thread != nullptr)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	Reader.Close();
+	bPoseCallback = false;
+	bPointCloudCallback = false;
+	bEventCallback = false;
+	bFrameCallback = false;
+}
+
+bool TangoHeadlessBackend::SetRuntimeConfig(const FTangoRuntimeConfig& RuntimeConfig)
+{
+	bDepthEnabled = RuntimeConfig.bEnableDepth;
+	DepthFramerate = RuntimeConfig.RuntimeDepthFramerate;
+	return true;
+}
+
+int32 TangoHeadlessBackend::GetMaxPointCloudElements()
+{
+	return MaxPointCloudElements;
+}
+
+bool TangoHeadlessBackend::GetCameraTextureSizes(int32& YWidth, int32& YHeight, int32& UVWidth, int32& UVHeight)
+{
+	YWidth = FrameWidth;
+	YHeight = FrameHeight;
+	UVWidth = FrameWidth / 2;
+	UVHeight = FrameHeight / 2;
+	return true;
+}
+
+bool TangoHeadlessBackend::GetPoseAtTime(double Timestamp, const FTangoCoordinateFramePair& FrameOfReference, FTangoBackendPose& Pose)
+{
+	if (!bIsConnected)
+	{
+		return false;
+	}
+	const int32 BaseFrame = FrameOfReference.BaseFrame;
+	const int32 TargetFrame = FrameOfReference.TargetFrame;
+
+	//Static extrinsics: IMU and DEVICE coincide
+	if (BaseFrame == ETangoCoordinateFrameType::IMU && (TargetFrame == ETangoCoordinateFrameType::DEVICE || IsCameraFrame(TargetFrame)))
+	{
+		SetPose(Pose, Timestamp, BaseFrame, TargetFrame, ETangoPoseStatus::VALID, FVector::ZeroVector, TargetFrame == ETangoCoordinateFrameType::DEVICE ? FQuat::Identity : DeviceToCamera);
+		return true;
+	}
+	if (BaseFrame != ETangoCoordinateFrameType::START_OF_SERVICE || (TargetFrame != ETangoCoordinateFrameType::DEVICE && !IsCameraFrame(TargetFrame)))
+	{
+		//Nothing else is tracked, e.g. there is no area description to localize in
+		SetPose(Pose, Timestamp, BaseFrame, TargetFrame, ETangoPoseStatus::INVALID, FVector::ZeroVector, FQuat::Identity);
+		return true;
+	}
+
+	FTangoBackendPose DevicePose;
+	{
+		FScopeLock ScopeLock(&Lock);
+		const double Time = Timestamp > 0.0 ? Timestamp : ServiceNow;
+		if (!Reader.IsOpen())
+		{
+			FVector Position;
+			FMatrix Rotation;
+			GetSyntheticDevicePose(Time - TrajectoryStart, Position, Rotation);
+			const int32 Status = Time - TrajectoryStart < InitializingDuration ? ETangoPoseStatus::INITIALIZING : ETangoPoseStatus::VALID;
+			SetPose(DevicePose, Time, BaseFrame, ETangoCoordinateFrameType::DEVICE, Status, Position, FQuat(Rotation));
+		}
+		else if (PoseHistory.Num() == 0)
+		{
+			SetPose(DevicePose, Time, BaseFrame, ETangoCoordinateFrameType::DEVICE, ETangoPoseStatus::INVALID, FVector::ZeroVector, FQuat::Identity);
+		}
+		else
+		{
+			//The last recorded pose at or before the time, the service interpolates but at 100 Hz this is close
+			int32 Index = PoseHistory.Num() - 1;
+			while (Index > 0 && PoseHistory[Index].Timestamp > Time)
+			{
+				--Index;
+			}
+			DevicePose = PoseHistory[Index];
+		}
+	}
+
+	if (TargetFrame == ETangoCoordinateFrameType::DEVICE)
+	{
+		Pose = DevicePose;
+		return true;
+	}
+	const FQuat Orientation = FQuat(DevicePose.Orientation[0], DevicePose.Orientation[1], DevicePose.Orientation[2], DevicePose.Orientation[3]) * DeviceToCamera;
+	const FVector Translation(DevicePose.Translation[0], DevicePose.Translation[1], DevicePose.Translation[2]);
+	SetPose(Pose, DevicePose.Timestamp, BaseFrame, TargetFrame, DevicePose.StatusCode, Translation, Orientation);
+	return true;
+}
+
+bool TangoHeadlessBackend::GetCameraIntrinsics(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (ReplayIntrinsics.Num() > 0)
+	{
+		for (const FTangoCameraIntrinsics& Recorded : ReplayIntrinsics)
+		{
+			if (Recorded.CameraID == Camera)
+			{
+				Intrinsics = Recorded;
+				return true;
+			}
+		}
+		return false;
+	}
+	if (Camera == ETangoCameraType::RGBR)
+	{
+		return false;
+	}
+	MakeSyntheticIntrinsics(Camera, Intrinsics);
+	return true;
+}
+
+void TangoHeadlessBackend::ResetMotionTracking()
+{
+	FScopeLock ScopeLock(&Lock);
+	TrajectoryStart = ServiceNow;
+	PoseHistory.Reset();
+}
+
+bool TangoHeadlessBackend::ConnectOnPoseAvailable(const TArray<FTangoCoordinateFramePair>& FramesOfReference)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		RequestedPairs = FramesOfReference;
+	}
+	bPoseCallback = true;
+	return bIsConnected;
+}
+
+bool TangoHeadlessBackend::ConnectOnPointCloudAvailable()
+{
+	bPointCloudCallback = true;
+	return bIsConnected;
+}
+
+bool TangoHeadlessBackend::ConnectOnTangoEvent()
+{
+	bEventCallback = true;
+	return bIsConnected;
+}
+
+bool TangoHeadlessBackend::ConnectOnFrameAvailable()
+{
+	bFrameCallback = true;
+	return bIsConnected;
+}
+
+bool TangoHeadlessBackend::DisconnectOnFrameAvailable()
+{
+	bFrameCallback = false;
+	return true;
+}
+
+bool TangoHeadlessBackend::ConnectCameraTextures(uint32 YTexture, uint32 CbTexture, uint32 CrTexture)
+{
+	//Only the service writes into camera textures
+	return false;
+}
+
+bool TangoHeadlessBackend::UpdateCameraTextures(double& Timestamp)
+{
+	Timestamp = 0.0;
+	return false;
+}
+
+bool TangoHeadlessBackend::DisconnectCamera()
+{
+	return true;
+}
+
+uint32 TangoHeadlessBackend::Run()
+{
+	if (Reader.IsOpen())
+	{
+		RunReplay();
+	}
+	else
+	{
+		RunSynthetic();
+	}
+	return 0;
+}
+
+void TangoHeadlessBackend::Stop()
+{
+	bStopping = true;
+	if (WakeUpEvent != nullptr)
+	{
+		WakeUpEvent->Trigger();
+	}
+}
+
+double TangoHeadlessBackend::GetServiceTime() const
+{
+	return ServiceStart + (FPlatformTime::Seconds() - WallStart) * Speed;
+}
+
+bool TangoHeadlessBackend::WaitUntil(double Timestamp)
+{
+	if (Speed > 0.0)
+	{
+		while (!bStopping)
+		{
+			const double Remaining = (Timestamp - GetServiceTime()) / Speed;
+			if (Remaining <= 0.0)
+			{
+				break;
+			}
+			WakeUpEvent->Wait(FMath::Max((uint32)FMath::Min(Remaining * 1000.0, (double)MaxWaitMs), 1u));
+		}
+	}
+	FScopeLock ScopeLock(&Lock);
+	ServiceNow = FMath::Max(ServiceNow, Timestamp);
+	return !bStopping;
+}
+
+bool TangoHeadlessBackend::IsPoseRequested(int32 BaseFrame, int32 TargetFrame)
+{
+	if (!bPoseCallback)
+	{
+		return false;
+	}
+	FScopeLock ScopeLock(&Lock);
+	for (const FTangoCoordinateFramePair& Pair : RequestedPairs)
+	{
+		if (Pair.BaseFrame.GetValue() == BaseFrame && Pair.TargetFrame.GetValue() == TargetFrame)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//BEGIN - Synthetic scene
+
+void TangoHeadlessBackend::GetSyntheticDevicePose(double Time, FVector& Position, FMatrix& Rotation)
+{
+	const double Angle = 2.0 * PI * Time / CirclePeriod;
+	const FVector Forward((float)FMath::Cos(Angle), (float)FMath::Sin(Angle), 0.0f);
+	const FVector Up(0.0f, 0.0f, 1.0f);
+	Position = Forward * CircleRadius;
+	//Rows are the device axes in START_OF_SERVICE: X right, Y up, Z out of the screen towards the user
+	Rotation = FMatrix(Forward ^ Up, Up, -Forward, FVector::ZeroVector);
+}
+
+void TangoHeadlessBackend::MakeSyntheticIntrinsics(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics)
+{
+	Intrinsics.CameraID = Camera;
+	Intrinsics.Distortion.Init(0.0f, 5);
+	switch (Camera)
+	{
+	case ETangoCameraType::DEPTH:
+		Intrinsics.CalibrationType = ETangoCalibrationType::POLYNOMIAL_3_PARAMETERS;
+		Intrinsics.Width = DepthColumns * 2;
+		Intrinsics.Height = DepthRows * 2;
+		Intrinsics.Fx = Intrinsics.Fy = 260.0f;
+		break;
+	case ETangoCameraType::FISHEYE:
+		Intrinsics.CalibrationType = ETangoCalibrationType::EQUIDISTANT;
+		Intrinsics.Width = 640;
+		Intrinsics.Height = 480;
+		Intrinsics.Fx = Intrinsics.Fy = 255.0f;
+		Intrinsics.Distortion[0] = 0.92f;
+		break;
+	default:
+		Intrinsics.CalibrationType = ETangoCalibrationType::POLYNOMIAL_3_PARAMETERS;
+		Intrinsics.Width = FrameWidth;
+		Intrinsics.Height = FrameHeight;
+		Intrinsics.Fx = Intrinsics.Fy = 520.0f;
+		break;
+	}
+	Intrinsics.Cx = Intrinsics.Width / 2;
+	Intrinsics.Cy = Intrinsics.Height / 2;
+}
+
+void TangoHeadlessBackend::RunSynthetic()
+{
+	FrameBuffer.SetNumUninitialized(FrameWidth * FrameHeight * 3 / 2);
+	//Gray chroma, only the luma pattern moves
+	FMemory::Memset(FrameBuffer.GetData() + FrameWidth * FrameHeight, 128, FrameWidth * FrameHeight / 2);
+
+	double NextPose = ServiceStart;
+	double NextDepth = ServiceStart;
+	double NextFrame = ServiceStart;
+	int64 FrameNumber = 0;
+	bool bSentEvent = false;
+	while (!bStopping)
+	{
+		const double Next = FMath::Min3(NextPose, NextDepth, NextFrame);
+		if (!WaitUntil(Next))
+		{
+			break;
+		}
+		if (bEventCallback && !bSentEvent)
+		{
+			//What the service reports before it tracks
+			FTangoBackendEvent Event = { Next, FeatureTrackingEventType, "TooFewFeaturesTracked", "Headless" };
+			UTangoDevice::Get().OnTangoEvent(Event);
+			bSentEvent = true;
+		}
+		if (NextPose <= Next)
+		{
+			EmitSyntheticPose(Next);
+			NextPose += PosePeriod;
+		}
+		if (NextDepth <= Next)
+		{
+			const int32 Framerate = DepthFramerate;
+			if (bPointCloudCallback && bDepthEnabled && Framerate > 0)
+			{
+				EmitSyntheticDepth(Next);
+			}
+			NextDepth += 1.0 / FMath::Clamp(Framerate, 1, 30);
+		}
+		if (NextFrame <= Next)
+		{
+			if (bFrameCallback && bEnableColorFrames)
+			{
+				EmitSyntheticFrame(Next, ++FrameNumber);
+			}
+			NextFrame += FramePeriod;
+		}
+	}
+}
+
+void TangoHeadlessBackend::EmitSyntheticPose(double Timestamp)
+{
+	const FTangoCoordinateFramePair Pair(ETangoCoordinateFrameType::START_OF_SERVICE, ETangoCoordinateFrameType::DEVICE);
+	if (!IsPoseRequested(Pair.BaseFrame, Pair.TargetFrame))
+	{
+		return;
+	}
+	FTangoBackendPose Pose;
+	if (GetPoseAtTime(Timestamp, Pair, Pose))
+	{
+		UTangoDevice::Get().OnPoseAvailable(Pose);
+	}
+}
+
+void TangoHeadlessBackend::EmitSyntheticDepth(double Timestamp)
+{
+	FVector Position;
+	FMatrix Rotation;
+	{
+		FScopeLock ScopeLock(&Lock);
+		GetSyntheticDevicePose(Timestamp - TrajectoryStart, Position, Rotation);
+	}
+	//Depth camera axes in START_OF_SERVICE: X right, Y down, Z forward
+	const FVector CameraX = Rotation.GetScaledAxis(EAxis::X);
+	const FVector CameraY = -Rotation.GetScaledAxis(EAxis::Y);
+	const FVector CameraZ = -Rotation.GetScaledAxis(EAxis::Z);
+
+	FTangoCameraIntrinsics Intrinsics;
+	MakeSyntheticIntrinsics(ETangoCameraType::DEPTH, Intrinsics);
+	DepthBuffer.SetNumUninitialized(DepthColumns * DepthRows * 3, false);
+	float* Point = DepthBuffer.GetData();
+	for (int32 Row = 0; Row < DepthRows; ++Row)
+	{
+		const float RayY = (Row * 2 + 1 - Intrinsics.Cy) / Intrinsics.Fy;
+		for (int32 Column = 0; Column < DepthColumns; ++Column)
+		{
+			const float RayX = (Column * 2 + 1 - Intrinsics.Cx) / Intrinsics.Fx;
+			//Rays have Z = 1, so the distance along them is the depth
+			const float Depth = RaycastRoom(Position, CameraX * RayX + CameraY * RayY + CameraZ);
+			Point[0] = RayX * Depth;
+			Point[1] = RayY * Depth;
+			Point[2] = Depth;
+			Point += 3;
+		}
+	}
+
+	FTangoBackendPointCloud PointCloud;
+	PointCloud.Timestamp = Timestamp;
+	PointCloud.NumPoints = DepthColumns * DepthRows;
+	PointCloud.XYZ = reinterpret_cast<const float(*)[3]>(DepthBuffer.GetData());
+	PointCloud.IJRows = 0;
+	PointCloud.IJCols = 0;
+	PointCloud.IJ = nullptr;
+	UTangoDevice::Get().OnPointCloudAvailable(PointCloud);
+}
+
+void TangoHeadlessBackend::EmitSyntheticFrame(double Timestamp, int64 FrameNumber)
+{
+	//Diagonal stripes that move a little every frame
+	uint8* Y = FrameBuffer.GetData();
+	const int32 Offset = (int32)(FrameNumber * 2);
+	for (int32 Row = 0; Row < FrameHeight; ++Row)
+	{
+		for (int32 Column = 0; Column < FrameWidth; ++Column)
+		{
+			*Y++ = (uint8)((Column + Row + Offset) & 0xFF);
+		}
+	}
+
+	FTangoBackendImage Image;
+	Image.Timestamp = Timestamp;
+	Image.FrameNumber = FrameNumber;
+	Image.Width = FrameWidth;
+	Image.Height = FrameHeight;
+	Image.Stride = FrameWidth;
+	Image.Y = FrameBuffer.GetData();
+	Image.VU = FrameBuffer.GetData() + FrameWidth * FrameHeight;
+	UTangoDevice::Get().OnCameraFrameAvailable(Image);
+}
+
+//END - Synthetic scene
+
+//BEGIN - Replay
+
+void TangoHeadlessBackend::RunReplay()
+{
+	FTangoSessionRecord Record;
+	while (!bStopping && Reader.Next(Record))
+	{
+		//Intrinsics are untimed, the reader already has them
+		if (Record.Timestamp > 0.0 && !WaitUntil(Record.Timestamp))
+		{
+			break;
+		}
+		EmitRecord(Record);
+	}
+	if (!bStopping)
+	{
+		UE_LOG(TangoPlugin, Log, TEXT("TangoHeadlessBackend::RunReplay: Reached the end of the session"));
+	}
+}
+
+void TangoHeadlessBackend::EmitRecord(const FTangoSessionRecord& Record)
+{
+	switch (Record.Type)
+	{
+	case TangoSessionFormat::ERecordType::POSE:
+	{
+		const TangoSessionFormat::FPosePayload* Payload = Record.GetPose();
+		if (Payload == nullptr)
+		{
+			break;
+		}
+		FTangoBackendPose Pose;
+		Pose.Timestamp = Record.Timestamp;
+		Pose.BaseFrame = Payload->BaseFrame;
+		Pose.TargetFrame = Payload->TargetFrame;
+		Pose.StatusCode = Payload->StatusCode;
+		FMemory::Memcpy(Pose.Translation, Payload->Translation, sizeof(Pose.Translation));
+		FMemory::Memcpy(Pose.Orientation, Payload->Orientation, sizeof(Pose.Orientation));
+		if (Pose.BaseFrame == ETangoCoordinateFrameType::START_OF_SERVICE && Pose.TargetFrame == ETangoCoordinateFrameType::DEVICE)
+		{
+			StorePose(Pose);
+		}
+		if (IsPoseRequested(Pose.BaseFrame, Pose.TargetFrame))
+		{
+			UTangoDevice::Get().OnPoseAvailable(Pose);
+		}
+		break;
+	}
+	case TangoSessionFormat::ERecordType::DEPTH:
+	{
+		const float* XYZ = nullptr;
+		const uint32* IJ = nullptr;
+		const TangoSessionFormat::FDepthPayload* Payload = Record.GetDepth(XYZ, IJ);
+		if (Payload == nullptr || !bPointCloudCallback || !bDepthEnabled)
+		{
+			break;
+		}
+		FTangoBackendPointCloud PointCloud;
+		PointCloud.Timestamp = Record.Timestamp;
+		PointCloud.NumPoints = Payload->NumPoints;
+		PointCloud.XYZ = reinterpret_cast<const float(*)[3]>(XYZ);
+		PointCloud.IJRows = IJ != nullptr ? Payload->IJRows : 0;
+		PointCloud.IJCols = IJ != nullptr ? Payload->IJCols : 0;
+		PointCloud.IJ = IJ;
+		UTangoDevice::Get().OnPointCloudAvailable(PointCloud);
+		break;
+	}
+	case TangoSessionFormat::ERecordType::EVENT:
+	{
+		FString Key;
+		FString Value;
+		const TangoSessionFormat::FEventPayload* Payload = Record.GetEvent(Key, Value);
+		if (Payload == nullptr || !bEventCallback)
+		{
+			break;
+		}
+		auto AnsiKey = StringCast<ANSICHAR>(*Key);
+		auto AnsiValue = StringCast<ANSICHAR>(*Value);
+		FTangoBackendEvent Event = { Record.Timestamp, Payload->Type, AnsiKey.Get(), AnsiValue.Get() };
+		UTangoDevice::Get().OnTangoEvent(Event);
+		break;
+	}
+	case TangoSessionFormat::ERecordType::COLOR_FRAME:
+	{
+		const uint8* NV21 = nullptr;
+		const TangoSessionFormat::FColorFramePayload* Payload = Record.GetColorFrame(NV21);
+		if (Payload == nullptr || !bFrameCallback || !bEnableColorFrames)
+		{
+			break;
+		}
+		FTangoBackendImage Image;
+		Image.Timestamp = Record.Timestamp;
+		Image.FrameNumber = Payload->FrameNumber;
+		Image.Width = Payload->Width;
+		Image.Height = Payload->Height;
+		Image.Stride = Payload->Width;
+		Image.Y = NV21;
+		Image.VU = NV21 + Payload->Width * Payload->Height;
+		UTangoDevice::Get().OnCameraFrameAvailable(Image);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void TangoHeadlessBackend::StorePose(const FTangoBackendPose& Pose)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (PoseHistory.Num() >= MaxReplayPoses)
+	{
+		PoseHistory.RemoveAt(0, PoseHistory.Num() - MaxReplayPoses + 1, false);
+	}
+	PoseHistory.Add(Pose);
+}
+
+//END - Replay
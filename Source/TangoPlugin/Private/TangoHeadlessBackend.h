@@ -0,0 +1,117 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#pragma once
+
+#include "TangoBackend.h"
+#include "TangoSessionReader.h"
+
+/*
+ * Stands in for the service on platforms without one. Either generates a synthetic scene, a device circling inside a box shaped room,
+ * or replays a file of TangoSessionRecorder. Data is delivered on a thread of its own through the same callbacks as on a device.
+ * Tango.Headless.ReplayFile picks the file, Tango.Headless.Speed how fast time passes: 1 is real time, 0 as fast as possible.
+ * With Tango.Headless.Deliver at 0 it only answers queries, the clock stands still and the callbacks are never called.
+ * It is only connected on Linux or after opting in with Tango.Headless.Enable, elsewhere connecting does nothing like it always did.
+ */
+class TangoHeadlessBackend : public ITangoBackend, public FRunnable
+{
+public:
+	TangoHeadlessBackend();
+	virtual ~TangoHeadlessBackend();
+
+	//Whether UTangoDevice connects this backend when asked to connect the service
+	static bool IsEnabled();
+	//Opts in on any platform, for tools like the commandlets. Without bDeliverData the next connection starts no thread.
+	static void Enable(bool bDeliverData = true);
+
+	//ITangoBackend interface
+	virtual const TCHAR* GetName() const override { return TEXT("Headless"); }
+	virtual bool Connect(const FTangoConfig& Config, const FTangoRuntimeConfig& RuntimeConfig) override;
+	virtual void Disconnect() override;
+	virtual bool IsConnected() const override { return bIsConnected; }
+	virtual bool SetRuntimeConfig(const FTangoRuntimeConfig& RuntimeConfig) override;
+	virtual int32 GetMaxPointCloudElements() override;
+	virtual bool GetCameraTextureSizes(int32& YWidth, int32& YHeight, int32& UVWidth, int32& UVHeight) override;
+	virtual bool GetPoseAtTime(double Timestamp, const FTangoCoordinateFramePair& FrameOfReference, FTangoBackendPose& Pose) override;
+	virtual bool GetCameraIntrinsics(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics) override;
+	virtual void ResetMotionTracking() override;
+	virtual bool ConnectOnPoseAvailable(const TArray<FTangoCoordinateFramePair>& FramesOfReference) override;
+	virtual bool ConnectOnPointCloudAvailable() override;
+	virtual bool ConnectOnTangoEvent() override;
+	virtual bool ConnectOnFrameAvailable() override;
+	virtual bool DisconnectOnFrameAvailable() override;
+	virtual bool ConnectCameraTextures(uint32 YTexture, uint32 CbTexture, uint32 CrTexture) override;
+	virtual bool UpdateCameraTextures(double& Timestamp) override;
+	virtual bool DisconnectCamera() override;
+
+	//FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	//Service time the clock is at now, which is ahead of the wall clock when running as fast as possible
+	double GetServiceTime() const;
+	//Blocks until the service clock reaches Timestamp. Returns false when stopping.
+	bool WaitUntil(double Timestamp);
+	bool IsPoseRequested(int32 BaseFrame, int32 TargetFrame);
+
+	void RunSynthetic();
+	void RunReplay();
+
+	//Synthetic scene
+	static void GetSyntheticDevicePose(double Timestamp, FVector& Position, FMatrix& Rotation);
+	static void MakeSyntheticIntrinsics(ETangoCameraType::Type Camera, FTangoCameraIntrinsics& Intrinsics);
+	void EmitSyntheticPose(double Timestamp);
+	void EmitSyntheticDepth(double Timestamp);
+	void EmitSyntheticFrame(double Timestamp, int64 FrameNumber);
+
+	//Replay
+	void EmitRecord(const FTangoSessionRecord& Record);
+	void StorePose(const FTangoBackendPose& Pose);
+
+	FRunnableThread* Thread;
+	FEvent* WakeUpEvent;
+	FThreadSafeBool bStopping;
+	volatile bool bIsConnected;
+	bool bEnableColorFrames;
+
+	//Read by the thread at the start of every step
+	volatile bool bPoseCallback;
+	volatile bool bPointCloudCallback;
+	volatile bool bEventCallback;
+	volatile bool bFrameCallback;
+	volatile bool bDepthEnabled;
+	volatile int32 DepthFramerate;
+
+	//Service clock: at WallStart it was at ServiceStart and runs at Speed, or jumps from step to step if Speed is 0
+	double Speed;
+	double WallStart;
+	double ServiceStart;
+
+	FCriticalSection Lock;
+	//Timestamp of the last step of the thread, the time of the latest pose
+	double ServiceNow;
+	//The synthetic device starts its circle here, reset by ResetMotionTracking
+	double TrajectoryStart;
+	TArray<FTangoCoordinateFramePair> RequestedPairs;
+	//START_OF_SERVICE to DEVICE of the replayed file, oldest first
+	TArray<FTangoBackendPose> PoseHistory;
+	TArray<FTangoCameraIntrinsics> ReplayIntrinsics;
+
+	//Opened by Connect, then only touched by the thread
+	TangoSessionReader Reader;
+	TArray<float> DepthBuffer;
+	TArray<uint8> FrameBuffer;
+};
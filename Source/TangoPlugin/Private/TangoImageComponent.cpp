@@ -29,14 +29,12 @@ void UTangoImageComponent::TickComponent(float DeltaTime, enum ELevelTick TickTy
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 	if (UTangoDevice::Get().GetTangoDeviceImagePointer())
 	{
-		if (UTangoDevice::Get().GetTangoDeviceImagePointer()->GetYTexture())
+		//Nothing to do until the render thread published a new frame
+		const FTangoCameraImageSnapshot Image = UTangoDevice::Get().GetTangoDeviceImagePointer()->GetFrameImage();
+		if (Image.FrameSequence > 0 && Image.FrameSequence != LastBroadcastFrameSequence)
 		{
-			float TimeStamp = UTangoDevice::Get().GetTangoDeviceImagePointer()->GetImageBufferTimestamp();
-			if (TimeStamp != LastBroadCastedTimestamp)
-			{
-				LastBroadCastedTimestamp = TimeStamp;
-				OnTangoImageAvailable.Broadcast(TimeStamp);
-			}
+			LastBroadcastFrameSequence = Image.FrameSequence;
+			OnTangoImageAvailable.Broadcast(Image.Timestamp);
 		}
 	}
 }
@@ -0,0 +1,607 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoImageConversion.h"
+#include "ParallelFor.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define TANGO_IMAGE_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TANGO_IMAGE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifndef TANGO_IMAGE_NEON
+#define TANGO_IMAGE_NEON 0
+#endif
+#ifndef TANGO_IMAGE_SSE2
+#define TANGO_IMAGE_SSE2 0
+#endif
+
+/*
+ * Full range BT.601, which is what the Android camera delivers, with 6 bit fixed point coefficients:
+ * R = Y + 1.402 V', G = Y - 0.344 U' - 0.714 V', B = Y + 1.772 U'
+ * All intermediate values fit into int16, so every lane width below gives the same result as the scalar code.
+ */
+namespace
+{
+	static const int32 CoefficientShift = 6;
+	static const int32 CoefficientRV = 90;
+	static const int32 CoefficientGU = 22;
+	static const int32 CoefficientGV = 46;
+	static const int32 CoefficientBU = 113;
+
+	//Don't split images into more bands than this many row pairs each, the scheduling overhead would dominate.
+	static const int32 MinRowPairsPerBand = 16;
+
+	FORCEINLINE uint8 ClampToByte(int32 Value)
+	{
+		return (uint8)FMath::Clamp(Value, 0, 255);
+	}
+
+	FORCEINLINE void ConvertPixel(int32 Luma, int32 RC, int32 GC, int32 BC, uint8* Out)
+	{
+		const int32 ScaledLuma = Luma << CoefficientShift;
+		Out[0] = ClampToByte((ScaledLuma + RC) >> CoefficientShift);
+		Out[1] = ClampToByte((ScaledLuma + GC) >> CoefficientShift);
+		Out[2] = ClampToByte((ScaledLuma + BC) >> CoefficientShift);
+	}
+
+	//Same rounding as vrhadd/_mm_avg_epu8 followed by a rounding pairwise add.
+	FORCEINLINE int32 AverageBlock(const uint8* Row0, const uint8* Row1, int32 x)
+	{
+		const int32 Left = (Row0[x] + Row1[x] + 1) >> 1;
+		const int32 Right = (Row0[x + 1] + Row1[x + 1] + 1) >> 1;
+		return (Left + Right + 1) >> 1;
+	}
+
+	//Scalar kernels. They also handle the columns the vector kernels leave over.
+
+	void RGBARowPairScalar(const uint8* Row0, const uint8* Row1, const uint8* VU, int32 Begin, int32 Width, uint8* Out0, uint8* Out1)
+	{
+		for (int32 x = Begin; x < Width; x += 2)
+		{
+			const int32 V = VU[x] - 128;
+			const int32 U = VU[x + 1] - 128;
+			const int32 RC = CoefficientRV * V;
+			const int32 GC = -(CoefficientGU * U + CoefficientGV * V);
+			const int32 BC = CoefficientBU * U;
+			ConvertPixel(Row0[x], RC, GC, BC, Out0 + x * 4);
+			ConvertPixel(Row0[x + 1], RC, GC, BC, Out0 + x * 4 + 4);
+			ConvertPixel(Row1[x], RC, GC, BC, Out1 + x * 4);
+			ConvertPixel(Row1[x + 1], RC, GC, BC, Out1 + x * 4 + 4);
+			Out0[x * 4 + 3] = Out0[x * 4 + 7] = Out1[x * 4 + 3] = Out1[x * 4 + 7] = 255;
+		}
+	}
+
+	void HalfRGBRowScalar(const uint8* Row0, const uint8* Row1, const uint8* VU, int32 Begin, int32 Width, uint8* Out)
+	{
+		for (int32 x = Begin; x < Width; x += 2)
+		{
+			const int32 V = VU[x] - 128;
+			const int32 U = VU[x + 1] - 128;
+			ConvertPixel(AverageBlock(Row0, Row1, x), CoefficientRV * V, -(CoefficientGU * U + CoefficientGV * V), CoefficientBU * U, Out + (x / 2) * 3);
+		}
+	}
+
+	void DownscaleRowScalar(const uint8* Row0, const uint8* Row1, int32 Begin, int32 Width, uint8* Out)
+	{
+		for (int32 x = Begin; x < Width; x += 2)
+		{
+			Out[x / 2] = (uint8)AverageBlock(Row0, Row1, x);
+		}
+	}
+
+	//Vertical [1 2 1] of three rows into 16 bit sums
+	void VerticalSumScalar(const uint8* Above, const uint8* Center, const uint8* Below, int32 Begin, int32 Width, uint16* Out)
+	{
+		for (int32 x = Begin; x < Width; ++x)
+		{
+			Out[x] = (uint16)(Above[x] + 2 * Center[x] + Below[x]);
+		}
+	}
+
+	//Horizontal [1 2 1] of the vertical sums at every second column, normalized by the total weight of 16
+	void HorizontalReduceScalar(const uint16* Sums, int32 Begin, int32 End, uint8* Out)
+	{
+		for (int32 x = Begin; x < End; ++x)
+		{
+			const int32 Left = Sums[x == 0 ? 0 : 2 * x - 1];
+			Out[x] = (uint8)((Left + 2 * Sums[2 * x] + Sums[2 * x + 1] + 8) >> 4);
+		}
+	}
+
+#if TANGO_IMAGE_NEON
+
+	//Returns the first column that was not converted
+	int32 RGBARowPairSIMD(const uint8* Row0, const uint8* Row1, const uint8* VU, int32 Width, uint8* Out0, uint8* Out1)
+	{
+		const int16x8_t Offset = vdupq_n_s16(128);
+		const uint8x16_t Alpha = vdupq_n_u8(255);
+		int32 x = 0;
+		for (; x + 16 <= Width; x += 16)
+		{
+			const uint8x8x2_t Chroma = vld2_u8(VU + x);
+			const int16x8_t V = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(Chroma.val[0])), Offset);
+			const int16x8_t U = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(Chroma.val[1])), Offset);
+			const int16x8_t RC = vmulq_n_s16(V, CoefficientRV);
+			const int16x8_t GC = vnegq_s16(vmlaq_n_s16(vmulq_n_s16(U, CoefficientGU), V, CoefficientGV));
+			const int16x8_t BC = vmulq_n_s16(U, CoefficientBU);
+			//Every chroma sample covers two neighbouring pixels
+			const int16x8x2_t R2 = vzipq_s16(RC, RC);
+			const int16x8x2_t G2 = vzipq_s16(GC, GC);
+			const int16x8x2_t B2 = vzipq_s16(BC, BC);
+
+			const uint8* Rows[2] = { Row0, Row1 };
+			uint8* Outs[2] = { Out0, Out1 };
+			for (int32 r = 0; r < 2; ++r)
+			{
+				const uint8x16_t Luma = vld1q_u8(Rows[r] + x);
+				const int16x8_t LumaLow = vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(Luma), CoefficientShift));
+				const int16x8_t LumaHigh = vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(Luma), CoefficientShift));
+				uint8x16x4_t Pixels;
+				Pixels.val[0] = vcombine_u8(vqshrun_n_s16(vaddq_s16(LumaLow, R2.val[0]), CoefficientShift), vqshrun_n_s16(vaddq_s16(LumaHigh, R2.val[1]), CoefficientShift));
+				Pixels.val[1] = vcombine_u8(vqshrun_n_s16(vaddq_s16(LumaLow, G2.val[0]), CoefficientShift), vqshrun_n_s16(vaddq_s16(LumaHigh, G2.val[1]), CoefficientShift));
+				Pixels.val[2] = vcombine_u8(vqshrun_n_s16(vaddq_s16(LumaLow, B2.val[0]), CoefficientShift), vqshrun_n_s16(vaddq_s16(LumaHigh, B2.val[1]), CoefficientShift));
+				Pixels.val[3] = Alpha;
+				vst4q_u8(Outs[r] + x * 4, Pixels);
+			}
+		}
+		return x;
+	}
+
+	FORCEINLINE uint8x8_t AverageBlocks(const uint8* Row0, const uint8* Row1)
+	{
+		return vrshrn_n_u16(vpaddlq_u8(vrhaddq_u8(vld1q_u8(Row0), vld1q_u8(Row1))), 1);
+	}
+
+	int32 HalfRGBRowSIMD(const uint8* Row0, const uint8* Row1, const uint8* VU, int32 Width, uint8* Out)
+	{
+		const int16x8_t Offset = vdupq_n_s16(128);
+		int32 x = 0;
+		for (; x + 16 <= Width; x += 16)
+		{
+			const uint8x8x2_t Chroma = vld2_u8(VU + x);
+			const int16x8_t V = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(Chroma.val[0])), Offset);
+			const int16x8_t U = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(Chroma.val[1])), Offset);
+			const int16x8_t Luma = vreinterpretq_s16_u16(vshll_n_u8(AverageBlocks(Row0 + x, Row1 + x), CoefficientShift));
+			uint8x8x3_t Pixels;
+			Pixels.val[0] = vqshrun_n_s16(vaddq_s16(Luma, vmulq_n_s16(V, CoefficientRV)), CoefficientShift);
+			Pixels.val[1] = vqshrun_n_s16(vsubq_s16(Luma, vmlaq_n_s16(vmulq_n_s16(U, CoefficientGU), V, CoefficientGV)), CoefficientShift);
+			Pixels.val[2] = vqshrun_n_s16(vaddq_s16(Luma, vmulq_n_s16(U, CoefficientBU)), CoefficientShift);
+			vst3_u8(Out + (x / 2) * 3, Pixels);
+		}
+		return x;
+	}
+
+	int32 DownscaleRowSIMD(const uint8* Row0, const uint8* Row1, int32 Width, uint8* Out)
+	{
+		int32 x = 0;
+		for (; x + 32 <= Width; x += 32)
+		{
+			vst1q_u8(Out + x / 2, vcombine_u8(AverageBlocks(Row0 + x, Row1 + x), AverageBlocks(Row0 + x + 16, Row1 + x + 16)));
+		}
+		return x;
+	}
+
+	int32 VerticalSumSIMD(const uint8* Above, const uint8* Center, const uint8* Below, int32 Width, uint16* Out)
+	{
+		int32 x = 0;
+		for (; x + 16 <= Width; x += 16)
+		{
+			const uint8x16_t A = vld1q_u8(Above + x);
+			const uint8x16_t C = vld1q_u8(Center + x);
+			const uint8x16_t B = vld1q_u8(Below + x);
+			vst1q_u16(Out + x, vaddq_u16(vaddl_u8(vget_low_u8(A), vget_low_u8(B)), vshll_n_u8(vget_low_u8(C), 1)));
+			vst1q_u16(Out + x + 8, vaddq_u16(vaddl_u8(vget_high_u8(A), vget_high_u8(B)), vshll_n_u8(vget_high_u8(C), 1)));
+		}
+		return x;
+	}
+
+	//Starts at output column Begin > 0 so the left neighbour never has to be clamped. Returns the first column that was not written.
+	int32 HorizontalReduceSIMD(const uint16* Sums, int32 Begin, int32 Width, uint8* Out)
+	{
+		int32 x = Begin;
+		for (; 2 * x + 16 < Width; x += 8)
+		{
+			//val[0] holds the columns left of each output sample, val[1] the centers
+			const uint16x8x2_t LeftAndCenter = vld2q_u16(Sums + 2 * x - 1);
+			const uint16x8x2_t Right = vld2q_u16(Sums + 2 * x + 1);
+			const uint16x8_t Sum = vaddq_u16(vaddq_u16(LeftAndCenter.val[0], Right.val[0]), vshlq_n_u16(LeftAndCenter.val[1], 1));
+			vst1_u8(Out + x, vrshrn_n_u16(Sum, 4));
+		}
+		return x;
+	}
+
+#elif TANGO_IMAGE_SSE2
+
+	FORCEINLINE __m128i ConvertChannel(__m128i ScaledLumaLow, __m128i ScaledLumaHigh, __m128i ChromaLow, __m128i ChromaHigh)
+	{
+		return _mm_packus_epi16(
+			_mm_srai_epi16(_mm_add_epi16(ScaledLumaLow, ChromaLow), CoefficientShift),
+			_mm_srai_epi16(_mm_add_epi16(ScaledLumaHigh, ChromaHigh), CoefficientShift));
+	}
+
+	//Splits 16 interleaved VU bytes into 8 signed V and U values and computes the chroma terms
+	FORCEINLINE void ChromaTerms(const uint8* VU, __m128i& RC, __m128i& GC, __m128i& BC)
+	{
+		const __m128i Offset = _mm_set1_epi16(128);
+		const __m128i Chroma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(VU));
+		const __m128i V = _mm_sub_epi16(_mm_and_si128(Chroma, _mm_set1_epi16(0x00FF)), Offset);
+		const __m128i U = _mm_sub_epi16(_mm_srli_epi16(Chroma, 8), Offset);
+		RC = _mm_mullo_epi16(V, _mm_set1_epi16(CoefficientRV));
+		GC = _mm_sub_epi16(_mm_setzero_si128(), _mm_add_epi16(_mm_mullo_epi16(U, _mm_set1_epi16(CoefficientGU)), _mm_mullo_epi16(V, _mm_set1_epi16(CoefficientGV))));
+		BC = _mm_mullo_epi16(U, _mm_set1_epi16(CoefficientBU));
+	}
+
+	int32 RGBARowPairSIMD(const uint8* Row0, const uint8* Row1, const uint8* VU, int32 Width, uint8* Out0, uint8* Out1)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Alpha = _mm_set1_epi8((char)0xFF);
+		int32 x = 0;
+		for (; x + 16 <= Width; x += 16)
+		{
+			__m128i RC, GC, BC;
+			ChromaTerms(VU + x, RC, GC, BC);
+			//Every chroma sample covers two neighbouring pixels
+			const __m128i RCLow = _mm_unpacklo_epi16(RC, RC), RCHigh = _mm_unpackhi_epi16(RC, RC);
+			const __m128i GCLow = _mm_unpacklo_epi16(GC, GC), GCHigh = _mm_unpackhi_epi16(GC, GC);
+			const __m128i BCLow = _mm_unpacklo_epi16(BC, BC), BCHigh = _mm_unpackhi_epi16(BC, BC);
+
+			const uint8* Rows[2] = { Row0, Row1 };
+			uint8* Outs[2] = { Out0, Out1 };
+			for (int32 r = 0; r < 2; ++r)
+			{
+				const __m128i Luma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Rows[r] + x));
+				const __m128i LumaLow = _mm_slli_epi16(_mm_unpacklo_epi8(Luma, Zero), CoefficientShift);
+				const __m128i LumaHigh = _mm_slli_epi16(_mm_unpackhi_epi8(Luma, Zero), CoefficientShift);
+				const __m128i R = ConvertChannel(LumaLow, LumaHigh, RCLow, RCHigh);
+				const __m128i G = ConvertChannel(LumaLow, LumaHigh, GCLow, GCHigh);
+				const __m128i B = ConvertChannel(LumaLow, LumaHigh, BCLow, BCHigh);
+				const __m128i RGLow = _mm_unpacklo_epi8(R, G), RGHigh = _mm_unpackhi_epi8(R, G);
+				const __m128i BALow = _mm_unpacklo_epi8(B, Alpha), BAHigh = _mm_unpackhi_epi8(B, Alpha);
+				__m128i* Dest = reinterpret_cast<__m128i*>(Outs[r] + x * 4);
+				_mm_storeu_si128(Dest + 0, _mm_unpacklo_epi16(RGLow, BALow));
+				_mm_storeu_si128(Dest + 1, _mm_unpackhi_epi16(RGLow, BALow));
+				_mm_storeu_si128(Dest + 2, _mm_unpacklo_epi16(RGHigh, BAHigh));
+				_mm_storeu_si128(Dest + 3, _mm_unpackhi_epi16(RGHigh, BAHigh));
+			}
+		}
+		return x;
+	}
+
+	//Averages 16 columns of two rows into 8 16bit lanes
+	FORCEINLINE __m128i AverageBlocks(const uint8* Row0, const uint8* Row1)
+	{
+		const __m128i Rows = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Row0)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Row1)));
+		const __m128i Sum = _mm_add_epi16(_mm_and_si128(Rows, _mm_set1_epi16(0x00FF)), _mm_srli_epi16(Rows, 8));
+		return _mm_srli_epi16(_mm_add_epi16(Sum, _mm_set1_epi16(1)), 1);
+	}
+
+	int32 HalfRGBRowSIMD(const uint8* Row0, const uint8* Row1, const uint8* VU, int32 Width, uint8* Out)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+		int32 x = 0;
+		for (; x + 16 <= Width; x += 16)
+		{
+			__m128i RC, GC, BC;
+			ChromaTerms(VU + x, RC, GC, BC);
+			const __m128i Luma = _mm_slli_epi16(AverageBlocks(Row0 + x, Row1 + x), CoefficientShift);
+			//Only the low 8 bytes of each register are used. SSE2 has no 3 channel interleave, so that is done per pixel.
+			MS_ALIGN(16) uint8 Channels[3][16] GCC_ALIGN(16);
+			_mm_store_si128(reinterpret_cast<__m128i*>(Channels[0]), ConvertChannel(Luma, Zero, RC, Zero));
+			_mm_store_si128(reinterpret_cast<__m128i*>(Channels[1]), ConvertChannel(Luma, Zero, GC, Zero));
+			_mm_store_si128(reinterpret_cast<__m128i*>(Channels[2]), ConvertChannel(Luma, Zero, BC, Zero));
+			uint8* Dest = Out + (x / 2) * 3;
+			for (int32 i = 0; i < 8; ++i)
+			{
+				Dest[i * 3 + 0] = Channels[0][i];
+				Dest[i * 3 + 1] = Channels[1][i];
+				Dest[i * 3 + 2] = Channels[2][i];
+			}
+		}
+		return x;
+	}
+
+	int32 DownscaleRowSIMD(const uint8* Row0, const uint8* Row1, int32 Width, uint8* Out)
+	{
+		int32 x = 0;
+		for (; x + 32 <= Width; x += 32)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Out + x / 2), _mm_packus_epi16(AverageBlocks(Row0 + x, Row1 + x), AverageBlocks(Row0 + x + 16, Row1 + x + 16)));
+		}
+		return x;
+	}
+
+	int32 VerticalSumSIMD(const uint8* Above, const uint8* Center, const uint8* Below, int32 Width, uint16* Out)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+		int32 x = 0;
+		for (; x + 16 <= Width; x += 16)
+		{
+			const __m128i A = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Above + x));
+			const __m128i C = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Center + x));
+			const __m128i B = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Below + x));
+			const __m128i Low = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(A, Zero), _mm_unpacklo_epi8(B, Zero)), _mm_slli_epi16(_mm_unpacklo_epi8(C, Zero), 1));
+			const __m128i High = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(A, Zero), _mm_unpackhi_epi8(B, Zero)), _mm_slli_epi16(_mm_unpackhi_epi8(C, Zero), 1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Out + x), Low);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Out + x + 8), High);
+		}
+		return x;
+	}
+
+	//Sums are at most 4 * 255, so the signed packs below never saturate.
+	FORCEINLINE __m128i EvenLanes(__m128i A, __m128i B)
+	{
+		return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(A, 16), 16), _mm_srai_epi32(_mm_slli_epi32(B, 16), 16));
+	}
+
+	FORCEINLINE __m128i OddLanes(__m128i A, __m128i B)
+	{
+		return _mm_packs_epi32(_mm_srai_epi32(A, 16), _mm_srai_epi32(B, 16));
+	}
+
+	//Starts at output column Begin > 0 so the left neighbour never has to be clamped. Returns the first column that was not written.
+	int32 HorizontalReduceSIMD(const uint16* Sums, int32 Begin, int32 Width, uint8* Out)
+	{
+		int32 x = Begin;
+		for (; 2 * x + 16 < Width; x += 8)
+		{
+			const __m128i* LeftSource = reinterpret_cast<const __m128i*>(Sums + 2 * x - 1);
+			const __m128i* RightSource = reinterpret_cast<const __m128i*>(Sums + 2 * x + 1);
+			const __m128i A = _mm_loadu_si128(LeftSource);
+			const __m128i B = _mm_loadu_si128(LeftSource + 1);
+			const __m128i Left = EvenLanes(A, B);
+			const __m128i Center = OddLanes(A, B);
+			const __m128i Right = EvenLanes(_mm_loadu_si128(RightSource), _mm_loadu_si128(RightSource + 1));
+			const __m128i Sum = _mm_add_epi16(_mm_add_epi16(Left, Right), _mm_slli_epi16(Center, 1));
+			const __m128i Result = _mm_srli_epi16(_mm_add_epi16(Sum, _mm_set1_epi16(8)), 4);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(Out + x), _mm_packus_epi16(Result, _mm_setzero_si128()));
+		}
+		return x;
+	}
+
+#else
+
+	int32 RGBARowPairSIMD(const uint8*, const uint8*, const uint8*, int32, uint8*, uint8*) { return 0; }
+	int32 HalfRGBRowSIMD(const uint8*, const uint8*, const uint8*, int32, uint8*) { return 0; }
+	int32 DownscaleRowSIMD(const uint8*, const uint8*, int32, uint8*) { return 0; }
+	int32 VerticalSumSIMD(const uint8*, const uint8*, const uint8*, int32, uint16*) { return 0; }
+	int32 HorizontalReduceSIMD(const uint16*, int32 Begin, int32, uint8*) { return Begin; }
+
+#endif
+
+	//Calls Function(FirstRowPair, EndRowPair) for bands of row pairs, in parallel if that is worth it.
+	template<typename FunctionType>
+	void ForEachRowBand(int32 NumRowPairs, bool bParallel, const FunctionType& Function)
+	{
+		int32 NumBands = 1;
+		if (bParallel && FPlatformProcess::SupportsMultithreading())
+		{
+			NumBands = FMath::Clamp(NumRowPairs / MinRowPairsPerBand, 1, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+		}
+		if (NumBands == 1)
+		{
+			Function(0, NumRowPairs);
+			return;
+		}
+		ParallelFor(NumBands, [&](int32 Band)
+		{
+			Function(NumRowPairs * Band / NumBands, NumRowPairs * (Band + 1) / NumBands);
+		});
+	}
+}
+
+void TangoImageConversion::NV21ToRGBA8(const uint8* Y, const uint8* VU, int32 Width, int32 Height, uint8* OutRGBA, bool bParallel, EKernels Kernels)
+{
+	check(Width % 2 == 0 && Height % 2 == 0);
+	const bool bScalar = Kernels == EKernels::Scalar;
+	ForEachRowBand(Height / 2, bParallel, [=](int32 FirstRowPair, int32 EndRowPair)
+	{
+		for (int32 Pair = FirstRowPair; Pair < EndRowPair; ++Pair)
+		{
+			const uint8* Row0 = Y + (Pair * 2) * Width;
+			const uint8* Row1 = Row0 + Width;
+			const uint8* ChromaRow = VU + Pair * Width;
+			uint8* Out0 = OutRGBA + (Pair * 2) * Width * 4;
+			uint8* Out1 = Out0 + Width * 4;
+			const int32 Done = bScalar ? 0 : RGBARowPairSIMD(Row0, Row1, ChromaRow, Width, Out0, Out1);
+			RGBARowPairScalar(Row0, Row1, ChromaRow, Done, Width, Out0, Out1);
+		}
+	});
+}
+
+void TangoImageConversion::NV21ToHalfResolutionRGB(const uint8* Y, const uint8* VU, int32 Width, int32 Height, uint8* OutRGB, bool bParallel, EKernels Kernels)
+{
+	check(Width % 2 == 0 && Height % 2 == 0);
+	const bool bScalar = Kernels == EKernels::Scalar;
+	ForEachRowBand(Height / 2, bParallel, [=](int32 FirstRowPair, int32 EndRowPair)
+	{
+		for (int32 Pair = FirstRowPair; Pair < EndRowPair; ++Pair)
+		{
+			const uint8* Row0 = Y + (Pair * 2) * Width;
+			const uint8* Row1 = Row0 + Width;
+			const uint8* ChromaRow = VU + Pair * Width;
+			uint8* Out = OutRGB + Pair * (Width / 2) * 3;
+			const int32 Done = bScalar ? 0 : HalfRGBRowSIMD(Row0, Row1, ChromaRow, Width, Out);
+			HalfRGBRowScalar(Row0, Row1, ChromaRow, Done, Width, Out);
+		}
+	});
+}
+
+void TangoImageConversion::DownscaleY(const uint8* Y, int32 Width, int32 Height, int32 Stride, uint8* OutY, bool bParallel, EKernels Kernels)
+{
+	check(Width % 2 == 0 && Height % 2 == 0 && Stride >= Width);
+	const bool bScalar = Kernels == EKernels::Scalar;
+	ForEachRowBand(Height / 2, bParallel, [=](int32 FirstRowPair, int32 EndRowPair)
+	{
+		for (int32 Pair = FirstRowPair; Pair < EndRowPair; ++Pair)
+		{
+			const uint8* Row0 = Y + (Pair * 2) * Stride;
+			const uint8* Row1 = Row0 + Stride;
+			uint8* Out = OutY + Pair * (Width / 2);
+			const int32 Done = bScalar ? 0 : DownscaleRowSIMD(Row0, Row1, Width, Out);
+			DownscaleRowScalar(Row0, Row1, Done, Width, Out);
+		}
+	});
+}
+
+void TangoImageConversion::PyramidDownsampleY(const uint8* Y, int32 Width, int32 Height, int32 Stride, uint8* OutY, bool bParallel, EKernels Kernels)
+{
+	check(Width >= 2 && Height >= 2 && Stride >= Width);
+	const bool bScalar = Kernels == EKernels::Scalar;
+	const int32 OutWidth = Width / 2;
+	//Every output row only depends on three input rows, so bands can run independently.
+	ForEachRowBand(Height / 2, bParallel, [=](int32 FirstRow, int32 EndRow)
+	{
+		TArray<uint16> Sums;
+		Sums.SetNumUninitialized(Width);
+		for (int32 Row = FirstRow; Row < EndRow; ++Row)
+		{
+			const uint8* Center = Y + (Row * 2) * Stride;
+			const uint8* Above = Row == 0 ? Center : Center - Stride;
+			const uint8* Below = Center + Stride;
+			uint8* Out = OutY + Row * OutWidth;
+
+			const int32 SummedColumns = bScalar ? 0 : VerticalSumSIMD(Above, Center, Below, Width, Sums.GetData());
+			VerticalSumScalar(Above, Center, Below, SummedColumns, Width, Sums.GetData());
+
+			HorizontalReduceScalar(Sums.GetData(), 0, 1, Out);
+			const int32 ReducedColumns = bScalar ? 1 : HorizontalReduceSIMD(Sums.GetData(), 1, Width, Out);
+			HorizontalReduceScalar(Sums.GetData(), ReducedColumns, OutWidth, Out);
+		}
+	});
+}
+
+void TangoImageConversion::GatherNV21(const uint8* Y, const uint8* VU, int32 Width, const uint32* PackedPixels, int32 Count, FColor* OutColors)
+{
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const uint32 Packed = PackedPixels[i];
+		if (Packed == InvalidPixel)
+		{
+			OutColors[i] = FColor(0, 0, 0, 0);
+			continue;
+		}
+		const int32 Column = (int32)(Packed & 0xffff);
+		const int32 Row = (int32)(Packed >> 16);
+		const uint8* Chroma = VU + (Row / 2) * Width + (Column & ~1);
+		const int32 V = Chroma[0] - 128;
+		const int32 U = Chroma[1] - 128;
+		uint8 RGB[3];
+		ConvertPixel(Y[Row * Width + Column], CoefficientRV * V, -(CoefficientGU * U + CoefficientGV * V), CoefficientBU * U, RGB);
+		OutColors[i] = FColor(RGB[0], RGB[1], RGB[2], 255);
+	}
+}
+
+const TCHAR* TangoImageConversion::GetKernelName()
+{
+#if TANGO_IMAGE_NEON
+	return TEXT("NEON");
+#elif TANGO_IMAGE_SSE2
+	return TEXT("SSE2");
+#else
+	return TEXT("Scalar");
+#endif
+}
+
+/*
+ * Tango.BenchmarkImageConversion [Width] [Height] [Iterations]
+ * Times every kernel scalar, vectorized and vectorized in parallel on a synthetic frame and checks that the results match.
+ */
+namespace
+{
+	template<typename FunctionType>
+	double TimeKernel(int32 Iterations, const FunctionType& Function)
+	{
+		Function();//Warm up caches and the task graph
+		const double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			Function();
+		}
+		return (FPlatformTime::Seconds() - Start) / Iterations;
+	}
+
+	void BenchmarkImageConversion(const TArray<FString>& Args)
+	{
+		const int32 Width = Args.Num() > 0 ? FCString::Atoi(*Args[0]) & ~1 : 1280;
+		const int32 Height = Args.Num() > 1 ? FCString::Atoi(*Args[1]) & ~1 : 720;
+		const int32 Iterations = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 100;
+		if (Width <= 0 || Height <= 0)
+		{
+			UE_LOG(TangoPlugin, Error, TEXT("Tango.BenchmarkImageConversion: Invalid image size %dx%d"), Width, Height);
+			return;
+		}
+
+		TArray<uint8> Source;
+		Source.SetNumUninitialized(Width * Height + Width * (Height / 2));
+		FRandomStream Random(Width * Height);
+		for (uint8& Byte : Source)
+		{
+			Byte = (uint8)Random.RandHelper(256);
+		}
+		const uint8* Y = Source.GetData();
+		const uint8* VU = Y + Width * Height;
+
+		typedef TangoImageConversion::EKernels EKernels;
+		struct FKernel
+		{
+			const TCHAR* Name;
+			//What the kernel reads, the luma kernels leave the chroma plane alone
+			int32 InputSize;
+			int32 OutputSize;
+			TFunction<void(uint8*, bool, EKernels)> Run;
+		};
+		const int32 NV21Size = Source.Num();
+		const int32 LumaSize = Width * Height;
+		const FKernel Kernels[] =
+		{
+			{ TEXT("NV21ToRGBA8"), NV21Size, Width * Height * 4, [=](uint8* Out, bool bParallel, EKernels Selection) { TangoImageConversion::NV21ToRGBA8(Y, VU, Width, Height, Out, bParallel, Selection); } },
+			{ TEXT("NV21ToHalfResolutionRGB"), NV21Size, (Width / 2) * (Height / 2) * 3, [=](uint8* Out, bool bParallel, EKernels Selection) { TangoImageConversion::NV21ToHalfResolutionRGB(Y, VU, Width, Height, Out, bParallel, Selection); } },
+			{ TEXT("DownscaleY"), LumaSize, (Width / 2) * (Height / 2), [=](uint8* Out, bool bParallel, EKernels Selection) { TangoImageConversion::DownscaleY(Y, Width, Height, Width, Out, bParallel, Selection); } },
+			{ TEXT("PyramidDownsampleY"), LumaSize, (Width / 2) * (Height / 2), [=](uint8* Out, bool bParallel, EKernels Selection) { TangoImageConversion::PyramidDownsampleY(Y, Width, Height, Width, Out, bParallel, Selection); } },
+		};
+
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkImageConversion: %dx%d, %d iterations, %s kernels"), Width, Height, Iterations, TangoImageConversion::GetKernelName());
+		for (const FKernel& Kernel : Kernels)
+		{
+			TArray<uint8> Reference, Result;
+			Reference.SetNumZeroed(Kernel.OutputSize);
+			Result.SetNumZeroed(Kernel.OutputSize);
+
+			const double ScalarTime = TimeKernel(Iterations, [&]() { Kernel.Run(Reference.GetData(), false, EKernels::Scalar); });
+			const double VectorTime = TimeKernel(Iterations, [&]() { Kernel.Run(Result.GetData(), false, EKernels::Vectorized); });
+			const bool bVectorMatches = FMemory::Memcmp(Reference.GetData(), Result.GetData(), Kernel.OutputSize) == 0;
+			FMemory::Memzero(Result.GetData(), Kernel.OutputSize);
+			const double ParallelTime = TimeKernel(Iterations, [&]() { Kernel.Run(Result.GetData(), true, EKernels::Vectorized); });
+			const bool bParallelMatches = FMemory::Memcmp(Reference.GetData(), Result.GetData(), Kernel.OutputSize) == 0;
+
+			const double InputMegabytes = Kernel.InputSize / (1024.0 * 1024.0);
+			UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkImageConversion: %-24s scalar %7.3f ms (%7.1f MB/s) | vector %7.3f ms (%7.1f MB/s) | parallel %7.3f ms (%7.1f MB/s)%s"),
+				Kernel.Name,
+				ScalarTime * 1000.0, InputMegabytes / ScalarTime,
+				VectorTime * 1000.0, InputMegabytes / VectorTime,
+				ParallelTime * 1000.0, InputMegabytes / ParallelTime,
+				(bVectorMatches && bParallelMatches) ? TEXT("") : TEXT(" MISMATCH"));
+		}
+	}
+
+	static FAutoConsoleCommand BenchmarkImageConversionCommand(
+		TEXT("Tango.BenchmarkImageConversion"),
+		TEXT("Times the NV21 conversion kernels. Arguments: [Width] [Height] [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkImageConversion));
+}
@@ -0,0 +1,52 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "Object.h"
+
+/*
+ * Color conversions for NV21 camera frames. Uses NEON on ARM and SSE2 on x86, with a scalar fallback
+ * that produces bit identical results. Large images are split into row bands that run in parallel.
+ * Width and Height have to be even, as they always are for NV21.
+ */
+class TangoImageConversion
+{
+public:
+	//Scalar runs the plain C++ path only, for comparing against it
+	enum class EKernels : uint8
+	{
+		Vectorized,
+		Scalar
+	};
+
+	//Writes Width * Height * 4 bytes of RGBA8 with full alpha.
+	static void NV21ToRGBA8(const uint8* Y, const uint8* VU, int32 Width, int32 Height, uint8* OutRGBA, bool bParallel = true, EKernels Kernels = EKernels::Vectorized);
+	//Writes (Width / 2) * (Height / 2) * 3 bytes of RGB8. Each pixel uses the average of a 2x2 luma block and its chroma sample.
+	static void NV21ToHalfResolutionRGB(const uint8* Y, const uint8* VU, int32 Width, int32 Height, uint8* OutRGB, bool bParallel = true, EKernels Kernels = EKernels::Vectorized);
+	//2x2 box filter of a luma plane. Writes (Width / 2) * (Height / 2) bytes.
+	static void DownscaleY(const uint8* Y, int32 Width, int32 Height, int32 Stride, uint8* OutY, bool bParallel = true, EKernels Kernels = EKernels::Vectorized);
+	//Separable [1 2 1] x [1 2 1] smoothing followed by decimation, the reduce step of an image pyramid.
+	//Writes (Width / 2) * (Height / 2) bytes. Unlike the other functions Width and Height may be odd.
+	static void PyramidDownsampleY(const uint8* Y, int32 Width, int32 Height, int32 Stride, uint8* OutY, bool bParallel = true, EKernels Kernels = EKernels::Vectorized);
+
+	//Pixel coordinates for GatherNV21, Row in the upper and Column in the lower 16 bits.
+	static uint32 PackPixel(int32 Column, int32 Row) { return ((uint32)Row << 16) | (uint32)Column; }
+	static const uint32 InvalidPixel = 0xffffffff;
+	//Converts Count single pixels, e.g. the ones points project to. InvalidPixel entries become transparent black.
+	static void GatherNV21(const uint8* Y, const uint8* VU, int32 Width, const uint32* PackedPixels, int32 Count, FColor* OutColors);
+
+	//Name of the instruction set the kernels were compiled for
+	static const TCHAR* GetKernelName();
+};
@@ -0,0 +1,228 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoImagePyramid.h"
+#include "TangoImageConversion.h"
+#include "Async.h"
+
+namespace
+{
+	//Level buffers of discarded pyramids. The camera resolution rarely changes, so they almost always fit the next pyramid.
+	static const int32 MaxPooledBuffers = 32;
+	static FCriticalSection BufferPoolLock;
+	static TArray<TArray<uint8>> BufferPool;
+
+	void AcquireBuffer(TArray<uint8>& Buffer, int32 Size)
+	{
+		{
+			FScopeLock ScopeLock(&BufferPoolLock);
+			int32 BestIndex = INDEX_NONE;
+			for (int32 i = 0; i < BufferPool.Num(); ++i)
+			{
+				if (BufferPool[i].Max() >= Size && (BestIndex == INDEX_NONE || BufferPool[i].Max() < BufferPool[BestIndex].Max()))
+				{
+					BestIndex = i;
+				}
+			}
+			if (BestIndex != INDEX_NONE)
+			{
+				Buffer = MoveTemp(BufferPool[BestIndex]);
+				BufferPool.RemoveAtSwap(BestIndex, 1, false);
+			}
+		}
+		Buffer.SetNumUninitialized(Size, false);
+	}
+
+	void ReleaseBuffer(TArray<uint8>& Buffer)
+	{
+		if (Buffer.Max() == 0)
+		{
+			return;
+		}
+		FScopeLock ScopeLock(&BufferPoolLock);
+		if (BufferPool.Num() < MaxPooledBuffers)
+		{
+			BufferPool.Add(MoveTemp(Buffer));
+		}
+	}
+}
+
+TangoImagePyramid::TangoImagePyramid(const FTangoCameraFrame& InFrame)
+	: Frame(InFrame)
+	, NumBuiltLevels(1)
+	, NumRequestedLevels(1)
+{
+	Levels.SetNum(MaxLevels);
+	Levels[0].Width = Frame.Width;
+	Levels[0].Height = Frame.Height;
+	for (int32 i = 1; i < MaxLevels; ++i)
+	{
+		Levels[i].Width = Levels[i - 1].Width / 2;
+		Levels[i].Height = Levels[i - 1].Height / 2;
+	}
+}
+
+TangoImagePyramid::~TangoImagePyramid()
+{
+	for (FLevel& Level : Levels)
+	{
+		ReleaseBuffer(Level.Buffer);
+	}
+}
+
+const uint8* TangoImagePyramid::GetLevelData(int32 Level) const
+{
+	check(Level < NumBuiltLevels);
+	return Level == 0 ? Frame.GetY() : Levels[Level].Buffer.GetData();
+}
+
+int32 TangoImagePyramid::ClampNumLevels(int32 NumLevels) const
+{
+	int32 Result = 1;
+	while (Result < FMath::Min(NumLevels, (int32)MaxLevels) && Levels[Result].Width >= MinLevelSize && Levels[Result].Height >= MinLevelSize)
+	{
+		Result++;
+	}
+	return Result;
+}
+
+void TangoImagePyramid::Build(int32 NumLevels)
+{
+	FScopeLock ScopeLock(&BuildLock);
+	for (int32 i = NumBuiltLevels; i < NumLevels; ++i)
+	{
+		const FLevel& Source = Levels[i - 1];
+		FLevel& Target = Levels[i];
+		AcquireBuffer(Target.Buffer, Target.Width * Target.Height);
+		//Builds already run on a worker or for a single consumer, so the kernel itself stays on this thread.
+		TangoImageConversion::PyramidDownsampleY(GetLevelData(i - 1), Source.Width, Source.Height, Source.Width, Target.Buffer.GetData(), false);
+		FPlatformMisc::MemoryBarrier();
+		NumBuiltLevels = i + 1;
+	}
+}
+
+void TangoImagePyramid::Request(const FTangoCameraFrameHandle& Frame, int32 NumLevels)
+{
+	if (!Frame.IsValid())
+	{
+		return;
+	}
+	TangoImagePyramid& Pyramid = Frame->GetOrCreatePyramid();
+	NumLevels = Pyramid.ClampNumLevels(NumLevels);
+	for (;;)
+	{
+		const int32 AlreadyRequested = Pyramid.NumRequestedLevels;
+		if (AlreadyRequested >= NumLevels)
+		{
+			return;
+		}
+		if (FPlatformAtomics::InterlockedCompareExchange(&Pyramid.NumRequestedLevels, NumLevels, AlreadyRequested) == AlreadyRequested)
+		{
+			break;
+		}
+	}
+	//The task holds a handle, so the pool cannot reuse the frame while its pyramid is being built.
+	FTangoCameraFrameHandle KeepAlive = Frame;
+	Async<void>(EAsyncExecution::ThreadPool, [KeepAlive, NumLevels]()
+	{
+		KeepAlive->GetOrCreatePyramid().Build(NumLevels);
+	});
+}
+
+const TangoImagePyramid& TangoImagePyramid::Get(const FTangoCameraFrameHandle& Frame, int32 NumLevels)
+{
+	check(Frame.IsValid());
+	TangoImagePyramid& Pyramid = Frame->GetOrCreatePyramid();
+	NumLevels = Pyramid.ClampNumLevels(NumLevels);
+	if (Pyramid.NumBuiltLevels < NumLevels)
+	{
+		Pyramid.Build(NumLevels);
+	}
+	return Pyramid;
+}
+
+/*
+ * Tango.BenchmarkImagePyramid [Levels] [Iterations] [Width] [Height]
+ * Defaults to the resolution of the Tango color camera. Builds pyramids of synthetic frames on the calling thread and through the worker.
+ */
+namespace
+{
+	void BenchmarkImagePyramid(const TArray<FString>& Args)
+	{
+		const int32 NumLevels = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 2, (int32)TangoImagePyramid::MaxLevels) : 5;
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 100;
+		const int32 Width = Args.Num() > 2 ? FCString::Atoi(*Args[2]) & ~1 : 1280;
+		const int32 Height = Args.Num() > 3 ? FCString::Atoi(*Args[3]) & ~1 : 720;
+		if (Width <= 0 || Height <= 0)
+		{
+			UE_LOG(TangoPlugin, Error, TEXT("Tango.BenchmarkImagePyramid: Invalid image size %dx%d"), Width, Height);
+			return;
+		}
+
+		TSharedPtr<TangoCameraFramePool, ESPMode::ThreadSafe> Pool = MakeShareable(new TangoCameraFramePool(3));
+		TArray<double> LevelTimes;
+		LevelTimes.SetNumZeroed(NumLevels);
+		double SynchronousTime = 0.0;
+		double AsynchronousTime = 0.0;
+		int32 BuiltLevels = 0;
+
+		for (int32 i = 0; i < Iterations + 1; ++i)
+		{
+			//Fresh frames, so every iteration builds a new pyramid into recycled buffers. The first iteration only warms up the buffer pool.
+			Pool->SubmitSyntheticFrame(Width, Height, (double)i);
+			FTangoCameraFrameHandle Frame = Pool->GetLatestFrame();
+			double Start = FPlatformTime::Seconds();
+			for (int32 Level = 1; Level < NumLevels; ++Level)
+			{
+				const double LevelStart = FPlatformTime::Seconds();
+				BuiltLevels = TangoImagePyramid::Get(Frame, Level + 1).GetNumLevels();
+				if (i > 0)
+				{
+					LevelTimes[Level] += FPlatformTime::Seconds() - LevelStart;
+				}
+			}
+			if (i > 0)
+			{
+				SynchronousTime += FPlatformTime::Seconds() - Start;
+			}
+
+			Pool->SubmitSyntheticFrame(Width, Height, (double)i + 0.5);
+			Frame = Pool->GetLatestFrame();
+			Start = FPlatformTime::Seconds();
+			TangoImagePyramid::Request(Frame, NumLevels);
+			TangoImagePyramid::Get(Frame, NumLevels);
+			if (i > 0)
+			{
+				AsynchronousTime += FPlatformTime::Seconds() - Start;
+			}
+		}
+
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkImagePyramid: %dx%d, %d levels built, %d iterations, %s kernels"), Width, Height, BuiltLevels, Iterations, TangoImageConversion::GetKernelName());
+		for (int32 Level = 1; Level < BuiltLevels; ++Level)
+		{
+			const int32 SourcePixels = (Width >> (Level - 1)) * (Height >> (Level - 1));
+			const double Seconds = LevelTimes[Level] / Iterations;
+			UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkImagePyramid: level %d (%dx%d) %7.3f ms, %6.2f ns/source pixel"),
+				Level, Width >> Level, Height >> Level, Seconds * 1000.0, Seconds * 1e9 / SourcePixels);
+		}
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkImagePyramid: full pyramid %7.3f ms on the calling thread, %7.3f ms request to ready through the worker"),
+			SynchronousTime * 1000.0 / Iterations, AsynchronousTime * 1000.0 / Iterations);
+	}
+
+	static FAutoConsoleCommand BenchmarkImagePyramidCommand(
+		TEXT("Tango.BenchmarkImagePyramid"),
+		TEXT("Times grayscale pyramid construction. Arguments: [Levels] [Iterations] [Width] [Height]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkImagePyramid));
+}
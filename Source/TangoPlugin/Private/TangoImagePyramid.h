@@ -0,0 +1,60 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoCameraFramePool.h"
+
+/*
+ * Grayscale pyramid of the Y plane of a camera frame. Level 0 is the Y plane itself, every further level has half the resolution of the one above.
+ * A pyramid belongs to its frame: it is valid as long as a handle to the frame is held and is discarded when the pool reuses the frame.
+ */
+class TangoImagePyramid
+{
+public:
+	static const int32 MaxLevels = 8;
+	//No level is made smaller than this in either dimension
+	static const int32 MinLevelSize = 8;
+
+	//Starts building NumLevels levels for Frame on a worker thread, unless they exist or are being built already.
+	static void Request(const FTangoCameraFrameHandle& Frame, int32 NumLevels);
+	//Returns the pyramid of Frame with up to NumLevels levels. Waits for a running build and builds missing levels on the calling thread.
+	static const TangoImagePyramid& Get(const FTangoCameraFrameHandle& Frame, int32 NumLevels);
+
+	TangoImagePyramid(const FTangoCameraFrame& InFrame);
+	~TangoImagePyramid();
+
+	int32 GetNumLevels() const { return NumBuiltLevels; }
+	const uint8* GetLevelData(int32 Level) const;
+	int32 GetLevelWidth(int32 Level) const { return Levels[Level].Width; }
+	int32 GetLevelHeight(int32 Level) const { return Levels[Level].Height; }
+
+private:
+	struct FLevel
+	{
+		int32 Width;
+		int32 Height;
+		TArray<uint8> Buffer;
+	};
+
+	int32 ClampNumLevels(int32 NumLevels) const;
+	void Build(int32 NumLevels);
+
+	const FTangoCameraFrame& Frame;
+	//Reserved for MaxLevels up front, so building more levels never moves the ones handed out already.
+	TArray<FLevel> Levels;
+	volatile int32 NumBuiltLevels;
+	volatile int32 NumRequestedLevels;
+	FCriticalSection BuildLock;
+};
@@ -0,0 +1,146 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoLatencyMonitor.h"
+#include "TangoStats.h"
+#include "TangoDevice.h"
+
+namespace
+{
+	FTangoLatencyPercentiles GetPercentiles(TArray<float>& Ages)
+	{
+		FTangoLatencyPercentiles Result;
+		Result.NumSamples = Ages.Num();
+		if (Ages.Num() == 0)
+		{
+			return Result;
+		}
+		Ages.Sort();
+		double Sum = 0.0;
+		for (float Age : Ages)
+		{
+			Sum += Age;
+		}
+		const auto AtPercentile = [&Ages](float Percentile)
+		{
+			const int32 Index = FMath::Clamp(FMath::CeilToInt(Ages.Num() * Percentile / 100.0f) - 1, 0, Ages.Num() - 1);
+			return Ages[Index] * 1000.0f;
+		};
+		Result.Mean = (float)(Sum / Ages.Num() * 1000.0);
+		Result.P50 = AtPercentile(50.0f);
+		Result.P95 = AtPercentile(95.0f);
+		Result.P99 = AtPercentile(99.0f);
+		Result.Max = Ages.Last() * 1000.0f;
+		return Result;
+	}
+}
+
+TangoLatencyMonitor::TangoLatencyMonitor()
+{
+	Reset();
+}
+
+void TangoLatencyMonitor::RecordFrame(const TangoClockSync& Clock, double PoseTimestamp, double ImageTimestamp)
+{
+	const double Now = FPlatformTime::Seconds();
+	FFrame Frame;
+	Frame.PoseAge = -1.0f;
+	Frame.ImageAge = -1.0f;
+	double EngineTime = 0.0;
+	if (PoseTimestamp > 0.0 && Clock.ServiceToEngineTime(PoseTimestamp, EngineTime))
+	{
+		Frame.PoseAge = (float)FMath::Max(Now - EngineTime, 0.0);
+		SET_FLOAT_STAT(STAT_TangoPoseAge, Frame.PoseAge * 1000.0f);
+	}
+	if (ImageTimestamp > 0.0 && Clock.ServiceToEngineTime(ImageTimestamp, EngineTime))
+	{
+		Frame.ImageAge = (float)FMath::Max(Now - EngineTime, 0.0);
+		SET_FLOAT_STAT(STAT_TangoImageAge, Frame.ImageAge * 1000.0f);
+	}
+	if (Frame.PoseAge < 0.0f && Frame.ImageAge < 0.0f)
+	{
+		return;
+	}
+	FScopeLock ScopeLock(&Lock);
+	Frames[NextFrame] = Frame;
+	NextFrame = (NextFrame + 1) % NumFrames;
+	NumRecordedFrames = FMath::Min(NumRecordedFrames + 1, NumFrames);
+}
+
+FTangoLatencyStats TangoLatencyMonitor::GetStats() const
+{
+	TArray<float> PoseAges;
+	TArray<float> ImageAges;
+	{
+		FScopeLock ScopeLock(&Lock);
+		PoseAges.Reserve(NumRecordedFrames);
+		ImageAges.Reserve(NumRecordedFrames);
+		for (int32 i = 0; i < NumRecordedFrames; ++i)
+		{
+			if (Frames[i].PoseAge >= 0.0f)
+			{
+				PoseAges.Add(Frames[i].PoseAge);
+			}
+			if (Frames[i].ImageAge >= 0.0f)
+			{
+				ImageAges.Add(Frames[i].ImageAge);
+			}
+		}
+	}
+	FTangoLatencyStats Stats;
+	Stats.PoseAge = GetPercentiles(PoseAges);
+	Stats.ImageAge = GetPercentiles(ImageAges);
+	return Stats;
+}
+
+void TangoLatencyMonitor::Reset()
+{
+	FScopeLock ScopeLock(&Lock);
+	NextFrame = 0;
+	NumRecordedFrames = 0;
+}
+
+/*
+ * Tango.LatencyStats [reset]
+ * Prints how old poses and camera images were when the render thread submitted the last frames.
+ */
+namespace
+{
+	void PrintLatency(const TCHAR* Name, const FTangoLatencyPercentiles& Latency)
+	{
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.LatencyStats: %-9s %5d frames, mean %7.2f p50 %7.2f p95 %7.2f p99 %7.2f max %7.2f ms"),
+			Name, Latency.NumSamples, Latency.Mean, Latency.P50, Latency.P95, Latency.P99, Latency.Max);
+	}
+
+	void PrintLatencyStats(const TArray<FString>& Args)
+	{
+		TangoLatencyMonitor& Monitor = UTangoDevice::Get().LatencyMonitor;
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			Monitor.Reset();
+			UE_LOG(TangoPlugin, Log, TEXT("Tango.LatencyStats: Statistics cleared"));
+			return;
+		}
+		const FTangoLatencyStats Stats = Monitor.GetStats();
+		PrintLatency(TEXT("pose"), Stats.PoseAge);
+		PrintLatency(TEXT("image"), Stats.ImageAge);
+	}
+
+	static FAutoConsoleCommand LatencyStatsCommand(
+		TEXT("Tango.LatencyStats"),
+		TEXT("Prints the age of poses and camera images at render thread submission over the last frames. Argument: [reset]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&PrintLatencyStats));
+}
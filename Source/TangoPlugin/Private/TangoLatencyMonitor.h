@@ -0,0 +1,68 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#pragma once
+
+#include "TangoClockSync.h"
+
+struct FTangoLatencyPercentiles
+{
+	int32 NumSamples = 0;
+	//Milliseconds
+	float Mean = 0.0f;
+	float P50 = 0.0f;
+	float P95 = 0.0f;
+	float P99 = 0.0f;
+	float Max = 0.0f;
+};
+
+struct FTangoLatencyStats
+{
+	//Age of the pose the late update used when the render thread submitted the frame
+	FTangoLatencyPercentiles PoseAge;
+	//Age of the camera image the frame shows, only frames that show one
+	FTangoLatencyPercentiles ImageAge;
+};
+
+/*
+ * Motion to photon latency over the last frames: how old the pose and the camera image of each frame were when the render thread
+ * submitted it. Service timestamps are converted to engine time with a TangoClockSync, so the ages are measured from the fastest
+ * delivery seen and leave out how long the service itself took.
+ */
+class TangoLatencyMonitor
+{
+public:
+	static const int32 NumFrames = 1024;
+
+	TangoLatencyMonitor();
+
+	//Render thread, once per frame. Timestamps are service timestamps, 0 if the frame has no pose or image.
+	void RecordFrame(const TangoClockSync& Clock, double PoseTimestamp, double ImageTimestamp);
+	FTangoLatencyStats GetStats() const;
+	void Reset();
+
+private:
+	struct FFrame
+	{
+		//Seconds, negative if not known
+		float PoseAge;
+		float ImageAge;
+	};
+
+	mutable FCriticalSection Lock;
+	FFrame Frames[NumFrames];
+	int32 NextFrame;
+	int32 NumRecordedFrames;
+};
@@ -0,0 +1,727 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoLensModel.h"
+#include "TangoImageConversion.h"
+#include "ParallelFor.h"
+#include "Async.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define TANGO_LENS_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TANGO_LENS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifndef TANGO_LENS_NEON
+#define TANGO_LENS_NEON 0
+#endif
+#ifndef TANGO_LENS_SSE2
+#define TANGO_LENS_SSE2 0
+#endif
+
+const FVector2D TangoLensModel::InvalidPixel(-1.0f, -1.0f);
+
+namespace
+{
+	//Bump this whenever the layout of the cache file changes.
+	static const uint32 LensCacheMagic = 0x544c4e53; //'TLNS'
+	static const uint32 LensCacheVersion = 2;
+
+	//Points closer to the camera than this are not projected, they would only produce huge pixel coordinates.
+	static const float MinDepth = 0.01f;
+	//Fixed point iterations for inverting the polynomial models. Plenty for the moderate distortion of the Tango cameras.
+	static const int32 UndistortIterations = 8;
+	//Batches are processed in chunks of this size where a temporary buffer is needed, so it stays on the stack.
+	static const int32 ChunkSize = 256;
+	static const int32 MaxSharedModels = 8;
+
+	static FCriticalSection SharedModelsLock;
+	static TMap<uint32, TSharedRef<TangoLensModel, ESPMode::ThreadSafe>> SharedModels;
+
+	//The calibration the lookup tables of a cache file were built from. The hash in the file name alone can collide.
+	void SerializeCalibration(FArchive& Ar, FTangoCameraIntrinsics& Calibration)
+	{
+		uint8 CalibrationType = (uint8)Calibration.CalibrationType.GetValue();
+		Ar << CalibrationType;
+		Calibration.CalibrationType = (ETangoCalibrationType::Type)CalibrationType;
+		Ar << Calibration.Width;
+		Ar << Calibration.Height;
+		Ar << Calibration.Fx;
+		Ar << Calibration.Fy;
+		Ar << Calibration.Cx;
+		Ar << Calibration.Cy;
+		Ar << Calibration.Distortion;
+	}
+
+	bool IsSameCalibration(const FTangoCameraIntrinsics& A, const FTangoCameraIntrinsics& B)
+	{
+		return A.CalibrationType == B.CalibrationType && A.Width == B.Width && A.Height == B.Height
+			&& A.Fx == B.Fx && A.Fy == B.Fy && A.Cx == B.Cx && A.Cy == B.Cy && A.Distortion == B.Distortion;
+	}
+}
+
+//Scalar kernels. They also handle the elements the vector kernels leave over and the equidistant model.
+namespace
+{
+	template<typename CoefficientsType>
+	FORCEINLINE void DistortScalar(const CoefficientsType& C, float Xn, float Yn, float& Xd, float& Yd)
+	{
+		const float R2 = Xn * Xn + Yn * Yn;
+		if (C.bEquidistant)
+		{
+			const float Ru = FMath::Sqrt(R2);
+			const float Factor = Ru > SMALL_NUMBER ? FMath::Atan(Ru * C.TwoTanHalfW) / (C.W * Ru) : 1.0f;
+			Xd = Xn * Factor;
+			Yd = Yn * Factor;
+			return;
+		}
+		const float Radial = 1.0f + R2 * (C.K1 + R2 * (C.K2 + R2 * C.K3));
+		const float XY2 = 2.0f * Xn * Yn;
+		Xd = Xn * Radial + XY2 * C.P1 + C.P2 * (R2 + 2.0f * Xn * Xn);
+		Yd = Yn * Radial + XY2 * C.P2 + C.P1 * (R2 + 2.0f * Yn * Yn);
+	}
+
+	template<typename CoefficientsType>
+	FORCEINLINE void UndistortScalar(const CoefficientsType& C, float Xd, float Yd, float& Xn, float& Yn)
+	{
+		if (C.bEquidistant)
+		{
+			//The FOV model has a closed form inverse
+			const float Rd = FMath::Sqrt(Xd * Xd + Yd * Yd);
+			const float Factor = Rd > SMALL_NUMBER ? FMath::Tan(Rd * C.W) / (C.TwoTanHalfW * Rd) : 1.0f;
+			Xn = Xd * Factor;
+			Yn = Yd * Factor;
+			return;
+		}
+		Xn = Xd;
+		Yn = Yd;
+		for (int32 i = 0; i < UndistortIterations; ++i)
+		{
+			float X;
+			float Y;
+			DistortScalar(C, Xn, Yn, X, Y);
+			Xn += Xd - X;
+			Yn += Yd - Y;
+		}
+	}
+
+	template<typename CoefficientsType>
+	FORCEINLINE FVector2D ProjectScalar(const CoefficientsType& C, const FMatrix& M, const FVector& Point)
+	{
+		const FVector P = M.TransformPosition(Point);
+		if (!(P.Z > MinDepth))
+		{
+			return TangoLensModel::InvalidPixel;
+		}
+		float Xd;
+		float Yd;
+		DistortScalar(C, P.X / P.Z, P.Y / P.Z, Xd, Yd);
+		return FVector2D(C.Fx * Xd + C.Cx, C.Fy * Yd + C.Cy);
+	}
+}
+
+/*
+ * Vector kernels for the polynomial models. Each one returns the first element it did not process.
+ * They evaluate in a different order than the scalar code, so results may differ in the last bits.
+ */
+namespace
+{
+#if TANGO_LENS_NEON
+
+	typedef float32x4_t FLanes;
+
+	FORCEINLINE FLanes Divide(FLanes A, FLanes B)
+	{
+		//Reciprocal estimate with two Newton-Raphson steps, ARMv7 has no vector division.
+		FLanes Reciprocal = vrecpeq_f32(B);
+		Reciprocal = vmulq_f32(vrecpsq_f32(B, Reciprocal), Reciprocal);
+		Reciprocal = vmulq_f32(vrecpsq_f32(B, Reciprocal), Reciprocal);
+		return vmulq_f32(A, Reciprocal);
+	}
+
+	template<typename CoefficientsType>
+	FORCEINLINE void DistortLanes(const CoefficientsType& C, FLanes Xn, FLanes Yn, FLanes& Xd, FLanes& Yd)
+	{
+		const FLanes Two = vdupq_n_f32(2.0f);
+		const FLanes R2 = vmlaq_f32(vmulq_f32(Xn, Xn), Yn, Yn);
+		const FLanes Radial = vmlaq_f32(vdupq_n_f32(1.0f), R2, vmlaq_f32(vdupq_n_f32(C.K1), R2, vmlaq_n_f32(vdupq_n_f32(C.K2), R2, C.K3)));
+		const FLanes XY2 = vmulq_f32(Two, vmulq_f32(Xn, Yn));
+		Xd = vmlaq_n_f32(vmlaq_n_f32(vmulq_f32(Xn, Radial), XY2, C.P1), vmlaq_f32(R2, Two, vmulq_f32(Xn, Xn)), C.P2);
+		Yd = vmlaq_n_f32(vmlaq_n_f32(vmulq_f32(Yn, Radial), XY2, C.P2), vmlaq_f32(R2, Two, vmulq_f32(Yn, Yn)), C.P1);
+	}
+
+	template<typename CoefficientsType>
+	int32 DistortSIMD(const CoefficientsType& C, const FVector2D* In, FVector2D* Out, int32 Count)
+	{
+		int32 i = 0;
+		for (; i + 4 <= Count; i += 4)
+		{
+			const float32x4x2_t Normalized = vld2q_f32(&In[i].X);
+			float32x4x2_t Distorted;
+			DistortLanes(C, Normalized.val[0], Normalized.val[1], Distorted.val[0], Distorted.val[1]);
+			vst2q_f32(&Out[i].X, Distorted);
+		}
+		return i;
+	}
+
+	template<typename CoefficientsType>
+	int32 UndistortSIMD(const CoefficientsType& C, const FVector2D* In, FVector2D* Out, int32 Count)
+	{
+		int32 i = 0;
+		for (; i + 4 <= Count; i += 4)
+		{
+			const float32x4x2_t Distorted = vld2q_f32(&In[i].X);
+			float32x4x2_t Normalized = Distorted;
+			for (int32 Iteration = 0; Iteration < UndistortIterations; ++Iteration)
+			{
+				FLanes X;
+				FLanes Y;
+				DistortLanes(C, Normalized.val[0], Normalized.val[1], X, Y);
+				Normalized.val[0] = vaddq_f32(Normalized.val[0], vsubq_f32(Distorted.val[0], X));
+				Normalized.val[1] = vaddq_f32(Normalized.val[1], vsubq_f32(Distorted.val[1], Y));
+			}
+			vst2q_f32(&Out[i].X, Normalized);
+		}
+		return i;
+	}
+
+	template<typename CoefficientsType>
+	int32 ProjectSIMD(const CoefficientsType& C, const FMatrix& M, const FVector* Points, FVector2D* Out, int32 Count)
+	{
+		const FLanes Invalid = vdupq_n_f32(TangoLensModel::InvalidPixel.X);
+		int32 i = 0;
+		for (; i + 4 <= Count; i += 4)
+		{
+			//FVector is three packed floats, so this deinterleaves four points into X, Y and Z lanes.
+			const float32x4x3_t In = vld3q_f32(&Points[i].X);
+			const FLanes X = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(M.M[3][0]), In.val[0], M.M[0][0]), In.val[1], M.M[1][0]), In.val[2], M.M[2][0]);
+			const FLanes Y = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(M.M[3][1]), In.val[0], M.M[0][1]), In.val[1], M.M[1][1]), In.val[2], M.M[2][1]);
+			const FLanes Z = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(M.M[3][2]), In.val[0], M.M[0][2]), In.val[1], M.M[1][2]), In.val[2], M.M[2][2]);
+			const uint32x4_t Valid = vcgtq_f32(Z, vdupq_n_f32(MinDepth));
+			FLanes Xd;
+			FLanes Yd;
+			DistortLanes(C, Divide(X, Z), Divide(Y, Z), Xd, Yd);
+			float32x4x2_t Pixels;
+			Pixels.val[0] = vbslq_f32(Valid, vmlaq_n_f32(vdupq_n_f32(C.Cx), Xd, C.Fx), Invalid);
+			Pixels.val[1] = vbslq_f32(Valid, vmlaq_n_f32(vdupq_n_f32(C.Cy), Yd, C.Fy), Invalid);
+			vst2q_f32(&Out[i].X, Pixels);
+		}
+		return i;
+	}
+
+#elif TANGO_LENS_SSE2
+
+	typedef __m128 FLanes;
+
+	FORCEINLINE void LoadVector2D(const FVector2D* In, FLanes& X, FLanes& Y)
+	{
+		const FLanes A = _mm_loadu_ps(&In[0].X);
+		const FLanes B = _mm_loadu_ps(&In[2].X);
+		X = _mm_shuffle_ps(A, B, _MM_SHUFFLE(2, 0, 2, 0));
+		Y = _mm_shuffle_ps(A, B, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	FORCEINLINE void StoreVector2D(FVector2D* Out, FLanes X, FLanes Y)
+	{
+		_mm_storeu_ps(&Out[0].X, _mm_unpacklo_ps(X, Y));
+		_mm_storeu_ps(&Out[2].X, _mm_unpackhi_ps(X, Y));
+	}
+
+	template<typename CoefficientsType>
+	FORCEINLINE void DistortLanes(const CoefficientsType& C, FLanes Xn, FLanes Yn, FLanes& Xd, FLanes& Yd)
+	{
+		const FLanes Two = _mm_set1_ps(2.0f);
+		const FLanes R2 = _mm_add_ps(_mm_mul_ps(Xn, Xn), _mm_mul_ps(Yn, Yn));
+		const FLanes Radial = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(R2, _mm_add_ps(_mm_set1_ps(C.K1), _mm_mul_ps(R2, _mm_add_ps(_mm_set1_ps(C.K2), _mm_mul_ps(R2, _mm_set1_ps(C.K3)))))));
+		const FLanes XY2 = _mm_mul_ps(Two, _mm_mul_ps(Xn, Yn));
+		Xd = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Xn, Radial), _mm_mul_ps(XY2, _mm_set1_ps(C.P1))), _mm_mul_ps(_mm_set1_ps(C.P2), _mm_add_ps(R2, _mm_mul_ps(Two, _mm_mul_ps(Xn, Xn)))));
+		Yd = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Yn, Radial), _mm_mul_ps(XY2, _mm_set1_ps(C.P2))), _mm_mul_ps(_mm_set1_ps(C.P1), _mm_add_ps(R2, _mm_mul_ps(Two, _mm_mul_ps(Yn, Yn)))));
+	}
+
+	template<typename CoefficientsType>
+	int32 DistortSIMD(const CoefficientsType& C, const FVector2D* In, FVector2D* Out, int32 Count)
+	{
+		int32 i = 0;
+		for (; i + 4 <= Count; i += 4)
+		{
+			FLanes Xn;
+			FLanes Yn;
+			LoadVector2D(In + i, Xn, Yn);
+			FLanes Xd;
+			FLanes Yd;
+			DistortLanes(C, Xn, Yn, Xd, Yd);
+			StoreVector2D(Out + i, Xd, Yd);
+		}
+		return i;
+	}
+
+	template<typename CoefficientsType>
+	int32 UndistortSIMD(const CoefficientsType& C, const FVector2D* In, FVector2D* Out, int32 Count)
+	{
+		int32 i = 0;
+		for (; i + 4 <= Count; i += 4)
+		{
+			FLanes Xd;
+			FLanes Yd;
+			LoadVector2D(In + i, Xd, Yd);
+			FLanes Xn = Xd;
+			FLanes Yn = Yd;
+			for (int32 Iteration = 0; Iteration < UndistortIterations; ++Iteration)
+			{
+				FLanes X;
+				FLanes Y;
+				DistortLanes(C, Xn, Yn, X, Y);
+				Xn = _mm_add_ps(Xn, _mm_sub_ps(Xd, X));
+				Yn = _mm_add_ps(Yn, _mm_sub_ps(Yd, Y));
+			}
+			StoreVector2D(Out + i, Xn, Yn);
+		}
+		return i;
+	}
+
+	template<typename CoefficientsType>
+	int32 ProjectSIMD(const CoefficientsType& C, const FMatrix& M, const FVector* Points, FVector2D* Out, int32 Count)
+	{
+		const FLanes Invalid = _mm_set1_ps(TangoLensModel::InvalidPixel.X);
+		int32 i = 0;
+		for (; i + 4 <= Count; i += 4)
+		{
+			const FVector* In = Points + i;
+			const FLanes PX = _mm_set_ps(In[3].X, In[2].X, In[1].X, In[0].X);
+			const FLanes PY = _mm_set_ps(In[3].Y, In[2].Y, In[1].Y, In[0].Y);
+			const FLanes PZ = _mm_set_ps(In[3].Z, In[2].Z, In[1].Z, In[0].Z);
+			const FLanes X = _mm_add_ps(_mm_add_ps(_mm_mul_ps(PX, _mm_set1_ps(M.M[0][0])), _mm_mul_ps(PY, _mm_set1_ps(M.M[1][0]))), _mm_add_ps(_mm_mul_ps(PZ, _mm_set1_ps(M.M[2][0])), _mm_set1_ps(M.M[3][0])));
+			const FLanes Y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(PX, _mm_set1_ps(M.M[0][1])), _mm_mul_ps(PY, _mm_set1_ps(M.M[1][1]))), _mm_add_ps(_mm_mul_ps(PZ, _mm_set1_ps(M.M[2][1])), _mm_set1_ps(M.M[3][1])));
+			const FLanes Z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(PX, _mm_set1_ps(M.M[0][2])), _mm_mul_ps(PY, _mm_set1_ps(M.M[1][2]))), _mm_add_ps(_mm_mul_ps(PZ, _mm_set1_ps(M.M[2][2])), _mm_set1_ps(M.M[3][2])));
+			const FLanes Valid = _mm_cmpgt_ps(Z, _mm_set1_ps(MinDepth));
+			FLanes Xd;
+			FLanes Yd;
+			DistortLanes(C, _mm_div_ps(X, Z), _mm_div_ps(Y, Z), Xd, Yd);
+			const FLanes U = _mm_add_ps(_mm_mul_ps(Xd, _mm_set1_ps(C.Fx)), _mm_set1_ps(C.Cx));
+			const FLanes V = _mm_add_ps(_mm_mul_ps(Yd, _mm_set1_ps(C.Fy)), _mm_set1_ps(C.Cy));
+			StoreVector2D(Out + i, _mm_or_ps(_mm_and_ps(Valid, U), _mm_andnot_ps(Valid, Invalid)), _mm_or_ps(_mm_and_ps(Valid, V), _mm_andnot_ps(Valid, Invalid)));
+		}
+		return i;
+	}
+
+#else
+
+	template<typename CoefficientsType>
+	int32 DistortSIMD(const CoefficientsType&, const FVector2D*, FVector2D*, int32) { return 0; }
+	template<typename CoefficientsType>
+	int32 UndistortSIMD(const CoefficientsType&, const FVector2D*, FVector2D*, int32) { return 0; }
+	template<typename CoefficientsType>
+	int32 ProjectSIMD(const CoefficientsType&, const FMatrix&, const FVector*, FVector2D*, int32) { return 0; }
+
+#endif
+}
+
+bool FTangoLensLookupTables::Sample(const TArray<FVector2D>& Map, float U, float V, FVector2D& Out) const
+{
+	const float GridX = U / Step;
+	const float GridY = V / Step;
+	if (!(GridX >= 0.0f && GridY >= 0.0f))
+	{
+		return false;
+	}
+	const int32 X0 = (int32)GridX;
+	const int32 Y0 = (int32)GridY;
+	if (X0 >= GridWidth - 1 || Y0 >= GridHeight - 1)
+	{
+		return false;
+	}
+	const float AlphaX = GridX - X0;
+	const float AlphaY = GridY - Y0;
+	const FVector2D* Row0 = Map.GetData() + Y0 * GridWidth + X0;
+	const FVector2D* Row1 = Row0 + GridWidth;
+	const FVector2D Top = Row0[0] + (Row0[1] - Row0[0]) * AlphaX;
+	const FVector2D Bottom = Row1[0] + (Row1[1] - Row1[0]) * AlphaX;
+	Out = Top + (Bottom - Top) * AlphaY;
+	return true;
+}
+
+uint32 TangoLensModel::HashIntrinsics(const FTangoCameraIntrinsics& Intrinsics)
+{
+	const float Values[] = { (float)Intrinsics.CalibrationType.GetValue(), (float)Intrinsics.Width, (float)Intrinsics.Height,
+		Intrinsics.Fx, Intrinsics.Fy, (float)Intrinsics.Cx, (float)Intrinsics.Cy };
+	uint32 Result = FCrc::MemCrc32(Values, sizeof(Values));
+	return FCrc::MemCrc32(Intrinsics.Distortion.GetData(), Intrinsics.Distortion.Num() * sizeof(float), Result);
+}
+
+TSharedRef<TangoLensModel, ESPMode::ThreadSafe> TangoLensModel::Get(const FTangoCameraIntrinsics& Intrinsics)
+{
+	const uint32 Hash = HashIntrinsics(Intrinsics);
+	FScopeLock ScopeLock(&SharedModelsLock);
+	if (const TSharedRef<TangoLensModel, ESPMode::ThreadSafe>* Found = SharedModels.Find(Hash))
+	{
+		return *Found;
+	}
+	//Calibrations hardly ever change, so this only triggers when something feeds made up intrinsics.
+	if (SharedModels.Num() >= MaxSharedModels)
+	{
+		SharedModels.Empty();
+	}
+	TSharedRef<TangoLensModel, ESPMode::ThreadSafe> Model = MakeShareable(new TangoLensModel(Intrinsics));
+	SharedModels.Add(Hash, Model);
+	return Model;
+}
+
+TangoLensModel::TangoLensModel(const FTangoCameraIntrinsics& InIntrinsics)
+	: Intrinsics(InIntrinsics)
+	, Hash(HashIntrinsics(InIntrinsics))
+	, RequestedStep(0)
+{
+	FCoefficients& C = Coefficients;
+	C.Fx = Intrinsics.Fx;
+	C.Fy = Intrinsics.Fy;
+	C.Cx = (float)Intrinsics.Cx;
+	C.Cy = (float)Intrinsics.Cy;
+
+	auto Coefficient = [this](int32 Index) { return Intrinsics.Distortion.IsValidIndex(Index) ? Intrinsics.Distortion[Index] : 0.0f; };
+	C.K1 = C.K2 = C.K3 = C.P1 = C.P2 = 0.0f;
+	C.bEquidistant = false;
+	C.W = C.TwoTanHalfW = 0.0f;
+	switch (Intrinsics.CalibrationType)
+	{
+	case ETangoCalibrationType::EQUIDISTANT:
+		C.W = Coefficient(0);
+		C.TwoTanHalfW = 2.0f * FMath::Tan(C.W * 0.5f);
+		C.bEquidistant = C.W != 0.0f;
+		break;
+	case ETangoCalibrationType::POLYNOMIAL_2_PARAMETERS:
+		C.K1 = Coefficient(0);
+		C.K2 = Coefficient(1);
+		break;
+	case ETangoCalibrationType::POLYNOMIAL_5_PARAMETERS:
+		//k1, k2, p1, p2, k3
+		C.K1 = Coefficient(0);
+		C.K2 = Coefficient(1);
+		C.P1 = Coefficient(2);
+		C.P2 = Coefficient(3);
+		C.K3 = Coefficient(4);
+		break;
+	default:
+		//Same as the camera materials, which always use three radial coefficients
+		C.K1 = Coefficient(0);
+		C.K2 = Coefficient(1);
+		C.K3 = Coefficient(2);
+		break;
+	}
+}
+
+void TangoLensModel::Distort(const FVector2D* In, FVector2D* Out, int32 Count, EKernels Kernels) const
+{
+	const int32 Done = Coefficients.bEquidistant || Kernels == EKernels::Scalar ? 0 : DistortSIMD(Coefficients, In, Out, Count);
+	for (int32 i = Done; i < Count; ++i)
+	{
+		DistortScalar(Coefficients, In[i].X, In[i].Y, Out[i].X, Out[i].Y);
+	}
+}
+
+void TangoLensModel::Undistort(const FVector2D* In, FVector2D* Out, int32 Count, EKernels Kernels) const
+{
+	const int32 Done = Coefficients.bEquidistant || Kernels == EKernels::Scalar ? 0 : UndistortSIMD(Coefficients, In, Out, Count);
+	for (int32 i = Done; i < Count; ++i)
+	{
+		UndistortScalar(Coefficients, In[i].X, In[i].Y, Out[i].X, Out[i].Y);
+	}
+}
+
+void TangoLensModel::Project(const FVector* Points, FVector2D* OutPixels, int32 Count, const FMatrix* Transform, EKernels Kernels) const
+{
+	const FMatrix& M = Transform != nullptr ? *Transform : FMatrix::Identity;
+	const int32 Done = Coefficients.bEquidistant || Kernels == EKernels::Scalar ? 0 : ProjectSIMD(Coefficients, M, Points, OutPixels, Count);
+	for (int32 i = Done; i < Count; ++i)
+	{
+		OutPixels[i] = ProjectScalar(Coefficients, M, Points[i]);
+	}
+}
+
+void TangoLensModel::Unproject(const FVector2D* Pixels, FVector* OutRays, int32 Count) const
+{
+	const FTangoLensLookupTablesPtr CurrentTables = GetLookupTables();
+	FVector2D Normalized[ChunkSize];
+	for (int32 Begin = 0; Begin < Count; Begin += ChunkSize)
+	{
+		const int32 ChunkCount = FMath::Min(ChunkSize, Count - Begin);
+		const FVector2D* ChunkPixels = Pixels + Begin;
+		for (int32 i = 0; i < ChunkCount; ++i)
+		{
+			Normalized[i] = FVector2D((ChunkPixels[i].X - Coefficients.Cx) / Coefficients.Fx, (ChunkPixels[i].Y - Coefficients.Cy) / Coefficients.Fy);
+		}
+		if (CurrentTables.IsValid())
+		{
+			for (int32 i = 0; i < ChunkCount; ++i)
+			{
+				FVector2D Undistorted;
+				if (!CurrentTables->Sample(CurrentTables->UndistortionMap, ChunkPixels[i].X, ChunkPixels[i].Y, Undistorted))
+				{
+					UndistortScalar(Coefficients, Normalized[i].X, Normalized[i].Y, Undistorted.X, Undistorted.Y);
+				}
+				OutRays[Begin + i] = FVector(Undistorted.X, Undistorted.Y, 1.0f);
+			}
+			continue;
+		}
+		Undistort(Normalized, Normalized, ChunkCount);
+		for (int32 i = 0; i < ChunkCount; ++i)
+		{
+			OutRays[Begin + i] = FVector(Normalized[i].X, Normalized[i].Y, 1.0f);
+		}
+	}
+}
+
+FTangoLensLookupTablesPtr TangoLensModel::GetLookupTables() const
+{
+	FScopeLock ScopeLock(&TablesLock);
+	return Tables;
+}
+
+void TangoLensModel::RequestLookupTables(int32 Step)
+{
+	Step = FMath::Max(Step, 1);
+	if (!IsValid())
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoLensModel::RequestLookupTables: No valid intrinsics, can't build lookup tables"));
+		return;
+	}
+	{
+		FScopeLock ScopeLock(&TablesLock);
+		if (RequestedStep == Step)
+		{
+			return;
+		}
+		RequestedStep = Step;
+	}
+	TSharedRef<TangoLensModel, ESPMode::ThreadSafe> KeepAlive = AsShared();
+	Async<void>(EAsyncExecution::ThreadPool, [KeepAlive, Step]()
+	{
+		KeepAlive->BuildLookupTables(Step);
+	});
+}
+
+void TangoLensModel::BuildLookupTables(int32 Step)
+{
+	TSharedPtr<FTangoLensLookupTables, ESPMode::ThreadSafe> NewTables = MakeShareable(new FTangoLensLookupTables());
+	if (!LoadLookupTables(Step, *NewTables))
+	{
+		const double Start = FPlatformTime::Seconds();
+		FTangoLensLookupTables& T = *NewTables;
+		T.Step = Step;
+		//One node past the last pixel, so every pixel has a full cell to interpolate in.
+		T.GridWidth = (Intrinsics.Width - 1) / Step + 2;
+		T.GridHeight = (Intrinsics.Height - 1) / Step + 2;
+		T.DistortionMap.SetNumUninitialized(T.GridWidth * T.GridHeight);
+		T.UndistortionMap.SetNumUninitialized(T.GridWidth * T.GridHeight);
+		const FCoefficients& C = Coefficients;
+		ParallelFor(T.GridHeight, [&](int32 GridY)
+		{
+			FVector2D* DistortionRow = T.DistortionMap.GetData() + GridY * T.GridWidth;
+			FVector2D* UndistortionRow = T.UndistortionMap.GetData() + GridY * T.GridWidth;
+			const float Yn = (GridY * Step - C.Cy) / C.Fy;
+			for (int32 GridX = 0; GridX < T.GridWidth; ++GridX)
+			{
+				DistortionRow[GridX] = FVector2D((GridX * Step - C.Cx) / C.Fx, Yn);
+			}
+			Distort(DistortionRow, DistortionRow, T.GridWidth);
+			for (int32 GridX = 0; GridX < T.GridWidth; ++GridX)
+			{
+				UndistortionRow[GridX] = FVector2D((GridX * Step - C.Cx) / C.Fx, Yn);
+				DistortionRow[GridX] = FVector2D(C.Fx * DistortionRow[GridX].X + C.Cx, C.Fy * DistortionRow[GridX].Y + C.Cy);
+			}
+			Undistort(UndistortionRow, UndistortionRow, T.GridWidth);
+		});
+		UE_LOG(TangoPlugin, Log, TEXT("TangoLensModel::BuildLookupTables: Built %dx%d lookup tables for %08x in %.1f ms"),
+			T.GridWidth, T.GridHeight, Hash, (FPlatformTime::Seconds() - Start) * 1000.0);
+		SaveLookupTables(T);
+	}
+
+	FScopeLock ScopeLock(&TablesLock);
+	//A newer request with a different step may have finished first.
+	if (RequestedStep == Step)
+	{
+		Tables = NewTables;
+	}
+}
+
+FString TangoLensModel::GetCacheFilePath(int32 Step) const
+{
+	return FPaths::Combine(*FPaths::GameSavedDir(), TEXT("Tango"), *FString::Printf(TEXT("Lens_%08x_%d.bin"), Hash, Step));
+}
+
+bool TangoLensModel::LoadLookupTables(int32 Step, FTangoLensLookupTables& Result) const
+{
+	const FString Path = GetCacheFilePath(Step);
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Path));
+	if (!Reader.IsValid())
+	{
+		return false;
+	}
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*Reader << Magic;
+	*Reader << Version;
+	if (Magic != LensCacheMagic || Version != LensCacheVersion)
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoLensModel::LoadLookupTables: Ignoring outdated cache file %s"), *Path);
+		return false;
+	}
+	FTangoCameraIntrinsics StoredCalibration;
+	SerializeCalibration(*Reader, StoredCalibration);
+	if (Reader->IsError() || !IsSameCalibration(StoredCalibration, Intrinsics))
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoLensModel::LoadLookupTables: Cache file %s was built for a different calibration"), *Path);
+		return false;
+	}
+	FTangoLensLookupTables Loaded;
+	*Reader << Loaded.Step;
+	*Reader << Loaded.GridWidth;
+	*Reader << Loaded.GridHeight;
+	*Reader << Loaded.DistortionMap;
+	*Reader << Loaded.UndistortionMap;
+	const int32 NumNodes = Loaded.GridWidth * Loaded.GridHeight;
+	if (Reader->IsError() || Loaded.Step != Step || Loaded.DistortionMap.Num() != NumNodes || Loaded.UndistortionMap.Num() != NumNodes)
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoLensModel::LoadLookupTables: Cache file %s is corrupt"), *Path);
+		return false;
+	}
+	Result = MoveTemp(Loaded);
+	UE_LOG(TangoPlugin, Log, TEXT("TangoLensModel::LoadLookupTables: Loaded lookup tables from %s"), *Path);
+	return true;
+}
+
+void TangoLensModel::SaveLookupTables(const FTangoLensLookupTables& ToSave) const
+{
+	const FString Path = GetCacheFilePath(ToSave.Step);
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Path));
+	if (!Writer.IsValid())
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoLensModel::SaveLookupTables: Unable to open %s for writing"), *Path);
+		return;
+	}
+	FTangoLensLookupTables Copy = ToSave;
+	uint32 Magic = LensCacheMagic;
+	uint32 Version = LensCacheVersion;
+	FTangoCameraIntrinsics StoredCalibration = Intrinsics;
+	*Writer << Magic;
+	*Writer << Version;
+	SerializeCalibration(*Writer, StoredCalibration);
+	*Writer << Copy.Step;
+	*Writer << Copy.GridWidth;
+	*Writer << Copy.GridHeight;
+	*Writer << Copy.DistortionMap;
+	*Writer << Copy.UndistortionMap;
+	Writer->Close();
+}
+
+/*
+ * Tango.BenchmarkLensModel [Points] [Iterations] [Step]
+ * Times the batch functions with typical color camera intrinsics and reports how far a distort/undistort round trip is off.
+ */
+namespace
+{
+	void BenchmarkLensModel(const TArray<FString>& Args)
+	{
+		const int32 NumPoints = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 4) : 60000;
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 50;
+		const int32 Step = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 4;
+
+		FTangoCameraIntrinsics Intrinsics;
+		Intrinsics.CalibrationType = ETangoCalibrationType::POLYNOMIAL_3_PARAMETERS;
+		Intrinsics.CameraID = ETangoCameraType::COLOR;
+		Intrinsics.Width = 1280;
+		Intrinsics.Height = 720;
+		Intrinsics.Fx = Intrinsics.Fy = 1040.0f;
+		Intrinsics.Cx = 640;
+		Intrinsics.Cy = 360;
+		Intrinsics.Distortion.Init(0.0f, 5);
+		Intrinsics.Distortion[0] = 0.22f;
+		Intrinsics.Distortion[1] = -0.51f;
+		Intrinsics.Distortion[2] = 0.43f;
+		//Not shared, so the lookup tables are built fresh
+		TSharedRef<TangoLensModel, ESPMode::ThreadSafe> Model = MakeShareable(new TangoLensModel(Intrinsics));
+
+		FRandomStream Random(1234);
+		TArray<FVector> Points;
+		TArray<FVector2D> Normalized;
+		Points.SetNumUninitialized(NumPoints);
+		Normalized.SetNumUninitialized(NumPoints);
+		for (int32 i = 0; i < NumPoints; ++i)
+		{
+			const float Z = Random.FRandRange(0.5f, 4.0f);
+			Normalized[i] = FVector2D(Random.FRandRange(-0.6f, 0.6f), Random.FRandRange(-0.34f, 0.34f));
+			Points[i] = FVector(Normalized[i].X * Z, Normalized[i].Y * Z, Z);
+		}
+		TArray<FVector2D> Distorted;
+		TArray<FVector2D> Undistorted;
+		TArray<FVector2D> Pixels;
+		TArray<FVector> Rays;
+		Distorted.SetNumUninitialized(NumPoints);
+		Undistorted.SetNumUninitialized(NumPoints);
+		Pixels.SetNumUninitialized(NumPoints);
+		Rays.SetNumUninitialized(NumPoints);
+
+		auto Time = [Iterations, NumPoints](const TFunction<void()>& Function)
+		{
+			const double Start = FPlatformTime::Seconds();
+			for (int32 i = 0; i < Iterations; ++i)
+			{
+				Function();
+			}
+			return (FPlatformTime::Seconds() - Start) * 1e9 / ((double)Iterations * NumPoints);
+		};
+
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkLensModel: %d points, %d iterations, ns/point"), NumPoints, Iterations);
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			const TangoLensModel::EKernels Kernels = Pass == 0 ? TangoLensModel::EKernels::Scalar : TangoLensModel::EKernels::Vectorized;
+			const double DistortTime = Time([&]() { Model->Distort(Normalized.GetData(), Distorted.GetData(), NumPoints, Kernels); });
+			const double UndistortTime = Time([&]() { Model->Undistort(Distorted.GetData(), Undistorted.GetData(), NumPoints, Kernels); });
+			const double ProjectTime = Time([&]() { Model->Project(Points.GetData(), Pixels.GetData(), NumPoints, nullptr, Kernels); });
+			const double UnprojectTime = Time([&]() { Model->Unproject(Pixels.GetData(), Rays.GetData(), NumPoints); });
+			UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkLensModel: %-6s distort %6.2f, undistort %6.2f, project %6.2f, unproject %6.2f"),
+				Pass == 0 ? TEXT("Scalar") : TangoImageConversion::GetKernelName(), DistortTime, UndistortTime, ProjectTime, UnprojectTime);
+		}
+
+		float MaxError = 0.0f;
+		for (int32 i = 0; i < NumPoints; ++i)
+		{
+			MaxError = FMath::Max(MaxError, (Undistorted[i] - Normalized[i]).GetAbsMax() * Intrinsics.Fx);
+		}
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkLensModel: distort/undistort round trip off by up to %.4f pixels"), MaxError);
+
+		const double BuildStart = FPlatformTime::Seconds();
+		Model->RequestLookupTables(Step);
+		while (!Model->GetLookupTables().IsValid())
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+		const double BuildTime = FPlatformTime::Seconds() - BuildStart;
+		const double LookupTime = Time([&]() { Model->Unproject(Pixels.GetData(), Rays.GetData(), NumPoints); });
+		MaxError = 0.0f;
+		for (int32 i = 0; i < NumPoints; ++i)
+		{
+			MaxError = FMath::Max(MaxError, FVector2D(Rays[i].X - Normalized[i].X, Rays[i].Y - Normalized[i].Y).GetAbsMax() * Intrinsics.Fx);
+		}
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkLensModel: step %d lookup tables ready after %.1f ms, unproject %6.2f ns/point, off by up to %.4f pixels"),
+			Step, BuildTime * 1000.0, LookupTime, MaxError);
+	}
+
+	static FAutoConsoleCommand BenchmarkLensModelCommand(
+		TEXT("Tango.BenchmarkLensModel"),
+		TEXT("Times the lens model batch functions and lookup tables. Arguments: [Points] [Iterations] [Step]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkLensModel));
+}
@@ -0,0 +1,98 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoDataTypes.h"
+#include "TangoImageConversion.h"
+
+/*
+ * Lookup tables of a lens model, sampled every Step pixels. Both maps share the same grid of GridWidth * GridHeight nodes.
+ */
+struct FTangoLensLookupTables
+{
+	int32 Step;
+	int32 GridWidth;
+	int32 GridHeight;
+	//Undistorted pixel to the distorted pixel it shows up at, for remapping a camera image into a pinhole image.
+	TArray<FVector2D> DistortionMap;
+	//Distorted pixel to undistorted normalized image coordinates (X / Z, Y / Z)
+	TArray<FVector2D> UndistortionMap;
+
+	//Bilinear lookup at a pixel position. Returns false outside the image.
+	bool Sample(const TArray<FVector2D>& Map, float U, float V, FVector2D& Out) const;
+};
+
+typedef TSharedPtr<const FTangoLensLookupTables, ESPMode::ThreadSafe> FTangoLensLookupTablesPtr;
+
+/*
+ * The camera model of FTangoCameraIntrinsics: pinhole projection followed by the polynomial or equidistant lens distortion.
+ * Camera space is the one of the Tango cameras: X right, Y down, Z forward, in meters. Pixel centers are at integer coordinates.
+ * Batch functions use NEON or SSE2 for the polynomial models and run on the calling thread.
+ */
+class TangoLensModel : public TSharedFromThis<TangoLensModel, ESPMode::ThreadSafe>
+{
+public:
+	//Shared model for these intrinsics, so their lookup tables are only built once.
+	static TSharedRef<TangoLensModel, ESPMode::ThreadSafe> Get(const FTangoCameraIntrinsics& Intrinsics);
+	//Identifies the calibration, also used to name the cache files of the lookup tables.
+	static uint32 HashIntrinsics(const FTangoCameraIntrinsics& Intrinsics);
+
+	TangoLensModel(const FTangoCameraIntrinsics& InIntrinsics);
+
+	const FTangoCameraIntrinsics& GetIntrinsics() const { return Intrinsics; }
+	uint32 GetHash() const { return Hash; }
+	bool IsValid() const { return Intrinsics.Width > 0 && Intrinsics.Height > 0 && Intrinsics.Fx != 0.0f && Intrinsics.Fy != 0.0f; }
+
+	typedef TangoImageConversion::EKernels EKernels;
+
+	//Normalized image coordinates, undistorted to distorted
+	void Distort(const FVector2D* In, FVector2D* Out, int32 Count, EKernels Kernels = EKernels::Vectorized) const;
+	//Normalized image coordinates, distorted to undistorted. Solved iteratively for the polynomial models.
+	void Undistort(const FVector2D* In, FVector2D* Out, int32 Count, EKernels Kernels = EKernels::Vectorized) const;
+	//Camera space points to distorted pixels, optionally transformed into camera space first. Points behind the camera become InvalidPixel.
+	void Project(const FVector* Points, FVector2D* OutPixels, int32 Count, const FMatrix* Transform = nullptr, EKernels Kernels = EKernels::Vectorized) const;
+	//Distorted pixels to camera space rays with Z = 1. Uses the undistortion map if it was built.
+	void Unproject(const FVector2D* Pixels, FVector* OutRays, int32 Count) const;
+
+	static const FVector2D InvalidPixel;
+
+	//Loads the lookup tables for this Step from disk or builds them, on a worker thread. Does nothing if they exist or are on their way.
+	void RequestLookupTables(int32 Step);
+	//The tables of the last finished request, or nullptr.
+	FTangoLensLookupTablesPtr GetLookupTables() const;
+
+private:
+	//Coefficients in the form the kernels want them
+	struct FCoefficients
+	{
+		float Fx, Fy, Cx, Cy;
+		float K1, K2, K3, P1, P2;
+		bool bEquidistant;
+		float W, TwoTanHalfW;
+	};
+
+	void BuildLookupTables(int32 Step);
+	FString GetCacheFilePath(int32 Step) const;
+	bool LoadLookupTables(int32 Step, FTangoLensLookupTables& Tables) const;
+	void SaveLookupTables(const FTangoLensLookupTables& Tables) const;
+
+	const FTangoCameraIntrinsics Intrinsics;
+	const uint32 Hash;
+	FCoefficients Coefficients;
+
+	mutable FCriticalSection TablesLock;
+	FTangoLensLookupTablesPtr Tables;
+	int32 RequestedStep;
+};
@@ -32,14 +32,55 @@ void UTangoMotionComponent::InitializeComponent()
 	Super::InitializeComponent();
 }
 
+//The view extension walks the components below this one again with the next frame.
+void UTangoMotionComponent::OnRegister()
+{
+	Super::OnRegister();
+	if (ViewExtension.IsValid())
+	{
+		ViewExtension->InvalidateHierarchyCache();
+	}
+}
+
+void UTangoMotionComponent::OnUnregister()
+{
+	if (ViewExtension.IsValid())
+	{
+		ViewExtension->InvalidateHierarchyCache();
+	}
+	Super::OnUnregister();
+}
+
+void UTangoMotionComponent::OnChildAttached(USceneComponent* ChildComponent)
+{
+	Super::OnChildAttached(ChildComponent);
+	if (ViewExtension.IsValid())
+	{
+		ViewExtension->InvalidateHierarchyCache();
+	}
+}
+
+void UTangoMotionComponent::OnChildDetached(USceneComponent* ChildComponent)
+{
+	Super::OnChildDetached(ChildComponent);
+	if (ViewExtension.IsValid())
+	{
+		ViewExtension->InvalidateHierarchyCache();
+	}
+}
+
 void UTangoMotionComponent::BeginDestroy()
 {
+	if (PoseEventSubscription.IsValid())
+	{
+		UTangoDevice::Get().RemoveTangoMotionComponent(PoseEventSubscription);
+	}
 	Super::BeginDestroy();
 }
 
 void UTangoMotionComponent::SetupPoseEvents(TArray<FTangoCoordinateFramePair> FramePairs)
 {
-	UTangoDevice::Get().AddTangoMotionComponent(this, FramePairs);
+	UTangoDevice::Get().AddTangoMotionComponent(this, FramePairs, MaxPoseEventRate, PoseEventSubscription);
 }
 
 FTangoPoseData UTangoMotionComponent::GetTangoPoseAtTime(FTangoCoordinateFramePair FrameOfReference, float Timestamp)
@@ -108,15 +149,6 @@ void UTangoMotionComponent::TickComponent(float DeltaTime, enum ELevelTick TickT
 	}
 }
 
-FTangoPoseData UTangoMotionComponent::GetCurrentPoseRENDERTHREAD(float TimeStamp)
-{
-	if (UTangoDevice::Get().GetTangoDeviceMotionPointer() == nullptr)
-	{
-		return FTangoPoseData();
-	}
-	return UTangoDevice::Get().GetTangoDeviceMotionPointer()->GetPoseAtTime(MotionComponentFrameOfReference, 0);
-}
-
 AActor * UTangoMotionComponent::GetActor()
 {
 	return GetOwner();
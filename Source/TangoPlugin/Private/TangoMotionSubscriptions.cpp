@@ -0,0 +1,233 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoMotionSubscriptions.h"
+#include "TangoMotionComponent.h"
+
+TangoMotionSubscriptionRegistry::TangoMotionSubscriptionRegistry()
+	: NumSubscribers(0)
+	, bQueriedPairsChanged(false)
+	, bIsDirty(false)
+	, bHasUnresolvedRequests(false)
+	, ExtrinsicsGeneration(-1)
+{
+}
+
+bool TangoMotionSubscriptionRegistry::IsHandleValid(const FTangoSubscriptionHandle& Handle) const
+{
+	return Handle.IsValid() && Slots.IsValidIndex(Handle.Index) && Slots[Handle.Index].bInUse && Slots[Handle.Index].Generation == Handle.Generation;
+}
+
+FTangoSubscriptionHandle TangoMotionSubscriptionRegistry::Subscribe(UTangoMotionComponent* Component, const TArray<FTangoCoordinateFramePair>& Requests, float MaxDeliveryRate)
+{
+	int32 Index;
+	if (FreeSlots.Num() > 0)
+	{
+		Index = FreeSlots.Pop(false);
+	}
+	else
+	{
+		Index = Slots.AddDefaulted();
+	}
+	FSubscriberSlot& Slot = Slots[Index];
+	Slot.Component = Component;
+	Slot.Requests = Requests;
+	Slot.MinDeliveryInterval = MaxDeliveryRate > 0.0f ? 1.0 / MaxDeliveryRate : 0.0;
+	Slot.bInUse = true;
+	NumSubscribers++;
+	bIsDirty = true;
+
+	FTangoSubscriptionHandle Handle;
+	Handle.Index = Index;
+	Handle.Generation = Slot.Generation;
+	return Handle;
+}
+
+bool TangoMotionSubscriptionRegistry::Update(const FTangoSubscriptionHandle& Handle, const TArray<FTangoCoordinateFramePair>& Requests, float MaxDeliveryRate)
+{
+	if (!IsHandleValid(Handle))
+	{
+		return false;
+	}
+	FSubscriberSlot& Slot = Slots[Handle.Index];
+	Slot.Requests = Requests;
+	Slot.MinDeliveryInterval = MaxDeliveryRate > 0.0f ? 1.0 / MaxDeliveryRate : 0.0;
+	bIsDirty = true;
+	return true;
+}
+
+void TangoMotionSubscriptionRegistry::Unsubscribe(FTangoSubscriptionHandle& Handle)
+{
+	if (IsHandleValid(Handle))
+	{
+		FSubscriberSlot& Slot = Slots[Handle.Index];
+		Slot.Component.Reset();
+		Slot.Requests.Empty();
+		Slot.bInUse = false;
+		Slot.Generation++;
+		FreeSlots.Push(Handle.Index);
+		NumSubscribers--;
+		bIsDirty = true;
+	}
+	Handle.Invalidate();
+}
+
+bool TangoMotionSubscriptionRegistry::ConsumeQueriedPairsChanged()
+{
+	bool bChanged = bQueriedPairsChanged;
+	bQueriedPairsChanged = false;
+	return bChanged;
+}
+
+void TangoMotionSubscriptionRegistry::GetQueriedPairs(TArray<FTangoCoordinateFramePair>& OutPairs) const
+{
+	QueriedPairReferences.GenerateKeyArray(OutPairs);
+}
+
+void TangoMotionSubscriptionRegistry::RebuildIfDirty()
+{
+	//Requests can only be resolved once the extrinsics are known, keep asking for them while some wait.
+	//When they arrive the generation changes.
+	if (bHasUnresolvedRequests)
+	{
+		TangoSpaceConversions::AreExtrinsicsAvailable();
+	}
+	const int32 Generation = TangoSpaceConversions::GetExtrinsicsGeneration();
+	if (Generation != ExtrinsicsGeneration)
+	{
+		ExtrinsicsGeneration = Generation;
+		bIsDirty = true;
+	}
+	if (!bIsDirty)
+	{
+		return;
+	}
+	bIsDirty = false;
+	bHasUnresolvedRequests = false;
+	const bool bExtrinsicsAvailable = TangoSpaceConversions::AreExtrinsicsAvailable();
+
+	for (FSubscriberSlot& Slot : Slots)
+	{
+		Slot.LastDeliveryTimestamps.Reset();
+	}
+	for (const FBroadcastGroup& Group : Groups)
+	{
+		for (int32 t = Group.FirstTarget; t < Group.FirstTarget + Group.NumTargets; ++t)
+		{
+			const FBroadcastTarget& Target = Targets[t];
+			FSubscriberSlot& Slot = Slots[Target.Slot];
+			if (Slot.bInUse && Slot.Generation == Target.SlotGeneration)
+			{
+				Slot.LastDeliveryTimestamps.Add(Group.RequestedSpace.Pair, Target.LastDeliveryTimestamp);
+			}
+		}
+	}
+	Groups.Reset();
+	Targets.Reset();
+	TMap<FTangoCoordinateFramePair, int32> NewQueriedPairReferences;
+
+	//Gather (group, slot) tuples first, then lay the targets out contiguously per group.
+	TMap<FTangoCoordinateFramePair, int32> GroupOfRequest;
+	TArray<TArray<int32>> SlotsOfGroup;
+	for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+	{
+		const FSubscriberSlot& Slot = Slots[SlotIndex];
+		if (!Slot.bInUse)
+		{
+			continue;
+		}
+		for (const FTangoCoordinateFramePair& Request : Slot.Requests)
+		{
+			int32* GroupIndex = GroupOfRequest.Find(Request);
+			if (GroupIndex == nullptr)
+			{
+				FBroadcastGroup Group;
+				//We cannot request any pair so we have to look stuff up
+				if (!TangoSpaceConversions::GetSpaceConversionPair(Group.RequestedSpace, Request))
+				{
+					//Pairs without any conversion stay unresolved for good, the others only until the extrinsics are known
+					bHasUnresolvedRequests = bHasUnresolvedRequests || !bExtrinsicsAvailable;
+					continue;
+				}
+				if (Group.RequestedSpace.bIsStatic)//Ignore static ones
+				{
+					continue;
+				}
+				Group.QueriedPair = Group.RequestedSpace.bNeedToBeQueriedFromDevice ? FTangoCoordinateFramePair(Request.BaseFrame, ETangoCoordinateFrameType::DEVICE) : Request;
+				Group.FirstTarget = 0;
+				Group.NumTargets = 0;
+				GroupIndex = &GroupOfRequest.Add(Request, Groups.Add(Group));
+				SlotsOfGroup.AddDefaulted();
+			}
+			SlotsOfGroup[*GroupIndex].AddUnique(SlotIndex);
+			NewQueriedPairReferences.FindOrAdd(Groups[*GroupIndex].QueriedPair)++;
+		}
+	}
+	for (int32 GroupIndex = 0; GroupIndex < Groups.Num(); ++GroupIndex)
+	{
+		Groups[GroupIndex].FirstTarget = Targets.Num();
+		Groups[GroupIndex].NumTargets = SlotsOfGroup[GroupIndex].Num();
+		for (int32 SlotIndex : SlotsOfGroup[GroupIndex])
+		{
+			const FSubscriberSlot& Slot = Slots[SlotIndex];
+			const double* LastDeliveryTimestamp = Slot.LastDeliveryTimestamps.Find(Groups[GroupIndex].RequestedSpace.Pair);
+			FBroadcastTarget Target;
+			Target.Slot = SlotIndex;
+			Target.SlotGeneration = Slot.Generation;
+			Target.LastDeliveryTimestamp = LastDeliveryTimestamp != nullptr ? *LastDeliveryTimestamp : -DBL_MAX;
+			Targets.Add(Target);
+		}
+	}
+
+	//Receiving a pair nobody listens to is harmless, so only new pairs force a reconnect.
+	for (const auto& Elem : NewQueriedPairReferences)
+	{
+		if (!QueriedPairReferences.Contains(Elem.Key))
+		{
+			bQueriedPairsChanged = true;
+			break;
+		}
+	}
+	QueriedPairReferences = MoveTemp(NewQueriedPairReferences);
+}
+
+void TangoMotionSubscriptionRegistry::Broadcast(const FTangoCoordinateFramePair& QueriedPair, const FTangoPoseData& Pose)
+{
+	const double Timestamp = Pose.PreciseTimestamp;
+	for (const FBroadcastGroup& Group : Groups)
+	{
+		if (!(Group.QueriedPair == QueriedPair))
+		{
+			continue;
+		}
+		FTangoPoseData ConvertedPose = Pose;
+		TangoSpaceConversions::ModifyPose(ConvertedPose, Group.RequestedSpace);
+		for (int32 t = Group.FirstTarget; t < Group.FirstTarget + Group.NumTargets; ++t)
+		{
+			FBroadcastTarget& Target = Targets[t];
+			const FSubscriberSlot& Slot = Slots[Target.Slot];
+			if (Slot.MinDeliveryInterval > 0.0 && Timestamp - Target.LastDeliveryTimestamp < Slot.MinDeliveryInterval)
+			{
+				continue;
+			}
+			UTangoMotionComponent* Component = Slot.Component.Get();
+			if (Component != nullptr)
+			{
+				Target.LastDeliveryTimestamp = Timestamp;
+				Component->OnTangoPoseAvailable.Broadcast(ConvertedPose, Group.RequestedSpace.Pair);
+			}
+		}
+	}
+}
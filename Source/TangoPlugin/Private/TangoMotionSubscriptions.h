@@ -0,0 +1,98 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoDataTypes.h"
+#include "TangoCoordinateConversions.h"
+
+class UTangoMotionComponent;
+
+/*
+ * Keeps track of which motion components want which pose events.
+ * Subscribers live in slots addressed by stable handles, so adding or removing one never shifts the others.
+ * The broadcast list is a flat array that is only rebuilt (at most once per tick) when subscriptions changed.
+ * Requests are stored as they were made and only resolved by the rebuild, since that needs the extrinsics which may not be known yet.
+ */
+class TangoMotionSubscriptionRegistry
+{
+public:
+	TangoMotionSubscriptionRegistry();
+
+	//Adds a subscriber. MaxDeliveryRate is in Hz, 0 means unlimited.
+	FTangoSubscriptionHandle Subscribe(UTangoMotionComponent* Component, const TArray<FTangoCoordinateFramePair>& Requests, float MaxDeliveryRate);
+	bool Update(const FTangoSubscriptionHandle& Handle, const TArray<FTangoCoordinateFramePair>& Requests, float MaxDeliveryRate);
+	void Unsubscribe(FTangoSubscriptionHandle& Handle);
+
+	int32 Num() const { return NumSubscribers; }
+
+	//True when the set of frame pairs that have to be requested from the service changed since the last call.
+	bool ConsumeQueriedPairsChanged();
+	void GetQueriedPairs(TArray<FTangoCoordinateFramePair>& OutPairs) const;
+
+	//Rebuilds the broadcast list and the queried pairs if subscriptions or the extrinsics changed since the last rebuild,
+	//or if some requests could not be resolved yet.
+	void RebuildIfDirty();
+	//Resolves every request again on the next rebuild, e.g. after connecting.
+	void MarkDirty() { bIsDirty = true; }
+
+	//Delivers a pose received for QueriedPair to every subscriber of a frame pair derived from it.
+	void Broadcast(const FTangoCoordinateFramePair& QueriedPair, const FTangoPoseData& Pose);
+
+private:
+	struct FSubscriberSlot
+	{
+		TWeakObjectPtr<UTangoMotionComponent> Component;
+		TArray<FTangoCoordinateFramePair> Requests;
+		double MinDeliveryInterval = 0.0;
+		//Per requested pair, carried over from the old broadcast list so a rebuild does not reset the rate limit
+		TMap<FTangoCoordinateFramePair, double> LastDeliveryTimestamps;
+		uint32 Generation = 0;
+		bool bInUse = false;
+	};
+
+	//One entry per subscriber and requested pair, grouped by the pair so a pose is only converted once per group.
+	struct FBroadcastTarget
+	{
+		int32 Slot;
+		//Of the slot when the target was built, the slot may have been reused since
+		uint32 SlotGeneration;
+		double LastDeliveryTimestamp;
+	};
+	struct FBroadcastGroup
+	{
+		FTangoCoordinateFramePair QueriedPair;
+		TangoSpaceConversions::TangoSpaceConversionPair RequestedSpace;
+		int32 FirstTarget;
+		int32 NumTargets;
+	};
+
+	bool IsHandleValid(const FTangoSubscriptionHandle& Handle) const;
+
+	TArray<FSubscriberSlot> Slots;
+	TArray<int32> FreeSlots;
+	int32 NumSubscribers;
+
+	//How many subscriber requests need each pair from the service, as of the last rebuild
+	TMap<FTangoCoordinateFramePair, int32> QueriedPairReferences;
+	bool bQueriedPairsChanged;
+
+	TArray<FBroadcastGroup> Groups;
+	TArray<FBroadcastTarget> Targets;
+	bool bIsDirty;
+	//Some requests had no conversion at the last rebuild, they are retried until the extrinsics are known
+	bool bHasUnresolvedRequests;
+	//Of the conversions the groups were resolved with
+	int32 ExtrinsicsGeneration;
+};
@@ -0,0 +1,239 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoOfflineStages.h"
+#include "TangoFromToCObject.h"
+#include "TangoCoordinateConversions.h"
+#include "TangoImageConversion.h"
+#include "TangoPointColorizer.h"
+
+using namespace TangoSessionFormat;
+
+namespace
+{
+	//Depth camera meters to Unreal space, as TangoDevicePointCloud does it every tick
+	class PointConversionStage : public ITangoOfflineStage
+	{
+	public:
+		virtual int64 Process(const FTangoSessionRecord& Record, FTangoOfflineContext& Context) override
+		{
+			const float* XYZ = nullptr;
+			const uint32* IJ = nullptr;
+			const FDepthPayload* Depth = Record.GetDepth(XYZ, IJ);
+			if (Depth == nullptr)
+			{
+				return -1;
+			}
+			const int32 Count = Depth->NumPoints;
+			const float Scale = Context.MetersToWorldScale;
+			Points.SetNumUninitialized(Count, false);
+			for (int32 i = 0; i < Count; ++i)
+			{
+				const float* Point = XYZ + i * 3;
+				Points[i] = FVector(Point[2] * Scale, Point[0] * Scale, -Point[1] * Scale);
+			}
+			return Count;
+		}
+
+	private:
+		TArray<FVector> Points;
+	};
+
+	//Service poses to Unreal space, as UTangoDeviceMotion does it for every callback
+	class PoseConversionStage : public ITangoOfflineStage
+	{
+	public:
+		virtual int64 Process(const FTangoSessionRecord& Record, FTangoOfflineContext& Context) override
+		{
+			const FPosePayload* Payload = Record.GetPose();
+			if (Payload == nullptr)
+			{
+				return -1;
+			}
+			FTangoBackendPose BackendPose;
+			BackendPose.Timestamp = Record.Timestamp;
+			BackendPose.BaseFrame = Payload->BaseFrame;
+			BackendPose.TargetFrame = Payload->TargetFrame;
+			BackendPose.StatusCode = Payload->StatusCode;
+			FMemory::Memcpy(BackendPose.Translation, Payload->Translation, sizeof(BackendPose.Translation));
+			FMemory::Memcpy(BackendPose.Orientation, Payload->Orientation, sizeof(BackendPose.Orientation));
+			FTangoPoseData Pose = FromBackendObject(BackendPose);
+
+			//The conversions are behind a lock, every thread keeps the few pairs of a session to itself
+			TangoSpaceConversions::TangoSpaceConversionPair* Converter = Converters.Find(Pose.FrameOfReference);
+			if (Converter == nullptr)
+			{
+				TangoSpaceConversions::TangoSpaceConversionPair NewConverter;
+				if (!TangoSpaceConversions::GetSpaceConversionPair(NewConverter, Pose.FrameOfReference))
+				{
+					return 0;
+				}
+				Converter = &Converters.Add(Pose.FrameOfReference, NewConverter);
+			}
+			TangoSpaceConversions::ModifyPose(Pose, *Converter);
+			return 1;
+		}
+
+	private:
+		TMap<FTangoCoordinateFramePair, TangoSpaceConversions::TangoSpaceConversionPair> Converters;
+	};
+
+	//NV21 color frames to RGBA, what the frame conversions of the camera pool do on request
+	class ColorConversionStage : public ITangoOfflineStage
+	{
+	public:
+		virtual int64 Process(const FTangoSessionRecord& Record, FTangoOfflineContext& Context) override
+		{
+			const uint8* NV21 = nullptr;
+			const FColorFramePayload* Frame = Record.GetColorFrame(NV21);
+			if (Frame == nullptr)
+			{
+				return -1;
+			}
+			const int32 NumPixels = Frame->Width * Frame->Height;
+			RGBA.SetNumUninitialized(NumPixels * 4, false);
+			//Chunks already run in parallel
+			TangoImageConversion::NV21ToRGBA8(NV21, NV21 + NumPixels, Frame->Width, Frame->Height, RGBA.GetData(), false);
+			return NumPixels;
+		}
+
+	private:
+		TArray<uint8> RGBA;
+	};
+
+	//Colors every depth frame from the latest color frame before it
+	class ColorizationStage : public ITangoOfflineStage
+	{
+	public:
+		ColorizationStage()
+			: bHasTransform(false)
+		{
+			bHasTransform = TangoPointColorizer::GetDepthToColor(DepthToColor);
+		}
+
+		virtual int64 Process(const FTangoSessionRecord& Record, FTangoOfflineContext& Context) override
+		{
+			const float* XYZ = nullptr;
+			const uint32* IJ = nullptr;
+			const FDepthPayload* Depth = Record.GetDepth(XYZ, IJ);
+			if (Depth == nullptr)
+			{
+				return -1;
+			}
+			const FTangoCameraIntrinsics* Intrinsics = Context.FindIntrinsics(ETangoCameraType::COLOR);
+			if (!bHasTransform || Intrinsics == nullptr || Context.ColorNV21 == nullptr)
+			{
+				return 0;
+			}
+			if (Frame.Timestamp != Context.ColorTimestamp || Frame.Data.Num() == 0)
+			{
+				Frame.InvalidateConversions();
+				Frame.Width = Context.ColorWidth;
+				Frame.Height = Context.ColorHeight;
+				Frame.Timestamp = Context.ColorTimestamp;
+				Frame.Data.SetNumUninitialized(FTangoCameraFrame::GetNV21Size(Frame.Width, Frame.Height), false);
+				FMemory::Memcpy(Frame.Data.GetData(), Context.ColorNV21, Frame.Data.Num());
+			}
+			const int32 Count = Depth->NumPoints;
+			Colors.SetNumUninitialized(Count, false);
+			TangoPointColorizer::ColorizePoints(reinterpret_cast<const FVector*>(XYZ), Count, DepthToColor, *Intrinsics, Frame, Colors.GetData(), false);
+			return Count;
+		}
+
+	private:
+		FMatrix DepthToColor;
+		bool bHasTransform;
+		FTangoCameraFrame Frame;
+		TArray<FColor> Colors;
+	};
+
+	struct FStageRegistry
+	{
+		FCriticalSection Lock;
+		TArray<FString> Names;
+		TArray<FTangoOfflineStageFactory> Factories;
+
+		FStageRegistry()
+		{
+			Add(TEXT("PointConversion"), []() -> ITangoOfflineStage* { return new PointConversionStage(); });
+			Add(TEXT("PoseConversion"), []() -> ITangoOfflineStage* { return new PoseConversionStage(); });
+			Add(TEXT("ColorConversion"), []() -> ITangoOfflineStage* { return new ColorConversionStage(); });
+			Add(TEXT("Colorization"), []() -> ITangoOfflineStage* { return new ColorizationStage(); });
+		}
+
+		void Add(const FString& Name, const FTangoOfflineStageFactory& Factory)
+		{
+			FScopeLock ScopeLock(&Lock);
+			const int32 Existing = Names.Find(Name);
+			if (Existing != INDEX_NONE)
+			{
+				Factories[Existing] = Factory;
+				return;
+			}
+			Names.Add(Name);
+			Factories.Add(Factory);
+		}
+
+		static FStageRegistry& Get()
+		{
+			static FStageRegistry Registry;
+			return Registry;
+		}
+	};
+}
+
+const FTangoCameraIntrinsics* FTangoOfflineContext::FindIntrinsics(ETangoCameraType::Type Camera) const
+{
+	if (Intrinsics != nullptr)
+	{
+		for (const FTangoCameraIntrinsics& Candidate : *Intrinsics)
+		{
+			if (Candidate.CameraID == Camera)
+			{
+				return &Candidate;
+			}
+		}
+	}
+	return nullptr;
+}
+
+void TangoOfflineStages::Register(const FString& Name, const FTangoOfflineStageFactory& Factory)
+{
+	FStageRegistry::Get().Add(Name, Factory);
+}
+
+TArray<FString> TangoOfflineStages::GetNames()
+{
+	FStageRegistry& Registry = FStageRegistry::Get();
+	FScopeLock ScopeLock(&Registry.Lock);
+	return Registry.Names;
+}
+
+ITangoOfflineStage* TangoOfflineStages::Create(const FString& Name)
+{
+	FStageRegistry& Registry = FStageRegistry::Get();
+	FTangoOfflineStageFactory Factory;
+	{
+		FScopeLock ScopeLock(&Registry.Lock);
+		const int32 Index = Registry.Names.Find(Name);
+		if (Index == INDEX_NONE)
+		{
+			return nullptr;
+		}
+		Factory = Registry.Factories[Index];
+	}
+	return Factory();
+}
@@ -0,0 +1,73 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#pragma once
+
+#include "TangoDataTypes.h"
+#include "TangoSessionReader.h"
+
+//What a stage gets to see besides the record itself. One context per chunk, records come in recording order.
+struct FTangoOfflineContext
+{
+	//Of the session being processed
+	const TArray<FTangoCameraIntrinsics>* Intrinsics;
+	float MetersToWorldScale;
+
+	//The latest color frame of the chunk so far, points into the session file. Null before the first one.
+	const uint8* ColorNV21;
+	int32 ColorWidth;
+	int32 ColorHeight;
+	double ColorTimestamp;
+
+	FTangoOfflineContext()
+		: Intrinsics(nullptr)
+		, MetersToWorldScale(100.0f)
+		, ColorNV21(nullptr)
+		, ColorWidth(0)
+		, ColorHeight(0)
+		, ColorTimestamp(0.0)
+	{
+	}
+
+	const FTangoCameraIntrinsics* FindIntrinsics(ETangoCameraType::Type Camera) const;
+};
+
+/*
+ * One processing step of the offline pipeline, e.g. converting points or poses into Unreal space.
+ * An instance only ever runs on one thread at a time, so it can keep its buffers between records.
+ */
+class ITangoOfflineStage
+{
+public:
+	virtual ~ITangoOfflineStage() {}
+
+	//Returns how many items (points, pixels, poses) the record gave this stage, or -1 if the stage does not handle the record.
+	virtual int64 Process(const FTangoSessionRecord& Record, FTangoOfflineContext& Context) = 0;
+};
+
+typedef TFunction<ITangoOfflineStage*()> FTangoOfflineStageFactory;
+
+/*
+ * The stages the offline processing runs, in the order they were registered. The plugin registers its own on startup,
+ * other modules can add theirs.
+ */
+class TangoOfflineStages
+{
+public:
+	static void Register(const FString& Name, const FTangoOfflineStageFactory& Factory);
+	static TArray<FString> GetNames();
+	//New instance of the stage, nullptr for an unknown name
+	static ITangoOfflineStage* Create(const FString& Name);
+};
@@ -13,6 +13,7 @@ limitations under the License.*/
 
 #include "TangoPluginPrivatePCH.h"
 #include "TangoRuntimeSettings.h"
+#include "TangoStats.h"
 #include "ModuleManager.h"
 #include "ISettingsModule.h"
 
@@ -20,6 +21,31 @@ limitations under the License.*/
 
 DEFINE_LOG_CATEGORY(TangoPlugin);
 
+DEFINE_STAT(STAT_TangoDeviceTick);
+DEFINE_STAT(STAT_TangoImageTick);
+DEFINE_STAT(STAT_TangoPointCloudTick);
+DEFINE_STAT(STAT_TangoPoseBroadcast);
+DEFINE_STAT(STAT_TangoGetPoseAtTimeService);
+DEFINE_STAT(STAT_TangoGetPoseAtTimeCached);
+DEFINE_STAT(STAT_TangoProxyBuild);
+DEFINE_STAT(STAT_TangoViewGather);
+DEFINE_STAT(STAT_TangoLateUpdate);
+DEFINE_STAT(STAT_TangoPoseAge);
+DEFINE_STAT(STAT_TangoImageAge);
+DEFINE_STAT(STAT_TangoPointCloudMemory);
+DEFINE_STAT(STAT_TangoPosesReceived);
+DEFINE_STAT(STAT_TangoPosesProcessed);
+DEFINE_STAT(STAT_TangoPosesDropped);
+DEFINE_STAT(STAT_TangoDepthReceived);
+DEFINE_STAT(STAT_TangoDepthProcessed);
+DEFINE_STAT(STAT_TangoDepthDropped);
+DEFINE_STAT(STAT_TangoColorReceived);
+DEFINE_STAT(STAT_TangoColorProcessed);
+DEFINE_STAT(STAT_TangoColorDropped);
+DEFINE_STAT(STAT_TangoTexturesReceived);
+DEFINE_STAT(STAT_TangoTexturesProcessed);
+DEFINE_STAT(STAT_TangoTexturesDropped);
+
 class FTangoPlugin : public ITangoPlugin
 {
 	/** IModuleInterface implementation */
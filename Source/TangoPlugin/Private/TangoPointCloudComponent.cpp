@@ -157,9 +157,14 @@ bool UTangoPointCloudComponent::GetPlaneAtScreenCoordinates(UCameraComponent* Vi
 	TArray<FVector> ClosestPoints = GetAllDepthPointsInArea(ViewPoint, ScreenPoint, PointAreaRadius, OutputSpace,Timestamp);
 	PlaneCenter = GetVectorArrayAverage(ClosestPoints);
 
+	return FitPlane(ClosestPoints, MinPercentage, PointDistanceThreshold, Plane);
+}
+
+bool UTangoPointCloudComponent::FitPlane(const TArray<FVector>& Points, float MinPercentage, float PointDistanceThreshold, FPlane& Plane)
+{
 	Plane = FPlane();
 
-	if (ClosestPoints.Num() < 3)
+	if (Points.Num() < 3)
 	{
 		return false;
 	}
@@ -178,13 +183,13 @@ bool UTangoPointCloudComponent::GetPlaneAtScreenCoordinates(UCameraComponent* Vi
 	//RANSAC algorithm to determine inliers
 	for (int i = 0; i < MaxIterations; i++)
 	{
-		FPlane CandidatePlane = MakeRandomPlane(FVector::ForwardVector, ClosestPoints);
+		FPlane CandidatePlane = MakeRandomPlane(FVector::ForwardVector, Points);
 		FittedPointsCount = 0;
 
 		//See for every point if it belongs to that Plane or not
-		for (int j = 0; j < ClosestPoints.Num(); j++)
+		for (int j = 0; j < Points.Num(); j++)
 		{
-			float DistToPlane = CandidatePlane.PlaneDot(ClosestPoints[j]);
+			float DistToPlane = CandidatePlane.PlaneDot(Points[j]);
 			if (DistToPlane < Threshold)
 			{
 				FittedPointsCount++;
@@ -196,7 +201,7 @@ bool UTangoPointCloudComponent::GetPlaneAtScreenCoordinates(UCameraComponent* Vi
 			MaxFittedPoints = FittedPointsCount;
 			Plane = CandidatePlane;
 
-			PercentageFitted = MaxFittedPoints / ClosestPoints.Num();
+			PercentageFitted = MaxFittedPoints / Points.Num();
 			if (PercentageFitted > MinPercentage)
 			{
 				break;
@@ -212,7 +217,7 @@ bool UTangoPointCloudComponent::GetPlaneAtScreenCoordinates(UCameraComponent* Vi
 	return true;
 }
 
-FPlane UTangoPointCloudComponent::MakeRandomPlane(FVector CameraForward, TArray<FVector> Points)
+FPlane UTangoPointCloudComponent::MakeRandomPlane(const FVector& CameraForward, const TArray<FVector>& Points)
 {
 	if (Points.Num() < 3)
 	{
@@ -301,8 +306,13 @@ FVector2D UTangoPointCloudComponent::ProjectVectorToScreen(UCameraComponent* Vie
 	static FVector2D ScreenDimensions;
 	GEngine->GetLocalPlayerFromControllerId(GWorld, 0)->ViewportClient->GetViewportSize(ScreenDimensions);//@TODO: POSSIBLY WRONG ASSUMPTION: ID = 0
 
-	float WU = FMath::Tan(FMath::DegreesToRadians<float>(ViewPoint->FieldOfView*0.5f)) * Location.X;
-	float WV = FMath::Tan(FMath::DegreesToRadians<float>(ViewPoint->FieldOfView*0.5f / ViewPoint->AspectRatio)) * Location.X;
+	return ProjectToScreen(ViewPoint->FieldOfView, ViewPoint->AspectRatio, ScreenDimensions, Location);
+}
+
+FVector2D UTangoPointCloudComponent::ProjectToScreen(float FieldOfView, float AspectRatio, const FVector2D& ScreenDimensions, const FVector& Location)
+{
+	float WU = FMath::Tan(FMath::DegreesToRadians<float>(FieldOfView*0.5f)) * Location.X;
+	float WV = FMath::Tan(FMath::DegreesToRadians<float>(FieldOfView*0.5f / AspectRatio)) * Location.X;
 
 	float U =  Location.Y / WU;
 	float V = -Location.Z / WV;
@@ -0,0 +1,230 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoPointColorizer.h"
+#include "TangoImageConversion.h"
+#include "TangoLensModel.h"
+#include "TangoCoordinateConversions.h"
+#include "TangoExtrinsicsCache.h"
+#include "TangoDevice.h"
+#include "TangoTracer.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	static const int32 MinPointsPerBand = 2048;
+	//Projected pixels are gathered in chunks of this size, so the buffers stay on the stack.
+	static const int32 ChunkSize = 256;
+
+	//Projects and samples one band of points, returns how many landed inside the image.
+	int32 ColorizeBand(const TangoLensModel& Lens, const FMatrix& DepthToColor, const FVector* Points, int32 Count, const FTangoCameraFrame& Frame, FColor* OutColors)
+	{
+		//The frame may come at a different resolution than the one the camera was calibrated at.
+		const float ScaleX = (float)Frame.Width / Lens.GetIntrinsics().Width;
+		const float ScaleY = (float)Frame.Height / Lens.GetIntrinsics().Height;
+		const float Width = (float)Frame.Width;
+		const float Height = (float)Frame.Height;
+
+		FVector2D Projected[ChunkSize];
+		uint32 Pixels[ChunkSize];
+		int32 NumColored = 0;
+		for (int32 Begin = 0; Begin < Count; Begin += ChunkSize)
+		{
+			const int32 ChunkCount = FMath::Min(ChunkSize, Count - Begin);
+			Lens.Project(Points + Begin, Projected, ChunkCount, &DepthToColor);
+			for (int32 i = 0; i < ChunkCount; ++i)
+			{
+				//Rounded to the nearest pixel center
+				const float U = Projected[i].X * ScaleX + 0.5f;
+				const float V = Projected[i].Y * ScaleY + 0.5f;
+				const bool bInside = U >= 0.0f && U < Width && V >= 0.0f && V < Height;
+				Pixels[i] = bInside ? TangoImageConversion::PackPixel((int32)U, (int32)V) : TangoImageConversion::InvalidPixel;
+				NumColored += bInside ? 1 : 0;
+			}
+			TangoImageConversion::GatherNV21(Frame.GetY(), Frame.GetVU(), Frame.Width, Pixels, ChunkCount, OutColors + Begin);
+		}
+		return NumColored;
+	}
+
+	//The bundle poses are START_OF_SERVICE to DEVICE in Unreal space, the motion compensation needs them in Tango space.
+	bool GetDeviceMatrix(const FTangoPoseData& Pose, FMatrix& Matrix)
+	{
+		const FTangoCoordinateFramePair Pair(ETangoCoordinateFrameType::START_OF_SERVICE, ETangoCoordinateFrameType::DEVICE);
+		TangoSpaceConversions::TangoSpaceConversionPair SpaceConverter;
+		if (Pose.StatusCode != ETangoPoseStatus::VALID || !TangoSpaceConversions::GetSpaceConversionPair(SpaceConverter, Pair))
+		{
+			return false;
+		}
+		Matrix = TangoSpaceConversions::GetTangoSpaceMatrix(Pose, SpaceConverter);
+		return true;
+	}
+}
+
+bool TangoPointColorizer::GetDepthToColor(FMatrix& DepthToColor, const FMatrix* DeviceAtDepth, const FMatrix* DeviceAtColor)
+{
+	FTangoDeviceExtrinsics Extrinsics;
+	if (!TangoSpaceConversions::GetExtrinsics(Extrinsics))
+	{
+		return false;
+	}
+	//Row vectors: each matrix moves points from its target into its base frame.
+	if (DeviceAtDepth != nullptr && DeviceAtColor != nullptr)
+	{
+		const FMatrix DEVICEtoIMU = Extrinsics.IMUtoDEVICE.Inverse();
+		DepthToColor = Extrinsics.IMUtoDEPTH * DEVICEtoIMU * (*DeviceAtDepth) * DeviceAtColor->Inverse() * Extrinsics.IMUtoDEVICE * Extrinsics.IMUtoCOLOR.Inverse();
+	}
+	else
+	{
+		DepthToColor = Extrinsics.IMUtoDEPTH * Extrinsics.IMUtoCOLOR.Inverse();
+	}
+	return true;
+}
+
+int32 TangoPointColorizer::ColorizePoints(const FVector* Points, int32 NumPoints, const FMatrix& DepthToColor, const FTangoCameraIntrinsics& Intrinsics,
+	const FTangoCameraFrame& Frame, FColor* OutColors, bool bParallel)
+{
+	TSharedRef<TangoLensModel, ESPMode::ThreadSafe> Lens = TangoLensModel::Get(Intrinsics);
+	if (!Lens->IsValid() || Frame.Width <= 0 || Frame.Height <= 0)
+	{
+		for (int32 i = 0; i < NumPoints; ++i)
+		{
+			OutColors[i] = FColor(0, 0, 0, 0);
+		}
+		return 0;
+	}
+
+	int32 NumBands = 1;
+	if (bParallel && FPlatformProcess::SupportsMultithreading())
+	{
+		NumBands = FMath::Clamp(NumPoints / MinPointsPerBand, 1, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+	}
+	if (NumBands == 1)
+	{
+		return ColorizeBand(*Lens, DepthToColor, Points, NumPoints, Frame, OutColors);
+	}
+	FThreadSafeCounter NumColored;
+	ParallelFor(NumBands, [&](int32 Band)
+	{
+		const int32 Begin = NumPoints * Band / NumBands;
+		const int32 End = NumPoints * (Band + 1) / NumBands;
+		NumColored.Add(ColorizeBand(*Lens, DepthToColor, Points + Begin, End - Begin, Frame, OutColors + Begin));
+	});
+	return NumColored.GetValue();
+}
+
+bool TangoPointColorizer::Colorize(const FTangoFrameBundle& Bundle, FTangoColoredPointCloud& Out, bool bCompensateMotion, bool bParallel)
+{
+	if (!Bundle.Depth.IsValid() || !Bundle.ColorFrame.IsValid())
+	{
+		return false;
+	}
+	TANGO_TRACE_SCOPE("PointColorizer.Colorize", Bundle.Depth->Timestamp);
+	const FTangoCameraIntrinsics Intrinsics = UTangoDevice::Get().GetCameraIntrinsics(ETangoCameraType::COLOR);
+	if (Intrinsics.Width <= 0 || Intrinsics.Height <= 0)
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoPointColorizer::Colorize: Color camera intrinsics are not available"));
+		return false;
+	}
+
+	FMatrix DepthToColor;
+	bool bHasTransform = false;
+	FMatrix DeviceAtDepth;
+	FMatrix DeviceAtColor;
+	if (bCompensateMotion && GetDeviceMatrix(Bundle.DepthPose, DeviceAtDepth) && GetDeviceMatrix(Bundle.ColorPose, DeviceAtColor))
+	{
+		bHasTransform = GetDepthToColor(DepthToColor, &DeviceAtDepth, &DeviceAtColor);
+	}
+	if (!bHasTransform && !GetDepthToColor(DepthToColor))
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoPointColorizer::Colorize: Device extrinsics are not available"));
+		return false;
+	}
+
+	const TArray<FVector>& Points = Bundle.Depth->Points;
+	const int32 NumPoints = Points.Num();
+	Out.Timestamp = Bundle.Depth->Timestamp;
+	Out.Colors.SetNumUninitialized(NumPoints, false);
+	Out.NumColoredPoints = ColorizePoints(Points.GetData(), NumPoints, DepthToColor, Intrinsics, *Bundle.ColorFrame, Out.Colors.GetData(), bParallel);
+
+	const float WorldScale = UTangoDevice::Get().GetMetersToWorldScale();
+	Out.Points.SetNumUninitialized(NumPoints, false);
+	for (int32 i = 0; i < NumPoints; ++i)
+	{
+		Out.Points[i] = FVector(Points[i].Z * WorldScale, Points[i].X * WorldScale, -Points[i].Y * WorldScale);
+	}
+	return true;
+}
+
+/*
+ * Tango.BenchmarkPointColorizer [Points] [Iterations]
+ * Colors random points in front of a synthetic 1280x720 frame with typical color camera intrinsics.
+ */
+namespace
+{
+	void BenchmarkPointColorizer(const TArray<FString>& Args)
+	{
+		const int32 NumPoints = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 60000;
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 50;
+
+		TSharedPtr<TangoCameraFramePool, ESPMode::ThreadSafe> Pool = MakeShareable(new TangoCameraFramePool(2));
+		Pool->SubmitSyntheticFrame(1280, 720, 0.0);
+		FTangoCameraFrameHandle Frame = Pool->GetLatestFrame();
+
+		FTangoCameraIntrinsics Intrinsics;
+		Intrinsics.CalibrationType = ETangoCalibrationType::POLYNOMIAL_3_PARAMETERS;
+		Intrinsics.CameraID = ETangoCameraType::COLOR;
+		Intrinsics.Width = 1280;
+		Intrinsics.Height = 720;
+		Intrinsics.Fx = Intrinsics.Fy = 1040.0f;
+		Intrinsics.Cx = 640;
+		Intrinsics.Cy = 360;
+		Intrinsics.Distortion.Init(0.0f, 5);
+		Intrinsics.Distortion[0] = 0.22f;
+		Intrinsics.Distortion[1] = -0.51f;
+		Intrinsics.Distortion[2] = 0.43f;
+
+		FRandomStream Random(1234);
+		TArray<FVector> Points;
+		Points.SetNumUninitialized(NumPoints);
+		for (FVector& Point : Points)
+		{
+			const float Z = Random.FRandRange(0.5f, 4.0f);
+			Point = FVector(Random.FRandRange(-0.7f, 0.7f) * Z, Random.FRandRange(-0.45f, 0.45f) * Z, Z);
+		}
+		//A few centimeters between the cameras, like on the devices
+		const FMatrix DepthToColor = FTranslationMatrix(FVector(0.02f, 0.0f, 0.0f));
+		TArray<FColor> Colors;
+		Colors.SetNumUninitialized(NumPoints);
+
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			const bool bParallel = Pass == 1;
+			int32 NumColored = 0;
+			const double Start = FPlatformTime::Seconds();
+			for (int32 i = 0; i < Iterations; ++i)
+			{
+				NumColored = TangoPointColorizer::ColorizePoints(Points.GetData(), NumPoints, DepthToColor, Intrinsics, *Frame, Colors.GetData(), bParallel);
+			}
+			const double Seconds = (FPlatformTime::Seconds() - Start) / Iterations;
+			UE_LOG(TangoPlugin, Log, TEXT("Tango.BenchmarkPointColorizer: %-8s %7.3f ms, %6.2f ns/point, %d of %d points colored, %s kernels"),
+				bParallel ? TEXT("parallel") : TEXT("single"), Seconds * 1000.0, Seconds * 1e9 / NumPoints, NumColored, NumPoints, TangoImageConversion::GetKernelName());
+		}
+	}
+
+	static FAutoConsoleCommand BenchmarkPointColorizerCommand(
+		TEXT("Tango.BenchmarkPointColorizer"),
+		TEXT("Times coloring depth points from a camera frame. Arguments: [Points] [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkPointColorizer));
+}
@@ -0,0 +1,53 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoDataTypes.h"
+#include "TangoFrameSynchronizer.h"
+
+//A depth frame with one color per point, for consumers that work without a material like fusion or export.
+struct FTangoColoredPointCloud
+{
+	double Timestamp;
+	//Unreal space relative to the depth camera, scaled like the points of TangoDevicePointCloud
+	TArray<FVector> Points;
+	//Alpha is 0 for points outside the color image
+	TArray<FColor> Colors;
+	int32 NumColoredPoints;
+
+	FTangoColoredPointCloud()
+		: Timestamp(0.0)
+		, NumColoredPoints(0)
+	{
+	}
+};
+
+/*
+ * Colors depth points on the CPU by projecting them into the color frame of their bundle with the color camera intrinsics,
+ * including the lens distortion. This is the same lookup the point coloring material does, just without a GPU.
+ */
+class TangoPointColorizer
+{
+public:
+	//Needs a bundle with a CPU color frame. With bCompensateMotion the device movement between the depth and the color pose of the bundle is taken into account.
+	static bool Colorize(const FTangoFrameBundle& Bundle, FTangoColoredPointCloud& Out, bool bCompensateMotion = true, bool bParallel = true);
+
+	//Points are in raw depth camera meters, DepthToColor moves them into the color camera frame. Writes one color per point and returns how many were inside the image.
+	static int32 ColorizePoints(const FVector* Points, int32 NumPoints, const FMatrix& DepthToColor, const FTangoCameraIntrinsics& Intrinsics,
+		const FTangoCameraFrame& Frame, FColor* OutColors, bool bParallel = true);
+
+	//Depth camera to color camera, from the device extrinsics. With both device poses (START_OF_SERVICE to DEVICE, Tango space) the motion between them is included.
+	static bool GetDepthToColor(FMatrix& DepthToColor, const FMatrix* DeviceAtDepth = nullptr, const FMatrix* DeviceAtColor = nullptr);
+};
@@ -17,6 +17,7 @@ limitations under the License.*/
 #include "TangoPointsComponent.h"
 #include "TangoImageComponent.h"
 #include "TangoARHelpers.h"
+#include "TangoStats.h"
 
 //The Component Implementation
 
@@ -60,8 +61,11 @@ bool UTangoPointsComponent::PrepareMaterialForPointColoring(UTangoImageComponent
 	}
 	else
 	{
-		Instance->SetTextureParameterValue(PackedYMaskTextureName, UTangoDevice::Get().GetTangoDeviceImagePointer()->GetYTexture());
-		Instance->SetTextureParameterValue(PackedUVMaskTextureName, UTangoDevice::Get().GetTangoDeviceImagePointer()->GetCrTexture());
+		ColoringMaterial = Instance;
+		ColoringYTextureName = PackedYMaskTextureName;
+		ColoringUVTextureName = PackedUVMaskTextureName;
+		BoundYTexture = nullptr;
+		BindCameraTextures();
 		Instance->SetVectorParameterValue(MaterialVectorName, FLinearColor(0, 0, Intrin.Width, Intrin.Height));
 		Instance->SetVectorParameterValue(IntrinsicsName, FLinearColor(Intrin.Cx, Intrin.Cy, Intrin.Fx, Intrin.Fy));
 		if (Intrin.Distortion.Num() >= 3 || Intrin.CalibrationType != ETangoCalibrationType::POLYNOMIAL_3_PARAMETERS)
@@ -77,13 +81,32 @@ bool UTangoPointsComponent::PrepareMaterialForPointColoring(UTangoImageComponent
 	}
 }
 
+void UTangoPointsComponent::BindCameraTextures()
+{
+	UTangoDeviceImage* DeviceImage = UTangoDevice::Get().GetTangoDeviceImagePointer();
+	if (ColoringMaterial == nullptr || DeviceImage == nullptr)
+	{
+		return;
+	}
+	//Each camera frame lands in another texture of the ring
+	UTexture* YTexture = DeviceImage->GetYTexture();
+	if (YTexture != nullptr && YTexture != BoundYTexture)
+	{
+		ColoringMaterial->SetTextureParameterValue(ColoringYTextureName, YTexture);
+		ColoringMaterial->SetTextureParameterValue(ColoringUVTextureName, DeviceImage->GetCrTexture());
+		BoundYTexture = YTexture;
+	}
+}
+
 void UTangoPointsComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction * ThisTickFunction)
 {
+	BindCameraTextures();
 	if (UTangoDevice::Get().GetTangoDevicePointCloudPointer()) {
-		float LatestTimestamp = UTangoDevice::Get().GetTangoDevicePointCloudPointer()->GetPointCloudTimestamp();
+		const double LatestTimestamp = UTangoDevice::Get().GetTangoDevicePointCloudPointer()->GetPointCloudTimestamp();
 		
-		if (Timestamp < LatestTimestamp)
+		if (PointCloudTimestamp < LatestTimestamp)
 		{
+			PointCloudTimestamp = LatestTimestamp;
 			Timestamp = LatestTimestamp;
 			MarkRenderStateDirty();
 		}
@@ -92,6 +115,7 @@ void UTangoPointsComponent::TickComponent(float DeltaTime, ELevelTick TickType,
 
 FPrimitiveSceneProxy * UTangoPointsComponent::CreateSceneProxy()
 {
+	SCOPE_CYCLE_COUNTER(STAT_TangoProxyBuild);
 	if (UTangoDevice::Get().GetTangoDevicePointCloudPointer() && UTangoDevice::Get().GetTangoDevicePointCloudPointer()->GetPointCloud().Num() > 0)
 	{
 		return new FTangoPointCloudSceneProxy(this, MinBounds, MaxBounds, TangoARHelpers::GetUnadjustedProjectionMatrix(), bExperimentalMeshGeneration);
@@ -125,195 +149,202 @@ FTangoPointCloudSceneProxy::FTangoPointCloudSceneProxy(const UTangoPointsCompone
 		FColor initColor = Color.ToFColor(true);
 
 		TArray<FVector> & Points = UTangoDevice::Get().GetTangoDevicePointCloudPointer()->GetPointCloud();
-		const int32 vertexCount = Points.Num();
+		BuildBuffers(Points, ProjMat, bTriangles, initColor, VertexBuffer.Vertices, IndexBuffer.Indices, MinBounds, MaxBounds);
+		//Initialise the Vertex Factory with our Vertices.
+		VertexFactory.Init(&VertexBuffer);
 
-		TArray<int32> TrueIJData;
-		uint32 RowCount = 0;
-		uint32 ColCount = 0;
+		//Tell the RHI to initialise the resources on the Graphics Card.
+		BeginInitResource(&VertexBuffer);
+		BeginInitResource(&IndexBuffer);
+		BeginInitResource(&VertexFactory);
+	}
 
-		VertexBuffer.Vertices.SetNumUninitialized(vertexCount);
-		if (!bTriangles)
-		{
-			IndexBuffer.Indices.SetNumUninitialized(vertexCount);
-		}
-		else
+	bWillEverBeLit = true;
+	ViewRelevance.bDrawRelevance = true;
+	ViewRelevance.bDynamicRelevance = true;
+	// ideally the TranslucencyRelevance should be filled out by the material, here we do it conservative
+	ViewRelevance.bSeparateTranslucencyRelevance = ViewRelevance.bNormalTranslucencyRelevance = true;
+}
+
+void FTangoPointCloudSceneProxy::BuildBuffers(const TArray<FVector>& Points, const FMatrix& ProjMat, bool bTriangles, FColor VertexColor,
+	TArray<FDynamicMeshVertex>& Vertices, TArray<int32>& Indices, FVector& MinBounds, FVector& MaxBounds)
+{
+	Indices.Reset();
+	const int32 vertexCount = Points.Num();
+
+	TArray<int32> TrueIJData;
+	uint32 RowCount = 0;
+	uint32 ColCount = 0;
+
+	Vertices.SetNumUninitialized(vertexCount);
+	if (!bTriangles)
+	{
+		Indices.SetNumUninitialized(vertexCount);
+	}
+	else
+	{
+		RowCount = FMath::FloorToInt(FMath::Sqrt(1250.0f/3.0f) * 16.0f*0.5f);//Camera aspect is 16:9 and max point count is 60000 so sqrt(60000 / (16 *9)) = 20.412
+		ColCount = FMath::FloorToInt(FMath::Sqrt(1250.0f / 3.0f) * 9.0f*0.5f);
+		TrueIJData.SetNumUninitialized(RowCount * ColCount);
+		for (uint32 i = 0; i < RowCount * ColCount; ++i)
 		{
-			RowCount = FMath::FloorToInt(FMath::Sqrt(1250.0f/3.0f) * 16.0f*0.5f);//Camera aspect is 16:9 and max point count is 60000 so sqrt(60000 / (16 *9)) = 20.412
-			ColCount = FMath::FloorToInt(FMath::Sqrt(1250.0f / 3.0f) * 9.0f*0.5f);
-			TrueIJData.SetNumUninitialized(RowCount * ColCount);
-			for (uint32 i = 0; i < RowCount * ColCount; ++i)
-			{
-				TrueIJData[i] = -1;
-			}
+			TrueIJData[i] = -1;
 		}
+	}
 
-		if (vertexCount > 0)
+	if (vertexCount > 0)
+	{
+		MinBounds = Points[0];
+		MaxBounds = Points[0];
+	}
+	//Initialize the Vertex and Index buffers with their data.
+	int32 Written = 0;
+	int32 Unique = 0;
+	FVector4 MinmaxUV = FVector4(0,0,0,0);
+	for (int32 Index = 0; Index < vertexCount; Index++)
+	{
+		Vertices[Index].Position = Points[Index];
+		Vertices[Index].Color = VertexColor;
+		FVector2D Texcoord = FVector2D((ProjMat.M[0][0] * Points[Index].Y + Points[Index].X * ProjMat.M[2][0]),
+									  (-ProjMat.M[1][1] * Points[Index].Z + Points[Index].X * ProjMat.M[2][1])) / Points[Index].X;
+		Texcoord = Texcoord * 0.5f + 0.5f;
+		Vertices[Index].TextureCoordinate = Texcoord;
+		//UE_LOG(TangoPlugin, Log, TEXT("FTangoPointCloudSceneProxy::FTangoPointCloudSceneProxy: Calculated %f %f"), Texcoord.X, Texcoord.Y);
+		
+		if (Texcoord.X != NAN && Texcoord.Y != NAN)
 		{
-			MinBounds = Points[0];
-			MaxBounds = Points[0];
+			MinmaxUV.X = FMath::Max<float>(MinmaxUV.X, Texcoord.X);
+			MinmaxUV.Y = FMath::Min<float>(MinmaxUV.Y, Texcoord.X);
+			MinmaxUV.Z = FMath::Max<float>(MinmaxUV.Z, Texcoord.Y);
+			MinmaxUV.W = FMath::Min<float>(MinmaxUV.W, Texcoord.Y);
 		}
-		//Initialize the Vertex and Index buffers with their data.
-		int32 Written = 0;
-		int32 Unique = 0;
-		FVector4 MinmaxUV = FVector4(0,0,0,0);
-		for (int32 Index = 0; Index < vertexCount; Index++)
-		{
-			VertexBuffer.Vertices[Index].Position = Points[Index];
-			VertexBuffer.Vertices[Index].Color = initColor;
-			FVector2D Texcoord = FVector2D((ProjMat.M[0][0] * Points[Index].Y + Points[Index].X * ProjMat.M[2][0]),
-										  (-ProjMat.M[1][1] * Points[Index].Z + Points[Index].X * ProjMat.M[2][1])) / Points[Index].X;
-			Texcoord = Texcoord * 0.5f + 0.5f;
-			VertexBuffer.Vertices[Index].TextureCoordinate = Texcoord;
-			//UE_LOG(TangoPlugin, Log, TEXT("FTangoPointCloudSceneProxy::FTangoPointCloudSceneProxy: Calculated %f %f"), Texcoord.X, Texcoord.Y);
-			
-			if (Texcoord.X != NAN && Texcoord.Y != NAN)
-			{
-				MinmaxUV.X = FMath::Max<float>(MinmaxUV.X, Texcoord.X);
-				MinmaxUV.Y = FMath::Min<float>(MinmaxUV.Y, Texcoord.X);
-				MinmaxUV.Z = FMath::Max<float>(MinmaxUV.Z, Texcoord.Y);
-				MinmaxUV.W = FMath::Min<float>(MinmaxUV.W, Texcoord.Y);
-			}
 
-			MinBounds.X = FMath::Min<float>(MinBounds.X, Points[Index].X);
-			MinBounds.Y = FMath::Min<float>(MinBounds.Y, Points[Index].Y);
-			MinBounds.Z = FMath::Min<float>(MinBounds.Z, Points[Index].Z);
-			MaxBounds.X = FMath::Max<float>(MaxBounds.X, Points[Index].X);
-			MaxBounds.Y = FMath::Max<float>(MaxBounds.Y, Points[Index].Y);
-			MaxBounds.Z = FMath::Max<float>(MaxBounds.Z, Points[Index].Z);
+		MinBounds.X = FMath::Min<float>(MinBounds.X, Points[Index].X);
+		MinBounds.Y = FMath::Min<float>(MinBounds.Y, Points[Index].Y);
+		MinBounds.Z = FMath::Min<float>(MinBounds.Z, Points[Index].Z);
+		MaxBounds.X = FMath::Max<float>(MaxBounds.X, Points[Index].X);
+		MaxBounds.Y = FMath::Max<float>(MaxBounds.Y, Points[Index].Y);
+		MaxBounds.Z = FMath::Max<float>(MaxBounds.Z, Points[Index].Z);
 
-			if (!bTriangles)
-			{
-				FVector Normal = Points[Index].GetSafeNormal() * -1.0f;
-				VertexBuffer.Vertices[Index].TangentX = FPackedNormal(Normal);
-				VertexBuffer.Vertices[Index].TangentZ = FPackedNormal(FVector::CrossProduct(Normal, FVector(0.0f, 1.0f, 0.0f)));
+		if (!bTriangles)
+		{
+			FVector Normal = Points[Index].GetSafeNormal() * -1.0f;
+			Vertices[Index].TangentX = FPackedNormal(Normal);
+			Vertices[Index].TangentZ = FPackedNormal(FVector::CrossProduct(Normal, FVector(0.0f, 1.0f, 0.0f)));
 
-				IndexBuffer.Indices[Index] = Index;
-			}
-			else
+			Indices[Index] = Index;
+		}
+		else
+		{
+			FVector2D Ind = Texcoord;
+			Ind.X *= RowCount;
+			Ind.Y *= ColCount;
+			int32 RInd = FMath::RoundToInt(Ind.X), CInd = FMath::RoundToInt(Ind.Y);
+			if (RInd >= 0 && CInd >= 0 && RInd < static_cast<int32>(RowCount)&& CInd < static_cast<int32>(ColCount))
 			{
-				FVector2D Ind = Texcoord;
-				Ind.X *= RowCount;
-				Ind.Y *= ColCount;
-				int32 RInd = FMath::RoundToInt(Ind.X), CInd = FMath::RoundToInt(Ind.Y);
-				if (RInd >= 0 && CInd >= 0 && RInd < static_cast<int32>(RowCount)&& CInd < static_cast<int32>(ColCount))
+				bool bFound = false;
+				if (TrueIJData[RInd + CInd*RowCount] == -1)
 				{
-					bool bFound = false;
-					if (TrueIJData[RInd + CInd*RowCount] == -1)
-					{
-						bFound = true;
-						Unique++;
-					}
-					else
+					bFound = true;
+					Unique++;
+				}
+				else
+				{
+					Ind.X -= RInd;
+					Ind.Y -= CInd;
+					if (Ind.X > 0.25f && RInd + 1 < static_cast<int32>(RowCount))
 					{
-						Ind.X -= RInd;
-						Ind.Y -= CInd;
-						if (Ind.X > 0.25f && RInd + 1 < static_cast<int32>(RowCount))
+						if (TrueIJData[RInd + 1 + CInd*RowCount] == -1)
 						{
-							if (TrueIJData[RInd + 1 + CInd*RowCount] == -1)
-							{
-								bFound = true;
-								RInd++;
-							}
+							bFound = true;
+							RInd++;
 						}
-						if (!bFound && Ind.Y > 0.25f && CInd + 1 < static_cast<int32>(ColCount))
+					}
+					if (!bFound && Ind.Y > 0.25f && CInd + 1 < static_cast<int32>(ColCount))
+					{
+						if (TrueIJData[RInd + CInd*RowCount + RowCount] == -1)
 						{
-							if (TrueIJData[RInd + CInd*RowCount + RowCount] == -1)
-							{
-								bFound = true;
-								CInd++;
-							}
+							bFound = true;
+							CInd++;
 						}
-						if (!bFound && Ind.X < -0.25f && RInd > 0)
+					}
+					if (!bFound && Ind.X < -0.25f && RInd > 0)
+					{
+						if (TrueIJData[RInd + CInd*RowCount - 1] == -1)
 						{
-							if (TrueIJData[RInd + CInd*RowCount - 1] == -1)
-							{
-								bFound = true;
-								RInd--;
-							}
-						}
-						if (!bFound && Ind.Y < -0.25f && CInd > 0)
-						{
-							if (TrueIJData[RInd + CInd*RowCount - RowCount] == -1)
-							{
-								bFound = true;
-								CInd--;
-							}
+							bFound = true;
+							RInd--;
 						}
 					}
-					if (bFound)
+					if (!bFound && Ind.Y < -0.25f && CInd > 0)
 					{
-						TrueIJData[RInd + CInd*RowCount] = Index;
-						Written++;
+						if (TrueIJData[RInd + CInd*RowCount - RowCount] == -1)
+						{
+							bFound = true;
+							CInd--;
+						}
 					}
 				}
+				if (bFound)
+				{
+					TrueIJData[RInd + CInd*RowCount] = Index;
+					Written++;
+				}
 			}
 		}
-		UE_LOG(TangoPlugin, Log, TEXT("FTangoPointCloudSceneProxy::FTangoPointCloudSceneProxy: MinMaxUV %f %f %f %f"), MinmaxUV.X, MinmaxUV.Y, MinmaxUV.Z, MinmaxUV.W);
+	}
+	UE_LOG(TangoPlugin, Verbose, TEXT("FTangoPointCloudSceneProxy::BuildBuffers: MinMaxUV %f %f %f %f"), MinmaxUV.X, MinmaxUV.Y, MinmaxUV.Z, MinmaxUV.W);
 
-		if (bTriangles)
+	if (bTriangles)
+	{
+		//int32* IJData;
+		//IJData = UTangoDevice::Get().GetTangoDevicePointCloudPointer()->GetIJData(RowCount, ColCount);
+		static int32 StepIndexes[8][2] = {{0,1},{ 1,1 },{ 1,0 },{ 1,-1 },{ 0,-1 },{ -1,-1 },{ -1,0 },{ -1,1 }};
+		UE_LOG(TangoPlugin, Verbose, TEXT("FTangoPointCloudSceneProxy::BuildBuffers: Wrote %d Unique %d out of %d"), Written, Unique, vertexCount);
+		UE_LOG(TangoPlugin, Verbose, TEXT("FTangoPointCloudSceneProxy::BuildBuffers: %d %d"),RowCount,ColCount);
+		for (uint32 r = 0; r < RowCount; r++)
 		{
-			//int32* IJData;
-			//IJData = UTangoDevice::Get().GetTangoDevicePointCloudPointer()->GetIJData(RowCount, ColCount);
-			static int32 StepIndexes[8][2] = {{0,1},{ 1,1 },{ 1,0 },{ 1,-1 },{ 0,-1 },{ -1,-1 },{ -1,0 },{ -1,1 }};
-			UE_LOG(TangoPlugin, Log, TEXT("FTangoPointCloudSceneProxy::FTangoPointCloudSceneProxy: Wrote %d Unique %d out of %d"), Written, Unique, vertexCount);
-			UE_LOG(TangoPlugin, Log, TEXT("FTangoPointCloudSceneProxy::FTangoPointCloudSceneProxy: %d %d"),RowCount,ColCount);
-			for (uint32 r = 0; r < RowCount; r++)
+			for (uint32 c = 0; c < ColCount; c++)
 			{
-				for (uint32 c = 0; c < ColCount; c++)
+				if (TrueIJData[r + c*RowCount] >= 0 && TrueIJData[r + c*RowCount] < vertexCount)
 				{
-					if (TrueIJData[r + c*RowCount] >= 0 && TrueIJData[r + c*RowCount] < vertexCount)
+					FVector point = Points[TrueIJData[r + c*RowCount]];
+					int32 rB = r + StepIndexes[7][0];
+					int32 cB = c + StepIndexes[7][1];
+					FVector NormalHelper = FVector::ZeroVector;
+					uint32 NormalHelperCount = 0;
+					for (uint32 i = 0; i < 8; ++i)
 					{
-						FVector point = Points[TrueIJData[r + c*RowCount]];
-						int32 rB = r + StepIndexes[7][0];
-						int32 cB = c + StepIndexes[7][1];
-						FVector NormalHelper = FVector::ZeroVector;
-						uint32 NormalHelperCount = 0;
-						for (uint32 i = 0; i < 8; ++i)
+						int32 rA = r + StepIndexes[i][0];
+						int32 cA = c + StepIndexes[i][1];
+						if (rA >= 0 && rA < static_cast<int32>(RowCount) && cA >= 0 && cA < static_cast<int32>(ColCount) && rB >= 0 && rB < static_cast<int32>(RowCount) && cB >= 0 && cB < static_cast<int32>(ColCount))
 						{
-							int32 rA = r + StepIndexes[i][0];
-							int32 cA = c + StepIndexes[i][1];
-							if (rA >= 0 && rA < static_cast<int32>(RowCount) && cA >= 0 && cA < static_cast<int32>(ColCount) && rB >= 0 && rB < static_cast<int32>(RowCount) && cB >= 0 && cB < static_cast<int32>(ColCount))
+							if (TrueIJData[rB + cB*RowCount] >= 0 && TrueIJData[rA + cA*RowCount] >= 0 && TrueIJData[rA + cA*RowCount] < vertexCount && TrueIJData[rB + cB*RowCount] < vertexCount)
 							{
-								if (TrueIJData[rB + cB*RowCount] >= 0 && TrueIJData[rA + cA*RowCount] >= 0 && TrueIJData[rA + cA*RowCount] < vertexCount && TrueIJData[rB + cB*RowCount] < vertexCount)
+								NormalHelper += FVector::CrossProduct(Points[TrueIJData[rB + cB*RowCount]] - point, Points[TrueIJData[rA + cA*RowCount]] - point).GetSafeNormal();
+								if (i == 1 || i == 2)//In these cases we add a triangle!
 								{
-									NormalHelper += FVector::CrossProduct(Points[TrueIJData[rB + cB*RowCount]] - point, Points[TrueIJData[rA + cA*RowCount]] - point).GetSafeNormal();
-									if (i == 1 || i == 2)//In these cases we add a triangle!
-									{
-										//UE_LOG(TangoPlugin, Log, TEXT("FTangoPointCloudSceneProxy::FTangoPointCloudSceneProxy: Adding a triangle! %d %d %d"), TrueIJData[r + c*RowCount], TrueIJData[rB + cB*RowCount], TrueIJData[rA + cA*RowCount]);
-										IndexBuffer.Indices.Add(TrueIJData[r + c*RowCount]);
-										IndexBuffer.Indices.Add(TrueIJData[rB + cB*RowCount]);
-										IndexBuffer.Indices.Add(TrueIJData[rA + cA*RowCount]);
-									}
+									//UE_LOG(TangoPlugin, Log, TEXT("FTangoPointCloudSceneProxy::FTangoPointCloudSceneProxy: Adding a triangle! %d %d %d"), TrueIJData[r + c*RowCount], TrueIJData[rB + cB*RowCount], TrueIJData[rA + cA*RowCount]);
+									Indices.Add(TrueIJData[r + c*RowCount]);
+									Indices.Add(TrueIJData[rB + cB*RowCount]);
+									Indices.Add(TrueIJData[rA + cA*RowCount]);
 								}
 							}
-							cB = cA;
-							rB = rA;
 						}
-						NormalHelper = NormalHelper.GetSafeNormal();
-						VertexBuffer.Vertices[TrueIJData[r + c*RowCount]].TangentX = FPackedNormal(NormalHelper);
-						VertexBuffer.Vertices[TrueIJData[r + c*RowCount]].TangentZ = FPackedNormal(FVector::CrossProduct(NormalHelper, FVector(0.0f, 1.0f, 0.0f)));
+						cB = cA;
+						rB = rA;
 					}
+					NormalHelper = NormalHelper.GetSafeNormal();
+					Vertices[TrueIJData[r + c*RowCount]].TangentX = FPackedNormal(NormalHelper);
+					Vertices[TrueIJData[r + c*RowCount]].TangentZ = FPackedNormal(FVector::CrossProduct(NormalHelper, FVector(0.0f, 1.0f, 0.0f)));
 				}
 			}
-			UE_LOG(TangoPlugin, Log, TEXT("FTangoPointCloudSceneProxy::FTangoPointCloudSceneProxy: Indexcount %d"), IndexBuffer.Indices.Num());
 		}
-		int32 count = 0;
-		while(IndexBuffer.Indices.Num()<9)
-			IndexBuffer.Indices.Add(count++);
-		//Initialise the Vertex Factory with our Vertices.
-		VertexFactory.Init(&VertexBuffer);
-
-		//Tell the RHI to initialise the resources on the Graphics Card.
-		BeginInitResource(&VertexBuffer);
-		BeginInitResource(&IndexBuffer);
-		BeginInitResource(&VertexFactory);
+		UE_LOG(TangoPlugin, Verbose, TEXT("FTangoPointCloudSceneProxy::BuildBuffers: Indexcount %d"), Indices.Num());
 	}
-
-	bWillEverBeLit = true;
-	ViewRelevance.bDrawRelevance = true;
-	ViewRelevance.bDynamicRelevance = true;
-	// ideally the TranslucencyRelevance should be filled out by the material, here we do it conservative
-	ViewRelevance.bSeparateTranslucencyRelevance = ViewRelevance.bNormalTranslucencyRelevance = true;
+	int32 count = 0;
+	while(Indices.Num()<9)
+		Indices.Add(count++);
 }
 
 FTangoPointCloudSceneProxy::~FTangoPointCloudSceneProxy()
@@ -0,0 +1,300 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoProcessSessionsCommandlet.h"
+#include "TangoOfflineStages.h"
+#include "TangoSessionReader.h"
+#include "TangoCoordinateConversions.h"
+#include "TangoExtrinsicsCache.h"
+#include "TangoReport.h"
+#include "TangoDevice.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	//Per stage, summed over the chunks a worker processed
+	struct FStageResult
+	{
+		int64 NumRecords;
+		int64 NumItems;
+		double Seconds;
+		//Microseconds per record
+		TArray<float> Latencies;
+
+		FStageResult()
+			: NumRecords(0)
+			, NumItems(0)
+			, Seconds(0.0)
+		{
+		}
+
+		void Add(int64 Items, double RecordSeconds)
+		{
+			NumRecords++;
+			NumItems += Items;
+			Seconds += RecordSeconds;
+			Latencies.Add((float)(RecordSeconds * 1e6));
+		}
+
+		void Append(const FStageResult& Other)
+		{
+			NumRecords += Other.NumRecords;
+			NumItems += Other.NumItems;
+			Seconds += Other.Seconds;
+			Latencies.Append(Other.Latencies);
+		}
+	};
+
+	struct FWorkItem
+	{
+		int32 Session;
+		int32 Chunk;
+	};
+
+	void FindSessions(const FString& Sessions, TArray<FString>& Paths)
+	{
+		TArray<FString> Entries;
+		Sessions.ParseIntoArray(Entries, TEXT("+"), true);
+		for (const FString& Entry : Entries)
+		{
+			if (IFileManager::Get().DirectoryExists(*Entry))
+			{
+				TArray<FString> Files;
+				IFileManager::Get().FindFiles(Files, *(Entry / TEXT("*.tses")), true, false);
+				Files.Sort();
+				for (const FString& File : Files)
+				{
+					Paths.Add(Entry / File);
+				}
+			}
+			else
+			{
+				Paths.Add(Entry);
+			}
+		}
+	}
+
+	bool WriteReport(const FString& Path, const TArray<FString>& StageNames, TArray<FStageResult>& Results, int32 NumSessions, int32 NumChunks, int32 NumThreads, double WallSeconds)
+	{
+		TangoReport Report({ TEXT("Stage"), TEXT("Records"), TEXT("Items"), TEXT("BusySeconds"), TEXT("RecordsPerSecond"), TEXT("ItemsPerSecond"), TEXT("WallItemsPerSecond"),
+			TEXT("MeanLatencyUs"), TEXT("P50LatencyUs"), TEXT("P95LatencyUs"), TEXT("P99LatencyUs"), TEXT("MaxLatencyUs") });
+		Report.AddField(TEXT("Sessions"), NumSessions, 0);
+		Report.AddField(TEXT("Chunks"), NumChunks, 0);
+		Report.AddField(TEXT("Threads"), NumThreads, 0);
+		Report.AddField(TEXT("WallSeconds"), WallSeconds, 6);
+		for (int32 Stage = 0; Stage < StageNames.Num(); ++Stage)
+		{
+			FStageResult& Result = Results[Stage];
+			Result.Latencies.Sort();
+			//Per busy second is what one core manages, per wall second what the whole run did
+			const double RecordsPerSecond = Result.Seconds > 0.0 ? Result.NumRecords / Result.Seconds : 0.0;
+			const double ItemsPerSecond = Result.Seconds > 0.0 ? Result.NumItems / Result.Seconds : 0.0;
+			const double WallItemsPerSecond = WallSeconds > 0.0 ? Result.NumItems / WallSeconds : 0.0;
+			const double MeanLatency = Result.NumRecords > 0 ? Result.Seconds * 1e6 / Result.NumRecords : 0.0;
+			const float MaxLatency = Result.Latencies.Num() > 0 ? Result.Latencies.Last() : 0.0f;
+			Report.AddRow();
+			Report.AddText(StageNames[Stage]);
+			Report.AddInt(Result.NumRecords);
+			Report.AddInt(Result.NumItems);
+			Report.AddNumber(Result.Seconds, 6);
+			Report.AddNumber(RecordsPerSecond, 1);
+			Report.AddNumber(ItemsPerSecond, 1);
+			Report.AddNumber(WallItemsPerSecond, 1);
+			Report.AddNumber(MeanLatency, 2);
+			Report.AddNumber(TangoReport::GetPercentile(Result.Latencies, 0.5f), 2);
+			Report.AddNumber(TangoReport::GetPercentile(Result.Latencies, 0.95f), 2);
+			Report.AddNumber(TangoReport::GetPercentile(Result.Latencies, 0.99f), 2);
+			Report.AddNumber(MaxLatency, 2);
+			UE_LOG(TangoPlugin, Display, TEXT("UTangoProcessSessionsCommandlet: %-16s %9lld records %12lld items %10.1f items/s per core, latency mean %.1f us, p95 %.1f us"),
+				*StageNames[Stage], Result.NumRecords, Result.NumItems, ItemsPerSecond, MeanLatency, TangoReport::GetPercentile(Result.Latencies, 0.95f));
+		}
+		return Report.Save(Path);
+	}
+}
+
+UTangoProcessSessionsCommandlet::UTangoProcessSessionsCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Runs the Tango offline stages over recorded sessions and reports their throughput.");
+	HelpUsage = TEXT("-run=TangoProcessSessions -Sessions=<File or directory>[+...] [-Report=<Path.csv or Path.json>] [-Stages=<Name>[+...]] [-Threads=<N>]");
+}
+
+int32 UTangoProcessSessionsCommandlet::Main(const FString& Params)
+{
+	FString Sessions;
+	if (!FParse::Value(*Params, TEXT("Sessions="), Sessions, false))
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoProcessSessionsCommandlet::Main: Usage: %s"), *HelpUsage);
+		return 1;
+	}
+	TArray<FString> Paths;
+	FindSessions(Sessions, Paths);
+
+	TArray<FString> StageNames;
+	FString Stages;
+	if (FParse::Value(*Params, TEXT("Stages="), Stages, false))
+	{
+		Stages.ParseIntoArray(StageNames, TEXT("+"), true);
+	}
+	else
+	{
+		StageNames = TangoOfflineStages::GetNames();
+	}
+	for (const FString& Name : StageNames)
+	{
+		TUniquePtr<ITangoOfflineStage> Probe(TangoOfflineStages::Create(Name));
+		if (!Probe.IsValid())
+		{
+			UE_LOG(TangoPlugin, Error, TEXT("UTangoProcessSessionsCommandlet::Main: Unknown stage %s"), *Name);
+			return 1;
+		}
+	}
+
+	int32 NumThreads = FPlatformProcess::SupportsMultithreading() ? FTaskGraphInterface::Get().GetNumWorkerThreads() + 1 : 1;
+	FParse::Value(*Params, TEXT("Threads="), NumThreads);
+	NumThreads = FMath::Max(NumThreads, 1);
+
+	FString ReportPath = TangoReport::GetDefaultPath(TEXT("ProcessSessions"));
+	FParse::Value(*Params, TEXT("Report="), ReportPath, false);
+
+	//Created here, the stages use its settings from the workers
+	const float MetersToWorldScale = UTangoDevice::Get().GetMetersToWorldScale();
+
+	TArray<TUniquePtr<TangoSessionReader>> Readers;
+	TArray<FWorkItem> WorkItems;
+	for (const FString& Path : Paths)
+	{
+		TUniquePtr<TangoSessionReader> Reader(new TangoSessionReader());
+		if (!Reader->Open(Path))
+		{
+			continue;
+		}
+		for (int32 Chunk = 0; Chunk < Reader->GetNumChunks(); ++Chunk)
+		{
+			FWorkItem Item = { Readers.Num(), Chunk };
+			WorkItems.Add(Item);
+		}
+		Readers.Add(MoveTemp(Reader));
+	}
+	if (Readers.Num() == 0)
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoProcessSessionsCommandlet::Main: No session could be opened from %s"), *Sessions);
+		return 1;
+	}
+	//Recordings do not contain the extrinsics, only the intrinsics, which select the extrinsics cached for that calibration.
+	//Without them the cameras sit in the device origin.
+	const uint32 CalibrationHash = TangoExtrinsicsCache::HashCalibration(Readers[0]->GetIntrinsics());
+	for (const TUniquePtr<TangoSessionReader>& Reader : Readers)
+	{
+		if (TangoExtrinsicsCache::HashCalibration(Reader->GetIntrinsics()) != CalibrationHash)
+		{
+			UE_LOG(TangoPlugin, Warning, TEXT("UTangoProcessSessionsCommandlet::Main: Sessions of different calibrations, all use the extrinsics of the first"));
+			break;
+		}
+	}
+	if (!TangoSpaceConversions::PrepareOfflineExtrinsics(CalibrationHash))
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("UTangoProcessSessionsCommandlet::Main: No cached extrinsics for calibration %08X, using cameras in the device origin"), CalibrationHash);
+	}
+	UE_LOG(TangoPlugin, Display, TEXT("UTangoProcessSessionsCommandlet::Main: %d sessions, %d chunks, %d stages on %d threads"), Readers.Num(), WorkItems.Num(), StageNames.Num(), NumThreads);
+
+	//Reading the chunk is reported like a stage, in front of the others.
+	//Over a mapped file only building the records costs nothing, so it also reads every payload byte once, which pages it in.
+	TArray<FString> ReportNames;
+	ReportNames.Add(TEXT("Read"));
+	ReportNames.Append(StageNames);
+	TArray<FStageResult> Results;
+	Results.SetNum(ReportNames.Num());
+	FCriticalSection ResultsLock;
+	FThreadSafeCounter NextItem;
+
+	const double Start = FPlatformTime::Seconds();
+	//Workers take chunks until none are left, so short and long sessions balance out
+	ParallelFor(NumThreads, [&](int32 Worker)
+	{
+		TArray<TUniquePtr<ITangoOfflineStage>> WorkerStages;
+		for (const FString& Name : StageNames)
+		{
+			WorkerStages.Emplace(TangoOfflineStages::Create(Name));
+		}
+		TArray<FStageResult> WorkerResults;
+		WorkerResults.SetNum(ReportNames.Num());
+		TArray<FTangoSessionRecord> Records;
+
+		for (int32 ItemIndex = NextItem.Increment() - 1; ItemIndex < WorkItems.Num(); ItemIndex = NextItem.Increment() - 1)
+		{
+			const FWorkItem& Item = WorkItems[ItemIndex];
+			const TangoSessionReader& Reader = *Readers[Item.Session];
+			Records.Reset();
+			const double ReadStart = FPlatformTime::Seconds();
+			if (!Reader.ReadChunk(Item.Chunk, Records))
+			{
+				continue;
+			}
+			uint32 Checksum = 0;
+			for (const FTangoSessionRecord& Record : Records)
+			{
+				Checksum = FCrc::MemCrc32(Record.Payload, Record.Size, Checksum);
+			}
+			WorkerResults[0].Add(Records.Num(), FPlatformTime::Seconds() - ReadStart);
+
+			//Every chunk starts without a color frame, the ones before it belong to another worker
+			FTangoOfflineContext Context;
+			Context.Intrinsics = &Reader.GetIntrinsics();
+			Context.MetersToWorldScale = MetersToWorldScale;
+			for (const FTangoSessionRecord& Record : Records)
+			{
+				const uint8* NV21 = nullptr;
+				if (const TangoSessionFormat::FColorFramePayload* Color = Record.GetColorFrame(NV21))
+				{
+					Context.ColorNV21 = NV21;
+					Context.ColorWidth = Color->Width;
+					Context.ColorHeight = Color->Height;
+					Context.ColorTimestamp = Record.Timestamp;
+				}
+				for (int32 Stage = 0; Stage < WorkerStages.Num(); ++Stage)
+				{
+					const double StageStart = FPlatformTime::Seconds();
+					const int64 Items = WorkerStages[Stage]->Process(Record, Context);
+					const double StageSeconds = FPlatformTime::Seconds() - StageStart;
+					if (Items >= 0)
+					{
+						WorkerResults[Stage + 1].Add(Items, StageSeconds);
+					}
+				}
+			}
+		}
+
+		FScopeLock ScopeLock(&ResultsLock);
+		for (int32 Stage = 0; Stage < Results.Num(); ++Stage)
+		{
+			Results[Stage].Append(WorkerResults[Stage]);
+		}
+	}, NumThreads == 1);
+	const double WallSeconds = FPlatformTime::Seconds() - Start;
+
+	UE_LOG(TangoPlugin, Display, TEXT("UTangoProcessSessionsCommandlet::Main: Processed in %.3f s"), WallSeconds);
+	if (!WriteReport(ReportPath, ReportNames, Results, Readers.Num(), WorkItems.Num(), NumThreads, WallSeconds))
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoProcessSessionsCommandlet::Main: Could not write %s"), *ReportPath);
+		return 1;
+	}
+	UE_LOG(TangoPlugin, Display, TEXT("UTangoProcessSessionsCommandlet::Main: Wrote %s"), *ReportPath);
+	return 0;
+}
@@ -0,0 +1,36 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "TangoProcessSessionsCommandlet.generated.h"
+
+/*
+ * Runs the registered offline stages over recorded sessions, as fast as all cores allow and without rendering,
+ * then writes the throughput and latency of every stage to a CSV or JSON report.
+ *
+ * UE4Editor-Cmd <Project> -run=TangoProcessSessions -Sessions=<File or directory>[+...] [-Report=<Path.csv or Path.json>] [-Stages=<Name>[+...]] [-Threads=<N>]
+ */
+UCLASS()
+class UTangoProcessSessionsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UTangoProcessSessionsCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,174 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoReport.h"
+
+TangoReport::TangoReport(const TArray<FString>& InColumns)
+	: Columns(InColumns)
+{
+}
+
+void TangoReport::AddField(const TCHAR* Key, const FString& Text)
+{
+	FCell Cell;
+	Cell.Value = Text;
+	Cell.bIsText = true;
+	FieldKeys.Add(Key);
+	Fields.Add(Cell);
+}
+
+void TangoReport::AddField(const TCHAR* Key, double Value, int32 Decimals)
+{
+	FieldKeys.Add(Key);
+	Fields.Add(MakeNumber(Value, Decimals));
+}
+
+void TangoReport::AddRow()
+{
+	Rows.AddDefaulted();
+	Rows.Last().Reserve(Columns.Num());
+}
+
+void TangoReport::AddText(const FString& Text)
+{
+	check(Rows.Num() > 0 && Rows.Last().Num() < Columns.Num());
+	FCell Cell;
+	Cell.Value = Text;
+	Cell.bIsText = true;
+	Rows.Last().Add(Cell);
+}
+
+void TangoReport::AddInt(int64 Value)
+{
+	check(Rows.Num() > 0 && Rows.Last().Num() < Columns.Num());
+	FCell Cell;
+	Cell.Value = FString::Printf(TEXT("%lld"), Value);
+	Cell.bIsText = false;
+	Rows.Last().Add(Cell);
+}
+
+void TangoReport::AddNumber(double Value, int32 Decimals)
+{
+	check(Rows.Num() > 0 && Rows.Last().Num() < Columns.Num());
+	Rows.Last().Add(MakeNumber(Value, Decimals));
+}
+
+bool TangoReport::Save(const FString& Path) const
+{
+	const bool bJson = FPaths::GetExtension(Path).Equals(TEXT("json"), ESearchCase::IgnoreCase);
+	FString Report;
+	if (bJson)
+	{
+		Report += TEXT("{\n");
+		for (int32 i = 0; i < Fields.Num(); ++i)
+		{
+			Report += FString::Printf(TEXT("\t\"%s\": %s,\n"), *EscapeJson(FieldKeys[i]), *ToJson(Fields[i]));
+		}
+		Report += TEXT("\t\"Rows\": [\n");
+		for (int32 Row = 0; Row < Rows.Num(); ++Row)
+		{
+			Report += TEXT("\t\t{ ");
+			for (int32 Column = 0; Column < Rows[Row].Num(); ++Column)
+			{
+				Report += FString::Printf(TEXT("%s\"%s\": %s"), Column > 0 ? TEXT(", ") : TEXT(""), *EscapeJson(Columns[Column]), *ToJson(Rows[Row][Column]));
+			}
+			Report += Row + 1 < Rows.Num() ? TEXT(" },\n") : TEXT(" }\n");
+		}
+		Report += TEXT("\t]\n}\n");
+	}
+	else
+	{
+		for (int32 Column = 0; Column < Columns.Num(); ++Column)
+		{
+			Report += Column > 0 ? TEXT(",") : TEXT("");
+			Report += EscapeCsv(Columns[Column]);
+		}
+		Report += TEXT("\n");
+		for (const TArray<FCell>& Row : Rows)
+		{
+			for (int32 Column = 0; Column < Row.Num(); ++Column)
+			{
+				Report += Column > 0 ? TEXT(",") : TEXT("");
+				Report += Row[Column].bIsText ? EscapeCsv(Row[Column].Value) : Row[Column].Value;
+			}
+			Report += TEXT("\n");
+		}
+	}
+	return FFileHelper::SaveStringToFile(Report, *Path);
+}
+
+FString TangoReport::GetDefaultPath(const TCHAR* Name)
+{
+	return FPaths::GameSavedDir() / TEXT("Tango") / FString::Printf(TEXT("%s-%s.csv"), Name, *FDateTime::Now().ToString());
+}
+
+float TangoReport::GetPercentile(const TArray<float>& SortedValues, float Percentile)
+{
+	if (SortedValues.Num() == 0)
+	{
+		return 0.0f;
+	}
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+	return SortedValues[Index];
+}
+
+TangoReport::FCell TangoReport::MakeNumber(double Value, int32 Decimals)
+{
+	FCell Cell;
+	Cell.Value = FString::Printf(*FString::Printf(TEXT("%%.%df"), Decimals), Value);
+	Cell.bIsText = false;
+	return Cell;
+}
+
+//RFC 4180: always quoted, quotes doubled, so commas and line breaks stay inside the field
+FString TangoReport::EscapeCsv(const FString& Text)
+{
+	return FString::Printf(TEXT("\"%s\""), *Text.Replace(TEXT("\""), TEXT("\"\"")));
+}
+
+//ReplaceCharWithEscapedChar would also escape single quotes, which JSON does not allow
+FString TangoReport::EscapeJson(const FString& Text)
+{
+	FString Result;
+	Result.Reserve(Text.Len());
+	for (int32 i = 0; i < Text.Len(); ++i)
+	{
+		const TCHAR Char = Text[i];
+		switch (Char)
+		{
+		case TEXT('"'): Result += TEXT("\\\""); break;
+		case TEXT('\\'): Result += TEXT("\\\\"); break;
+		case TEXT('\n'): Result += TEXT("\\n"); break;
+		case TEXT('\r'): Result += TEXT("\\r"); break;
+		case TEXT('\t'): Result += TEXT("\\t"); break;
+		default:
+			if (Char < 0x20)
+			{
+				Result += FString::Printf(TEXT("\\u%04x"), (uint32)Char);
+			}
+			else
+			{
+				Result += Char;
+			}
+		}
+	}
+	return Result;
+}
+
+FString TangoReport::ToJson(const FCell& Cell)
+{
+	return Cell.bIsText ? FString::Printf(TEXT("\"%s\""), *EscapeJson(Cell.Value)) : Cell.Value;
+}
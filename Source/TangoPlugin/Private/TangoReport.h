@@ -0,0 +1,59 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#pragma once
+
+/*
+ * A table of results the commandlets write to disk, as CSV or, for a .json path, as JSON.
+ * Rows are filled left to right with one value per column. Text is quoted and escaped for either format.
+ */
+class TangoReport
+{
+public:
+	TangoReport(const TArray<FString>& InColumns);
+
+	//Written at the top of JSON reports. CSV has no place for them, pass whatever has to be in every row as a column instead.
+	void AddField(const TCHAR* Key, const FString& Text);
+	void AddField(const TCHAR* Key, double Value, int32 Decimals);
+
+	void AddRow();
+	void AddText(const FString& Text);
+	void AddInt(int64 Value);
+	void AddNumber(double Value, int32 Decimals);
+
+	bool Save(const FString& Path) const;
+
+	//Saved/Tango/<Name>-<date>.csv
+	static FString GetDefaultPath(const TCHAR* Name);
+	//Nearest rank percentile of values sorted in ascending order, 0 without values.
+	static float GetPercentile(const TArray<float>& SortedValues, float Percentile);
+
+private:
+	struct FCell
+	{
+		FString Value;
+		bool bIsText;
+	};
+
+	static FCell MakeNumber(double Value, int32 Decimals);
+	static FString EscapeCsv(const FString& Text);
+	static FString EscapeJson(const FString& Text);
+	static FString ToJson(const FCell& Cell);
+
+	TArray<FString> Columns;
+	TArray<FString> FieldKeys;
+	TArray<FCell> Fields;
+	TArray<TArray<FCell>> Rows;
+};
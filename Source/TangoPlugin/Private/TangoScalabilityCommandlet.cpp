@@ -0,0 +1,304 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoScalabilityCommandlet.h"
+#include "TangoMotionComponent.h"
+#include "TangoPointCloudComponent.h"
+#include "TangoEventComponent.h"
+#include "TangoCoordinateConversions.h"
+#include "TangoDevice.h"
+#include "TangoHeadlessBackend.h"
+#include "TangoReport.h"
+
+namespace
+{
+	enum EScalabilityStage
+	{
+		STAGE_AddMotionComponent,
+		STAGE_CheckForChangeInRequests,
+		STAGE_DeviceMotionTick,
+		STAGE_BroadCastEvents,
+		STAGE_DeviceTick,
+		STAGE_Count
+	};
+
+	const TCHAR* StageNames[STAGE_Count] =
+	{
+		TEXT("AddTangoMotionComponent"),
+		TEXT("CheckForChangeInRequests"),
+		TEXT("UTangoDeviceMotion::Tick"),
+		TEXT("BroadCastEvents"),
+		TEXT("UTangoDevice::Tick")
+	};
+
+	struct FStageResult
+	{
+		int32 NumComponents;
+		int32 Stage;
+		//Microseconds per call, sorted once the level is done
+		TArray<float> Latencies;
+
+		double GetMean() const
+		{
+			double Sum = 0.0;
+			for (float Latency : Latencies)
+			{
+				Sum += Latency;
+			}
+			return Latencies.Num() > 0 ? Sum / Latencies.Num() : 0.0;
+		}
+	};
+
+	//Times one call on the game thread in microseconds
+	template <typename FunctionType>
+	void TimeCall(FStageResult& Result, FunctionType Function)
+	{
+		const double Start = FPlatformTime::Seconds();
+		Function();
+		Result.Latencies.Add((float)((FPlatformTime::Seconds() - Start) * 1e6));
+	}
+
+	//The pairs a motion component subscribes to. Every component follows the device, some also a camera or the area description,
+	//so the broadcast list has several groups like in a real scene.
+	void GetFramePairs(int32 Index, TArray<FTangoCoordinateFramePair>& Pairs)
+	{
+		Pairs.Reset();
+		Pairs.Add(FTangoCoordinateFramePair(ETangoCoordinateFrameType::START_OF_SERVICE, ETangoCoordinateFrameType::DEVICE));
+		if (Index % 2 == 1)
+		{
+			Pairs.Add(FTangoCoordinateFramePair(ETangoCoordinateFrameType::START_OF_SERVICE, ETangoCoordinateFrameType::CAMERA_COLOR));
+		}
+		if (Index % 3 == 2)
+		{
+			Pairs.Add(FTangoCoordinateFramePair(ETangoCoordinateFrameType::AREA_DESCRIPTION, ETangoCoordinateFrameType::DEVICE));
+		}
+	}
+
+	void PushPose(double Timestamp, ETangoCoordinateFrameType::Type BaseFrame)
+	{
+		FTangoBackendPose Pose;
+		Pose.Timestamp = Timestamp;
+		Pose.BaseFrame = BaseFrame;
+		Pose.TargetFrame = ETangoCoordinateFrameType::DEVICE;
+		Pose.StatusCode = ETangoPoseStatus::VALID;
+		Pose.Translation[0] = FMath::Cos(Timestamp);
+		Pose.Translation[1] = FMath::Sin(Timestamp);
+		Pose.Translation[2] = 0.0;
+		Pose.Orientation[0] = 0.0;
+		Pose.Orientation[1] = 0.0;
+		Pose.Orientation[2] = 0.0;
+		Pose.Orientation[3] = 1.0;
+		UTangoDevice::Get().OnPoseAvailable(Pose);
+	}
+
+	bool WriteReport(const FString& Path, const TArray<FStageResult>& Results, int32 NumTicks, int32 NumPoints)
+	{
+		TangoReport Report({ TEXT("Components"), TEXT("Stage"), TEXT("Calls"), TEXT("MeanUs"), TEXT("P50Us"), TEXT("P95Us"), TEXT("MaxUs"), TEXT("MeanNsPerComponent") });
+		Report.AddField(TEXT("Ticks"), NumTicks, 0);
+		Report.AddField(TEXT("Points"), NumPoints, 0);
+		for (const FStageResult& Result : Results)
+		{
+			const double Mean = Result.GetMean();
+			Report.AddRow();
+			Report.AddInt(Result.NumComponents);
+			Report.AddText(StageNames[Result.Stage]);
+			Report.AddInt(Result.Latencies.Num());
+			Report.AddNumber(Mean, 3);
+			Report.AddNumber(TangoReport::GetPercentile(Result.Latencies, 0.5f), 3);
+			Report.AddNumber(TangoReport::GetPercentile(Result.Latencies, 0.95f), 3);
+			Report.AddNumber(Result.Latencies.Num() > 0 ? Result.Latencies.Last() : 0.0f, 3);
+			Report.AddNumber(Mean * 1000.0 / Result.NumComponents, 2);
+		}
+		return Report.Save(Path);
+	}
+}
+
+UTangoScalabilityCommandlet::UTangoScalabilityCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Times how the Tango device fans poses, depth and events out to growing numbers of components.");
+	HelpUsage = TEXT("-run=TangoScalability [-Counts=<N>[+...]] [-Ticks=<N>] [-Points=<N>] [-Report=<Path.csv or Path.json>]");
+}
+
+int32 UTangoScalabilityCommandlet::Main(const FString& Params)
+{
+	TArray<int32> Counts;
+	FString CountsParam;
+	if (FParse::Value(*Params, TEXT("Counts="), CountsParam, false))
+	{
+		TArray<FString> Entries;
+		CountsParam.ParseIntoArray(Entries, TEXT("+"), true);
+		for (const FString& Entry : Entries)
+		{
+			Counts.Add(FMath::Max(FCString::Atoi(*Entry), 1));
+		}
+		Counts.Sort();
+	}
+	else
+	{
+		Counts = { 1, 10, 100, 250, 500, 1000 };
+	}
+	int32 NumTicks = 100;
+	FParse::Value(*Params, TEXT("Ticks="), NumTicks);
+	NumTicks = FMath::Max(NumTicks, 1);
+	int32 NumPoints = 10000;
+	FParse::Value(*Params, TEXT("Points="), NumPoints);
+	FString ReportPath = TangoReport::GetDefaultPath(TEXT("Scalability"));
+	FParse::Value(*Params, TEXT("Report="), ReportPath, false);
+
+	if (!TangoSpaceConversions::PrepareOfflineExtrinsics())
+	{
+		UE_LOG(TangoPlugin, Display, TEXT("UTangoScalabilityCommandlet::Main: No cached extrinsics, using cameras in the device origin"));
+	}
+
+	//Connects the headless backend without its thread, so only the data pushed below reaches the device and runs are reproducible
+#if !PLATFORM_ANDROID
+	TangoHeadlessBackend::Enable(false);
+#endif
+	UTangoDevice& Device = UTangoDevice::Get();
+	FTangoConfig Config = FTangoConfig();
+	Config.bEnableMotionTracking = true;
+	Config.bEnableDepthCapabilities = true;
+	FTangoRuntimeConfig RuntimeConfig = FTangoRuntimeConfig();
+	RuntimeConfig.bEnableDepth = true;
+	RuntimeConfig.RuntimeDepthFramerate = 5;
+	Device.StartTangoService(Config, RuntimeConfig);
+	if (!Device.IsTangoServiceRunning() || Device.GetTangoDeviceMotionPointer() == nullptr || Device.GetTangoDevicePointCloudPointer() == nullptr)
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoScalabilityCommandlet::Main: Could not connect the %s backend"), Device.GetBackend().GetName());
+		return 1;
+	}
+	UTangoDeviceMotion* Motion = Device.GetTangoDeviceMotionPointer();
+	//UTangoDevice keeps its override private, the engine ticks it through this interface too
+	FTickableGameObject& DeviceTickable = Device;
+
+	NumPoints = FMath::Clamp(NumPoints, 1, Device.GetTangoDevicePointCloudPointer()->GetMaxVertexCapacity());
+	TArray<float> Points;
+	Points.SetNumUninitialized(NumPoints * 3);
+	FRandomStream Random(1234);
+	for (float& Coordinate : Points)
+	{
+		Coordinate = Random.FRandRange(0.5f, 4.0f);
+	}
+	FTangoBackendPointCloud PointCloud;
+	PointCloud.NumPoints = NumPoints;
+	PointCloud.XYZ = reinterpret_cast<const float(*)[3]>(Points.GetData());
+	PointCloud.IJRows = 0;
+	PointCloud.IJCols = 0;
+	PointCloud.IJ = nullptr;
+
+	FTangoBackendEvent Event;
+	Event.Type = (int32)ETangoEventType::COLOR_CAMERA;
+	Event.Key = "ColorOverExposed";
+	Event.Value = "1.5";
+
+	//Service time of the first pushed frame
+	const double ServiceStart = 1e6;
+	const float DeltaTime = 1.0f / 60.0f;
+	int64 Tick = 0;
+
+	TArray<UTangoMotionComponent*> MotionComponents;
+	TArray<UObject*> Components;
+	TArray<FTangoCoordinateFramePair> Pairs;
+	TArray<FStageResult> Results;
+
+	for (int32 Count : Counts)
+	{
+		while (MotionComponents.Num() < Count)
+		{
+			UTangoMotionComponent* MotionComponent = NewObject<UTangoMotionComponent>(GetTransientPackage());
+			UTangoPointCloudComponent* PointCloudComponent = NewObject<UTangoPointCloudComponent>(GetTransientPackage());
+			UTangoEventComponent* EventComponent = NewObject<UTangoEventComponent>(GetTransientPackage());
+			//Motion components are only referenced weakly by the device
+			MotionComponent->AddToRoot();
+			//What the components do in BeginPlay, without needing a world
+			GetFramePairs(MotionComponents.Num(), Pairs);
+			MotionComponent->SetupPoseEvents(Pairs);
+			Device.PointCloudComponents.Add(PointCloudComponent);
+			Device.AttachTangoEventComponent(EventComponent);
+			MotionComponents.Add(MotionComponent);
+			Components.Add(MotionComponent);
+			Components.Add(PointCloudComponent);
+			Components.Add(EventComponent);
+		}
+		//The first rebuild after the growth is not what a steady frame costs
+		Motion->CheckForChangeInRequests();
+
+		const int32 FirstResult = Results.AddDefaulted(STAGE_Count);
+		for (int32 Stage = 0; Stage < STAGE_Count; ++Stage)
+		{
+			Results[FirstResult + Stage].NumComponents = Count;
+			Results[FirstResult + Stage].Stage = Stage;
+			Results[FirstResult + Stage].Latencies.Reserve(NumTicks);
+		}
+
+		for (int32 i = 0; i < NumTicks; ++i, ++Tick)
+		{
+			const double Timestamp = ServiceStart + Tick * DeltaTime;
+
+			//One component changes its subscription per frame, which dirties the broadcast list
+			const int32 Changed = (int32)(Tick % MotionComponents.Num());
+			GetFramePairs(Changed, Pairs);
+			UTangoMotionComponent* ChangedComponent = MotionComponents[Changed];
+			TimeCall(Results[FirstResult + STAGE_AddMotionComponent], [&]() { ChangedComponent->SetupPoseEvents(Pairs); });
+			TimeCall(Results[FirstResult + STAGE_CheckForChangeInRequests], [&]() { Motion->CheckForChangeInRequests(); });
+
+			PushPose(Timestamp, ETangoCoordinateFrameType::START_OF_SERVICE);
+			PushPose(Timestamp, ETangoCoordinateFrameType::AREA_DESCRIPTION);
+			TimeCall(Results[FirstResult + STAGE_DeviceMotionTick], [&]() { Motion->Tick(DeltaTime); });
+
+			Device.OnTangoEvent(Event);
+			TimeCall(Results[FirstResult + STAGE_BroadCastEvents], [&]() { Device.BroadCastEvents(); });
+
+			PointCloud.Timestamp = Timestamp;
+			Device.OnPointCloudAvailable(PointCloud);
+			Device.OnTangoEvent(Event);
+			TimeCall(Results[FirstResult + STAGE_DeviceTick], [&]() { DeviceTickable.Tick(DeltaTime); });
+		}
+
+		for (int32 Stage = 0; Stage < STAGE_Count; ++Stage)
+		{
+			FStageResult& Result = Results[FirstResult + Stage];
+			Result.Latencies.Sort();
+			UE_LOG(TangoPlugin, Display, TEXT("UTangoScalabilityCommandlet: %5d components %-26s mean %9.2f us, p95 %9.2f us, %8.2f ns per component"),
+				Count, StageNames[Stage], Result.GetMean(), TangoReport::GetPercentile(Result.Latencies, 0.95f), Result.GetMean() * 1000.0 / Count);
+		}
+	}
+
+	//Destroyed components are unsubscribed and nulled in the lists of the device, which drops them on its next tick
+	for (UTangoMotionComponent* MotionComponent : MotionComponents)
+	{
+		MotionComponent->RemoveFromRoot();
+	}
+	for (UObject* Component : Components)
+	{
+		Component->MarkPendingKill();
+	}
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	Device.StopTangoService();
+
+	if (!WriteReport(ReportPath, Results, NumTicks, NumPoints))
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("UTangoScalabilityCommandlet::Main: Could not write %s"), *ReportPath);
+		return 1;
+	}
+	UE_LOG(TangoPlugin, Display, TEXT("UTangoScalabilityCommandlet::Main: Wrote %s"), *ReportPath);
+	return 0;
+}
@@ -0,0 +1,37 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "TangoScalabilityCommandlet.generated.h"
+
+/*
+ * Subscribes growing numbers of motion, point cloud and event components to the device, feeds it synthetic poses, depth and events
+ * and times the game thread work that fans them out, to show where it stops scaling with the number of components.
+ *
+ * UE4Editor-Cmd <Project> -run=TangoScalability [-Counts=<N>[+...]] [-Ticks=<N>] [-Points=<N>] [-Report=<Path.csv or Path.json>]
+ */
+UCLASS()
+class UTangoScalabilityCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UTangoScalabilityCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,149 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+/*
+ * Layout of a recorded session. Little endian, every structure and payload is 8 byte aligned.
+ *
+ *   FFileHeader
+ *   Chunk*          FChunkHeader, then NumRecords times FRecordHeader and its payload
+ *   FIndexEntry*    one per chunk
+ *   FFooter
+ *
+ * The file is only ever appended to. A recording that was cut short has no index and footer, the chunk headers are enough to rebuild them.
+ */
+namespace TangoSessionFormat
+{
+	static const uint32 FileMagic = 0x53455354;		// "TSES"
+	static const uint32 ChunkMagic = 0x4b484354;	// "TCHK"
+	static const uint32 FooterMagic = 0x58444954;	// "TIDX"
+	static const uint32 Version = 1;
+
+	namespace ERecordType
+	{
+		enum Type
+		{
+			DEPTH = 1,
+			POSE = 2,
+			EVENT = 3,
+			INTRINSICS = 4,
+			COLOR_FRAME = 5,
+			NUM_TYPES
+		};
+	}
+
+	struct FFileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		//FDateTime ticks when the recording started
+		int64 CreationTime;
+	};
+
+	struct FChunkHeader
+	{
+		uint32 Magic;
+		uint32 NumRecords;
+		//Bytes of records following the header
+		uint64 Size;
+		double MinTimestamp;
+		//Largest timestamp in this or any earlier chunk, so chunks can be searched by time
+		double MaxTimestamp;
+	};
+
+	struct FRecordHeader
+	{
+		uint32 Type;
+		//Payload bytes, a multiple of 8
+		uint32 Size;
+		double Timestamp;
+	};
+
+	struct FIndexEntry
+	{
+		//Of the chunk header, from the start of the file
+		uint64 Offset;
+		double MinTimestamp;
+		double MaxTimestamp;
+		uint32 NumRecords;
+		uint32 Padding;
+	};
+
+	struct FFooter
+	{
+		uint64 IndexOffset;
+		uint32 NumChunks;
+		uint32 Magic;
+	};
+
+	//Followed by NumPoints * 3 floats (x, y, z in meters, depth camera frame) and IJRows * IJCols uint32 point indices
+	struct FDepthPayload
+	{
+		uint32 NumPoints;
+		uint32 IJRows;
+		uint32 IJCols;
+		uint32 Padding;
+	};
+
+	//As TangoPoseData delivers it
+	struct FPosePayload
+	{
+		int32 BaseFrame;
+		int32 TargetFrame;
+		int32 StatusCode;
+		int32 Padding;
+		double Translation[3];
+		double Orientation[4];
+	};
+
+	//Followed by the key and the value characters, without terminators
+	struct FEventPayload
+	{
+		int32 Type;
+		uint32 KeyLength;
+		uint32 ValueLength;
+		uint32 Padding;
+	};
+
+	//Camera and calibration as ETangoCameraType and ETangoCalibrationType
+	struct FIntrinsicsPayload
+	{
+		int32 CameraId;
+		int32 CalibrationType;
+		int32 Width;
+		int32 Height;
+		double Fx;
+		double Fy;
+		double Cx;
+		double Cy;
+		double Distortion[5];
+	};
+
+	//Followed by the NV21 image without row padding: Width * Height luma bytes, then Width * Height / 2 interleaved VU bytes
+	struct FColorFramePayload
+	{
+		int32 Width;
+		int32 Height;
+		int64 FrameNumber;
+	};
+
+	static_assert(sizeof(FFileHeader) == 16 && sizeof(FChunkHeader) == 32 && sizeof(FRecordHeader) == 16 && sizeof(FIndexEntry) == 32 && sizeof(FFooter) == 16,
+		"Session file structures must not change size");
+
+	inline uint32 Align(uint32 Size)
+	{
+		return (Size + 7) & ~7u;
+	}
+}
@@ -0,0 +1,445 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoSessionReader.h"
+
+#if PLATFORM_ANDROID || PLATFORM_LINUX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace TangoSessionFormat;
+
+namespace
+{
+	FString ToString(const uint8* Chars, uint32 Length)
+	{
+		FString Result;
+		Result.Reserve(Length);
+		for (uint32 i = 0; i < Length; ++i)
+		{
+			Result.AppendChar((TCHAR)Chars[i]);
+		}
+		return Result;
+	}
+}
+
+const FPosePayload* FTangoSessionRecord::GetPose() const
+{
+	return Type == ERecordType::POSE && Size >= sizeof(FPosePayload) ? reinterpret_cast<const FPosePayload*>(Payload) : nullptr;
+}
+
+const FIntrinsicsPayload* FTangoSessionRecord::GetIntrinsics() const
+{
+	return Type == ERecordType::INTRINSICS && Size >= sizeof(FIntrinsicsPayload) ? reinterpret_cast<const FIntrinsicsPayload*>(Payload) : nullptr;
+}
+
+const FDepthPayload* FTangoSessionRecord::GetDepth(const float*& XYZ, const uint32*& IJ) const
+{
+	if (Type != ERecordType::DEPTH || Size < sizeof(FDepthPayload))
+	{
+		return nullptr;
+	}
+	const FDepthPayload* Depth = reinterpret_cast<const FDepthPayload*>(Payload);
+	const uint64 PointBytes = sizeof(float) * 3 * (uint64)Depth->NumPoints;
+	const uint64 IJBytes = sizeof(uint32) * (uint64)Depth->IJRows * Depth->IJCols;
+	if (sizeof(FDepthPayload) + PointBytes + IJBytes > Size)
+	{
+		return nullptr;
+	}
+	XYZ = reinterpret_cast<const float*>(Payload + sizeof(FDepthPayload));
+	IJ = IJBytes > 0 ? reinterpret_cast<const uint32*>(Payload + sizeof(FDepthPayload) + PointBytes) : nullptr;
+	return Depth;
+}
+
+const FColorFramePayload* FTangoSessionRecord::GetColorFrame(const uint8*& NV21) const
+{
+	if (Type != ERecordType::COLOR_FRAME || Size < sizeof(FColorFramePayload))
+	{
+		return nullptr;
+	}
+	const FColorFramePayload* Color = reinterpret_cast<const FColorFramePayload*>(Payload);
+	if (Color->Width <= 0 || Color->Height <= 0 || sizeof(FColorFramePayload) + (uint64)Color->Width * Color->Height * 3 / 2 > Size)
+	{
+		return nullptr;
+	}
+	NV21 = Payload + sizeof(FColorFramePayload);
+	return Color;
+}
+
+const FEventPayload* FTangoSessionRecord::GetEvent(FString& Key, FString& Value) const
+{
+	if (Type != ERecordType::EVENT || Size < sizeof(FEventPayload))
+	{
+		return nullptr;
+	}
+	const FEventPayload* Event = reinterpret_cast<const FEventPayload*>(Payload);
+	if (sizeof(FEventPayload) + (uint64)Event->KeyLength + Event->ValueLength > Size)
+	{
+		return nullptr;
+	}
+	Key = ToString(Payload + sizeof(FEventPayload), Event->KeyLength);
+	Value = ToString(Payload + sizeof(FEventPayload) + Event->KeyLength, Event->ValueLength);
+	return Event;
+}
+
+TangoSessionReader::TangoSessionReader()
+	: Data(nullptr)
+	, Size(0)
+	, bMapped(false)
+	, ChunkIndex(0)
+	, RecordOffset(0)
+	, ChunkEnd(0)
+	, SeekTimestamp(0.0)
+{
+}
+
+TangoSessionReader::~TangoSessionReader()
+{
+	Close();
+}
+
+bool TangoSessionReader::Open(const FString& Path)
+{
+	Close();
+	if (!Map(Path))
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoSessionReader::Open: Could not read %s"), *Path);
+		return false;
+	}
+	const FFileHeader* Header = reinterpret_cast<const FFileHeader*>(Data);
+	if (Size < (int64)sizeof(FFileHeader) || Header->Magic != FileMagic || Header->Version != Version)
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoSessionReader::Open: %s is not a session file of version %u"), *Path, Version);
+		Close();
+		return false;
+	}
+	if (!ReadFooter())
+	{
+		RebuildIndex();
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoSessionReader::Open: %s has no index, the recording was not finished. Found %d complete chunks."), *Path, Index.Num());
+	}
+	ReadIntrinsics();
+	Seek(0.0);
+	return true;
+}
+
+void TangoSessionReader::Close()
+{
+	Unmap();
+	Index.Reset();
+	Intrinsics.Reset();
+	ChunkIndex = 0;
+	RecordOffset = ChunkEnd = 0;
+}
+
+bool TangoSessionReader::Map(const FString& Path)
+{
+#if PLATFORM_ANDROID || PLATFORM_LINUX
+	const FString FullPath = IFileManager::Get().ConvertToAbsolutePathForExternalAppForRead(*Path);
+	const int File = open(TCHAR_TO_UTF8(*FullPath), O_RDONLY);
+	if (File >= 0)
+	{
+		struct stat Stat;
+		void* Mapping = MAP_FAILED;
+		if (fstat(File, &Stat) == 0 && Stat.st_size > 0)
+		{
+			Mapping = mmap(nullptr, Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+		}
+		//The mapping keeps its own reference to the file
+		close(File);
+		if (Mapping != MAP_FAILED)
+		{
+			Data = static_cast<const uint8*>(Mapping);
+			Size = Stat.st_size;
+			bMapped = true;
+			return true;
+		}
+	}
+#endif
+	if (!FFileHelper::LoadFileToArray(LoadedData, *Path) || LoadedData.Num() == 0)
+	{
+		return false;
+	}
+	Data = LoadedData.GetData();
+	Size = LoadedData.Num();
+	return true;
+}
+
+void TangoSessionReader::Unmap()
+{
+#if PLATFORM_ANDROID || PLATFORM_LINUX
+	if (bMapped)
+	{
+		munmap(const_cast<uint8*>(Data), Size);
+	}
+#endif
+	bMapped = false;
+	LoadedData.Empty();
+	Data = nullptr;
+	Size = 0;
+}
+
+bool TangoSessionReader::ReadFooter()
+{
+	if (Size < (int64)(sizeof(FFileHeader) + sizeof(FFooter)))
+	{
+		return false;
+	}
+	const FFooter* Footer = reinterpret_cast<const FFooter*>(Data + Size - sizeof(FFooter));
+	if (Footer->Magic != FooterMagic || Footer->IndexOffset + (uint64)Footer->NumChunks * sizeof(FIndexEntry) + sizeof(FFooter) != (uint64)Size)
+	{
+		return false;
+	}
+	Index.SetNumUninitialized(Footer->NumChunks);
+	FMemory::Memcpy(Index.GetData(), Data + Footer->IndexOffset, Footer->NumChunks * sizeof(FIndexEntry));
+	return true;
+}
+
+void TangoSessionReader::RebuildIndex()
+{
+	Index.Reset();
+	int64 Offset = sizeof(FFileHeader);
+	while (Offset + (int64)sizeof(FChunkHeader) <= Size)
+	{
+		const FChunkHeader* Header = reinterpret_cast<const FChunkHeader*>(Data + Offset);
+		if (Header->Magic != ChunkMagic || Header->Size > (uint64)(Size - Offset - sizeof(FChunkHeader)))
+		{
+			break;
+		}
+		FIndexEntry Entry;
+		Entry.Offset = Offset;
+		Entry.MinTimestamp = Header->MinTimestamp;
+		Entry.MaxTimestamp = Header->MaxTimestamp;
+		Entry.NumRecords = Header->NumRecords;
+		Entry.Padding = 0;
+		Index.Add(Entry);
+		Offset += sizeof(FChunkHeader) + Header->Size;
+	}
+}
+
+void TangoSessionReader::ReadIntrinsics()
+{
+	//Recorded first thing, so they are in the first chunk
+	if (!BeginChunk(0))
+	{
+		return;
+	}
+	FTangoSessionRecord Record;
+	SeekTimestamp = -DBL_MAX;
+	while (ChunkIndex == 0 && Next(Record))
+	{
+		const FIntrinsicsPayload* Payload = Record.GetIntrinsics();
+		if (Payload == nullptr)
+		{
+			continue;
+		}
+		FTangoCameraIntrinsics Camera;
+		Camera.CameraID = (ETangoCameraType::Type)Payload->CameraId;
+		Camera.CalibrationType = (ETangoCalibrationType::Type)Payload->CalibrationType;
+		Camera.Width = Payload->Width;
+		Camera.Height = Payload->Height;
+		Camera.Fx = Payload->Fx;
+		Camera.Fy = Payload->Fy;
+		Camera.Cx = Payload->Cx;
+		Camera.Cy = Payload->Cy;
+		Camera.Distortion.SetNumUninitialized(5);
+		for (int32 i = 0; i < 5; ++i)
+		{
+			Camera.Distortion[i] = Payload->Distortion[i];
+		}
+		Intrinsics.Add(Camera);
+	}
+}
+
+double TangoSessionReader::GetStartTimestamp() const
+{
+	return Index.Num() > 0 ? Index[0].MinTimestamp : 0.0;
+}
+
+double TangoSessionReader::GetEndTimestamp() const
+{
+	return Index.Num() > 0 ? Index.Last().MaxTimestamp : 0.0;
+}
+
+bool TangoSessionReader::BeginChunk(int32 Chunk)
+{
+	ChunkIndex = Chunk;
+	if (!Index.IsValidIndex(Chunk))
+	{
+		return false;
+	}
+	const int64 Offset = Index[Chunk].Offset;
+	if (Offset + (int64)sizeof(FChunkHeader) > Size)
+	{
+		return false;
+	}
+	const FChunkHeader* Header = reinterpret_cast<const FChunkHeader*>(Data + Offset);
+	if (Header->Magic != ChunkMagic || Header->Size > (uint64)(Size - Offset - sizeof(FChunkHeader)))
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoSessionReader::BeginChunk: Chunk %d is damaged"), Chunk);
+		return false;
+	}
+	RecordOffset = Offset + sizeof(FChunkHeader);
+	ChunkEnd = RecordOffset + Header->Size;
+	return true;
+}
+
+void TangoSessionReader::Seek(double Timestamp)
+{
+	//The running maximum only grows, so all chunks before the first one reaching Timestamp are older.
+	int32 Low = 0;
+	int32 High = Index.Num();
+	while (Low < High)
+	{
+		const int32 Middle = (Low + High) / 2;
+		if (Index[Middle].MaxTimestamp < Timestamp)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+	SeekTimestamp = Timestamp;
+	if (!BeginChunk(Low))
+	{
+		RecordOffset = ChunkEnd = 0;
+	}
+}
+
+bool TangoSessionReader::Next(FTangoSessionRecord& Record)
+{
+	while (IsOpen() && ChunkIndex < Index.Num())
+	{
+		if (RecordOffset + (int64)sizeof(FRecordHeader) > ChunkEnd)
+		{
+			if (!BeginChunk(ChunkIndex + 1))
+			{
+				ChunkIndex = Index.Num();
+				return false;
+			}
+			continue;
+		}
+		const FRecordHeader* Header = reinterpret_cast<const FRecordHeader*>(Data + RecordOffset);
+		const int64 PayloadOffset = RecordOffset + sizeof(FRecordHeader);
+		if (PayloadOffset + Header->Size > ChunkEnd)
+		{
+			UE_LOG(TangoPlugin, Warning, TEXT("TangoSessionReader::Next: Record at %lld runs past its chunk"), RecordOffset);
+			RecordOffset = ChunkEnd;
+			continue;
+		}
+		RecordOffset = PayloadOffset + Header->Size;
+		if (Header->Timestamp < SeekTimestamp)
+		{
+			continue;
+		}
+		//Timestamps are only sorted per stream, so later records before the seek target are still returned
+		SeekTimestamp = -DBL_MAX;
+		Record.Type = Header->Type;
+		Record.Timestamp = Header->Timestamp;
+		Record.Payload = Data + PayloadOffset;
+		Record.Size = Header->Size;
+		return true;
+	}
+	return false;
+}
+
+bool TangoSessionReader::ReadChunk(int32 Chunk, TArray<FTangoSessionRecord>& Records) const
+{
+	if (!IsOpen() || !Index.IsValidIndex(Chunk))
+	{
+		return false;
+	}
+	const int64 Offset = Index[Chunk].Offset;
+	if (Offset + (int64)sizeof(FChunkHeader) > Size)
+	{
+		return false;
+	}
+	const FChunkHeader* Header = reinterpret_cast<const FChunkHeader*>(Data + Offset);
+	if (Header->Magic != ChunkMagic || Header->Size > (uint64)(Size - Offset - sizeof(FChunkHeader)))
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoSessionReader::ReadChunk: Chunk %d is damaged"), Chunk);
+		return false;
+	}
+	Records.Reserve(Records.Num() + Header->NumRecords);
+	int64 Position = Offset + sizeof(FChunkHeader);
+	const int64 End = Position + Header->Size;
+	while (Position + (int64)sizeof(FRecordHeader) <= End)
+	{
+		const FRecordHeader* RecordHeader = reinterpret_cast<const FRecordHeader*>(Data + Position);
+		const int64 PayloadOffset = Position + sizeof(FRecordHeader);
+		if (PayloadOffset + RecordHeader->Size > End)
+		{
+			UE_LOG(TangoPlugin, Warning, TEXT("TangoSessionReader::ReadChunk: Record at %lld runs past its chunk"), Position);
+			break;
+		}
+		FTangoSessionRecord& Record = Records[Records.AddUninitialized()];
+		Record.Type = RecordHeader->Type;
+		Record.Timestamp = RecordHeader->Timestamp;
+		Record.Payload = Data + PayloadOffset;
+		Record.Size = RecordHeader->Size;
+		Position = PayloadOffset + RecordHeader->Size;
+	}
+	return true;
+}
+
+/*
+ * Tango.Session.Info <Path>
+ */
+namespace
+{
+	void PrintSessionInfo(const TArray<FString>& Args)
+	{
+		if (Args.Num() < 1)
+		{
+			UE_LOG(TangoPlugin, Warning, TEXT("Tango.Session.Info: Needs the path of a session file"));
+			return;
+		}
+		TangoSessionReader Reader;
+		if (!Reader.Open(Args[0]))
+		{
+			return;
+		}
+		int64 Counts[ERecordType::NUM_TYPES] = {};
+		int64 Bytes[ERecordType::NUM_TYPES] = {};
+		const double Start = FPlatformTime::Seconds();
+		FTangoSessionRecord Record;
+		while (Reader.Next(Record))
+		{
+			if (Record.Type < ERecordType::NUM_TYPES)
+			{
+				Counts[Record.Type]++;
+				Bytes[Record.Type] += Record.Size;
+			}
+		}
+		const double Seconds = FPlatformTime::Seconds() - Start;
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.Session.Info: %d chunks, %.3f s of data from %.3f to %.3f, %d cameras with intrinsics, read in %.2f ms"),
+			Reader.GetNumChunks(), Reader.GetEndTimestamp() - Reader.GetStartTimestamp(), Reader.GetStartTimestamp(), Reader.GetEndTimestamp(), Reader.GetIntrinsics().Num(), Seconds * 1000.0);
+		const TCHAR* Names[ERecordType::NUM_TYPES] = { TEXT("unknown"), TEXT("depth"), TEXT("pose"), TEXT("event"), TEXT("intrinsics"), TEXT("color frame") };
+		for (int32 Type = ERecordType::DEPTH; Type < ERecordType::NUM_TYPES; ++Type)
+		{
+			UE_LOG(TangoPlugin, Log, TEXT("Tango.Session.Info: %-12s %8lld records, %10lld bytes"), Names[Type], Counts[Type], Bytes[Type]);
+		}
+	}
+
+	static FAutoConsoleCommand SessionInfoCommand(
+		TEXT("Tango.Session.Info"),
+		TEXT("Reads a session file and prints what it contains. Arguments: Path"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&PrintSessionInfo));
+}
@@ -0,0 +1,84 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoDataTypes.h"
+#include "TangoSessionFormat.h"
+
+//One record of a session file. Points into the mapped file, valid as long as the reader stays open.
+struct FTangoSessionRecord
+{
+	uint32 Type;
+	double Timestamp;
+	const uint8* Payload;
+	uint32 Size;
+
+	//Each returns nullptr if the record is of another type or too short for its contents.
+	const TangoSessionFormat::FPosePayload* GetPose() const;
+	const TangoSessionFormat::FIntrinsicsPayload* GetIntrinsics() const;
+	const TangoSessionFormat::FDepthPayload* GetDepth(const float*& XYZ, const uint32*& IJ) const;
+	const TangoSessionFormat::FColorFramePayload* GetColorFrame(const uint8*& NV21) const;
+	const TangoSessionFormat::FEventPayload* GetEvent(FString& Key, FString& Value) const;
+};
+
+/*
+ * Reads a file of TangoSessionRecorder. The file is memory mapped where the platform allows it, otherwise loaded as a whole.
+ * Recordings that were cut short are readable up to their last complete chunk.
+ */
+class TangoSessionReader
+{
+public:
+	TangoSessionReader();
+	~TangoSessionReader();
+
+	bool Open(const FString& Path);
+	void Close();
+	bool IsOpen() const { return Data != nullptr; }
+
+	int32 GetNumChunks() const { return Index.Num(); }
+	double GetStartTimestamp() const;
+	double GetEndTimestamp() const;
+	//Of all cameras that had intrinsics when the recording started
+	const TArray<FTangoCameraIntrinsics>& GetIntrinsics() const { return Intrinsics; }
+
+	//The next record returned is the first one at or after Timestamp. Finds the chunk with a binary search over the index.
+	void Seek(double Timestamp);
+	//Records in the order they were recorded. Returns false at the end of the file.
+	bool Next(FTangoSessionRecord& Record);
+	//Appends all records of one chunk. Does not touch the position of Next, so several threads can read chunks of the same file.
+	bool ReadChunk(int32 Chunk, TArray<FTangoSessionRecord>& Records) const;
+
+private:
+	bool Map(const FString& Path);
+	void Unmap();
+	bool ReadFooter();
+	void RebuildIndex();
+	bool BeginChunk(int32 Chunk);
+	void ReadIntrinsics();
+
+	const uint8* Data;
+	int64 Size;
+	bool bMapped;
+	TArray<uint8> LoadedData;
+	TArray<TangoSessionFormat::FIndexEntry> Index;
+	TArray<FTangoCameraIntrinsics> Intrinsics;
+
+	//Position of Next
+	int32 ChunkIndex;
+	int64 RecordOffset;
+	int64 ChunkEnd;
+	//Records before it are skipped until Next returned the first record after a Seek
+	double SeekTimestamp;
+};
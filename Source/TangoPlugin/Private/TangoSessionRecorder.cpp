@@ -0,0 +1,459 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoSessionRecorder.h"
+#include "TangoDevice.h"
+
+using namespace TangoSessionFormat;
+
+namespace
+{
+	//A chunk is written once it reaches this size or once its first record is this old, whichever comes first.
+	static const int32 ChunkSize = 1024 * 1024;
+	static const double MaxChunkDuration = 1.0;
+	//About 1.5 seconds of 720p color frames
+	static const int32 MaxQueuedBytes = 64 * 1024 * 1024;
+	//Producers do not wake the writer, it polls the queue instead.
+	static const uint32 PollIntervalMs = 20;
+}
+
+TangoSessionRecorder::TangoSessionRecorder()
+	: Thread(nullptr)
+	, WakeUpEvent(nullptr)
+	, bIsRecording(false)
+	, bRecordColor(false)
+	, Writer(nullptr)
+	, bWriteFailed(false)
+	, ChunkRecords(0)
+	, ChunkMinTimestamp(0.0)
+	, ChunkMaxTimestamp(0.0)
+	, ChunkStartTime(0.0)
+	, MaxTimestamp(0.0)
+{
+}
+
+TangoSessionRecorder::~TangoSessionRecorder()
+{
+	StopRecording();
+	if (WakeUpEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+		WakeUpEvent = nullptr;
+	}
+}
+
+bool TangoSessionRecorder::StartRecording(const FString& InPath, bool bRecordColorFrames)
+{
+	if (bIsRecording)
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoSessionRecorder::StartRecording: Already recording to %s"), *Path);
+		return false;
+	}
+	//A recording that stopped itself after a write error still has to be joined
+	StopRecording();
+	if (!FPlatformProcess::SupportsMultithreading())
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoSessionRecorder::StartRecording: Recording needs a writer thread"));
+		return false;
+	}
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(InPath), true);
+	Writer = IFileManager::Get().CreateFileWriter(*InPath);
+	if (Writer == nullptr)
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoSessionRecorder::StartRecording: Could not create %s"), *InPath);
+		return false;
+	}
+	Path = InPath;
+
+	FFileHeader Header;
+	Header.Magic = FileMagic;
+	Header.Version = Version;
+	Header.CreationTime = FDateTime::UtcNow().GetTicks();
+	Writer->Serialize(&Header, sizeof(Header));
+
+	//Records that raced the end of the last recording
+	FRecordBuffer Leftover;
+	while (Records.Dequeue(Leftover))
+	{
+	}
+	QueuedBytes.Reset();
+	NumRecords.Reset();
+	NumDroppedRecords.Reset();
+	NumChunks.Reset();
+	BytesWritten.Set(sizeof(Header));
+	ChunkData.Reset();
+	ChunkRecords = 0;
+	MaxTimestamp = 0.0;
+	Index.Reset();
+	bWriteFailed = false;
+
+	if (WakeUpEvent == nullptr)
+	{
+		WakeUpEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	}
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("TangoSessionRecorder"), 0, TPri_BelowNormal);
+	if (Thread == nullptr)
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoSessionRecorder::StartRecording: Could not start the writer thread"));
+		delete Writer;
+		Writer = nullptr;
+		return false;
+	}
+	bRecordColor = bRecordColorFrames;
+	FPlatformMisc::MemoryBarrier();
+	bIsRecording = true;
+
+	const ETangoCameraType::Type Cameras[] = { ETangoCameraType::COLOR, ETangoCameraType::DEPTH, ETangoCameraType::FISHEYE };
+	for (ETangoCameraType::Type Camera : Cameras)
+	{
+		const FTangoCameraIntrinsics Intrinsics = UTangoDevice::Get().GetCameraIntrinsics(Camera);
+		if (Intrinsics.Width > 0 && Intrinsics.Height > 0)
+		{
+			RecordIntrinsics(Intrinsics);
+		}
+	}
+	UE_LOG(TangoPlugin, Log, TEXT("TangoSessionRecorder::StartRecording: Recording to %s%s"), *Path, bRecordColor ? TEXT(" with color frames") : TEXT(""));
+	return true;
+}
+
+void TangoSessionRecorder::StopRecording()
+{
+	if (Thread == nullptr)
+	{
+		return;
+	}
+	bIsRecording = false;
+	Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	const FTangoSessionRecorderStats RecorderStats = GetStats();
+	UE_LOG(TangoPlugin, Log, TEXT("TangoSessionRecorder::StopRecording: Wrote %llu records in %llu chunks, %llu bytes, to %s. %llu records were dropped."),
+		RecorderStats.NumRecords, RecorderStats.NumChunks, RecorderStats.BytesWritten, *Path, RecorderStats.NumDroppedRecords);
+}
+
+TangoSessionRecorder::FRecordBuffer TangoSessionRecorder::BeginRecord(uint32 Type, double Timestamp, uint32 PayloadSize)
+{
+	const int32 Size = sizeof(FRecordHeader) + Align(PayloadSize);
+	if (QueuedBytes.Add(Size) + Size > MaxQueuedBytes)
+	{
+		QueuedBytes.Subtract(Size);
+		NumDroppedRecords.Increment();
+		return FRecordBuffer();
+	}
+	FRecordBuffer Record = MakeShareable(new TArray<uint8>());
+	Record->SetNumUninitialized(Size);
+	FRecordHeader* Header = reinterpret_cast<FRecordHeader*>(Record->GetData());
+	Header->Type = Type;
+	Header->Size = Align(PayloadSize);
+	Header->Timestamp = Timestamp;
+	//Padding, so files are reproducible
+	FMemory::Memzero(Record->GetData() + sizeof(FRecordHeader) + PayloadSize, Header->Size - PayloadSize);
+	return Record;
+}
+
+void TangoSessionRecorder::SubmitRecord(const FRecordBuffer& Record)
+{
+	Records.Enqueue(Record);
+	NumRecords.Increment();
+}
+
+void TangoSessionRecorder::RecordDepth(double Timestamp, const float (*XYZ)[3], int32 Count, const uint32* IJ, int32 IJRows, int32 IJCols)
+{
+	if (!bIsRecording || XYZ == nullptr || Count < 0)
+	{
+		return;
+	}
+	if (IJ == nullptr)
+	{
+		IJRows = IJCols = 0;
+	}
+	const uint32 PointBytes = sizeof(float) * 3 * Count;
+	const uint32 IJBytes = sizeof(uint32) * IJRows * IJCols;
+	FRecordBuffer Record = BeginRecord(ERecordType::DEPTH, Timestamp, sizeof(FDepthPayload) + PointBytes + IJBytes);
+	if (!Record.IsValid())
+	{
+		return;
+	}
+	uint8* Payload = Record->GetData() + sizeof(FRecordHeader);
+	FDepthPayload* Depth = reinterpret_cast<FDepthPayload*>(Payload);
+	Depth->NumPoints = Count;
+	Depth->IJRows = IJRows;
+	Depth->IJCols = IJCols;
+	Depth->Padding = 0;
+	FMemory::Memcpy(Payload + sizeof(FDepthPayload), XYZ, PointBytes);
+	if (IJBytes > 0)
+	{
+		FMemory::Memcpy(Payload + sizeof(FDepthPayload) + PointBytes, IJ, IJBytes);
+	}
+	SubmitRecord(Record);
+}
+
+void TangoSessionRecorder::RecordPose(double Timestamp, int32 BaseFrame, int32 TargetFrame, int32 StatusCode, const double* Translation, const double* Orientation)
+{
+	if (!bIsRecording)
+	{
+		return;
+	}
+	FRecordBuffer Record = BeginRecord(ERecordType::POSE, Timestamp, sizeof(FPosePayload));
+	if (!Record.IsValid())
+	{
+		return;
+	}
+	FPosePayload* Pose = reinterpret_cast<FPosePayload*>(Record->GetData() + sizeof(FRecordHeader));
+	Pose->BaseFrame = BaseFrame;
+	Pose->TargetFrame = TargetFrame;
+	Pose->StatusCode = StatusCode;
+	Pose->Padding = 0;
+	FMemory::Memcpy(Pose->Translation, Translation, sizeof(Pose->Translation));
+	FMemory::Memcpy(Pose->Orientation, Orientation, sizeof(Pose->Orientation));
+	SubmitRecord(Record);
+}
+
+void TangoSessionRecorder::RecordEvent(double Timestamp, int32 Type, const ANSICHAR* Key, const ANSICHAR* Value)
+{
+	if (!bIsRecording)
+	{
+		return;
+	}
+	const uint32 KeyLength = Key != nullptr ? FCStringAnsi::Strlen(Key) : 0;
+	const uint32 ValueLength = Value != nullptr ? FCStringAnsi::Strlen(Value) : 0;
+	FRecordBuffer Record = BeginRecord(ERecordType::EVENT, Timestamp, sizeof(FEventPayload) + KeyLength + ValueLength);
+	if (!Record.IsValid())
+	{
+		return;
+	}
+	uint8* Payload = Record->GetData() + sizeof(FRecordHeader);
+	FEventPayload* Event = reinterpret_cast<FEventPayload*>(Payload);
+	Event->Type = Type;
+	Event->KeyLength = KeyLength;
+	Event->ValueLength = ValueLength;
+	Event->Padding = 0;
+	FMemory::Memcpy(Payload + sizeof(FEventPayload), Key, KeyLength);
+	FMemory::Memcpy(Payload + sizeof(FEventPayload) + KeyLength, Value, ValueLength);
+	SubmitRecord(Record);
+}
+
+void TangoSessionRecorder::RecordIntrinsics(const FTangoCameraIntrinsics& Intrinsics)
+{
+	if (!bIsRecording)
+	{
+		return;
+	}
+	//Intrinsics do not change during a connection, so they are untimed
+	FRecordBuffer Record = BeginRecord(ERecordType::INTRINSICS, 0.0, sizeof(FIntrinsicsPayload));
+	if (!Record.IsValid())
+	{
+		return;
+	}
+	FIntrinsicsPayload* Payload = reinterpret_cast<FIntrinsicsPayload*>(Record->GetData() + sizeof(FRecordHeader));
+	Payload->CameraId = Intrinsics.CameraID;
+	Payload->CalibrationType = Intrinsics.CalibrationType;
+	Payload->Width = Intrinsics.Width;
+	Payload->Height = Intrinsics.Height;
+	Payload->Fx = Intrinsics.Fx;
+	Payload->Fy = Intrinsics.Fy;
+	Payload->Cx = Intrinsics.Cx;
+	Payload->Cy = Intrinsics.Cy;
+	for (int32 i = 0; i < 5; ++i)
+	{
+		Payload->Distortion[i] = Intrinsics.Distortion.IsValidIndex(i) ? Intrinsics.Distortion[i] : 0.0;
+	}
+	SubmitRecord(Record);
+}
+
+void TangoSessionRecorder::RecordColorFrame(const FTangoCameraFrame& Frame)
+{
+	const int32 ImageBytes = FTangoCameraFrame::GetNV21Size(Frame.Width, Frame.Height);
+	if (!IsRecordingColor() || Frame.Data.Num() < ImageBytes)
+	{
+		return;
+	}
+	FRecordBuffer Record = BeginRecord(ERecordType::COLOR_FRAME, Frame.Timestamp, sizeof(FColorFramePayload) + ImageBytes);
+	if (!Record.IsValid())
+	{
+		return;
+	}
+	uint8* Payload = Record->GetData() + sizeof(FRecordHeader);
+	FColorFramePayload* Color = reinterpret_cast<FColorFramePayload*>(Payload);
+	Color->Width = Frame.Width;
+	Color->Height = Frame.Height;
+	Color->FrameNumber = Frame.FrameNumber;
+	FMemory::Memcpy(Payload + sizeof(FColorFramePayload), Frame.Data.GetData(), ImageBytes);
+	SubmitRecord(Record);
+}
+
+FTangoSessionRecorderStats TangoSessionRecorder::GetStats() const
+{
+	FTangoSessionRecorderStats Result;
+	Result.NumRecords = NumRecords.GetValue();
+	Result.NumDroppedRecords = NumDroppedRecords.GetValue();
+	Result.NumChunks = NumChunks.GetValue();
+	Result.BytesWritten = BytesWritten.GetValue();
+	return Result;
+}
+
+uint32 TangoSessionRecorder::Run()
+{
+	while (!bStopping && !bWriteFailed)
+	{
+		WakeUpEvent->Wait(PollIntervalMs);
+		WriteQueuedRecords();
+		if (ChunkRecords > 0 && FPlatformTime::Seconds() - ChunkStartTime >= MaxChunkDuration)
+		{
+			FlushChunk();
+		}
+	}
+	WriteQueuedRecords();
+	FlushChunk();
+	if (!bWriteFailed)
+	{
+		WriteIndex();
+	}
+	Writer->Close();
+	delete Writer;
+	Writer = nullptr;
+	return 0;
+}
+
+void TangoSessionRecorder::Stop()
+{
+	bStopping = true;
+	if (WakeUpEvent != nullptr)
+	{
+		WakeUpEvent->Trigger();
+	}
+}
+
+void TangoSessionRecorder::WriteQueuedRecords()
+{
+	FRecordBuffer Record;
+	while (!bWriteFailed && Records.Dequeue(Record))
+	{
+		QueuedBytes.Subtract(Record->Num());
+		const double Timestamp = reinterpret_cast<const FRecordHeader*>(Record->GetData())->Timestamp;
+		if (ChunkRecords == 0)
+		{
+			ChunkStartTime = FPlatformTime::Seconds();
+			ChunkMinTimestamp = DBL_MAX;
+			ChunkMaxTimestamp = 0.0;
+		}
+		//Untimed records like the intrinsics do not count for the time range
+		if (Timestamp > 0.0)
+		{
+			ChunkMinTimestamp = FMath::Min(ChunkMinTimestamp, Timestamp);
+			ChunkMaxTimestamp = FMath::Max(ChunkMaxTimestamp, Timestamp);
+		}
+		ChunkData.Append(*Record);
+		ChunkRecords++;
+		if (ChunkData.Num() >= ChunkSize)
+		{
+			FlushChunk();
+		}
+	}
+}
+
+void TangoSessionRecorder::FlushChunk()
+{
+	if (ChunkRecords == 0 || bWriteFailed)
+	{
+		return;
+	}
+	MaxTimestamp = FMath::Max(MaxTimestamp, ChunkMaxTimestamp);
+	FChunkHeader Header;
+	Header.Magic = ChunkMagic;
+	Header.NumRecords = ChunkRecords;
+	Header.Size = ChunkData.Num();
+	Header.MinTimestamp = ChunkMinTimestamp != DBL_MAX ? ChunkMinTimestamp : MaxTimestamp;
+	Header.MaxTimestamp = MaxTimestamp;
+
+	FIndexEntry Entry;
+	Entry.Offset = Writer->Tell();
+	Entry.MinTimestamp = Header.MinTimestamp;
+	Entry.MaxTimestamp = Header.MaxTimestamp;
+	Entry.NumRecords = ChunkRecords;
+	Entry.Padding = 0;
+	Index.Add(Entry);
+
+	Writer->Serialize(&Header, sizeof(Header));
+	Writer->Serialize(ChunkData.GetData(), ChunkData.Num());
+	//Complete chunks survive a crash
+	Writer->Flush();
+	if (Writer->IsError())
+	{
+		//E.g. the storage is full. Without an index the reader recovers the complete chunks before this one.
+		UE_LOG(TangoPlugin, Error, TEXT("TangoSessionRecorder::FlushChunk: Writing to %s failed, stopping the recording"), *Path);
+		bWriteFailed = true;
+		bIsRecording = false;
+		return;
+	}
+	BytesWritten.Add(sizeof(Header) + ChunkData.Num());
+	NumChunks.Increment();
+	ChunkData.Reset();
+	ChunkRecords = 0;
+}
+
+void TangoSessionRecorder::WriteIndex()
+{
+	FFooter Footer;
+	Footer.IndexOffset = Writer->Tell();
+	Footer.NumChunks = Index.Num();
+	Footer.Magic = FooterMagic;
+	Writer->Serialize(Index.GetData(), Index.Num() * sizeof(FIndexEntry));
+	Writer->Serialize(&Footer, sizeof(Footer));
+	BytesWritten.Add(Index.Num() * sizeof(FIndexEntry) + sizeof(Footer));
+}
+
+/*
+ * Tango.Session.Record [Path] [color]
+ * Tango.Session.Stop
+ */
+namespace
+{
+	void StartSessionRecording(const TArray<FString>& Args)
+	{
+		FString Path = FPaths::GameSavedDir() / TEXT("Tango") / FString::Printf(TEXT("Session-%s.tses"), *FDateTime::Now().ToString());
+		bool bColor = false;
+		for (const FString& Arg : Args)
+		{
+			if (Arg.Equals(TEXT("color"), ESearchCase::IgnoreCase))
+			{
+				bColor = true;
+			}
+			else
+			{
+				Path = Arg;
+			}
+		}
+		UTangoDevice::Get().SessionRecorder.StartRecording(Path, bColor);
+	}
+
+	void StopSessionRecording(const TArray<FString>& Args)
+	{
+		UTangoDevice::Get().SessionRecorder.StopRecording();
+	}
+
+	static FAutoConsoleCommand StartSessionRecordingCommand(
+		TEXT("Tango.Session.Record"),
+		TEXT("Records depth, poses, events and intrinsics into a session file. Arguments: [Path] [color]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StartSessionRecording));
+
+	static FAutoConsoleCommand StopSessionRecordingCommand(
+		TEXT("Tango.Session.Stop"),
+		TEXT("Finishes the session recording"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StopSessionRecording));
+}
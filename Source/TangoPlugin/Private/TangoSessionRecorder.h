@@ -0,0 +1,99 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+#pragma once
+
+#include "TangoDataTypes.h"
+#include "TangoCameraFramePool.h"
+#include "TangoSessionFormat.h"
+
+struct FTangoSessionRecorderStats
+{
+	uint64 NumRecords = 0;
+	//Records thrown away because the writer fell too far behind
+	uint64 NumDroppedRecords = 0;
+	uint64 NumChunks = 0;
+	uint64 BytesWritten = 0;
+};
+
+/*
+ * Streams everything the service delivers into a session file, see TangoSessionFormat.h.
+ * Record calls come straight from the service callbacks and never block: the record is serialized into a buffer and queued,
+ * a writer thread packs the queue into chunks and appends them to the file. Once more than MaxQueuedBytes wait, records are dropped.
+ */
+class TangoSessionRecorder : public FRunnable
+{
+public:
+	TangoSessionRecorder();
+	virtual ~TangoSessionRecorder();
+
+	//Game thread. Opens the file, starts the writer and records the intrinsics of all cameras.
+	bool StartRecording(const FString& Path, bool bRecordColorFrames);
+	//Game thread. Writes the remaining records and the index, then closes the file.
+	void StopRecording();
+	bool IsRecording() const { return bIsRecording; }
+	//Color frames are large, they are only recorded on request
+	bool IsRecordingColor() const { return bIsRecording && bRecordColor; }
+	const FString& GetPath() const { return Path; }
+
+	//Can be called from any thread. Do nothing while not recording.
+	void RecordDepth(double Timestamp, const float (*XYZ)[3], int32 Count, const uint32* IJ, int32 IJRows, int32 IJCols);
+	void RecordPose(double Timestamp, int32 BaseFrame, int32 TargetFrame, int32 StatusCode, const double* Translation, const double* Orientation);
+	void RecordEvent(double Timestamp, int32 Type, const ANSICHAR* Key, const ANSICHAR* Value);
+	void RecordIntrinsics(const FTangoCameraIntrinsics& Intrinsics);
+	void RecordColorFrame(const FTangoCameraFrame& Frame);
+
+	FTangoSessionRecorderStats GetStats() const;
+
+	//FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	typedef TSharedPtr<TArray<uint8>, ESPMode::ThreadSafe> FRecordBuffer;
+
+	//Serialized record of PayloadSize bytes past the header, or an invalid buffer if the queue is full
+	FRecordBuffer BeginRecord(uint32 Type, double Timestamp, uint32 PayloadSize);
+	void SubmitRecord(const FRecordBuffer& Record);
+
+	void WriteQueuedRecords();
+	void FlushChunk();
+	void WriteIndex();
+
+	FRunnableThread* Thread;
+	FEvent* WakeUpEvent;
+	FThreadSafeBool bStopping;
+	volatile bool bIsRecording;
+	volatile bool bRecordColor;
+	FString Path;
+
+	TQueue<FRecordBuffer, EQueueMode::Mpsc> Records;
+	FThreadSafeCounter QueuedBytes;
+	FThreadSafeCounter64 NumRecords;
+	FThreadSafeCounter64 NumDroppedRecords;
+
+	//Only touched by the writer thread while recording
+	FArchive* Writer;
+	//Set once a chunk could not be written, nothing is written after that
+	bool bWriteFailed;
+	TArray<uint8> ChunkData;
+	uint32 ChunkRecords;
+	double ChunkMinTimestamp;
+	double ChunkMaxTimestamp;
+	double ChunkStartTime;
+	double MaxTimestamp;
+	TArray<TangoSessionFormat::FIndexEntry> Index;
+	FThreadSafeCounter64 NumChunks;
+	FThreadSafeCounter64 BytesWritten;
+};
@@ -0,0 +1,53 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#pragma once
+
+#include "Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("Tango"), STATGROUP_Tango, STATCAT_Advanced);
+
+//Game thread
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Device Tick"), STAT_TangoDeviceTick, STATGROUP_Tango, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Image TickByDevice"), STAT_TangoImageTick, STATGROUP_Tango, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Point Cloud TickByDevice"), STAT_TangoPointCloudTick, STATGROUP_Tango, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pose Broadcast"), STAT_TangoPoseBroadcast, STATGROUP_Tango, );
+//Any thread. Static pairs are answered from the cached extrinsics, everything else asks the service.
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetPoseAtTime Service"), STAT_TangoGetPoseAtTimeService, STATGROUP_Tango, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetPoseAtTime Cached"), STAT_TangoGetPoseAtTimeCached, STATGROUP_Tango, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Points Proxy Build"), STAT_TangoProxyBuild, STATGROUP_Tango, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("View Extension Gather"), STAT_TangoViewGather, STATGROUP_Tango, );
+//Render thread
+DECLARE_CYCLE_STAT_EXTERN(TEXT("View Extension Late Update"), STAT_TangoLateUpdate, STATGROUP_Tango, );
+
+//Of the latest frame at render thread submission, in milliseconds
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Pose Age (ms)"), STAT_TangoPoseAge, STATGROUP_Tango, );
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Image Age (ms)"), STAT_TangoImageAge, STATGROUP_Tango, );
+
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Point Cloud Buffers"), STAT_TangoPointCloudMemory, STATGROUP_Tango, );
+
+//Per stream: received from the backend, handed to consumers, and lost on the way because a newer one replaced it or it did not fit.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Poses Received"), STAT_TangoPosesReceived, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Poses Processed"), STAT_TangoPosesProcessed, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Poses Dropped"), STAT_TangoPosesDropped, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Depth Frames Received"), STAT_TangoDepthReceived, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Depth Frames Processed"), STAT_TangoDepthProcessed, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Depth Frames Dropped"), STAT_TangoDepthDropped, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Color Frames Received"), STAT_TangoColorReceived, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Color Frames Processed"), STAT_TangoColorProcessed, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Color Frames Dropped"), STAT_TangoColorDropped, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Camera Textures Received"), STAT_TangoTexturesReceived, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Camera Textures Processed"), STAT_TangoTexturesProcessed, STATGROUP_Tango, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Camera Textures Dropped"), STAT_TangoTexturesDropped, STATGROUP_Tango, );
@@ -0,0 +1,254 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoStreamMonitor.h"
+#include "TangoDevice.h"
+
+namespace
+{
+	static TAutoConsoleVariable<float> CVarStallThreshold(
+		TEXT("Tango.StreamMonitor.StallThreshold"),
+		250.0f,
+		TEXT("Milliseconds without an update after which a Tango stream counts as stalled and OnTangoStreamStalled fires."));
+
+	const TCHAR* GetStreamName(int32 Stream)
+	{
+		static const TCHAR* Names[TangoStreamMonitor::NumStreams] = { TEXT("Pose"), TEXT("Depth"), TEXT("ColorFrame"), TEXT("CameraTexture") };
+		return Stream >= 0 && Stream < TangoStreamMonitor::NumStreams ? Names[Stream] : TEXT("Unknown");
+	}
+}
+
+void TangoStreamMonitor::FIntervalHistogram::Add(int64 Microseconds)
+{
+	const int32 Bucket = Microseconds <= 1 ? 0 : FMath::Min((int32)(4.0 * FMath::Log2((double)Microseconds)), NumBuckets - 1);
+	Buckets[Bucket].Increment();
+}
+
+float TangoStreamMonitor::FIntervalHistogram::GetPercentile(float Percentile) const
+{
+	int32 Counts[NumBuckets];
+	int64 Total = 0;
+	for (int32 i = 0; i < NumBuckets; ++i)
+	{
+		Counts[i] = Buckets[i].GetValue();
+		Total += Counts[i];
+	}
+	if (Total == 0)
+	{
+		return 0.0f;
+	}
+	const int64 Rank = FMath::Max<int64>(1, (int64)FMath::CeilToDouble(Total * Percentile / 100.0));
+	int64 Seen = 0;
+	int32 Bucket = 0;
+	for (; Bucket < NumBuckets - 1; ++Bucket)
+	{
+		Seen += Counts[Bucket];
+		if (Seen >= Rank)
+		{
+			break;
+		}
+	}
+	return (float)(FMath::Pow(2.0f, (Bucket + 0.5f) / 4.0f) / 1000.0f);
+}
+
+void TangoStreamMonitor::FIntervalHistogram::Reset()
+{
+	for (FThreadSafeCounter& Bucket : Buckets)
+	{
+		Bucket.Reset();
+	}
+}
+
+TangoStreamMonitor::TangoStreamMonitor()
+{
+	for (FStream& State : Streams)
+	{
+		State.bIsEnabled = 1;
+	}
+	Reset();
+}
+
+void TangoStreamMonitor::RecordArrival(ETangoStreamType::Type Stream, double Timestamp)
+{
+	FStream& State = Streams[Stream];
+	//Callbacks that were already running when the stream got turned off
+	if (!State.bIsEnabled)
+	{
+		return;
+	}
+	const int64 Now = (int64)FPlatformTime::Cycles64();
+	const int64 TimestampMicroseconds = (int64)(Timestamp * 1e6);
+	if (TimestampMicroseconds > 0)
+	{
+		const int64 PreviousTimestamp = State.LastTimestamp.Set(TimestampMicroseconds);
+		if (PreviousTimestamp == TimestampMicroseconds)
+		{
+			return;
+		}
+		if (PreviousTimestamp > 0 && TimestampMicroseconds > PreviousTimestamp)
+		{
+			State.ServiceIntervals.Add(TimestampMicroseconds - PreviousTimestamp);
+		}
+	}
+	State.NumArrivals.Increment();
+	FPlatformAtomics::InterlockedExchange(&State.bStallReported, 0);
+	const int64 PreviousArrival = State.LastArrivalCycles.Set(Now);
+	if (PreviousArrival == 0)
+	{
+		return;
+	}
+	const int64 Interval = (int64)(FPlatformTime::ToSeconds64(Now - PreviousArrival) * 1e6);
+	State.ArrivalIntervals.Add(Interval);
+	if (Interval > (int64)(GetStallThreshold() * 1e6))
+	{
+		State.NumStalls.Increment();
+	}
+	const int32 IntervalClamped = (int32)FMath::Min<int64>(Interval, MAX_int32);
+	int32 Max = State.MaxIntervalMicroseconds;
+	while (IntervalClamped > Max)
+	{
+		const int32 Previous = FPlatformAtomics::InterlockedCompareExchange(&State.MaxIntervalMicroseconds, IntervalClamped, Max);
+		if (Previous == Max)
+		{
+			break;
+		}
+		Max = Previous;
+	}
+}
+
+void TangoStreamMonitor::CheckForStalls(TArray<FTangoStreamStatistics>& NewStalls)
+{
+	const double Threshold = GetStallThreshold();
+	const int64 Now = (int64)FPlatformTime::Cycles64();
+	for (int32 Stream = 0; Stream < NumStreams; ++Stream)
+	{
+		FStream& State = Streams[Stream];
+		const int64 LastArrival = State.LastArrivalCycles.GetValue();
+		if (!State.bIsEnabled || LastArrival == 0 || FPlatformTime::ToSeconds64(Now - LastArrival) <= Threshold)
+		{
+			continue;
+		}
+		//Only the first check of a stall reports it
+		if (FPlatformAtomics::InterlockedExchange(&State.bStallReported, 1) == 0)
+		{
+			UE_LOG(TangoPlugin, Warning, TEXT("TangoStreamMonitor::CheckForStalls: %s stream delivered nothing for %.0f ms"),
+				GetStreamName(Stream), FPlatformTime::ToSeconds64(Now - LastArrival) * 1000.0);
+			NewStalls.Add(GetStatistics((ETangoStreamType::Type)Stream));
+		}
+	}
+}
+
+FTangoStreamStatistics TangoStreamMonitor::GetStatistics(ETangoStreamType::Type Stream) const
+{
+	FTangoStreamStatistics Statistics;
+	//Blueprints can pass any byte
+	if (Stream < 0 || Stream >= NumStreams)
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("TangoStreamMonitor::GetStatistics: Unknown stream %d"), (int32)Stream);
+		return Statistics;
+	}
+	const FStream& State = Streams[Stream];
+	Statistics.Stream = Stream;
+	Statistics.NumArrivals = State.NumArrivals.GetValue();
+	Statistics.IntervalP50 = State.ArrivalIntervals.GetPercentile(50.0f);
+	Statistics.IntervalP95 = State.ArrivalIntervals.GetPercentile(95.0f);
+	Statistics.IntervalP99 = State.ArrivalIntervals.GetPercentile(99.0f);
+	Statistics.MaxInterval = State.MaxIntervalMicroseconds / 1000.0f;
+	Statistics.ServiceIntervalP50 = State.ServiceIntervals.GetPercentile(50.0f);
+	Statistics.ServiceIntervalP99 = State.ServiceIntervals.GetPercentile(99.0f);
+	Statistics.NumStalls = State.NumStalls.GetValue();
+	const int64 LastArrival = State.LastArrivalCycles.GetValue();
+	if (State.bIsEnabled && LastArrival != 0)
+	{
+		Statistics.SecondsSinceLastArrival = (float)FPlatformTime::ToSeconds64((int64)FPlatformTime::Cycles64() - LastArrival);
+		Statistics.bIsStalled = Statistics.SecondsSinceLastArrival > GetStallThreshold();
+	}
+	return Statistics;
+}
+
+void TangoStreamMonitor::Reset()
+{
+	for (FStream& State : Streams)
+	{
+		ResetStream(State);
+	}
+}
+
+void TangoStreamMonitor::ResetStream(FStream& State)
+{
+	State.ArrivalIntervals.Reset();
+	State.ServiceIntervals.Reset();
+	State.LastArrivalCycles.Reset();
+	State.LastTimestamp.Reset();
+	State.NumArrivals.Reset();
+	State.NumStalls.Reset();
+	State.MaxIntervalMicroseconds = 0;
+	State.bStallReported = 0;
+}
+
+void TangoStreamMonitor::SetRuntimeConfig(const FTangoRuntimeConfig& RuntimeConfig)
+{
+	//A depth framerate of 0 turns the depth stream off as well
+	SetStreamEnabled(ETangoStreamType::DEPTH, RuntimeConfig.bEnableDepth && RuntimeConfig.RuntimeDepthFramerate > 0);
+	//Only the texture callback follows the color camera setting, color frames keep coming
+	SetStreamEnabled(ETangoStreamType::CAMERA_TEXTURE, RuntimeConfig.bEnableColorCamera);
+}
+
+void TangoStreamMonitor::SetStreamEnabled(ETangoStreamType::Type Stream, bool bEnabled)
+{
+	FStream& State = Streams[Stream];
+	if (FPlatformAtomics::InterlockedExchange(&State.bIsEnabled, bEnabled ? 1 : 0) != (bEnabled ? 1 : 0))
+	{
+		//Also drops what a late callback recorded while the stream was off
+		ResetStream(State);
+	}
+}
+
+double TangoStreamMonitor::GetStallThreshold()
+{
+	return FMath::Max(CVarStallThreshold.GetValueOnAnyThread(), 1.0f) / 1000.0;
+}
+
+/*
+ * Tango.StreamStats [reset]
+ * Prints the arrival intervals and stalls of every stream since the last connection.
+ */
+namespace
+{
+	void PrintStreamStats(const TArray<FString>& Args)
+	{
+		TangoStreamMonitor& Monitor = UTangoDevice::Get().StreamMonitor;
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			Monitor.Reset();
+			UE_LOG(TangoPlugin, Log, TEXT("Tango.StreamStats: Statistics cleared"));
+			return;
+		}
+		UE_LOG(TangoPlugin, Log, TEXT("Tango.StreamStats: stall threshold %.0f ms, intervals in ms"), TangoStreamMonitor::GetStallThreshold() * 1000.0);
+		for (int32 Stream = 0; Stream < TangoStreamMonitor::NumStreams; ++Stream)
+		{
+			const FTangoStreamStatistics Statistics = Monitor.GetStatistics((ETangoStreamType::Type)Stream);
+			UE_LOG(TangoPlugin, Log, TEXT("Tango.StreamStats: %-13s %7d arrivals, p50 %7.2f p95 %7.2f p99 %7.2f max %8.2f, service p50 %7.2f p99 %7.2f, %d stalls%s"),
+				GetStreamName(Stream), Statistics.NumArrivals, Statistics.IntervalP50, Statistics.IntervalP95, Statistics.IntervalP99, Statistics.MaxInterval,
+				Statistics.ServiceIntervalP50, Statistics.ServiceIntervalP99, Statistics.NumStalls, Statistics.bIsStalled ? TEXT(", stalled now") : TEXT(""));
+		}
+	}
+
+	static FAutoConsoleCommand StreamStatsCommand(
+		TEXT("Tango.StreamStats"),
+		TEXT("Prints arrival jitter and stalls of the pose, depth and color streams. Argument: [reset]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&PrintStreamStats));
+}
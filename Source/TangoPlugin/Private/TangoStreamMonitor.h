@@ -0,0 +1,84 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#pragma once
+
+#include "TangoDataTypes.h"
+
+/*
+ * Watches how regularly the service streams arrive. Every callback records the time since the previous one of its stream,
+ * and the difference of their service timestamps, into histograms that are only touched with atomics.
+ * A stream is stalled once nothing arrived for longer than Tango.StreamMonitor.StallThreshold.
+ * Streams the runtime config turned off are not watched, so stopping them on purpose is no stall.
+ */
+class TangoStreamMonitor
+{
+public:
+	static const int32 NumStreams = ETangoStreamType::CAMERA_TEXTURE + 1;
+
+	TangoStreamMonitor();
+
+	//Any thread. Timestamp is the service time of the update, 0 if the callback has none.
+	//Arrivals with the timestamp of the previous one are ignored, so a pose update counts once however many pairs it has.
+	void RecordArrival(ETangoStreamType::Type Stream, double Timestamp = 0.0);
+	//Game thread: adds the streams that went stalled since the last call. Streams that never delivered anything are not watched.
+	void CheckForStalls(TArray<FTangoStreamStatistics>& NewStalls);
+	FTangoStreamStatistics GetStatistics(ETangoStreamType::Type Stream) const;
+	//Forgets all arrivals, e.g. because the service was (re)connected
+	void Reset();
+	//Game thread: stops watching the streams the config turns off, and starts over with the ones it turns back on
+	void SetRuntimeConfig(const FTangoRuntimeConfig& RuntimeConfig);
+
+	//In seconds
+	static double GetStallThreshold();
+
+private:
+	//Quarter octaves of microseconds, up to about 16 seconds
+	class FIntervalHistogram
+	{
+	public:
+		static const int32 NumBuckets = 96;
+
+		void Add(int64 Microseconds);
+		//Center of the bucket that holds the percentile, in milliseconds
+		float GetPercentile(float Percentile) const;
+		void Reset();
+
+	private:
+		FThreadSafeCounter Buckets[NumBuckets];
+	};
+
+	struct FStream
+	{
+		FIntervalHistogram ArrivalIntervals;
+		FIntervalHistogram ServiceIntervals;
+		//FPlatformTime::Cycles64 of the last arrival, 0 before the first
+		FThreadSafeCounter64 LastArrivalCycles;
+		//Service timestamp of the last arrival in microseconds
+		FThreadSafeCounter64 LastTimestamp;
+		FThreadSafeCounter NumArrivals;
+		FThreadSafeCounter NumStalls;
+		volatile int32 MaxIntervalMicroseconds;
+		//Set once CheckForStalls reported the current stall, cleared by the next arrival
+		volatile int32 bStallReported;
+		//Cleared while the runtime config has the stream turned off, kept by Reset
+		volatile int32 bIsEnabled;
+	};
+
+	void SetStreamEnabled(ETangoStreamType::Type Stream, bool bEnabled);
+	static void ResetStream(FStream& State);
+
+	FStream Streams[NumStreams];
+};
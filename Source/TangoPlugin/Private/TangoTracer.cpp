@@ -0,0 +1,262 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#include "TangoPluginPrivatePCH.h"
+#include "TangoTracer.h"
+
+namespace
+{
+	static TAutoConsoleVariable<int32> CVarTraceEventsPerThread(
+		TEXT("Tango.Trace.EventsPerThread"),
+		65536,
+		TEXT("Size of the trace buffer of every thread, in events. Only applies to buffers that are allocated after the change."));
+
+	//Only written by its thread, read by Dump
+	struct FThreadBuffer
+	{
+		uint32 ThreadId;
+		FString ThreadName;
+		//Empty after Start released it, allocated again by the next event of the thread
+		TArray<FTangoTraceEvent> Events;
+		//Events written in Trace, published after the event
+		volatile int32 NumEvents;
+		volatile int32 NumDropped;
+		int32 Trace;
+		//Held by the thread while it adds an event and by Start while it releases Events
+		volatile int32 bInUse;
+	};
+
+	FCriticalSection BuffersLock;
+	TArray<TSharedPtr<FThreadBuffer>> Buffers;
+	//Incremented by every Start, buffers of an older trace are reset by their thread on the next event
+	volatile int32 CurrentTrace = 0;
+	double TraceStartTime = 0.0;
+
+	int32 GetEventsPerThread()
+	{
+		return FMath::Max(CVarTraceEventsPerThread.GetValueOnAnyThread(), 1024);
+	}
+
+	FThreadBuffer* CreateThreadBuffer()
+	{
+		TSharedPtr<FThreadBuffer> Buffer = MakeShareable(new FThreadBuffer());
+		Buffer->ThreadId = FPlatformTLS::GetCurrentThreadId();
+		const FRunnableThread* Thread = FRunnableThread::GetRunnableThread();
+		if (IsInGameThread())
+		{
+			Buffer->ThreadName = TEXT("GameThread");
+		}
+		else if (IsInActualRenderingThread())
+		{
+			Buffer->ThreadName = TEXT("RenderThread");
+		}
+		else if (Thread != nullptr)
+		{
+			Buffer->ThreadName = Thread->GetThreadName();
+		}
+		else
+		{
+			//Threads of the service that call into the plugin
+			Buffer->ThreadName = FString::Printf(TEXT("Thread %u"), Buffer->ThreadId);
+		}
+		Buffer->Events.SetNumUninitialized(GetEventsPerThread());
+		Buffer->NumEvents = 0;
+		Buffer->NumDropped = 0;
+		Buffer->Trace = CurrentTrace;
+		Buffer->bInUse = 0;
+		FScopeLock ScopeLock(&BuffersLock);
+		Buffers.Add(Buffer);
+		return Buffer.Get();
+	}
+
+	FThreadBuffer* GetThreadBuffer()
+	{
+		static const uint32 TlsSlot = FPlatformTLS::AllocTlsSlot();
+		FThreadBuffer* Buffer = static_cast<FThreadBuffer*>(FPlatformTLS::GetTlsValue(TlsSlot));
+		if (Buffer == nullptr)
+		{
+			Buffer = CreateThreadBuffer();
+			FPlatformTLS::SetTlsValue(TlsSlot, Buffer);
+		}
+		return Buffer;
+	}
+}
+
+volatile int32 TangoTracer::bEnabled = 0;
+
+void TangoTracer::Start()
+{
+	//Threads that added nothing to the last trace may have exited, there is no hook to free their buffer when they do.
+	//So the memory of those buffers is released here, a thread that is still alive allocates it again with its next event.
+	const int32 PreviousTrace = CurrentTrace;
+	int32 NumReleased = 0;
+	{
+		FScopeLock ScopeLock(&BuffersLock);
+		for (const TSharedPtr<FThreadBuffer>& Buffer : Buffers)
+		{
+			if (Buffer->Trace != PreviousTrace && FPlatformAtomics::InterlockedCompareExchange(&Buffer->bInUse, 1, 0) == 0)
+			{
+				if (Buffer->Events.Num() > 0)
+				{
+					Buffer->Events.Empty();
+					NumReleased++;
+				}
+				FPlatformAtomics::InterlockedExchange(&Buffer->bInUse, 0);
+			}
+		}
+	}
+	TraceStartTime = FPlatformTime::Seconds();
+	FPlatformAtomics::InterlockedIncrement(&CurrentTrace);
+	FPlatformAtomics::InterlockedExchange(&bEnabled, 1);
+	UE_LOG(TangoPlugin, Log, TEXT("TangoTracer::Start: Tracing, released the buffers of %d idle threads"), NumReleased);
+}
+
+void TangoTracer::Stop()
+{
+	FPlatformAtomics::InterlockedExchange(&bEnabled, 0);
+	UE_LOG(TangoPlugin, Log, TEXT("TangoTracer::Stop: Stopped after %.2f s"), FPlatformTime::Seconds() - TraceStartTime);
+}
+
+void TangoTracer::AddEvent(const TCHAR* Name, double Begin, double End, double TangoTimestamp)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+	FThreadBuffer* Buffer = GetThreadBuffer();
+	//Only fails while Start releases the buffer
+	if (FPlatformAtomics::InterlockedCompareExchange(&Buffer->bInUse, 1, 0) != 0)
+	{
+		return;
+	}
+	const int32 Trace = CurrentTrace;
+	if (Buffer->Trace != Trace)
+	{
+		if (Buffer->Events.Num() == 0)
+		{
+			Buffer->Events.SetNumUninitialized(GetEventsPerThread());
+		}
+		Buffer->NumEvents = 0;
+		Buffer->NumDropped = 0;
+		FPlatformMisc::MemoryBarrier();
+		Buffer->Trace = Trace;
+	}
+	const int32 Index = Buffer->NumEvents;
+	if (Index < Buffer->Events.Num())
+	{
+		FTangoTraceEvent& Event = Buffer->Events[Index];
+		Event.Name = Name;
+		Event.Begin = Begin;
+		Event.End = End;
+		Event.TangoTimestamp = TangoTimestamp;
+		//The event has to be complete before Dump sees it
+		FPlatformMisc::MemoryBarrier();
+		Buffer->NumEvents = Index + 1;
+	}
+	else
+	{
+		Buffer->NumDropped = Buffer->NumDropped + 1;
+	}
+	FPlatformAtomics::InterlockedExchange(&Buffer->bInUse, 0);
+}
+
+bool TangoTracer::Dump(const FString& Path)
+{
+	TArray<TSharedPtr<FThreadBuffer>> BuffersCopy;
+	{
+		FScopeLock ScopeLock(&BuffersLock);
+		BuffersCopy = Buffers;
+	}
+	const int32 Trace = CurrentTrace;
+	const uint32 ProcessId = FPlatformProcess::GetCurrentProcessId();
+	int32 NumEvents = 0;
+	int32 NumDropped = 0;
+	FString Json = TEXT("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool bFirst = true;
+	for (const TSharedPtr<FThreadBuffer>& Buffer : BuffersCopy)
+	{
+		if (Buffer->Trace != Trace)
+		{
+			continue;
+		}
+		const int32 Count = Buffer->NumEvents;
+		FPlatformMisc::MemoryBarrier();
+		if (Count == 0)
+		{
+			continue;
+		}
+		Json += FString::Printf(TEXT("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}"),
+			bFirst ? TEXT("") : TEXT(",\n"), ProcessId, Buffer->ThreadId, *Buffer->ThreadName.ReplaceCharWithEscapedChar());
+		bFirst = false;
+		for (int32 i = 0; i < Count; ++i)
+		{
+			const FTangoTraceEvent& Event = Buffer->Events[i];
+			//Microseconds since the start of the trace, the viewers want small numbers
+			Json += FString::Printf(TEXT(",\n{\"name\":\"%s\",\"cat\":\"Tango\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"engine\":%.6f,\"tango\":%.6f}}"),
+				Event.Name, ProcessId, Buffer->ThreadId, (Event.Begin - TraceStartTime) * 1e6, (Event.End - Event.Begin) * 1e6, Event.Begin, Event.TangoTimestamp);
+		}
+		NumEvents += Count;
+		NumDropped += Buffer->NumDropped;
+	}
+	Json += TEXT("\n]}\n");
+	if (!FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(TangoPlugin, Error, TEXT("TangoTracer::Dump: Could not write %s"), *Path);
+		return false;
+	}
+	UE_LOG(TangoPlugin, Log, TEXT("TangoTracer::Dump: Wrote %d events to %s, %d dropped because a thread buffer was full"), NumEvents, *Path, NumDropped);
+	return true;
+}
+
+/*
+ * Tango.Trace.Start, Tango.Trace.Stop, Tango.Trace.Dump [Path]
+ */
+namespace
+{
+	void StartTrace()
+	{
+		TangoTracer::Start();
+	}
+
+	void StopTrace()
+	{
+		TangoTracer::Stop();
+	}
+
+	void DumpTrace(const TArray<FString>& Args)
+	{
+		FString Path = FPaths::GameSavedDir() / TEXT("Tango") / FString::Printf(TEXT("Trace-%s.json"), *FDateTime::Now().ToString());
+		if (Args.Num() > 0)
+		{
+			Path = Args[0];
+		}
+		TangoTracer::Dump(Path);
+	}
+
+	static FAutoConsoleCommand StartTraceCommand(
+		TEXT("Tango.Trace.Start"),
+		TEXT("Starts recording a timeline of callbacks, conversions, broadcasts and render thread updates"),
+		FConsoleCommandDelegate::CreateStatic(&StartTrace));
+
+	static FAutoConsoleCommand StopTraceCommand(
+		TEXT("Tango.Trace.Stop"),
+		TEXT("Stops recording the timeline"),
+		FConsoleCommandDelegate::CreateStatic(&StopTrace));
+
+	static FAutoConsoleCommand DumpTraceCommand(
+		TEXT("Tango.Trace.Dump"),
+		TEXT("Writes the recorded timeline as Chrome trace JSON. Argument: [Path]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&DumpTrace));
+}
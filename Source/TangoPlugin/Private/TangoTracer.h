@@ -0,0 +1,79 @@
+/*Copyright 2016 Google
+Author: Opaque Media Group
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.*/
+
+
+#pragma once
+
+struct FTangoTraceEvent
+{
+	//Static string, only the pointer is stored
+	const TCHAR* Name;
+	//FPlatformTime::Seconds
+	double Begin;
+	double End;
+	//Service timestamp of the data the event worked on, 0 if there is none
+	double TangoTimestamp;
+};
+
+/*
+ * Timeline of the pipeline for finding out which thread and stage made a frame slow. Off unless started with Tango.Trace.Start.
+ * Every thread writes into its own buffer without locks, events that do not fit any more are dropped and counted.
+ * Tango.Trace.Dump writes all buffers as Chrome trace JSON, for chrome://tracing or other trace viewers.
+ */
+class TangoTracer
+{
+public:
+	static bool IsEnabled() { return bEnabled != 0; }
+	//Forgets the events of the previous trace, and releases the buffers of threads that added nothing to it
+	static void Start();
+	static void Stop();
+	//Game thread. Best called after Stop, events that are still being written are left out.
+	static bool Dump(const FString& Path);
+
+	//Any thread
+	static void AddEvent(const TCHAR* Name, double Begin, double End, double TangoTimestamp);
+
+private:
+	static volatile int32 bEnabled;
+};
+
+//Records an event from its construction to the end of the scope, if the tracer runs
+class FTangoTraceScope
+{
+public:
+	FTangoTraceScope(const TCHAR* InName, double InTangoTimestamp = 0.0)
+		: Name(TangoTracer::IsEnabled() ? InName : nullptr)
+		, TangoTimestamp(InTangoTimestamp)
+		, Begin(Name != nullptr ? FPlatformTime::Seconds() : 0.0)
+	{
+	}
+
+	~FTangoTraceScope()
+	{
+		if (Name != nullptr)
+		{
+			TangoTracer::AddEvent(Name, Begin, FPlatformTime::Seconds(), TangoTimestamp);
+		}
+	}
+
+	//For scopes that only learn which data they work on after they started
+	void SetTangoTimestamp(double InTangoTimestamp) { TangoTimestamp = InTangoTimestamp; }
+
+private:
+	const TCHAR* Name;
+	double TangoTimestamp;
+	double Begin;
+};
+
+#define TANGO_TRACE_SCOPE(Name, TangoTimestamp) FTangoTraceScope PREPROCESSOR_JOIN(TangoTraceScope, __LINE__)(TEXT(Name), TangoTimestamp)
@@ -22,10 +22,13 @@ limitations under the License.*/
 #include "ITangoAR.h"
 #include "TangoARHelpers.h"
 #include "PrimitiveSceneInfo.h"
+#include "TangoStats.h"
+#include "TangoTracer.h"
 
-#if PLATFORM_ANDROID
-#include "tango_client_api.h"
-#endif
+namespace
+{
+	typedef TSharedRef<FTangoViewExtension, ESPMode::ThreadSafe> FTangoViewExtensionRef;
+}
 
 UTangoARInterface::UTangoARInterface(const class FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -33,23 +36,11 @@ UTangoARInterface::UTangoARInterface(const class FObjectInitializer& ObjectIniti
 
 }
 
-namespace {
-	/** This is to prevent destruction of tango motion components while they are
-	in the middle of being accessed by the render thread */
-	FCriticalSection CritSect;
-} // anonymous namespace
-
 UTangoMotionComponent::~UTangoMotionComponent()
 {
 	if (ViewExtension.IsValid())
 	{
-		{
-			// This component could be getting accessed from the render thread so it needs to wait
-			// before clearing MotionControllerComponent and allowing the destructor to continue
-			FScopeLock ScopeLock(&CritSect);
-			ViewExtension->ARComponent = nullptr;
-		}
-
+		ViewExtension->Detach();
 		if (GEngine)
 		{
 			GEngine->ViewExtensions.Remove(ViewExtension);
@@ -62,13 +53,7 @@ UTangoARCamera::~UTangoARCamera()
 {
 	if (ViewExtension.IsValid())
 	{
-		{
-			// This component could be getting accessed from the render thread so it needs to wait
-			// before clearing MotionControllerComponent and allowing the destructor to continue
-			FScopeLock ScopeLock(&CritSect);
-			ViewExtension->ARComponent = nullptr;
-		}
-
+		ViewExtension->Detach();
 		if (GEngine)
 		{
 			GEngine->ViewExtensions.Remove(ViewExtension);
@@ -77,89 +62,56 @@ UTangoARCamera::~UTangoARCamera()
 	ViewExtension.Reset();
 }
 
-
-bool FTangoViewExtension::IdentifyViewWithCameraComponent(const FSceneView* InView,int32 Stride)
+void FTangoViewExtension::Detach()
 {
-	FScopeLock ScopeLock(&CritSect);
-	for (int32 i = 0; i < Cameras[Stride].Num(); ++i)
-	{
-		/*if(InView->ViewActor != nullptr)
-		{
-			UE_LOG(TangoPlugin, Log, TEXT("Actorname: %s compared to: %s and there also is: %s"), *InView->ViewActor->GetName(), *CameraActors[i]->GetName(),*ARComponent->GetActor()->GetName());
-		}*/
-		if (Cameras[Stride][i].Actor == InView->ViewActor)
+	ARComponent = nullptr;
+	//Families already on their way keep their own snapshot, this only drops the one the render thread holds on to.
+	ENQUEUE_UNIQUE_RENDER_COMMAND_ONEPARAMETER(ReleaseTangoLateUpdateSnapshot,
+		FTangoViewExtensionRef, Extension, AsShared(),
 		{
-			//UE_LOG(TangoPlugin, Log, TEXT("FTangoViewExtension::IdentifyViewWithCameraComponent: identified Actor"));
-			if (InView->ViewLocation.X == Cameras[Stride][i].Pos.X && InView->ViewLocation.Y == Cameras[Stride][i].Pos.Y &&InView->ViewLocation.Z == Cameras[Stride][i].Pos.Z &&
-				InView->ViewRotation.Pitch == Cameras[Stride][i].Rot.Pitch &&InView->ViewRotation.Roll == Cameras[Stride][i].Rot.Roll && InView->ViewRotation.Yaw == Cameras[Stride][i].Rot.Yaw)
-			{
-				//UE_LOG(TangoPlugin, Log, TEXT("FTangoViewExtension::IdentifyViewWithCameraComponent: identified position"));
-				return true;
-			}
-		}
-	}
-#if !WITH_EDITOR
-	UE_LOG(TangoPlugin, Warning, TEXT("FTangoViewExtension::IdentifyViewWithCameraComponent: Did not identify Actor"));
-#endif
-	return false;
+			Extension->RenderSnapshot.Reset();
+		});
 }
 
-const bool FTangoViewExtension::GetLateUpdateTransform(FTransform& Transform,int32 Stride, bool bIsAbsolute)
+const bool FTangoViewExtension::GetLateUpdateTransform(FTransform& Transform, const LateUpdateSnapshot& Snapshot, bool bIsAbsolute)
 {
 	bool bIsNew = false;
-	FScopeLock ScopeLock(&CritSect);
-
-	if (!ARComponent)
-	{
-		return false;
-	}
-
-	if (ARComponent->WantToDoAR())
+	if (PoseSnapshotId != Snapshot.Id)
 	{
-		if (UTangoDevice::Get().GetTangoDeviceImagePointer())
+		UTangoDeviceMotion* Motion = UTangoDevice::Get().GetTangoDeviceMotionPointer();
+		if (Motion == nullptr)
 		{
-			float CurrentTime = UTangoDevice::Get().GetTangoDeviceImagePointer()->GetImageBufferTimestamp();
-			if (LatestPoseStamp < CurrentTime)
-			{
-				if (UTangoDevice::Get().GetTangoDeviceMotionPointer())
-				{
-					LatestPose = ARComponent->GetCurrentPoseRENDERTHREAD(CurrentTime);
-					LatestPoseStamp = CurrentTime;
-					bIsNew = true;
-				}
-				else
-				{
-					Transform = FTransform::Identity;
-					return false;
-				}
-			}
+			Transform = FTransform::Identity;
+			return false;
 		}
-	}
-	if (PoseFrame[Stride] != FrameNumber[Stride])
-	{
-		if (!ARComponent->WantToDoAR())
+		if (!Snapshot.bWantsAR)
 		{
-			LatestPose = ARComponent->GetCurrentPoseRENDERTHREAD(0);
-			LatestPoseStamp = 0;
+			LatestPose = Motion->GetPoseAtTime(Snapshot.FrameOfReference, 0);
+			LatestPoseTimestamp = LatestPose.PreciseTimestamp;
+			LatestPoseFrameSequence = 0;
 		}
-		Poses[Stride] = LatestPose;
-		PoseFrame[Stride] = FrameNumber[Stride];
+		//The image the game thread bound for this frame, not the one published last
+		else if (Snapshot.Image.FrameSequence > 0 && Snapshot.Image.FrameSequence != LatestPoseFrameSequence)
+		{
+			LatestPose = Motion->GetPoseAtTime(Snapshot.FrameOfReference, Snapshot.Image.Timestamp);
+			LatestPoseTimestamp = Snapshot.Image.Timestamp;
+			LatestPoseFrameSequence = Snapshot.Image.FrameSequence;
+			bIsNew = true;
+		}
+		PoseSnapshotId = Snapshot.Id;
 	}
 	//Only move the component if the pose status is valid.
-	if (Poses[Stride].StatusCode == ETangoPoseStatus::VALID)
+	if (LatestPose.StatusCode == ETangoPoseStatus::VALID)
 	{
+		const FTransform NewLocalToWorldTransform = FTransform(LatestPose.Rotation, LatestPose.Position) * Snapshot.ParentToWorld;
 		if (bIsAbsolute)
 		{
-			Transform = ARComponent->CalcComponentToWorld(FTransform(Poses[Stride].Rotation, Poses[Stride].Position));
-			return bIsNew;
-		}
-		else if(ARComponent)
-		{
-			const FTransform OldLocalToWorldTransform = ARComponent->CalcComponentToWorld(ARComponent->AsSceneComponent()->GetRelativeTransform());
-			const FTransform NewLocalToWorldTransform = ARComponent->CalcComponentToWorld(FTransform(Poses[Stride].Rotation, Poses[Stride].Position));
-			Transform = (OldLocalToWorldTransform.Inverse() * NewLocalToWorldTransform);
+			Transform = NewLocalToWorldTransform;
 			return bIsNew;
 		}
+		const FTransform OldLocalToWorldTransform = Snapshot.RelativeTransform * Snapshot.ParentToWorld;
+		Transform = (OldLocalToWorldTransform.Inverse() * NewLocalToWorldTransform);
+		return bIsNew;
 	}
 #if !WITH_EDITOR
 	UE_LOG(TangoPlugin, Warning, TEXT("FTangoViewExtension::GetLateUpdateTransform: Failed because pose is invalid!"));
@@ -168,113 +120,116 @@ const bool FTangoViewExtension::GetLateUpdateTransform(FTransform& Transform,int
 	return false;
 }
 
-void FTangoViewExtension::PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily)
+void FTangoViewExtension::ApplyLateUpdateTransform(FSceneInterface* Scene, const LateUpdateSnapshot& Snapshot, const FTransform& LateUpdateTransform) const
 {
-	if (UTangoDevice::Get().GetTangoDeviceImagePointer())
+	const FMatrix LateUpdateMatrix = LateUpdateTransform.ToMatrixWithScale();
+	for (const LateUpdatePrimitiveInfo& PrimitiveInfo : Snapshot.Proxies)
 	{
-		if (UTangoDevice::Get().GetTangoDeviceImagePointer()->IsNewDataAvail())
+		FPrimitiveSceneInfo* RetrievedSceneInfo = Scene->GetPrimitiveSceneInfo(*PrimitiveInfo.IndexAddress);
+		FPrimitiveSceneInfo* CachedSceneInfo = PrimitiveInfo.SceneInfo;
+		// If the retrieved scene info is different than our cached scene info then the primitive was removed from the scene
+		if (CachedSceneInfo == RetrievedSceneInfo && CachedSceneInfo->Proxy)
 		{
-			double Stamp = 0.0;
-#if PLATFORM_ANDROID
-				TangoService_updateTexture(TANGO_CAMERA_COLOR, &Stamp);
-#endif
-				UTangoDevice::Get().GetTangoDeviceImagePointer()->DataSet(Stamp);
+			CachedSceneInfo->Proxy->ApplyLateUpdateTransform(LateUpdateMatrix);
 		}
 	}
-	if (!ARComponent)
+}
+
+void FTangoViewExtension::RecordLatency(const LateUpdateSnapshot& Snapshot)
+{
+	if (LatencySnapshotId == Snapshot.Id)
 	{
 		return;
 	}
+	LatencySnapshotId = Snapshot.Id;
+	const double PoseTimestamp = LatestPose.StatusCode == ETangoPoseStatus::VALID ? LatestPoseTimestamp : 0.0;
+	const double ImageTimestamp = Snapshot.bWantsAR ? Snapshot.Image.Timestamp : 0.0;
+	UTangoDevice::Get().LatencyMonitor.RecordFrame(UTangoDevice::Get().ClockSync, PoseTimestamp, ImageTimestamp);
+}
 
-	FTransform NewTransform;
-	FScopeLock ScopeLock(&CritSect);
-	int32 S = FindStride(InViewFamily.FrameNumber);
-	// Apply adjustment to the affected scene proxies
-	if (S >= 0)
+void FTangoViewExtension::PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily)
+{
+	if (UTangoDevice::Get().GetTangoDeviceImagePointer())
 	{
-		if (Cameras[S].Num() > 0)
-		{
-			return;
-		}
-		GetLateUpdateTransform(NewTransform, S, false);
-		FMatrix LateUpdateMatrix = NewTransform.ToMatrixWithScale();
-		for (auto PrimitiveInfo : LateUpdateSceneProxies[S])
+		if (UTangoDevice::Get().GetTangoDeviceImagePointer()->ConsumeNewData())
 		{
-			FPrimitiveSceneInfo* RetrievedSceneInfo = InViewFamily.Scene->GetPrimitiveSceneInfo(*PrimitiveInfo.IndexAddress);
-			FPrimitiveSceneInfo* CachedSceneInfo = PrimitiveInfo.SceneInfo;
-			// If the retrieved scene info is different than our cached scene info then the primitive was removed from the scene
-			if (CachedSceneInfo == RetrievedSceneInfo && CachedSceneInfo->Proxy)
-			{
-				CachedSceneInfo->Proxy->ApplyLateUpdateTransform(LateUpdateMatrix);
-			}
+			FTangoTraceScope Trace(TEXT("CameraTexture.Update"));
+			double Stamp = 0.0;
+			UTangoDevice::Get().GetBackend().UpdateCameraTextures(Stamp);
+			Trace.SetTangoTimestamp(Stamp);
+			UTangoDevice::Get().GetTangoDeviceImagePointer()->DataSet(Stamp, InViewFamily.FrameNumber);
 		}
 	}
-	else
+	//Held for the whole function, even if the game thread detaches in the meantime
+	const LateUpdateSnapshotPtr Snapshot = RenderSnapshot;
+	if (!Snapshot.IsValid())
+	{
+		return;
+	}
+	if (Snapshot->FrameNumber != InViewFamily.FrameNumber)
+	{
+		UE_LOG(TangoPlugin, Warning, TEXT("FTangoViewExtension::PreRenderViewFamily_RenderThread: No snapshot for this frame!"))
+		return;
+	}
+	if (Snapshot->bWantsAR && UTangoDevice::Get().GetTangoDeviceImagePointer())
 	{
-		UE_LOG(TangoPlugin, Warning, TEXT("FTangoViewExtension::PreRenderViewFamily_RenderThread: No Stride found!"))
+		UTangoDevice::Get().GetTangoDeviceImagePointer()->RecordImageDisplayed(Snapshot->Image, InViewFamily.FrameNumber);
 	}
+	// Apply adjustment to the affected scene proxies. With cameras it is done per view.
+	if (Snapshot->bHasCameras)
+	{
+		return;
+	}
+	SCOPE_CYCLE_COUNTER(STAT_TangoLateUpdate);
+	FTangoTraceScope Trace(TEXT("LateUpdate.Family"));
+	FTransform NewTransform;
+	GetLateUpdateTransform(NewTransform, *Snapshot, false);
+	Trace.SetTangoTimestamp(LatestPoseTimestamp);
+	ApplyLateUpdateTransform(InViewFamily.Scene, *Snapshot, NewTransform);
+	RecordLatency(*Snapshot);
 }
 
 void FTangoViewExtension::PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView)
 {
-
-	if (!ARComponent)
+	const LateUpdateSnapshotPtr Snapshot = RenderSnapshot;
+	if (!Snapshot.IsValid())
 	{
 		return;
 	}
-	FScopeLock ScopeLock(&CritSect);
-	int32 S = FindStride(InView.Family->FrameNumber);
 	//UE_LOG(ProjectTangoPlugin, Log, TEXT("FTangoViewExtension::PreRenderView_RenderThread: Called!"));
-	if (!IdentifyViewWithCameraComponent(&InView, S))
+	if (InView.Family == nullptr || Snapshot->FrameNumber != InView.Family->FrameNumber)
 	{
-		return;
-	}
-	//UE_LOG(ProjectTangoPlugin, Log, TEXT("FTangoViewExtension::PreRenderView_RenderThread: View found!"));
-	if (InView.Family)
-	{
-		if (S >= 0)
+		if (Snapshot->bWantsAR)
 		{
-			FTransform ViewTransform = FTransform(InView.ViewRotation, InView.ViewLocation);
-			FTransform LateUpdateTransform;
-			GetLateUpdateTransform(LateUpdateTransform, S, false);
-			ViewTransform = ViewTransform * LateUpdateTransform;
-			InView.ViewLocation = ViewTransform.GetLocation();
-			InView.ViewRotation = ViewTransform.Rotator();
-			if (ARComponent->WantToDoAR())
-			{
-				InView.ProjectionMatrixUnadjustedForRHI = TangoARHelpers::GetARProjectionMatrix();
-				InView.ViewMatrices.ProjMatrix = AdjustProjectionMatrixForRHI(InView.ProjectionMatrixUnadjustedForRHI);
-			}
-			InView.UpdateViewMatrix();
-			FMatrix LateUpdateMatrix = LateUpdateTransform.ToMatrixWithScale();
-			for (auto PrimitiveInfo : LateUpdateSceneProxies[S])
-			{
-				FPrimitiveSceneInfo* RetrievedSceneInfo = InView.Family->Scene->GetPrimitiveSceneInfo(*PrimitiveInfo.IndexAddress);
-				FPrimitiveSceneInfo* CachedSceneInfo = PrimitiveInfo.SceneInfo;
-				// If the retrieved scene info is different than our cached scene info then the primitive was removed from the scene
-				if (CachedSceneInfo == RetrievedSceneInfo && CachedSceneInfo->Proxy)
-				{
-					CachedSceneInfo->Proxy->ApplyLateUpdateTransform(LateUpdateMatrix);
-				}
-			}
-		}
-		else if (ARComponent->WantToDoAR())
-		{
-			UE_LOG(TangoPlugin, Warning, TEXT("FTangoViewExtension::PreRenderView_RenderThread: No Stride could be found!"));
+			UE_LOG(TangoPlugin, Warning, TEXT("FTangoViewExtension::PreRenderView_RenderThread: No snapshot for this view!"));
 			InView.ProjectionMatrixUnadjustedForRHI = TangoARHelpers::GetARProjectionMatrix();
 			InView.ViewMatrices.ProjMatrix = AdjustProjectionMatrixForRHI(InView.ProjectionMatrixUnadjustedForRHI);
-
 			InView.UpdateViewMatrix();
 		}
+		return;
 	}
-	else if (ARComponent->WantToDoAR())
+	if (!IdentifyViewWithCameraComponent(&InView, *Snapshot))
+	{
+		return;
+	}
+	//UE_LOG(ProjectTangoPlugin, Log, TEXT("FTangoViewExtension::PreRenderView_RenderThread: View found!"));
+	SCOPE_CYCLE_COUNTER(STAT_TangoLateUpdate);
+	FTangoTraceScope Trace(TEXT("LateUpdate.View"));
+	FTransform ViewTransform = FTransform(InView.ViewRotation, InView.ViewLocation);
+	FTransform LateUpdateTransform;
+	GetLateUpdateTransform(LateUpdateTransform, *Snapshot, false);
+	Trace.SetTangoTimestamp(LatestPoseTimestamp);
+	ViewTransform = ViewTransform * LateUpdateTransform;
+	InView.ViewLocation = ViewTransform.GetLocation();
+	InView.ViewRotation = ViewTransform.Rotator();
+	if (Snapshot->bWantsAR)
 	{
-		UE_LOG(TangoPlugin, Warning, TEXT("FTangoViewExtension::PreRenderView_RenderThread: InView.Family is nullptr!"));
 		InView.ProjectionMatrixUnadjustedForRHI = TangoARHelpers::GetARProjectionMatrix();
 		InView.ViewMatrices.ProjMatrix = AdjustProjectionMatrixForRHI(InView.ProjectionMatrixUnadjustedForRHI);
-		InView.UpdateViewMatrix();
 	}
-
+	InView.UpdateViewMatrix();
+	ApplyLateUpdateTransform(InView.Family->Scene, *Snapshot, LateUpdateTransform);
+	RecordLatency(*Snapshot);
 }
 
 void FTangoViewExtension::BeginRenderViewFamily(FSceneViewFamily& InViewFamily)
@@ -283,65 +238,95 @@ void FTangoViewExtension::BeginRenderViewFamily(FSceneViewFamily& InViewFamily)
 	{
 		return;
 	}
-	FScopeLock ScopeLock(&CritSect);
-	if (!ARComponent)
+	USceneComponent* Root = ARComponent->AsSceneComponent();
+	if (Root == nullptr)
 	{
 		return;
 	}
+	if (bHierarchyCacheDirty || CachedRoot.Get() != Root)
+	{
+		bHierarchyCacheDirty = false;
+		CachedHierarchy.Reset();
+		CachedRoot = Root;
+		CacheHierarchy(Root);
+	}
 	//UE_LOG(TangoPlugin, Log, TEXT("FTangoViewExtension::BeginRenderViewFamily: Called"));
-	CurrentStride = (CurrentStride + 1) % MaxCameraStride;
-	LateUpdateSceneProxies[CurrentStride].Empty();
-	Cameras[CurrentStride].Empty();
-	FrameNumber[CurrentStride] = InViewFamily.FrameNumber;
-	GatherSceneProxiesAndCameras(ARComponent->AsSceneComponent());
+	SCOPE_CYCLE_COUNTER(STAT_TangoViewGather);
+	LateUpdateSnapshot* Snapshot = new LateUpdateSnapshot();
+	Snapshot->Id = NextSnapshotId++;
+	Snapshot->FrameNumber = InViewFamily.FrameNumber;
+	Snapshot->bWantsAR = ARComponent->WantToDoAR();
+	Snapshot->FrameOfReference = ARComponent->GetFrameOfReference();
+	Snapshot->ParentToWorld = ARComponent->CalcComponentToWorld(FTransform::Identity);
+	Snapshot->RelativeTransform = Root->GetRelativeTransform();
+	Snapshot->Image = UTangoDevice::Get().GetTangoDeviceImagePointer() ? UTangoDevice::Get().GetTangoDeviceImagePointer()->GetFrameImage() : FTangoCameraImageSnapshot();
+	GatherSceneProxiesAndCameras(InViewFamily, *Snapshot);
+	//UE_LOG(TangoPlugin, Log, TEXT("FTangoViewExtension::BeginRenderViewFamily: Found %d Sceneproxies and %d camera views!"), Snapshot->Proxies.Num(), Snapshot->CameraViews.Num());
 
-	//UE_LOG(TangoPlugin, Log, TEXT("FTangoViewExtension::BeginRenderViewFamily: Found %d Sceneproxies and %d Cameras!"), LateUpdateSceneProxyCount, CameraCount);
+	//Runs right before the family is rendered. Replacing the previous snapshot releases it on the render thread.
+	ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(SetTangoLateUpdateSnapshot,
+		FTangoViewExtensionRef, Extension, AsShared(),
+		LateUpdateSnapshotPtr, NewSnapshot, LateUpdateSnapshotPtr(Snapshot),
+		{
+			Extension->RenderSnapshot = NewSnapshot;
+		});
 }
 
-int32 FTangoViewExtension::FindStride(int32 Time)
+void FTangoViewExtension::CacheHierarchy(USceneComponent* Component)
 {
-	for (int32 i = 0; i < MaxCameraStride; ++i)
+	CachedComponent Cached;
+	Cached.Component = Component;
+	Cached.bIsPrimitive = Component->IsA<UPrimitiveComponent>();
+	Cached.bIsCamera = Component->IsA<UCameraComponent>();
+	CachedHierarchy.Add(Cached);
+
+	for (int32 ChildIndex = 0; ChildIndex < Component->GetNumChildrenComponents(); ++ChildIndex)
 	{
-		if (FrameNumber[i] == Time)
+		USceneComponent* ChildComponent = Component->GetChildComponent(ChildIndex);
+		if (ChildComponent)
 		{
-			return i;
+			CacheHierarchy(ChildComponent);
 		}
 	}
-	return -1;
 }
 
-void FTangoViewExtension::GatherSceneProxiesAndCameras(USceneComponent* Component)
+void FTangoViewExtension::GatherSceneProxiesAndCameras(const FSceneViewFamily& ViewFamily, LateUpdateSnapshot& Snapshot)
 {
-	// If a scene proxy is present, cache it
-	UPrimitiveComponent* PrimitiveComponent = dynamic_cast<UPrimitiveComponent*>(Component);
-	if (PrimitiveComponent && PrimitiveComponent->SceneProxy)
+	TArray<const AActor*, TInlineAllocator<4>> CameraActors;
+	for (const CachedComponent& Cached : CachedHierarchy)
 	{
-		FPrimitiveSceneInfo* PrimitiveSceneInfo = PrimitiveComponent->SceneProxy->GetPrimitiveSceneInfo();
-		if (PrimitiveSceneInfo)
+		USceneComponent* Component = Cached.Component.Get();
+		//Components below the children of the AR component do not tell it when they go away, so they are walked again next frame
+		if (Component == nullptr || !Component->IsRegistered())
 		{
-			LateUpdatePrimitiveInfo PrimitiveInfo;
-			PrimitiveInfo.IndexAddress = PrimitiveSceneInfo->GetIndexAddress();
-			PrimitiveInfo.SceneInfo = PrimitiveSceneInfo;
-			LateUpdateSceneProxies[CurrentStride].Emplace(PrimitiveInfo);
+			bHierarchyCacheDirty = true;
+			continue;
+		}
+		// If a scene proxy is present, cache it
+		if (Cached.bIsPrimitive)
+		{
+			UPrimitiveComponent* PrimitiveComponent = static_cast<UPrimitiveComponent*>(Component);
+			FPrimitiveSceneInfo* PrimitiveSceneInfo = PrimitiveComponent->SceneProxy ? PrimitiveComponent->SceneProxy->GetPrimitiveSceneInfo() : nullptr;
+			if (PrimitiveSceneInfo)
+			{
+				LateUpdatePrimitiveInfo PrimitiveInfo;
+				PrimitiveInfo.IndexAddress = PrimitiveSceneInfo->GetIndexAddress();
+				PrimitiveInfo.SceneInfo = PrimitiveSceneInfo;
+				Snapshot.Proxies.Emplace(PrimitiveInfo);
+			}
+		}
+		if (Cached.bIsCamera)
+		{
+			CameraActors.AddUnique(Component->GetOwner());
 		}
 	}
-	UCameraComponent* CameraComponent = dynamic_cast<UCameraComponent*>(Component);
-	if (CameraComponent)
-	{
-		auto Transform = CameraComponent->GetComponentTransform(); //.Inverse();
-		Cameras[CurrentStride].Emplace(CamData(Transform.GetTranslation(), Transform.Rotator(), CameraComponent->GetOwner()));
-	}
-
-	// Gather children proxies
-	const int32 ChildCount = Component->GetNumChildrenComponents();
-	for (int32 ChildIndex = 0; ChildIndex < ChildCount; ++ChildIndex)
+	Snapshot.bHasCameras = CameraActors.Num() > 0;
+	//A view looks through one of the cameras if its actor is the view target
+	for (const FSceneView* View : ViewFamily.Views)
 	{
-		USceneComponent* ChildComponent = Component->GetChildComponent(ChildIndex);
-		if (!ChildComponent)
+		if (View != nullptr && View->ViewActor != nullptr && CameraActors.Contains(View->ViewActor))
 		{
-			continue;
+			Snapshot.CameraViews.Add(ViewKey(*View));
 		}
-
-		GatherSceneProxiesAndCameras(ChildComponent);
 	}
-}
\ No newline at end of file
+}
@@ -13,15 +13,18 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.*/
 
+#pragma once
+
 #include "SceneViewExtension.h"
 #include "TangoDataTypes.h"
 #include "ITangoAR.h"
+#include "TangoCameraImageState.h"
 
 /** View extension object that can persist on the render thread without the components */
 class FTangoViewExtension : public ISceneViewExtension, public TSharedFromThis<FTangoViewExtension, ESPMode::ThreadSafe>
 {
 public:
-	FTangoViewExtension(ITangoARInterface* MotionComponent) {  ARComponent = MotionComponent; CurrentStride = 0; }
+	FTangoViewExtension(ITangoARInterface* MotionComponent) {  ARComponent = MotionComponent; LatestPoseTimestamp = 0.0; LatestPoseFrameSequence = 0; PoseSnapshotId = 0; LatencySnapshotId = 0; NextSnapshotId = 1; bHierarchyCacheDirty = true; }
 	virtual ~FTangoViewExtension() {}
 
 	/** ISceneViewExtension interface */
@@ -33,23 +36,15 @@ public:
 	virtual void PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView) override;
 	virtual void PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily) override;
 
-	ITangoARInterface* ARComponent;
+	/** Game thread. Called by the component before it goes away, the render thread lets go of its last snapshot afterwards. */
+	void Detach();
+	/** Game thread. Called by the AR component when it is (un)registered or children are attached to or detached from it. */
+	void InvalidateHierarchyCache() { bHierarchyCacheDirty = true; }
 
 private:
+	/** Game thread only, the render thread works on snapshots */
+	ITangoARInterface* ARComponent;
 
-
-	/** Walks the component hierarchy gathering scene proxies */
-	void GatherSceneProxiesAndCameras(USceneComponent* Component);
-	/** Checks whether this SceneView has to be adjusted or not*/
-	bool IdentifyViewWithCameraComponent(const FSceneView* InView,int32 Stride);
-	const bool GetLateUpdateTransform(FTransform & Transform, int32 Stride, bool bIsAbsolute);
-	//void MoveViewAndDoProjection(const FSceneView* InView, const FMatrix& LateUpdateTransform);
-
-	int32 FindStride(int32 Time);
-	//How many positions should be stored. Should be greater than what the Renderthread could ever lag behind.
-#define MaxCameraStride 4
-	int32 CurrentStride;
-	uint32 FrameNumber[MaxCameraStride];
 	/*
 	*	Late update primitive info for accessing valid scene proxy info. From the time the info is gathered
 	*  to the time it is later accessed the render proxy can be deleted. To ensure we only access a proxy that is
@@ -63,24 +58,85 @@ private:
 		FPrimitiveSceneInfo*	SceneInfo;
 	};
 
-	TArray<LateUpdatePrimitiveInfo> LateUpdateSceneProxies[MaxCameraStride];
-	/** Camera component positions and rotations since we have no other way to identify them :(*/
-
-	struct CamData {
-		FVector Pos;
-		FRotator Rot;
-		AActor* Actor;
-		CamData(FVector P, FRotator R, AActor* A)
+	/**
+	*  Identifies a view across the game and render thread. The renderer copies the views of a family, so their addresses
+	*  change, but the persistent view state and the view actor are carried over. Split-screen players and scene captures
+	*  each have their own view state.
+	*/
+	struct ViewKey
+	{
+		const FSceneViewStateInterface* State;
+		const AActor* Actor;
+		ViewKey(const FSceneView& View)
+			: State(View.State)
+			, Actor(View.ViewActor)
 		{
-			Pos = P;
-			Rot = R;
-			Actor = A;
 		}
+		bool operator==(const ViewKey& Other) const { return State == Other.State && Actor == Other.Actor; }
+		friend uint32 GetTypeHash(const ViewKey& Key) { return HashCombine(PointerHash(Key.State), PointerHash(Key.Actor)); }
 	};
-	TArray<CamData> Cameras[MaxCameraStride];
+
+	/**
+	*  Everything the render thread needs for the late update of one view family, so it never has to touch the component.
+	*  Built on the game thread and not changed afterwards. It travels to the render thread in a render command, which
+	*  keeps it in order with the frame it belongs to. The previous snapshot is released on the render thread once replaced.
+	*/
+	struct LateUpdateSnapshot
+	{
+		uint32 Id;
+		uint32 FrameNumber;
+		bool bWantsAR;
+		FTangoCoordinateFramePair FrameOfReference;
+		/** The component's parent in world space, and the component relative to it */
+		FTransform ParentToWorld;
+		FTransform RelativeTransform;
+		/** Camera image the game thread latched for the frame */
+		FTangoCameraImageSnapshot Image;
+		TArray<LateUpdatePrimitiveInfo> Proxies;
+		/** Views looking through a camera below the component. Their proxies are moved per view instead of per family. */
+		bool bHasCameras;
+		TSet<ViewKey> CameraViews;
+	};
+	typedef TSharedPtr<const LateUpdateSnapshot, ESPMode::ThreadSafe> LateUpdateSnapshotPtr;
+
+	/** Collects the scene proxies of the cached hierarchy and the views of the family that look through its cameras */
+	void GatherSceneProxiesAndCameras(const FSceneViewFamily& ViewFamily, LateUpdateSnapshot& Snapshot);
+	/** Walks the component hierarchy, only when the cache was invalidated */
+	void CacheHierarchy(USceneComponent* Component);
+	/** Checks whether this SceneView has to be adjusted or not*/
+	bool IdentifyViewWithCameraComponent(const FSceneView* InView, const LateUpdateSnapshot& Snapshot) const { return Snapshot.CameraViews.Contains(ViewKey(*InView)); }
+	const bool GetLateUpdateTransform(FTransform & Transform, const LateUpdateSnapshot& Snapshot, bool bIsAbsolute);
+	void ApplyLateUpdateTransform(FSceneInterface* Scene, const LateUpdateSnapshot& Snapshot, const FTransform& LateUpdateTransform) const;
+	/** Render thread. Records the age of the pose and the image of the snapshot once, when its frame is submitted. */
+	void RecordLatency(const LateUpdateSnapshot& Snapshot);
+	//void MoveViewAndDoProjection(const FSceneView* InView, const FMatrix& LateUpdateTransform);
+
+	/**
+	*  Game thread only. Every component below the AR component, as found by the last walk. The walk is repeated after the AR
+	*  component invalidated the cache, or once the gather found a cached component destroyed or unregistered.
+	*  Scene proxies are not cached, they are read from the primitives each frame since they are recreated with the render state.
+	*/
+	struct CachedComponent
+	{
+		TWeakObjectPtr<USceneComponent> Component;
+		bool bIsPrimitive;
+		bool bIsCamera;
+	};
+	TArray<CachedComponent> CachedHierarchy;
+	TWeakObjectPtr<USceneComponent> CachedRoot;
+	bool bHierarchyCacheDirty;
+	uint32 NextSnapshotId;
+
+	/** Render thread only */
+	LateUpdateSnapshotPtr RenderSnapshot;
 	/** Poses buffered by GetLateUpdateTransform*/
 	FTangoPoseData LatestPose;
-	float LatestPoseStamp;
-	FTangoPoseData Poses[MaxCameraStride];
-	int32 PoseFrame[MaxCameraStride];
-};
\ No newline at end of file
+	//Service timestamp of LatestPose in full precision
+	double LatestPoseTimestamp;
+	//Camera frame LatestPose was queried for
+	int64 LatestPoseFrameSequence;
+	//Snapshot LatestPose is used for, so all views of a family get the same pose
+	uint32 PoseSnapshotId;
+	//Snapshot whose frame latency was recorded last
+	uint32 LatencySnapshotId;
+};
@@ -26,7 +26,8 @@ class ITangoARInterface
 {
 	GENERATED_IINTERFACE_BODY()
 public:
-	virtual FTangoPoseData GetCurrentPoseRENDERTHREAD(float TimeStamp) { return FTangoPoseData(); }
+	//Frame pair of the pose the late update uses. Read on the game thread, the render thread queries the pose itself.
+	virtual FTangoCoordinateFramePair GetFrameOfReference() { return FTangoCoordinateFramePair(); }
 	virtual AActor* GetActor() { return nullptr; }
 	virtual USceneComponent* AsSceneComponent() { return nullptr;  }
 	virtual FTransform CalcComponentToWorld(FTransform Transform) { return FTransform(); }
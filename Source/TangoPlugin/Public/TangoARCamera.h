@@ -30,13 +30,17 @@ public:
 	~UTangoARCamera();//In TangoViewExtension.cpp!
 	//ITangoARInterface
 public:
-	virtual FTangoPoseData GetCurrentPoseRENDERTHREAD(float TimeStamp) override;
+	virtual FTangoCoordinateFramePair GetFrameOfReference() override { return FrameOfReference; }
 	virtual AActor* GetActor() override;
 	virtual USceneComponent* AsSceneComponent() override;
 	virtual FTransform CalcComponentToWorld(FTransform Transform) override;
 protected:
 	virtual void BeginPlay() override;
 	virtual void InitializeComponent() override;
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+	virtual void OnChildAttached(USceneComponent* ChildComponent) override;
+	virtual void OnChildDetached(USceneComponent* ChildComponent) override;
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
 	virtual bool WantToDoAR() override { return true; }
 private:
@@ -38,9 +38,15 @@ protected:
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
 private:
 	void SetupMaterial();
+	void BindCameraTextures();
 
 	bool bInitializedMaterial = false;
 
+	UPROPERTY(transient)
+		UMaterialInstanceDynamic* ScreenMaterial = nullptr;
+	UPROPERTY(transient)
+		UTexture* BoundYTexture = nullptr;
+
 	UStaticMesh* FoundMesh;
 	UMaterial* FoundMaterial;
 };
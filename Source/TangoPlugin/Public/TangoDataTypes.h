@@ -266,6 +266,20 @@ struct TANGOPLUGIN_API FTangoCoordinateFramePair
 };
 
 
+/*
+	FTangoSubscriptionHandle
+	Identifies a subscription in one of the plugins subscriber registries. The generation
+	makes sure a handle to a released slot never refers to the subscriber that reused it.
+*/
+struct TANGOPLUGIN_API FTangoSubscriptionHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Generation = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Invalidate() { Index = INDEX_NONE; Generation = 0; }
+};
+
 /*
 	FTangoAreaDescription
 	Data structure which holds information about Tango Area Description Files.
@@ -328,6 +342,9 @@ struct TANGOPLUGIN_API FTangoConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tango", meta = (ToolTip = "Allow for activation of color camera"))
 		bool bEnableColorCameraCapabilities;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tango", meta = (ToolTip = "Copy every color camera frame to CPU memory as well. Costs one copy per frame, only enable it if you process camera images on the CPU"))
+		bool bEnableColorCameraFrames = false;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tango", meta = (ToolTip = "Automatically adjust ISO and Exposure"))
 		bool bColorModeAuto;
 
@@ -399,6 +416,10 @@ struct TANGOPLUGIN_API FTangoPoseData
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Tango", meta = (ToolTip = "Pose time in seconds since the device was started"))
 		float Timestamp;
 
+	//@NOTE: Timestamp in full precision. Blueprint has no doubles, and
+	//as a float Timestamp loses milliseconds after a day of uptime.
+	double PreciseTimestamp;
+
 	FTangoPoseData(FVector NewPosition = FVector(), FRotator NewRotation = FRotator(), FQuat NewQuatRotation = FQuat(), FTangoCoordinateFramePair NewFrameOfReference = FTangoCoordinateFramePair(),
 		TEnumAsByte<ETangoPoseStatus::Type> NewStatusCode = ETangoPoseStatus::UNKNOWN, float NewTimestamp = 0.0f);
 };
@@ -472,4 +493,71 @@ struct TANGOPLUGIN_API FTangoAreaDescriptionMetaData
 
 	FTangoAreaDescriptionMetaData(const FString InFileName, const int32 InMillisecondsSinceUnixEpoch, const FTransform InTransformation);
 	FTangoAreaDescriptionMetaData() {};
-};
\ No newline at end of file
+};
+/*
+	ETangoStreamType
+	The streams the service delivers, as watched by the stream monitor.
+*/
+UENUM(BlueprintType)
+namespace ETangoStreamType
+{
+	enum Type
+	{
+		POSE			UMETA(DisplayName = "Pose"),
+		DEPTH			UMETA(DisplayName = "Depth"),
+		COLOR_FRAME		UMETA(DisplayName = "Color Frame"),
+		CAMERA_TEXTURE	UMETA(DisplayName = "Camera Texture")
+	};
+}
+
+/*
+	FTangoStreamStatistics
+	Arrival intervals of one stream since the last connection. Percentiles come from a histogram with about 20% resolution.
+*/
+USTRUCT(BlueprintType)
+struct TANGOPLUGIN_API FTangoStreamStatistics
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "Stream the statistics are for"))
+		TEnumAsByte<ETangoStreamType::Type> Stream;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "Number of updates that arrived"))
+		int32 NumArrivals;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "Median time between two arrivals in milliseconds, measured when the callback ran"))
+		float IntervalP50;
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "95th percentile of the time between two arrivals in milliseconds"))
+		float IntervalP95;
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "99th percentile of the time between two arrivals in milliseconds"))
+		float IntervalP99;
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "Longest time between two arrivals in milliseconds"))
+		float MaxInterval;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "Median difference between the timestamps of two updates in milliseconds. If these are steady while the arrival intervals are not, the delay is in delivery, not in the service."))
+		float ServiceIntervalP50;
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "99th percentile of the difference between the timestamps of two updates in milliseconds"))
+		float ServiceIntervalP99;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "How often the time between two arrivals exceeded the stall threshold"))
+		int32 NumStalls;
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "True if nothing arrived for longer than the stall threshold"))
+		bool bIsStalled;
+	UPROPERTY(BlueprintReadOnly, Category = "Tango", meta = (ToolTip = "Seconds since the last update arrived"))
+		float SecondsSinceLastArrival;
+
+	FTangoStreamStatistics()
+		: Stream(ETangoStreamType::POSE)
+		, NumArrivals(0)
+		, IntervalP50(0.0f)
+		, IntervalP95(0.0f)
+		, IntervalP99(0.0f)
+		, MaxInterval(0.0f)
+		, ServiceIntervalP50(0.0f)
+		, ServiceIntervalP99(0.0f)
+		, NumStalls(0)
+		, bIsStalled(false)
+		, SecondsSinceLastArrival(0.0f)
+	{
+	}
+};
@@ -26,6 +26,8 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FTangoEventDelegate,FTangoEvent,Even
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FTangoResultDelegate, ETangoRequestResult::Type, Result);
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FTangoStreamStallDelegate, FTangoStreamStatistics, Statistics);
+
 UCLASS(ClassGroup = Tango, meta = (BlueprintSpawnableComponent))
 class TANGOPLUGIN_API UTangoEventComponent : public UActorComponent
 {
@@ -61,6 +63,9 @@ public:
     
     UPROPERTY(BlueprintAssignable, meta = (ToolTip = "Fires when a file export request has occurred, returns the result of the request"))
         FTangoResultDelegate OnFileExportEvent;
+
+	UPROPERTY(BlueprintAssignable, meta = (ToolTip = "Fires when a stream of the service delivered nothing for longer than Tango.StreamMonitor.StallThreshold"))
+		FTangoStreamStallDelegate OnTangoStreamStalled;
     
 protected:
 
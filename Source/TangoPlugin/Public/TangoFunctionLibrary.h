@@ -98,6 +98,20 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Tango|Core", meta = (Keywords = "tango, camera, camera type, device"))
 		static FTangoCameraIntrinsics GetCameraIntrinsics(TEnumAsByte<ETangoCameraType::Type> CameraID);
 
+	/*
+	*	Returns how regularly a stream of the service arrived since the last connection, to tell hitches of the service from hitches of the app.
+	* @param Stream The stream to get the statistics for.
+	* @return Arrival interval percentiles and stall counts of the stream.
+	*/
+	UFUNCTION(Category = "Tango|Core", BlueprintPure, meta = (ToolTip = "Gets the arrival jitter and stall statistics of a Tango stream", Keywords = "tango, stream, jitter, stall, statistics"))
+		static FTangoStreamStatistics GetStreamStatistics(TEnumAsByte<ETangoStreamType::Type> Stream);
+
+	/*
+	*	Clears the statistics of all streams.
+	*/
+	UFUNCTION(Category = "Tango|Core", BlueprintCallable, meta = (ToolTip = "Clears the arrival jitter and stall statistics of all Tango streams", Keywords = "tango, stream, jitter, stall, statistics, reset"))
+		static void ResetStreamStatistics();
+
 	/*
 	* Utility to get a rotation as a quaternion
 	*/
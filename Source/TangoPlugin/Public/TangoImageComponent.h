@@ -58,6 +58,6 @@ public:
 	UFUNCTION(Category = "Tango|Camera", BluePrintPure, meta = (ToolTip = "Get the latest cameraimage timestamp.", keyword = "image, timestamp, time, seconds, camera"))
 		float  GetLatestImageTimeStamp();
 private:
-	float LastBroadCastedTimestamp = 0;
+	int64 LastBroadcastFrameSequence = 0;
 
 };
\ No newline at end of file
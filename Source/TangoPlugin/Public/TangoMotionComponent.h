@@ -31,6 +31,10 @@ class TANGOPLUGIN_API UTangoMotionComponent : public USceneComponent, public ITa
 	~UTangoMotionComponent(); //In TangoViewExtension.cpp!
 	virtual void BeginDestroy() override;
 	virtual void InitializeComponent() override;
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+	virtual void OnChildAttached(USceneComponent* ChildComponent) override;
+	virtual void OnChildDetached(USceneComponent* ChildComponent) override;
 
 public:
 
@@ -42,6 +46,10 @@ public:
 	UPROPERTY(Category = "Tango|Motion", meta = (ToolTip = "The Frame of Reference which will drive the position and rotation of this component.", keyword = "motion, frame, coordinate pair, frame of reference, position, rotation", ExposeOnSpawn), BlueprintReadWrite, EditAnywhere)
 		FTangoCoordinateFramePair MotionComponentFrameOfReference;
 
+	//The maximum rate in Hz at which OnTangoPoseAvailable fires for each requested pair. 0 delivers every pose.
+	UPROPERTY(Category = "Tango|Motion", meta = (ToolTip = "The maximum rate in Hz at which pose events are delivered to this component. 0 delivers every pose.", keyword = "motion, pose, events, rate, frequency", ClampMin = "0"), BlueprintReadWrite, EditAnywhere)
+		float MaxPoseEventRate = 0.0f;
+
 	/*
 	* Sets the pose events that are received by this component. If called twice, the second FramePair parameter will overwrite the first.
 	*	@param FramePairs An array of the FramePairs to recieve the matching events for.
@@ -96,7 +104,7 @@ public:
 	void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
 	//ITangoARInterface
 public:
-	virtual FTangoPoseData GetCurrentPoseRENDERTHREAD(float TimeStamp) override;
+	virtual FTangoCoordinateFramePair GetFrameOfReference() override { return MotionComponentFrameOfReference; }
 	virtual AActor* GetActor() override;
 	virtual USceneComponent* AsSceneComponent() override;
 	virtual FTransform CalcComponentToWorld(FTransform Transform) override;
@@ -107,6 +115,8 @@ private:
 	FVector UpdateLocation;
 	FRotator UpdateRotation;
 
+	FTangoSubscriptionHandle PoseEventSubscription;
+
 	TSharedPtr< FTangoViewExtension, ESPMode::ThreadSafe > ViewExtension;
 	friend class FTangoViewExtension;
 };
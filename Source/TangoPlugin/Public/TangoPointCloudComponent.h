@@ -136,6 +136,12 @@ public:
 	*/
 	UFUNCTION(Category = "Tango|Depth", BlueprintPure, meta = (ToolTip = "Returns the current scale factor to convert Tango distance units to Unreal distance units.", keyword = "depth, scale, factor, world"))
 		float GetCurrentWorldScaleFactor();
+
+	//Screen position of a point relative to a camera (X forward) with this field of view and aspect ratio
+	static FVector2D ProjectToScreen(float FieldOfView, float AspectRatio, const FVector2D& ScreenDimensions, const FVector& Location);
+	//RANSAC over planes through random point triples. Returns false if none fits more than MinPercentage of the points.
+	static bool FitPlane(const TArray<FVector>& Points, float MinPercentage, float PointDistanceThreshold, FPlane& Plane);
+	static FPlane MakeRandomPlane(const FVector& CameraForward, const TArray<FVector>& Points);
 private:
 	float LatestDepthTimeStamp;
 
@@ -146,6 +152,5 @@ private:
 	bool ConvertPointSpace(FVector& Point, ETangoPointSpace::Type Space,bool bIsNormal);
 	FVector2D ProjectVectorToScreen(UCameraComponent* ViewPoint, FVector Location);
 	FVector GetVectorArrayAverage(const TArray<FVector>& Vectors);
-	FPlane MakeRandomPlane(FVector CameraForward, TArray<FVector> Points);
 };
 
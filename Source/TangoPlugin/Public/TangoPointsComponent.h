@@ -52,8 +52,19 @@ public:
 	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
 	// End UPrimitiveComponent interface.
 private:
+	//Timestamp of the points the proxy was built from, Timestamp rounded to float does not tell frames apart at long uptimes
+	double PointCloudTimestamp = 0.0;
 	FVector MinBounds;
 	FVector MaxBounds;
+
+	//Rebinds the camera textures of the coloring material when a new frame is in another slot of the ring
+	void BindCameraTextures();
+	UPROPERTY(transient)
+		UMaterialInstanceDynamic* ColoringMaterial = nullptr;
+	UPROPERTY(transient)
+		UTexture* BoundYTexture = nullptr;
+	FName ColoringYTextureName;
+	FName ColoringUVTextureName;
 };
 
 /** This class is the container inside the renderer that holds onto our array of vertices. */
@@ -196,6 +207,10 @@ public:
 	FTangoPointCloudSceneProxy(const UTangoPointsComponent* InComponent, FVector& MinBounds,FVector& MaxBounds,const FMatrix& ProjMat,const bool bCreateTriangles = false);
 	virtual ~FTangoPointCloudSceneProxy();
 
+	//Fills the vertices and indices for these points on the CPU, without touching the RHI. Also what the benchmark commandlet times.
+	static void BuildBuffers(const TArray<FVector>& Points, const FMatrix& ProjMat, bool bTriangles, FColor VertexColor,
+		TArray<FDynamicMeshVertex>& Vertices, TArray<int32>& Indices, FVector& MinBounds, FVector& MaxBounds);
+
 	void UpdatePoints_RenderThread();
 
 	virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override;
@@ -58,6 +58,8 @@ public class TangoPlugin : ModuleRules
 			AdditionalPropertiesForReceipt.Add(new ReceiptProperty("AndroidPlugin", Path.Combine(ModuleDirectory, "TangoPlugin_APL.xml")));
             //@NOTE: is the include here now attempting to load the public library as well as the APL.xml include?
             PublicAdditionalLibraries.Add(Path.Combine(ModuleDirectory, "../../ThirdParty/libtango_client_api.so"));
+			//Copying camera frames into the texture ring
+			PublicAdditionalLibraries.Add("GLESv2");
 
             
 		}